@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#include "../simulator/riscv_matrix.hpp"
+
+// Chained matrix product benchmark (C++ API)
+//   nested   - matrix_multiply_2x2(matrix_multiply_2x2(a, b), c) ... from C,
+//              each step a call returning a temporary tile
+//   eager    - riscv::multiply step by step in C++
+//   fused    - a * b * c * d as one expression: operands loaded once into
+//              4-lane vectors, one store
+// and for a non-square chain, 64x1 * 1x64 * 64x1 left to right against the
+// order the expression picks.
+
+#define CHAINS 4096
+#define ROUNDS 2000
+
+using riscv::Matrix;
+using riscv::Tile;
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static Tile a[CHAINS], b[CHAINS], c[CHAINS], d[CHAINS], out[CHAINS];
+
+static std::uint32_t checksum() {
+    std::uint32_t sum = 0;
+    for (int i = 0; i < CHAINS; i++) sum = sum * 31 + (std::uint32_t)(out[i](0, 0) ^ out[i](1, 1));
+    return sum;
+}
+
+template <typename F>
+static void time_tiles(const char *name, F body) {
+    double start = now_seconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < CHAINS; i++) body(i);
+        __asm__ volatile("" ::: "memory");
+    }
+    double seconds = now_seconds() - start;
+    printf("%-10s %10.1f %14.1f   %08x\n", name, seconds * 1e3, seconds / ((double)CHAINS * ROUNDS) * 1e9, checksum());
+}
+
+int main() {
+    for (int i = 0; i < CHAINS; i++) {
+        for (int e = 0; e < MATRIX_SIZE; e++) {
+            a[i].m[e / 2][e % 2] = (i + e) % 17 - 8;
+            b[i].m[e / 2][e % 2] = (i * 3 + e) % 13 - 6;
+            c[i].m[e / 2][e % 2] = (i * 5 + e) % 11 - 5;
+            d[i].m[e / 2][e % 2] = (i * 7 + e) % 7 - 3;
+        }
+    }
+
+    printf("=== Chained Matrix Products ===\n");
+    printf("%d chains of four tiles, %d rounds\n\n", CHAINS, ROUNDS);
+    printf("%-10s %10s %14s   %s\n", "method", "ms", "ns/chain", "checksum");
+
+    time_tiles("nested", [](int i) {
+        matrix_2x2_t r = matrix_multiply_2x2(riscv::to_c(a[i]), riscv::to_c(b[i]));
+        r = matrix_multiply_2x2(r, riscv::to_c(c[i]));
+        out[i] = riscv::from_c(matrix_multiply_2x2(r, riscv::to_c(d[i])));
+    });
+    time_tiles("eager", [](int i) { out[i] = riscv::multiply(riscv::multiply(riscv::multiply(a[i], b[i]), c[i]), d[i]); });
+    time_tiles("fused", [](int i) { out[i] = a[i] * b[i] * c[i] * d[i]; });
+
+    // Outer product in the middle: left to right builds a 64x64 temporary
+    static Matrix<int, 64, 1> x, z, result;
+    static Matrix<int, 1, 64> y;
+    for (int i = 0; i < 64; i++) {
+        x(i, 0) = i - 32;
+        y(0, i) = i % 5 - 2;
+        z(i, 0) = 3 * i % 7;
+    }
+    printf("\n%-10s %10s %14s %12s\n", "64-chain", "ms", "ns/chain", "multiplies");
+    const int chain_rounds = 20000;
+    double start = now_seconds();
+    for (int r = 0; r < chain_rounds; r++) {
+        result = riscv::multiply(riscv::multiply(x, y), z);
+        __asm__ volatile("" ::: "memory");
+        x(r & 63, 0) ^= 1;
+    }
+    double seconds = now_seconds() - start;
+    printf("%-10s %10.1f %14.1f %12d\n", "left", seconds * 1e3, seconds / chain_rounds * 1e9, 64 * 64 + 64 * 64);
+    int left_sum = result(5, 0);
+    for (int r = 0; r < chain_rounds; r++) x(r & 63, 0) ^= 1;
+
+    start = now_seconds();
+    for (int r = 0; r < chain_rounds; r++) {
+        result = x * y * z;
+        __asm__ volatile("" ::: "memory");
+        x(r & 63, 0) ^= 1;
+    }
+    seconds = now_seconds() - start;
+    printf("%-10s %10.1f %14.1f %12d\n", "ordered", seconds * 1e3, seconds / chain_rounds * 1e9,
+           (int)decltype(x * y * z)::cost());
+    if (result(5, 0) != left_sum) {
+        printf("ERROR: reordered chain disagrees with left to right\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/timing.h"
+#include "../simulator/csr.h"
+#include "../simulator/conv2d.h"
+
+// 3x3 convolution benchmark: direct CONV2D versus im2col + MATVEC
+// A 66x66 image gives a 64x64 output. im2col expands every output's 3x3
+// patch into a padded 10-element row (two output rows per 2x10 block of
+// five 2x2 tiles), then a GEMV against the padded kernel produces the
+// outputs. CONV2D reads each 4x4 input window in place. Traffic is the
+// data-cache line fills: the image fits in L1, the im2col buffer does not.
+
+#define IN_DIM       66
+#define OUT_DIM      (IN_DIM - CONV_K + 1)
+#define PITCH        (IN_DIM * 4)
+#define CODE_BASE    0x1000
+#define ADDR_IN      0x10000
+#define ADDR_COL     0x20000
+#define ADDR_OUT     0x50000
+#define ADDR_TMP     0x60000
+#define ADDR_K       0x61000
+#define ADDR_KV      0x61100
+#define MEMORY_SIZE  (1024 * 1024)
+#define KV_LEN       10             // 9 weights padded to whole 2-element vectors
+
+// Direct: output tile (ty, tx) lands at ADDR_OUT + 16 * (ty * OUT_DIM / 2 + tx)
+// x5/x6 = row/tile counters, x12 = window cursor, x13 = kernel, x14 = output
+static void build_direct(rv_program_t *p) {
+    p->len = 0;
+    rv_emit_li(p, 7, PITCH);
+    rv_emit32(p, rv_csrrw(0, CSR_CONVPITCH, 7));
+    rv_emit_li(p, 12, ADDR_IN);
+    rv_emit_li(p, 13, ADDR_K);
+    rv_emit_li(p, 14, ADDR_OUT);
+    rv_emit_li(p, 5, OUT_DIM / 2);
+    size_t row = p->len;
+    rv_emit_li(p, 6, OUT_DIM / 2);
+    size_t tile = p->len;
+    rv_emit32(p, rv_conv2d(14, 12, 13));
+    rv_emit32(p, rv_addi(12, 12, 8));
+    rv_emit32(p, rv_addi(14, 14, 16));
+    rv_emit32(p, rv_addi(6, 6, -1));
+    rv_emit32(p, rv_bne(6, 0, (int32_t)tile - (int32_t)p->len));
+    rv_emit32(p, rv_addi(12, 12, 2 * PITCH - OUT_DIM * 4));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)row - (int32_t)p->len));
+    rv_emit32(p, rv_ecall());
+}
+
+// im2col: outputs row-major at ADDR_OUT. Phase 1 expands each horizontal
+// output pair into a 2x10 block at ADDR_COL; phase 2 runs five MATVECs per
+// block against the padded kernel vector.
+static void build_im2col(rv_program_t *p) {
+    p->len = 0;
+    rv_emit_li(p, 12, ADDR_IN);
+    rv_emit_li(p, 15, ADDR_COL);
+    rv_emit_li(p, 5, OUT_DIM);
+    size_t row = p->len;
+    rv_emit_li(p, 6, OUT_DIM / 2);
+    size_t pair = p->len;
+    for (int e = 0; e < CONV_K * CONV_K; e++) {
+        int32_t src = (e / CONV_K) * PITCH + (e % CONV_K) * 4;
+        int32_t dst = (e / 2) * 16 + (e % 2) * 4;
+        rv_emit32(p, rv_lw(7, 12, src));
+        rv_emit32(p, rv_lw(8, 12, src + 4));
+        rv_emit32(p, rv_sw(7, 15, dst));
+        rv_emit32(p, rv_sw(8, 15, dst + 8));
+    }
+    rv_emit32(p, rv_addi(12, 12, 8));
+    rv_emit32(p, rv_addi(15, 15, KV_LEN * 8));
+    rv_emit32(p, rv_addi(6, 6, -1));
+    rv_emit32(p, rv_bne(6, 0, (int32_t)pair - (int32_t)p->len));
+    rv_emit32(p, rv_addi(12, 12, PITCH - OUT_DIM * 4));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)row - (int32_t)p->len));
+
+    rv_emit_li(p, 12, ADDR_COL);
+    rv_emit_li(p, 13, ADDR_KV);
+    rv_emit_li(p, 14, ADDR_TMP);
+    rv_emit_li(p, 17, ADDR_OUT);
+    rv_emit_li(p, 5, OUT_DIM * OUT_DIM / 2);
+    size_t gemv = p->len;
+    rv_emit32(p, rv_addi(20, 0, 0));
+    rv_emit32(p, rv_addi(21, 0, 0));
+    for (int t = 0; t < KV_LEN / 2; t++) {
+        rv_emit32(p, rv_matvec(14, 12, 13));
+        rv_emit32(p, rv_lw(7, 14, 0));
+        rv_emit32(p, rv_lw(8, 14, 4));
+        rv_emit32(p, rv_add(20, 20, 7));
+        rv_emit32(p, rv_add(21, 21, 8));
+        rv_emit32(p, rv_addi(12, 12, 16));
+        rv_emit32(p, rv_addi(13, 13, 8));
+    }
+    rv_emit32(p, rv_sw(20, 17, 0));
+    rv_emit32(p, rv_sw(21, 17, 4));
+    rv_emit32(p, rv_addi(17, 17, 8));
+    rv_emit32(p, rv_addi(13, 13, -KV_LEN * 4));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)gemv - (int32_t)p->len));
+    rv_emit32(p, rv_ecall());
+}
+
+static int32_t output_at(cpu_state_t *cpu, bool direct, int y, int x) {
+    xlen_t addr = direct
+        ? ADDR_OUT + (xlen_t)((y / 2) * (OUT_DIM / 2) + x / 2) * MATRIX_BYTES + (xlen_t)((y % 2) * 2 + x % 2) * 4
+        : ADDR_OUT + (xlen_t)(y * OUT_DIM + x) * 4;
+    return read_word(cpu, addr);
+}
+
+int main(void) {
+    static int32_t image[IN_DIM][IN_DIM], expected[OUT_DIM][OUT_DIM];
+    static rv_program_t program;
+    int32_t kernel[CONV_K][CONV_K] = {{1, 2, 1}, {0, 0, 0}, {-1, -2, -1}};
+    int32_t kvec[KV_LEN] = { 0 };
+    memcpy(kvec, kernel, sizeof(kernel));
+
+    for (int y = 0; y < IN_DIM; y++) {
+        for (int x = 0; x < IN_DIM; x++) image[y][x] = (y * 13 + x * 29) % 17 - 8;
+    }
+    for (int y = 0; y < OUT_DIM; y++) {
+        for (int x = 0; x < OUT_DIM; x++) {
+            int32_t sum = 0;
+            for (int i = 0; i < CONV_K; i++) {
+                for (int j = 0; j < CONV_K; j++) sum += image[y + i][x + j] * kernel[i][j];
+            }
+            expected[y][x] = sum;
+        }
+    }
+
+    printf("=== 3x3 Convolution: CONV2D vs im2col + MATVEC ===\n");
+    printf("%dx%d input, %dx%d output\n\n", IN_DIM, IN_DIM, OUT_DIM, OUT_DIM);
+    printf("%-16s %10s %10s %8s %12s %9s\n", "method", "insns", "cycles", "misses", "fill bytes", "correct");
+
+    for (int v = 0; v < 2; v++) {
+        bool direct = v == 1;
+        cpu_state_t *cpu = init_cpu(MEMORY_SIZE);
+        if (!cpu || timing_attach(cpu, NULL) != RISCV_SUCCESS) return 1;
+        load_image(cpu, ADDR_IN, image, sizeof(image));
+        load_image(cpu, ADDR_K, kernel, sizeof(kernel));
+        load_image(cpu, ADDR_KV, kvec, sizeof(kvec));
+        if (direct) build_direct(&program);
+        else build_im2col(&program);
+        load_image(cpu, CODE_BASE, program.bytes, program.len);
+        cpu->pc = CODE_BASE;
+        riscv_run_timed(cpu, UINT64_MAX);
+
+        bool correct = cpu->halted;
+        for (int y = 0; y < OUT_DIM; y++) {
+            for (int x = 0; x < OUT_DIM; x++) {
+                if (output_at(cpu, direct, y, x) != expected[y][x]) correct = false;
+            }
+        }
+        uint64_t misses = cpu->timing->dcache_misses;
+        printf("%-16s %10llu %10llu %8llu %12llu %9s\n", direct ? "conv2d" : "im2col+matvec",
+               (unsigned long long)cpu->instret, (unsigned long long)cpu->timing->cycles,
+               (unsigned long long)misses, (unsigned long long)misses * cpu->timing->config.line_bytes,
+               correct ? "yes" : "NO");
+        free_cpu(cpu);
+        if (!correct) return 1;
+    }
+    return 0;
+}
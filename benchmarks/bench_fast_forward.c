@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/timing.h"
+
+// Functional fast-forward benchmark
+// A guest program spends most of its instructions filling the matrix
+// buffer, then runs a short MATMUL kernel between ROI markers. Timing the
+// whole run in detail is compared with fast-forwarding to the kernel.
+
+#define SETUP_ITERS  2000000
+#define UNROLL       32
+#define PASSES       200
+#define ADDR_A       0x10000
+#define ADDR_C       0x20000
+#define CODE_BASE    0x1000
+
+// x5 = setup counter, x8 = buffer, x15 = checksum, x16 = pass counter
+static void build_program(rv_program_t *p) {
+    p->len = 0;
+    rv_emit_li(p, 5, SETUP_ITERS);
+    rv_emit32(p, rv_lui(8, ADDR_A));
+    size_t setup = p->len;
+    rv_emit32(p, rv_andi(9, 5, 0x3FF));
+    rv_emit32(p, rv_slli(9, 9, 2));
+    rv_emit32(p, rv_add(9, 9, 8));
+    rv_emit32(p, rv_sw(5, 9, 0));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)setup - (int32_t)p->len));
+
+    rv_emit32(p, rv_marker(RV_MARKER_ROI_BEGIN));
+    rv_emit32(p, rv_addi(16, 0, PASSES));
+    size_t outer = p->len;
+    rv_emit32(p, rv_lui(12, ADDR_A));
+    rv_emit32(p, rv_lui(14, ADDR_C));
+    for (int i = 0; i < UNROLL; i++) {
+        rv_emit32(p, rv_addi(13, 12, 16));
+        rv_emit32(p, rv_matmul(14, 12, 13));
+        rv_emit32(p, rv_lw(10, 14, 0));
+        rv_emit32(p, rv_add(15, 15, 10));
+        rv_emit32(p, rv_addi(12, 12, 32));
+        rv_emit32(p, rv_addi(14, 14, 16));
+    }
+    rv_emit32(p, rv_addi(16, 16, -1));
+    rv_emit32(p, rv_bne(16, 0, (int32_t)outer - (int32_t)p->len));
+    rv_emit32(p, rv_marker(RV_MARKER_ROI_END));
+
+    rv_emit32(p, rv_add(10, 15, 0));
+    rv_emit32(p, rv_ecall());
+}
+
+int main(void) {
+    static rv_program_t program;
+    static const sim_mode_t modes[] = { SIM_MODE_DETAILED, SIM_MODE_FAST_FORWARD };
+    static const char *names[] = { "detailed", "fast-fwd" };
+    int checksum[2] = { 0, 0 };
+
+    build_program(&program);
+
+    printf("=== Functional Fast-Forward ===\n");
+    printf("Setup: %d iterations, ROI: %d passes x %d MATMULs\n\n", SETUP_ITERS, PASSES, UNROLL);
+    printf("%-10s %12s %12s %12s %10s\n", "mode", "functional", "detailed", "cycles", "seconds");
+
+    for (int m = 0; m < 2; m++) {
+        cpu_state_t *cpu = init_cpu(256 * 1024);
+        if (!cpu || timing_attach(cpu, NULL) != RISCV_SUCCESS) return 1;
+        load_image(cpu, CODE_BASE, program.bytes, program.len);
+        cpu->pc = CODE_BASE;
+
+        sim_config_t config;
+        sim_stats_t stats;
+        sim_default_config(&config);
+        config.mode = modes[m];
+
+        clock_t start = clock();
+        int status = sim_run(cpu, &config, UINT64_MAX, &stats);
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        if (status != RISCV_SUCCESS || !cpu->halted) {
+            printf("ERROR: program did not complete\n");
+            free_cpu(cpu);
+            return 1;
+        }
+
+        checksum[m] = cpu->exit_code;
+        printf("%-10s %12llu %12llu %12llu %10.3f\n", names[m],
+               (unsigned long long)stats.functional_insns,
+               (unsigned long long)stats.detailed_insns,
+               (unsigned long long)stats.detailed_cycles, seconds);
+        free_cpu(cpu);
+    }
+
+    printf("\nChecksums %s (0x%08x)\n",
+           checksum[0] == checksum[1] ? "match" : "DIFFER", (unsigned)checksum[0]);
+    return checksum[0] == checksum[1] ? 0 : 1;
+}
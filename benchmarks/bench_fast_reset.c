@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/checkpoint.h"
+
+// Fast reset benchmark
+// A test harness runs many short cases against the same initial image.
+// Rebuilding the CPU each time (free, calloc, reload) costs time in
+// proportion to guest RAM. riscv_cpu_reset only copies back the pages the
+// case wrote.
+
+#define MEMORY_SIZE  (16 * 1024 * 1024)
+#define CASES        2000
+#define CODE_BASE    0x1000
+#define ADDR_A       0x10000
+#define ADDR_C       0x20000
+
+// Each case runs one MATMUL on its input and exits with C[0][0]
+static void build_program(rv_program_t *p) {
+    p->len = 0;
+    rv_emit32(p, rv_lui(12, ADDR_A));
+    rv_emit32(p, rv_lui(14, ADDR_C));
+    rv_emit32(p, rv_matmul(14, 12, 12));
+    rv_emit32(p, rv_lw(10, 14, 0));
+    rv_emit32(p, rv_ecall());
+}
+
+static void setup(cpu_state_t *cpu, const rv_program_t *program) {
+    load_image(cpu, CODE_BASE, program->bytes, program->len);
+    cpu->pc = CODE_BASE;
+}
+
+static int run_case(cpu_state_t *cpu, int n) {
+    matrix_2x2_t a = {{{n, 1}, {0, 1}}};
+    write_matrix_2x2(cpu, ADDR_A, a);
+    riscv_run(cpu, 100);
+    return cpu->exit_code;
+}
+
+int main(void) {
+    rv_program_t program;
+    long checksum[2] = { 0, 0 };
+    double seconds[2];
+
+    build_program(&program);
+
+    printf("=== Fast Reset ===\n");
+    printf("Guest RAM: %d MiB, %d cases\n\n", MEMORY_SIZE >> 20, CASES);
+
+    // Rebuild the CPU for every case
+    clock_t start = clock();
+    for (int n = 0; n < CASES; n++) {
+        cpu_state_t *cpu = init_cpu(MEMORY_SIZE);
+        if (!cpu) return 1;
+        setup(cpu, &program);
+        checksum[0] += run_case(cpu, n);
+        free_cpu(cpu);
+    }
+    seconds[0] = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    // Reset to a base image between cases
+    cpu_state_t *cpu = init_cpu(MEMORY_SIZE);
+    if (!cpu) return 1;
+    setup(cpu, &program);
+    if (riscv_cpu_set_base(cpu) != RISCV_SUCCESS) return 1;
+    start = clock();
+    for (int n = 0; n < CASES; n++) {
+        checksum[1] += run_case(cpu, n);
+        riscv_cpu_reset(cpu);
+    }
+    seconds[1] = (double)(clock() - start) / CLOCKS_PER_SEC;
+    free_cpu(cpu);
+
+    printf("%-10s %12s %14s\n", "method", "seconds", "us/case");
+    printf("%-10s %12.3f %14.2f\n", "rebuild", seconds[0], seconds[0] * 1e6 / CASES);
+    printf("%-10s %12.3f %14.2f\n", "reset", seconds[1], seconds[1] * 1e6 / CASES);
+    if (seconds[1] > 0.0) printf("\nSpeedup: %.1fx\n", seconds[0] / seconds[1]);
+
+    if (checksum[0] != checksum[1]) {
+        printf("ERROR: Results differ (%ld vs %ld)\n", checksum[0], checksum[1]);
+        return 1;
+    }
+    printf("Results match\n");
+    return 0;
+}
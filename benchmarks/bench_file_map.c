@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/file_map.h"
+
+// Memory-mapped dataset benchmark
+// A file of PAIRS A/B tile pairs is fed to a guest MATMUL loop that streams
+// through every pair. Startup is CPU creation plus getting the data into
+// the guest:
+//   write_word - host read, then one write_word per element (as
+//                run_matmul_demo does)
+//   load_image - host read into a buffer, then one bulk copy
+//   file_map   - map the file read-only above RAM; no copy at all
+// Process CPU time; the file is in the host page cache for every method.
+
+#define PAIRS        (2 * 1024 * 1024)
+#define PAIR_BYTES   (2 * MATRIX_BYTES)
+#define DATA_BYTES   ((size_t)PAIRS * PAIR_BYTES)
+#define CODE_BASE    0x1000
+#define ADDR_C       0x8000
+#define ADDR_RAM     0x100000
+#define ADDR_MAPPED  0x10000000
+#define DATA_PATH    "build/bench_file_map.bin"
+
+static double now_seconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+// x15 = sum of C[0][0] over every pair at x10
+static void build_program(rv_program_t *p, xlen_t data) {
+    p->len = 0;
+    rv_emit_li(p, 10, (int32_t)data);
+    rv_emit_li(p, 14, ADDR_C);
+    rv_emit_li(p, 5, PAIRS);
+    rv_emit32(p, rv_addi(15, 0, 0));
+    size_t loop = p->len;
+    rv_emit32(p, rv_addi(11, 10, MATRIX_BYTES));
+    rv_emit32(p, rv_matmul(14, 10, 11));
+    rv_emit32(p, rv_lw(7, 14, 0));
+    rv_emit32(p, rv_add(15, 15, 7));
+    rv_emit32(p, rv_addi(10, 10, PAIR_BYTES));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)loop - (int32_t)p->len));
+    rv_emit32(p, rv_ecall());
+}
+
+static int32_t* read_file(void) {
+    int32_t *data = malloc(DATA_BYTES);
+    FILE *f = fopen(DATA_PATH, "rb");
+    bool ok = data && f && fread(data, 1, DATA_BYTES, f) == DATA_BYTES;
+    if (f) fclose(f);
+    if (!ok) {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+int main(void) {
+    static rv_program_t program;
+    static const char *names[] = { "write_word", "load_image", "file_map" };
+
+    int32_t *data = malloc(DATA_BYTES);
+    FILE *f = fopen(DATA_PATH, "wb");
+    if (!data || !f) return 1;
+    for (size_t i = 0; i < DATA_BYTES / 4; i++) data[i] = (int32_t)(i % 13) - 6;
+    if (fwrite(data, 1, DATA_BYTES, f) != DATA_BYTES) return 1;
+    fclose(f);
+    free(data);
+
+    printf("=== Memory-Mapped Matrix Dataset ===\n");
+    printf("%d tile pairs (%zu MiB)\n\n", PAIRS, DATA_BYTES >> 20);
+    printf("%-12s %12s %12s %12s\n", "method", "startup ms", "run ms", "checksum");
+
+    int32_t checksum[3];
+    for (int v = 0; v < 3; v++) {
+        bool mapped = v == 2;
+        double start = now_seconds();
+        cpu_state_t *cpu = init_cpu(mapped ? ADDR_RAM : ADDR_RAM + DATA_BYTES);
+        if (!cpu) return 1;
+        if (mapped) {
+            if (file_map(cpu, ADDR_MAPPED, DATA_PATH, 0, 0, FILE_MAP_READ_ONLY | FILE_MAP_SEQUENTIAL) != RISCV_SUCCESS) {
+                return 1;
+            }
+        } else {
+            int32_t *host = read_file();
+            if (!host) return 1;
+            if (v == 0) {
+                for (size_t i = 0; i < DATA_BYTES / 4; i++) write_word(cpu, ADDR_RAM + (xlen_t)i * 4, host[i]);
+            } else {
+                load_image(cpu, ADDR_RAM, host, DATA_BYTES);
+            }
+            free(host);
+        }
+        double loaded = now_seconds();
+
+        build_program(&program, mapped ? ADDR_MAPPED : ADDR_RAM);
+        load_image(cpu, CODE_BASE, program.bytes, program.len);
+        cpu->pc = CODE_BASE;
+        riscv_run(cpu, UINT64_MAX);
+        double done = now_seconds();
+
+        checksum[v] = (int32_t)cpu->regs[15];
+        bool halted = cpu->halted;
+        free_cpu(cpu);
+        printf("%-12s %12.2f %12.2f %12d\n", names[v], (loaded - start) * 1e3, (done - loaded) * 1e3, checksum[v]);
+        if (!halted || checksum[v] != checksum[0]) {
+            printf("ERROR: %s produced a different result\n", names[v]);
+            return 1;
+        }
+    }
+    remove(DATA_PATH);
+    return 0;
+}
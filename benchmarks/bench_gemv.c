@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/timing.h"
+
+// GEMV benchmark: MATVEC versus MATMUL emulation
+// y = M * x for an N x N matrix stored as 2x2 tiles, tile rows contiguous.
+// Each tile product lands in a scratch vector that the loop adds into two
+// accumulators. Emulating with MATMUL first pads x into 2x2 matrices
+// [x0 0; x1 0] and then wastes half of every product.
+
+#define N            256
+#define TILES        (N / 2)
+#define PASSES       4
+#define CODE_BASE    0x1000
+#define ADDR_M       0x100000
+#define ADDR_X       0x80000
+#define ADDR_XM      0x90000
+#define ADDR_Y       0xA0000
+#define ADDR_TMP     0xB0000
+#define MEMORY_SIZE  (2 * 1024 * 1024)
+
+// x5 = tile-row counter, x6 = tile counter, x12 = tile cursor,
+// x13 = vector cursor, x14 = scratch, x17 = y cursor, x20/x21 = accumulators
+static void build_program(rv_program_t *p, bool use_matvec) {
+    p->len = 0;
+    rv_emit_li(p, 14, ADDR_TMP);
+
+    if (!use_matvec) {
+        // Pad x into 2x2 matrices; the zero columns are already zero
+        rv_emit_li(p, 13, ADDR_X);
+        rv_emit_li(p, 15, ADDR_XM);
+        rv_emit_li(p, 6, TILES);
+        size_t pad = p->len;
+        rv_emit32(p, rv_lw(7, 13, 0));
+        rv_emit32(p, rv_lw(8, 13, 4));
+        rv_emit32(p, rv_sw(7, 15, 0));
+        rv_emit32(p, rv_sw(8, 15, 8));
+        rv_emit32(p, rv_addi(13, 13, 8));
+        rv_emit32(p, rv_addi(15, 15, 16));
+        rv_emit32(p, rv_addi(6, 6, -1));
+        rv_emit32(p, rv_bne(6, 0, (int32_t)pad - (int32_t)p->len));
+    }
+
+    rv_emit_li(p, 22, PASSES);
+    size_t pass = p->len;
+    rv_emit_li(p, 12, ADDR_M);
+    rv_emit_li(p, 17, ADDR_Y);
+    rv_emit_li(p, 5, TILES);
+    size_t row = p->len;
+    rv_emit_li(p, 13, use_matvec ? ADDR_X : ADDR_XM);
+    rv_emit32(p, rv_addi(20, 0, 0));
+    rv_emit32(p, rv_addi(21, 0, 0));
+    rv_emit_li(p, 6, TILES);
+    size_t tile = p->len;
+    if (use_matvec) {
+        rv_emit32(p, rv_matvec(14, 12, 13));
+        rv_emit32(p, rv_lw(7, 14, 0));
+        rv_emit32(p, rv_lw(8, 14, 4));
+        rv_emit32(p, rv_addi(13, 13, 8));
+    } else {
+        rv_emit32(p, rv_matmul(14, 12, 13));
+        rv_emit32(p, rv_lw(7, 14, 0));
+        rv_emit32(p, rv_lw(8, 14, 8));
+        rv_emit32(p, rv_addi(13, 13, 16));
+    }
+    rv_emit32(p, rv_add(20, 20, 7));
+    rv_emit32(p, rv_add(21, 21, 8));
+    rv_emit32(p, rv_addi(12, 12, 16));
+    rv_emit32(p, rv_addi(6, 6, -1));
+    rv_emit32(p, rv_bne(6, 0, (int32_t)tile - (int32_t)p->len));
+    rv_emit32(p, rv_sw(20, 17, 0));
+    rv_emit32(p, rv_sw(21, 17, 4));
+    rv_emit32(p, rv_addi(17, 17, 8));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)row - (int32_t)p->len));
+    rv_emit32(p, rv_addi(22, 22, -1));
+    rv_emit32(p, rv_bne(22, 0, (int32_t)pass - (int32_t)p->len));
+    rv_emit32(p, rv_ecall());
+}
+
+static int32_t element(int r, int c) {
+    return (int32_t)((r * 31 + c * 17) % 23) - 11;
+}
+
+int main(void) {
+    static rv_program_t program;
+    static int32_t expected[N];
+    static const char *names[] = { "matmul-emulated", "matvec" };
+
+    for (int r = 0; r < N; r++) {
+        int32_t sum = 0;
+        for (int c = 0; c < N; c++) sum += element(r, c) * (c % 7 - 3);
+        expected[r] = sum;
+    }
+
+    printf("=== GEMV: MATVEC vs MATMUL ===\n");
+    printf("%d x %d matrix, %d passes\n\n", N, N, PASSES);
+    printf("%-16s %10s %10s %10s %10s %9s\n", "method", "insns", "cycles", "misses", "seconds", "correct");
+
+    for (int v = 0; v < 2; v++) {
+        cpu_state_t *cpu = init_cpu(MEMORY_SIZE);
+        if (!cpu || timing_attach(cpu, NULL) != RISCV_SUCCESS) return 1;
+        for (int tr = 0; tr < TILES; tr++) {
+            for (int tc = 0; tc < TILES; tc++) {
+                matrix_2x2_t t = {{{element(2 * tr, 2 * tc), element(2 * tr, 2 * tc + 1)},
+                                   {element(2 * tr + 1, 2 * tc), element(2 * tr + 1, 2 * tc + 1)}}};
+                write_matrix_2x2(cpu, ADDR_M + (xlen_t)(tr * TILES + tc) * MATRIX_BYTES, t);
+            }
+        }
+        for (int c = 0; c < N; c++) write_word(cpu, ADDR_X + (xlen_t)c * 4, c % 7 - 3);
+
+        build_program(&program, v == 1);
+        load_image(cpu, CODE_BASE, program.bytes, program.len);
+        cpu->pc = CODE_BASE;
+
+        clock_t start = clock();
+        riscv_run_timed(cpu, UINT64_MAX);
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        bool correct = cpu->halted;
+        for (int r = 0; r < N; r++) {
+            if (read_word(cpu, ADDR_Y + (xlen_t)r * 4) != expected[r]) correct = false;
+        }
+        printf("%-16s %10llu %10llu %10llu %10.3f %9s\n", names[v],
+               (unsigned long long)cpu->instret, (unsigned long long)cpu->timing->cycles,
+               (unsigned long long)cpu->timing->dcache_misses, seconds, correct ? "yes" : "NO");
+        free_cpu(cpu);
+        if (!correct) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/timing.h"
+#include "../simulator/csr.h"
+
+// Guest self-measurement benchmark
+// The benchmark_matmul loop from docs/assembly_examples.md, bracketed by
+// counter reads: the guest zeroes the matrix event counters, runs ITERS
+// MATMULs, and stores cycle, instret and mhpmcounter3..6 deltas to a
+// results block. The host compares them with the timing model. The hot
+// run reuses one operand pair; the cold run walks arrays larger than L1.
+
+#define ITERS        1000
+#define CODE_BASE    0x1000
+#define ADDR_IN      0x10000
+#define ADDR_OUT     0x40000
+#define ADDR_RESULT  0x8000
+#define MEMORY_SIZE  (512 * 1024)
+#define COUNTERS     6
+
+static const uint32_t counter_csr[COUNTERS] = {
+    CSR_CYCLE, CSR_INSTRET, CSR_HPMCOUNTER3, CSR_HPMCOUNTER3 + 1, CSR_HPMCOUNTER3 + 2, CSR_HPMCOUNTER3 + 3
+};
+static const char *counter_name[COUNTERS] = {
+    "cycles", "instret", "matrix ops", "bytes loaded", "bytes stored", "stall cycles"
+};
+
+// x20..x25 hold the start values; deltas land at ADDR_RESULT
+static void build_program(rv_program_t *p, bool cold) {
+    p->len = 0;
+    rv_emit_li(p, 5, ADDR_IN);
+    rv_emit_li(p, 6, ADDR_OUT);
+    rv_emit_li(p, 7, ITERS);
+    for (int c = 0; c < 4; c++) rv_emit32(p, rv_csrrw(0, CSR_MHPMCOUNTER3 + (uint32_t)c, 0));
+    for (int c = 0; c < COUNTERS; c++) rv_emit32(p, rv_csrrs((uint32_t)(20 + c), counter_csr[c], 0));
+
+    size_t loop = p->len;
+    rv_emit32(p, rv_addi(1, 5, 0));
+    rv_emit32(p, rv_addi(2, 5, MATRIX_BYTES));
+    rv_emit32(p, rv_addi(3, 6, 0));
+    rv_emit32(p, rv_matmul(3, 1, 2));
+    if (cold) {
+        rv_emit32(p, rv_addi(5, 5, 2 * MATRIX_BYTES));
+        rv_emit32(p, rv_addi(6, 6, MATRIX_BYTES));
+    }
+    rv_emit32(p, rv_addi(7, 7, -1));
+    rv_emit32(p, rv_bne(7, 0, (int32_t)loop - (int32_t)p->len));
+
+    for (int c = 0; c < COUNTERS; c++) rv_emit32(p, rv_csrrs((uint32_t)(10 + c), counter_csr[c], 0));
+    rv_emit_li(p, 5, ADDR_RESULT);
+    for (int c = 0; c < COUNTERS; c++) {
+        rv_emit32(p, rv_sub((uint32_t)(10 + c), (uint32_t)(10 + c), (uint32_t)(20 + c)));
+        rv_emit32(p, rv_sw((uint32_t)(10 + c), 5, 4 * c));
+    }
+    rv_emit32(p, rv_ecall());
+}
+
+int main(void) {
+    static rv_program_t program;
+
+    printf("=== Guest Performance Counters ===\n");
+    printf("%d MATMULs, guest-read counter deltas vs the timing model\n\n", ITERS);
+
+    for (int v = 0; v < 2; v++) {
+        bool cold = v == 1;
+        cpu_state_t *cpu = init_cpu(MEMORY_SIZE);
+        if (!cpu || timing_attach(cpu, NULL) != RISCV_SUCCESS) return 1;
+        for (int i = 0; i < 2 * ITERS; i++) {
+            matrix_2x2_t m = {{{i % 7, 1}, {2, i % 5}}};
+            write_matrix_2x2(cpu, ADDR_IN + (xlen_t)i * MATRIX_BYTES, m);
+        }
+        build_program(&program, cold);
+        load_image(cpu, CODE_BASE, program.bytes, program.len);
+        cpu->pc = CODE_BASE;
+        riscv_run_timed(cpu, UINT64_MAX);
+        if (!cpu->halted) {
+            printf("ERROR: Guest benchmark did not complete\n");
+            return 1;
+        }
+
+        timing_model_t *t = cpu->timing;
+        printf("%s operands\n", cold ? "Cold (streaming)" : "Hot (one pair)");
+        printf("  %-14s %12s %12s\n", "counter", "guest", "host total");
+        uint64_t host[COUNTERS] = {
+            t->cycles, cpu->instret, cpu->hpm.matrix_ops, cpu->hpm.matrix_load_bytes,
+            cpu->hpm.matrix_store_bytes, cpu->hpm.stall_cycles
+        };
+        for (int c = 0; c < COUNTERS; c++) {
+            uint32_t guest = (uint32_t)read_word(cpu, ADDR_RESULT + (xlen_t)c * 4);
+            printf("  %-14s %12u %12llu\n", counter_name[c], guest, (unsigned long long)host[c]);
+        }
+        printf("  %-14s %12s %12llu\n\n", "dcache misses", "-", (unsigned long long)t->dcache_misses);
+        bool exact = (uint32_t)read_word(cpu, ADDR_RESULT + 8) == ITERS &&
+                     (uint32_t)read_word(cpu, ADDR_RESULT + 12) == ITERS * 2 * MATRIX_BYTES;
+        free_cpu(cpu);
+        if (!exact) {
+            printf("ERROR: Guest event counts are wrong\n");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/timing.h"
+#include "../simulator/csr.h"
+#include "../simulator/layout.h"
+
+// Matrix layout benchmark
+// 1. Host gather of every tile of a 1024x1024 matrix, walking tile rows
+//    and tile columns, per layout, with and without prefetching.
+// 2. Guest GEMM on 32x32 row-major inputs: repacking A and B into tiles
+//    first, versus MATMUL reading tiles in place through tilepitcha/b,
+//    versus inputs that are already blocked.
+
+#define HOST_DIM     1024
+#define HOST_TILES   ((HOST_DIM / 2) * (HOST_DIM / 2))
+#define GEMM_N       32
+#define GEMM_T       (GEMM_N / 2)
+#define ROW_BYTES    (GEMM_N * 4)
+#define CODE_BASE    0x1000
+#define ADDR_A       0x10000
+#define ADDR_B       0x20000
+#define ADDR_PA      0x30000
+#define ADDR_PB      0x40000
+#define ADDR_C       0x50000
+#define ADDR_TMP     0x60000
+
+static double now_seconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+// Repack the row-major matrix at x10 into blocked tiles at x11
+static void emit_repack(rv_program_t *p, xlen_t src, xlen_t dst) {
+    rv_emit_li(p, 10, src);
+    rv_emit_li(p, 11, dst);
+    rv_emit_li(p, 5, GEMM_T);
+    size_t row = p->len;
+    rv_emit_li(p, 6, GEMM_T);
+    size_t tile = p->len;
+    rv_emit32(p, rv_lw(24, 10, 0));
+    rv_emit32(p, rv_lw(25, 10, 4));
+    rv_emit32(p, rv_lw(26, 10, ROW_BYTES));
+    rv_emit32(p, rv_lw(27, 10, ROW_BYTES + 4));
+    rv_emit32(p, rv_sw(24, 11, 0));
+    rv_emit32(p, rv_sw(25, 11, 4));
+    rv_emit32(p, rv_sw(26, 11, 8));
+    rv_emit32(p, rv_sw(27, 11, 12));
+    rv_emit32(p, rv_addi(10, 10, 8));
+    rv_emit32(p, rv_addi(11, 11, 16));
+    rv_emit32(p, rv_addi(6, 6, -1));
+    rv_emit32(p, rv_bne(6, 0, (int32_t)tile - (int32_t)p->len));
+    rv_emit32(p, rv_addi(10, 10, ROW_BYTES));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)row - (int32_t)p->len));
+}
+
+// C tile (i, j) = sum over k of A(i, k) * B(k, j), written blocked at ADDR_C.
+// Cursor steps: A moves along a tile row, B down a tile column.
+static void emit_gemm(rv_program_t *p, xlen_t a, xlen_t b, bool row_major) {
+    int32_t a_step_k = row_major ? 8 : MATRIX_BYTES;
+    int32_t b_step_k = row_major ? 2 * ROW_BYTES : GEMM_T * MATRIX_BYTES;
+    int32_t a_step_i = row_major ? 2 * ROW_BYTES : GEMM_T * MATRIX_BYTES;
+    int32_t b_step_j = row_major ? 8 : MATRIX_BYTES;
+
+    rv_emit_li(p, 10, a);
+    rv_emit_li(p, 14, ADDR_TMP);
+    rv_emit_li(p, 17, ADDR_C);
+    rv_emit_li(p, 5, GEMM_T);
+    size_t row = p->len;
+    rv_emit_li(p, 11, b);
+    rv_emit_li(p, 6, GEMM_T);
+    size_t col = p->len;
+    rv_emit32(p, rv_addi(12, 10, 0));
+    rv_emit32(p, rv_addi(13, 11, 0));
+    for (int r = 20; r < 24; r++) rv_emit32(p, rv_addi((uint32_t)r, 0, 0));
+    rv_emit_li(p, 7, GEMM_T);
+    size_t k = p->len;
+    rv_emit32(p, rv_matmul(14, 12, 13));
+    for (int e = 0; e < 4; e++) {
+        rv_emit32(p, rv_lw((uint32_t)(24 + e), 14, 4 * e));
+        rv_emit32(p, rv_add((uint32_t)(20 + e), (uint32_t)(20 + e), (uint32_t)(24 + e)));
+    }
+    rv_emit32(p, rv_addi(12, 12, a_step_k));
+    rv_emit32(p, rv_addi(13, 13, b_step_k));
+    rv_emit32(p, rv_addi(7, 7, -1));
+    rv_emit32(p, rv_bne(7, 0, (int32_t)k - (int32_t)p->len));
+    for (int e = 0; e < 4; e++) rv_emit32(p, rv_sw((uint32_t)(20 + e), 17, 4 * e));
+    rv_emit32(p, rv_addi(17, 17, MATRIX_BYTES));
+    rv_emit32(p, rv_addi(11, 11, b_step_j));
+    rv_emit32(p, rv_addi(6, 6, -1));
+    rv_emit32(p, rv_bne(6, 0, (int32_t)col - (int32_t)p->len));
+    rv_emit32(p, rv_addi(10, 10, a_step_i));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)row - (int32_t)p->len));
+}
+
+static int host_gather(void) {
+    static const char *names[] = { "row-major", "blocked", "z-order" };
+    static uint32_t rows[HOST_TILES], cols[HOST_TILES];
+    static matrix_2x2_t out[HOST_TILES];
+    static int32_t dense[HOST_DIM * HOST_DIM];
+
+    for (size_t i = 0; i < (size_t)HOST_DIM * HOST_DIM; i++) dense[i] = (int32_t)(i * 2654435761u);
+    cpu_state_t *cpu = init_cpu((size_t)HOST_DIM * HOST_DIM * 4);
+    if (!cpu) return 1;
+
+    printf("Host gather, %dx%d matrix (%d tiles), ns per tile\n", HOST_DIM, HOST_DIM, HOST_TILES);
+    printf("  %-10s %12s %12s %12s %12s\n", "layout", "rows", "rows+pf", "columns", "columns+pf");
+    for (int l = 0; l < 3; l++) {
+        matrix_layout_t layout = { (layout_kind_t)l, HOST_DIM, HOST_DIM, 0 };
+        if (layout_store(cpu, 0, &layout, dense) != RISCV_SUCCESS) return 1;
+        printf("  %-10s", names[l]);
+        for (int walk = 0; walk < 2; walk++) {
+            for (size_t i = 0; i < HOST_TILES; i++) {
+                uint32_t major = (uint32_t)(i / (HOST_DIM / 2)), minor = (uint32_t)(i % (HOST_DIM / 2));
+                rows[i] = walk ? minor : major;
+                cols[i] = walk ? major : minor;
+            }
+            for (int pf = 0; pf < 2; pf++) {
+                double start = now_seconds();
+                if (layout_gather(cpu, 0, &layout, rows, cols, HOST_TILES, out, pf) != RISCV_SUCCESS) return 1;
+                double ns = (now_seconds() - start) * 1e9 / HOST_TILES;
+                int32_t expect = dense[(size_t)2 * rows[HOST_TILES - 1] * HOST_DIM + 2 * cols[HOST_TILES - 1]];
+                if (out[HOST_TILES - 1].m[0][0] != expect) {
+                    printf("\nERROR: %s gather returned the wrong tile\n", names[l]);
+                    return 1;
+                }
+                printf(" %12.2f", ns);
+            }
+        }
+        printf("\n");
+    }
+    free_cpu(cpu);
+    return 0;
+}
+
+int main(void) {
+    static rv_program_t program;
+    static int32_t a[GEMM_N * GEMM_N], b[GEMM_N * GEMM_N], expected[GEMM_N * GEMM_N], c[GEMM_N * GEMM_N];
+    static const char *names[] = { "repack + matmul", "strided matmul", "pre-blocked" };
+
+    printf("=== Matrix Layouts ===\n\n");
+    if (host_gather() != 0) return 1;
+
+    for (int i = 0; i < GEMM_N * GEMM_N; i++) {
+        a[i] = (i * 7) % 13 - 6;
+        b[i] = (i * 11) % 9 - 4;
+    }
+    for (int i = 0; i < GEMM_N; i++) {
+        for (int j = 0; j < GEMM_N; j++) {
+            int32_t sum = 0;
+            for (int k = 0; k < GEMM_N; k++) sum += a[i * GEMM_N + k] * b[k * GEMM_N + j];
+            expected[i * GEMM_N + j] = sum;
+        }
+    }
+    matrix_layout_t row_major = { LAYOUT_ROW_MAJOR, GEMM_N, GEMM_N, 0 };
+    matrix_layout_t blocked = { LAYOUT_BLOCKED, GEMM_N, GEMM_N, 0 };
+
+    printf("\nGuest %dx%d GEMM from row-major inputs\n", GEMM_N, GEMM_N);
+    printf("  %-16s %10s %10s %8s %9s\n", "method", "insns", "cycles", "misses", "correct");
+    for (int v = 0; v < 3; v++) {
+        cpu_state_t *cpu = init_cpu(512 * 1024);
+        if (!cpu || timing_attach(cpu, NULL) != RISCV_SUCCESS) return 1;
+        const matrix_layout_t *in = v == 2 ? &blocked : &row_major;
+        layout_store(cpu, ADDR_A, in, a);
+        layout_store(cpu, ADDR_B, in, b);
+
+        program.len = 0;
+        if (v == 0) {
+            emit_repack(&program, ADDR_A, ADDR_PA);
+            emit_repack(&program, ADDR_B, ADDR_PB);
+            emit_gemm(&program, ADDR_PA, ADDR_PB, false);
+        } else if (v == 1) {
+            rv_emit_li(&program, 5, ROW_BYTES);
+            rv_emit32(&program, rv_csrrw(0, CSR_TILEPITCHA, 5));
+            rv_emit32(&program, rv_csrrw(0, CSR_TILEPITCHB, 5));
+            emit_gemm(&program, ADDR_A, ADDR_B, true);
+        } else {
+            emit_gemm(&program, ADDR_A, ADDR_B, false);
+        }
+        rv_emit32(&program, rv_ecall());
+        load_image(cpu, CODE_BASE, program.bytes, program.len);
+        cpu->pc = CODE_BASE;
+        riscv_run_timed(cpu, UINT64_MAX);
+
+        bool correct = cpu->halted && layout_load(cpu, ADDR_C, &blocked, c) == RISCV_SUCCESS &&
+                       memcmp(c, expected, sizeof(c)) == 0;
+        printf("  %-16s %10llu %10llu %8llu %9s\n", names[v],
+               (unsigned long long)cpu->instret, (unsigned long long)cpu->timing->cycles,
+               (unsigned long long)cpu->timing->dcache_misses, correct ? "yes" : "NO");
+        free_cpu(cpu);
+        if (!correct) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/lockstep.h"
+
+// Lockstep throughput benchmark
+// A Monte-Carlo style guest kernel (LCG draws, a data-dependent branch and a
+// MATMUL per batch) runs with a different seed per lane, first as independent
+// scalar harts and then as lockstep groups. Reports lane instructions per
+// second and how often the lanes stayed converged.
+
+#define ITERATIONS 20000
+#define CODE_BASE  0x100
+#define MEM_SIZE   (64 * 1024)
+
+static void build_kernel(rv_program_t *p) {
+    p->len = 0;
+    rv_emit_li(p, 11, 1103515245);                  // x11 = LCG multiplier
+    rv_emit_li(p, 5, ITERATIONS);                   // x5 = iteration count
+    rv_emit32(p, rv_addi(6, 0, 0));                 // x6 = hits
+    rv_emit32(p, rv_addi(12, 0, 0x400));
+    rv_emit32(p, rv_addi(14, 0, 0x420));
+    size_t loop = p->len;
+    rv_emit32(p, rv_mul(10, 10, 11));               // seed = seed * a + c
+    rv_emit32(p, rv_addi(10, 10, 1234));
+    rv_emit32(p, rv_srli(7, 10, 16));
+    rv_emit32(p, rv_andi(7, 7, 0x3FF));
+    rv_emit32(p, rv_addi(8, 0, 700));
+    rv_emit32(p, rv_blt(7, 8, 8));                  // skip the hit when x7 < 700
+    rv_emit32(p, rv_addi(6, 6, 1));
+    rv_emit32(p, rv_andi(9, 5, 63));
+    rv_emit32(p, rv_bne(9, 0, 8));                  // MATMUL every 64 draws
+    rv_emit32(p, rv_matmul(14, 12, 12));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)loop - (int32_t)p->len));
+    rv_emit32(p, rv_addi(10, 6, 0));
+    rv_emit32(p, rv_ecall());
+}
+
+static double seconds_since(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void) {
+    static rv_program_t prog;
+    build_kernel(&prog);
+
+    printf("=== Lockstep SoA Harts vs Scalar ===\n");
+    printf("Kernel: %d LCG draws per lane with a data-dependent branch\n\n", ITERATIONS);
+    printf("%-10s %6s %14s %12s %12s %10s\n",
+           "mode", "lanes", "lane insns", "seconds", "Minsn/s", "converged");
+
+    int failures = 0;
+    for (int lanes = 8; lanes <= 16; lanes += 8) {
+        int scalar_exit[LOCKSTEP_MAX_LANES];
+        uint64_t total = 0;
+
+        clock_t start = clock();
+        for (int l = 0; l < lanes; l++) {
+            cpu_state_t *cpu = init_cpu(MEM_SIZE);
+            load_image(cpu, CODE_BASE, prog.bytes, prog.len);
+            cpu->pc = CODE_BASE;
+            cpu->regs[10] = (xlen_t)(l * 7919 + 1);
+            riscv_run(cpu, UINT64_MAX);
+            scalar_exit[l] = cpu->exit_code;
+            total += cpu->instret;
+            free_cpu(cpu);
+        }
+        double scalar_s = seconds_since(start);
+        printf("%-10s %6d %14llu %12.3f %12.1f %10s\n", "scalar", lanes,
+               (unsigned long long)total, scalar_s, total / scalar_s / 1e6, "-");
+
+        lockstep_group_t *group = lockstep_create(lanes, MEM_SIZE);
+        lockstep_load_image(group, CODE_BASE, prog.bytes, prog.len);
+        lockstep_set_pc(group, CODE_BASE);
+        for (int l = 0; l < lanes; l++) {
+            group->regs[10][l] = (xlen_t)(l * 7919 + 1);
+        }
+
+        start = clock();
+        lockstep_run(group, UINT64_MAX);
+        double lockstep_s = seconds_since(start);
+
+        total = 0;
+        for (int l = 0; l < lanes; l++) {
+            total += group->cpu[l]->instret;
+            if (group->cpu[l]->exit_code != scalar_exit[l]) failures++;
+        }
+        uint64_t steps = group->converged_steps + group->divergent_steps;
+        printf("%-10s %6d %14llu %12.3f %12.1f %9.1f%%\n", "lockstep", lanes,
+               (unsigned long long)total, lockstep_s, total / lockstep_s / 1e6,
+               100.0 * (double)group->converged_steps / (double)steps);
+        lockstep_free(group);
+    }
+
+    printf("\nResults %s scalar execution\n", failures ? "DIFFER from" : "match");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// MATMUL batch benchmark: host page size
+// A batch of MATMULs whose operands are scattered over a 256 MiB guest
+// RAM. With 4 KiB host pages nearly every operand access misses the host
+// dTLB; 2 MiB pages cover the same RAM with 512x fewer entries. Host dTLB
+// load misses are read with perf_event when the kernel allows it.
+
+#define MEMORY_SIZE  ((size_t)256 << 20)
+#define CODE_BASE    0x1000
+#define TABLE_ADDR   0x100000
+#define OPS          65536
+#define PASSES       20
+#define DATA_BASE    ((size_t)4 << 20)
+
+// Operand addresses: a, b, c per MATMUL, 16-byte aligned across the RAM
+static void build_table(cpu_state_t *cpu) {
+    uint32_t state = 12345;
+    for (int i = 0; i < OPS * 3; i++) {
+        state = state * 1103515245u + 12345u;
+        uint32_t addr = (uint32_t)(DATA_BASE + (((size_t)state << 4) % (MEMORY_SIZE - DATA_BASE)));
+        write_word(cpu, TABLE_ADDR + (xlen_t)i * 4, (int32_t)addr);
+    }
+}
+
+// x5 = table cursor, x6 = table end, x7 = pass counter
+static void build_program(rv_program_t *p) {
+    p->len = 0;
+    rv_emit_li(p, 7, PASSES);
+    size_t outer = p->len;
+    rv_emit_li(p, 5, TABLE_ADDR);
+    rv_emit_li(p, 6, TABLE_ADDR + OPS * 12);
+    size_t loop = p->len;
+    rv_emit32(p, rv_lw(12, 5, 0));
+    rv_emit32(p, rv_lw(13, 5, 4));
+    rv_emit32(p, rv_lw(14, 5, 8));
+    rv_emit32(p, rv_matmul(14, 12, 13));
+    rv_emit32(p, rv_addi(5, 5, 12));
+    rv_emit32(p, rv_bne(5, 6, (int32_t)loop - (int32_t)p->len));
+    rv_emit32(p, rv_addi(7, 7, -1));
+    rv_emit32(p, rv_bne(7, 0, (int32_t)outer - (int32_t)p->len));
+    rv_emit32(p, rv_ecall());
+}
+
+#ifdef __linux__
+static int dtlb_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// AnonHugePages of this process, in KiB
+static long anon_huge_kb(void) {
+    FILE *f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f) return -1;
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) break;
+    }
+    fclose(f);
+    return kb;
+}
+#endif
+
+int main(void) {
+    static rv_program_t program;
+    static const char *names[] = { "4K", "huge" };
+
+    build_program(&program);
+
+    printf("=== MATMUL Batch: Host Page Size ===\n");
+    printf("Guest RAM: %zu MiB, %d MATMULs x %d passes\n\n", MEMORY_SIZE >> 20, OPS, PASSES);
+    printf("%-6s %-10s %10s %16s %14s\n", "pages", "backing", "seconds", "dTLB misses", "huge KiB");
+
+    for (int h = 0; h < 2; h++) {
+        cpu_state_t *cpu = h ? init_cpu_huge(MEMORY_SIZE) : init_cpu(MEMORY_SIZE);
+        if (!cpu) return 1;
+
+        // Fault every page in up front so only steady-state TLB behaviour is timed
+        memset(cpu->memory, 0, cpu->memory_size);
+        build_table(cpu);
+        load_image(cpu, CODE_BASE, program.bytes, program.len);
+        cpu->pc = CODE_BASE;
+
+        long huge_kb = -1;
+        long long misses = -1;
+#ifdef __linux__
+        huge_kb = anon_huge_kb();
+        int fd = dtlb_open();
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+        clock_t start = clock();
+        riscv_run(cpu, UINT64_MAX);
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &misses, sizeof(misses)) != (ssize_t)sizeof(misses)) misses = -1;
+            close(fd);
+        }
+#endif
+
+        char miss_text[32], huge_text[32];
+        if (misses >= 0) snprintf(miss_text, sizeof(miss_text), "%lld", misses);
+        else snprintf(miss_text, sizeof(miss_text), "n/a");
+        if (huge_kb >= 0) snprintf(huge_text, sizeof(huge_text), "%ld", huge_kb);
+        else snprintf(huge_text, sizeof(huge_text), "n/a");
+
+        printf("%-6s %-10s %10.3f %16s %14s\n", names[h], host_pages_name(cpu->memory_pages),
+               seconds, miss_text, huge_text);
+        if (!cpu->halted) {
+            printf("ERROR: Batch did not finish\n");
+            free_cpu(cpu);
+            return 1;
+        }
+        free_cpu(cpu);
+    }
+
+    printf("\ndTLB misses read n/a when perf_event is not permitted\n");
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/timing.h"
+
+// Transpose-on-load benchmark
+// 1. Host cost of each MATMUL variant's kernel: the transpose is folded
+//    into the lane shuffles, so all four should run at the same speed.
+// 2. Guest cost of C = A * B^T over a batch: transposing B in guest code
+//    first (an extra load/store pass) versus a single matmul.tb.
+
+#define HOST_MATRICES 1024
+#define HOST_ROUNDS   20000
+#define BATCH         4096
+#define CODE_BASE     0x1000
+#define ADDR_A        0x10000
+#define ADDR_B        0x20000
+#define ADDR_T        0x30000
+#define ADDR_C        0x40000
+
+// x5 = pair counter, x12/x13/x14 = A/B/C cursors, x16 = scratch for B^T
+static void build_program(rv_program_t *p, bool explicit_transpose) {
+    p->len = 0;
+    rv_emit_li(p, 5, BATCH);
+    rv_emit_li(p, 12, ADDR_A);
+    rv_emit_li(p, 13, ADDR_B);
+    rv_emit_li(p, 14, ADDR_C);
+    rv_emit_li(p, 16, ADDR_T);
+    size_t loop = p->len;
+    if (explicit_transpose) {
+        rv_emit32(p, rv_lw(6, 13, 0));
+        rv_emit32(p, rv_lw(7, 13, 4));
+        rv_emit32(p, rv_lw(8, 13, 8));
+        rv_emit32(p, rv_lw(9, 13, 12));
+        rv_emit32(p, rv_sw(6, 16, 0));
+        rv_emit32(p, rv_sw(8, 16, 4));
+        rv_emit32(p, rv_sw(7, 16, 8));
+        rv_emit32(p, rv_sw(9, 16, 12));
+        rv_emit32(p, rv_matmul(14, 12, 16));
+    } else {
+        rv_emit32(p, rv_matmul_t(14, 12, 13, MATMUL_TRANSPOSE_B));
+    }
+    rv_emit32(p, rv_addi(12, 12, 16));
+    rv_emit32(p, rv_addi(13, 13, 16));
+    rv_emit32(p, rv_addi(14, 14, 16));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)loop - (int32_t)p->len));
+    rv_emit32(p, rv_ecall());
+}
+
+static double host_kernel(const matrix_2x2_t *m, int transpose, int32_t *sink) {
+    int32_t acc = 0;
+    clock_t start = clock();
+    for (int r = 0; r < HOST_ROUNDS; r++) {
+        for (int i = 0; i + 1 < HOST_MATRICES; i++) {
+            matrix_2x2_t c = matrix_multiply_2x2_transposed(m[i], m[i + 1], transpose);
+            acc += c.m[0][1];
+        }
+    }
+    *sink += acc;
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    return seconds * 1e9 / ((double)HOST_ROUNDS * (HOST_MATRICES - 1));
+}
+
+int main(void) {
+    static matrix_2x2_t host[HOST_MATRICES];
+    static const char *names[] = { "matmul", "matmul.ta", "matmul.tb", "matmul.tt" };
+    static rv_program_t program;
+    int32_t sink = 0;
+
+    for (int i = 0; i < HOST_MATRICES; i++) {
+        for (int e = 0; e < MATRIX_SIZE; e++) host[i].m[e / 2][e % 2] = i * 7 + e;
+    }
+
+    printf("=== Transpose-on-Load MATMUL ===\n\n");
+    printf("Host kernel (%d multiplies per variant)\n", HOST_ROUNDS * (HOST_MATRICES - 1));
+    for (int t = 0; t < 4; t++) {
+        printf("  %-10s %6.2f ns/op\n", names[t], host_kernel(host, t, &sink));
+    }
+
+    printf("\nGuest C = A * B^T over %d pairs\n", BATCH);
+    printf("  %-22s %10s %10s %8s\n", "method", "insns", "cycles", "CPI");
+    int32_t checksum[2];
+    for (int v = 0; v < 2; v++) {
+        cpu_state_t *cpu = init_cpu(512 * 1024);
+        if (!cpu || timing_attach(cpu, NULL) != RISCV_SUCCESS) return 1;
+        for (int i = 0; i < BATCH; i++) {
+            write_matrix_2x2(cpu, ADDR_A + (xlen_t)i * 16, host[i % HOST_MATRICES]);
+            write_matrix_2x2(cpu, ADDR_B + (xlen_t)i * 16, host[(i + 1) % HOST_MATRICES]);
+        }
+        build_program(&program, v == 0);
+        load_image(cpu, CODE_BASE, program.bytes, program.len);
+        cpu->pc = CODE_BASE;
+        riscv_run_timed(cpu, UINT64_MAX);
+
+        checksum[v] = 0;
+        for (int i = 0; i < BATCH; i++) checksum[v] += read_word(cpu, ADDR_C + (xlen_t)i * 16 + 4);
+        printf("  %-22s %10llu %10llu %8.2f\n", v == 0 ? "transpose + matmul" : "matmul.tb",
+               (unsigned long long)cpu->instret, (unsigned long long)cpu->timing->cycles,
+               (double)cpu->timing->cycles / (double)cpu->instret);
+        free_cpu(cpu);
+    }
+
+    if (checksum[0] != checksum[1]) {
+        printf("ERROR: Results differ\n");
+        return 1;
+    }
+    printf("\nResults match (sink %d)\n", sink);
+    return 0;
+}
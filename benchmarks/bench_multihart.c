@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/multihart.h"
+#include "../simulator/replay.h"
+
+// Parallel multi-hart timing benchmark
+// Every hart runs a MATMUL sweep over its own region while all of them
+// contend for the shared bus. Serial mode is the reference; the parallel
+// modes are run at several quanta and compared against it. Wall time is
+// measured with CLOCK_MONOTONIC since the threads run concurrently.
+// Finally a parallel run is recorded, saved, loaded and replayed.
+
+#define HARTS        8
+#define SWEEP_ITERS  20000
+#define REGION_BITS  21
+#define CODE_BASE    0x1000
+#define MEMORY_SIZE  ((size_t)(HARTS + 1) << REGION_BITS)
+#define LOG_PATH     "build/bench_multihart.rrlog"
+#define RR_QUANTUM   1000
+
+static void build_program(rv_program_t *p) {
+    p->len = 0;
+    rv_emit32(p, rv_addi(13, 10, 1));
+    rv_emit32(p, rv_slli(12, 13, REGION_BITS));
+    rv_emit_li(p, 5, SWEEP_ITERS);
+    size_t loop = p->len;
+    rv_emit32(p, rv_addi(14, 12, 16));
+    rv_emit32(p, rv_matmul(14, 12, 12));
+    rv_emit32(p, rv_lw(11, 14, 0));
+    rv_emit32(p, rv_mul(11, 11, 11));
+    rv_emit32(p, rv_add(15, 15, 11));
+    rv_emit32(p, rv_addi(12, 12, 64));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)loop - (int32_t)p->len));
+    rv_emit32(p, rv_ecall());
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int run(const rv_program_t *program, multihart_mode_t mode, uint64_t quantum,
+               rr_log_t *log, uint64_t *cycles, uint64_t *quanta, double *seconds) {
+    multihart_t *system = multihart_create(HARTS, MEMORY_SIZE, NULL);
+    if (!system) return RISCV_ERROR_MEMORY;
+    multihart_load_image(system, CODE_BASE, program->bytes, program->len);
+    for (int h = 0; h < HARTS; h++) system->cpu[h]->pc = CODE_BASE;
+    multihart_attach_log(system, log);
+
+    double start = now_seconds();
+    int status = multihart_run(system, mode, quantum, UINT64_MAX);
+    *seconds = now_seconds() - start;
+
+    for (int h = 0; h < HARTS; h++) {
+        cycles[h] = system->cpu[h]->timing->cycles;
+        if (!system->cpu[h]->halted) status = RISCV_ERROR_INSTRUCTION;
+    }
+    *quanta = system->quanta;
+    multihart_free(system);
+    return status;
+}
+
+int main(void) {
+    static rv_program_t program;
+    static const uint64_t quanta_sizes[] = { 10, 100, 1000, 10000 };
+    static const multihart_mode_t modes[] = { MULTIHART_PARALLEL, MULTIHART_DETERMINISTIC };
+    static const char *names[] = { "parallel", "determ." };
+    uint64_t serial[HARTS], cycles[HARTS], quanta;
+    double seconds;
+
+    build_program(&program);
+
+    printf("=== Multi-Hart Timing: Parallel vs Serial ===\n");
+    printf("%d harts x %d MATMUL sweep iterations on a shared bus\n\n", HARTS, SWEEP_ITERS);
+
+    if (run(&program, MULTIHART_SERIAL, 0, NULL, serial, &quanta, &seconds) != RISCV_SUCCESS) {
+        printf("ERROR: serial run failed\n");
+        return 1;
+    }
+    uint64_t serial_max = 0;
+    for (int h = 0; h < HARTS; h++) if (serial[h] > serial_max) serial_max = serial[h];
+
+    printf("%-10s %8s %10s %12s %12s %10s\n",
+           "mode", "quantum", "quanta", "max cycles", "max |err|", "seconds");
+    printf("%-10s %8s %10s %12llu %12s %10.3f\n", "serial", "-", "-",
+           (unsigned long long)serial_max, "-", seconds);
+
+    for (int m = 0; m < 2; m++) {
+        for (size_t q = 0; q < sizeof(quanta_sizes) / sizeof(quanta_sizes[0]); q++) {
+            if (run(&program, modes[m], quanta_sizes[q], NULL, cycles, &quanta, &seconds) !=
+                RISCV_SUCCESS) {
+                printf("ERROR: %s run failed\n", names[m]);
+                return 1;
+            }
+
+            uint64_t max_cycles = 0;
+            double worst = 0.0;
+            for (int h = 0; h < HARTS; h++) {
+                double error = ((double)cycles[h] - (double)serial[h]) / (double)serial[h];
+                if (error < 0) error = -error;
+                if (error > worst) worst = error;
+                if (cycles[h] > max_cycles) max_cycles = cycles[h];
+            }
+            printf("%-10s %8llu %10llu %12llu %11.3f%% %10.3f\n", names[m],
+                   (unsigned long long)quanta_sizes[q], (unsigned long long)quanta,
+                   (unsigned long long)max_cycles, 100.0 * worst, seconds);
+        }
+    }
+
+    // Record a scheduling-dependent run, then replay it from disk
+    uint64_t replayed[HARTS];
+    double replay_seconds;
+    rr_log_t *log = rr_create(HARTS);
+    if (!log) return 1;
+    if (run(&program, MULTIHART_PARALLEL, RR_QUANTUM, log, cycles, &quanta, &seconds) != RISCV_SUCCESS ||
+        rr_save(log, LOG_PATH) != RISCV_SUCCESS) {
+        rr_free(log);
+        return 1;
+    }
+    size_t log_bytes = rr_size(log);
+    rr_free(log);
+
+    log = rr_load(LOG_PATH);
+    if (!log) return 1;
+    int status = run(&program, MULTIHART_PARALLEL, RR_QUANTUM, log, replayed, &quanta,
+                     &replay_seconds);
+    bool exact = status == RISCV_SUCCESS && !rr_diverged(log) &&
+                 memcmp(cycles, replayed, sizeof(replayed)) == 0;
+    rr_free(log);
+
+    printf("\nRecord/replay (parallel, quantum %d): log %zu bytes\n", RR_QUANTUM, log_bytes);
+    printf("  record %.3f s, replay %.3f s, replay %s\n", seconds, replay_seconds,
+           exact ? "cycle-exact" : "DIVERGED");
+    return exact ? 0 : 1;
+}
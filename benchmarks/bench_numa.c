@@ -0,0 +1,124 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/multihart.h"
+
+// NUMA placement benchmark
+// Eight harts each sweep MATMULs over their own 4 MiB region in a parallel
+// run. Each policy is applied to a fresh system before the image is
+// loaded. Locality is the share of sampled region pages sitting on their
+// hart's node; on a single-node host every policy reads 100% but still
+// runs its placement path.
+
+#define HARTS        8
+#define SWEEP_ITERS  60000
+#define REGION_BITS  22
+#define CODE_BASE    0x1000
+#define MEMORY_SIZE  ((size_t)(HARTS + 1) << REGION_BITS)
+#define QUANTUM      10000
+#define SAMPLE_STEP  (64 * 1024)
+
+static void build_program(rv_program_t *p) {
+    p->len = 0;
+    rv_emit32(p, rv_addi(13, 10, 1));
+    rv_emit32(p, rv_slli(12, 13, REGION_BITS));
+    rv_emit_li(p, 5, SWEEP_ITERS);
+    size_t loop = p->len;
+    rv_emit32(p, rv_addi(14, 12, 16));
+    rv_emit32(p, rv_matmul(14, 12, 12));
+    rv_emit32(p, rv_lw(11, 14, 0));
+    rv_emit32(p, rv_add(15, 15, 11));
+    rv_emit32(p, rv_addi(12, 12, 64));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)loop - (int32_t)p->len));
+    rv_emit32(p, rv_ecall());
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Share of sampled region pages on their hart's node (-1 if unknown)
+static double locality(multihart_t *system) {
+    size_t local = 0, known = 0;
+    for (int h = 0; h < HARTS; h++) {
+        uint8_t *region = system->memory + ((size_t)(h + 1) << REGION_BITS);
+        for (size_t off = 0; off < ((size_t)1 << REGION_BITS); off += SAMPLE_STEP) {
+            int node = host_numa_node_of(region + off);
+            if (node < 0) continue;
+            known++;
+            local += (node == system->hart_node[h]);
+        }
+    }
+    return known ? (double)local / (double)known : -1.0;
+}
+
+int main(void) {
+    static rv_program_t program;
+    static const multihart_numa_policy_t policies[] = {
+        MULTIHART_NUMA_NONE, MULTIHART_NUMA_FIRST_TOUCH, MULTIHART_NUMA_BIND, MULTIHART_NUMA_INTERLEAVE
+    };
+    static const char *names[] = { "none", "first-touch", "bind", "interleave" };
+    uint64_t reference[HARTS];
+
+    build_program(&program);
+
+    host_numa_topology_t topo;
+    host_numa_topology(&topo);
+    printf("=== NUMA Placement ===\n");
+    printf("Host: %d node(s); %d harts x %d MiB regions, quantum %d\n\n",
+           topo.nodes, HARTS, 1 << (REGION_BITS - 20), QUANTUM);
+    printf("%-12s %10s %10s %12s\n", "policy", "seconds", "locality", "cycles");
+
+    for (int p = 0; p < 4; p++) {
+        multihart_t *system = multihart_create(HARTS, MEMORY_SIZE, NULL);
+        if (!system) return 1;
+        multihart_numa_t numa = { .policy = policies[p], .region_base = (xlen_t)1 << REGION_BITS,
+                                  .region_size = (size_t)1 << REGION_BITS };
+        if (multihart_set_numa(system, &numa) != RISCV_SUCCESS) {
+            multihart_free(system);
+            return 1;
+        }
+        multihart_load_image(system, CODE_BASE, program.bytes, program.len);
+        for (int h = 0; h < HARTS; h++) system->cpu[h]->pc = CODE_BASE;
+
+        double start = now_seconds();
+        int status = multihart_run(system, MULTIHART_DETERMINISTIC, QUANTUM, UINT64_MAX);
+        double seconds = now_seconds() - start;
+        double local = locality(system);
+
+        uint64_t cycles[HARTS];
+        for (int h = 0; h < HARTS; h++) {
+            cycles[h] = system->cpu[h]->timing->cycles;
+            if (!system->cpu[h]->halted) status = RISCV_ERROR_INSTRUCTION;
+        }
+        multihart_free(system);
+        if (status != RISCV_SUCCESS) {
+            printf("ERROR: %s run failed\n", names[p]);
+            return 1;
+        }
+        if (p == 0) memcpy(reference, cycles, sizeof(cycles));
+        if (memcmp(reference, cycles, sizeof(cycles)) != 0) {
+            printf("ERROR: %s changed simulated timing\n", names[p]);
+            return 1;
+        }
+
+        char local_text[16];
+        if (local >= 0.0) snprintf(local_text, sizeof(local_text), "%.0f%%", 100.0 * local);
+        else snprintf(local_text, sizeof(local_text), "n/a");
+        printf("%-12s %10.3f %10s %12llu\n", names[p], seconds, local_text,
+               (unsigned long long)cycles[0]);
+    }
+
+    printf("\nSimulated cycles are identical across policies; only host time moves\n");
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/timing.h"
+#include "../simulator/csr.h"
+
+// Requantization epilogue benchmark
+// int8 inference: every MATMUL result is scaled, shifted, offset and
+// clamped to [-128, 127]. A MATMUL batch followed by a separate
+// load/scale/clamp/store pass over the results is compared with the
+// epilogue configured once through CSRs. Inputs are small so the guest's
+// 32-bit products match the epilogue's 64-bit ones.
+
+#define TILES        1024
+#define BATCH        4096
+#define CODE_BASE    0x1000
+#define ADDR_A       0x10000
+#define ADDR_B       0x20000
+#define ADDR_C       0x30000
+#define MEMORY_SIZE  (512 * 1024)
+#define Q_SCALE      77
+#define Q_SHIFT      6
+#define Q_ZERO       3
+
+// x5 = counter, x12/x13/x14 = A/B/C cursors
+static void build_program(rv_program_t *p, bool fused) {
+    p->len = 0;
+    if (fused) {
+        rv_emit_li(p, 6, Q_SCALE);
+        rv_emit32(p, rv_csrrw(0, CSR_QSCALE, 6));
+        rv_emit32(p, rv_csrrwi(0, CSR_QSHIFT, Q_SHIFT));
+        rv_emit32(p, rv_csrrwi(0, CSR_QZERO, Q_ZERO));
+        rv_emit32(p, rv_csrrwi(0, CSR_QMODE, QUANT_MODE_INT8));
+    }
+    rv_emit_li(p, 5, BATCH);
+    rv_emit_li(p, 12, ADDR_A);
+    rv_emit_li(p, 13, ADDR_B);
+    rv_emit_li(p, 14, ADDR_C);
+    size_t loop = p->len;
+    rv_emit32(p, rv_matmul(14, 12, 13));
+    rv_emit32(p, rv_addi(12, 12, 16));
+    rv_emit32(p, rv_addi(13, 13, 16));
+    rv_emit32(p, rv_addi(14, 14, 16));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)loop - (int32_t)p->len));
+
+    if (!fused) {
+        // x9 = scale, x28/x29 = clamp bounds
+        rv_emit_li(p, 9, Q_SCALE);
+        rv_emit32(p, rv_addi(28, 0, -128));
+        rv_emit32(p, rv_addi(29, 0, 127));
+        rv_emit_li(p, 5, BATCH * MATRIX_SIZE);
+        rv_emit_li(p, 14, ADDR_C);
+        size_t pass = p->len;
+        rv_emit32(p, rv_lw(6, 14, 0));
+        rv_emit32(p, rv_mul(6, 6, 9));
+        rv_emit32(p, rv_addi(6, 6, 1 << (Q_SHIFT - 1)));
+        rv_emit32(p, rv_srai(6, 6, Q_SHIFT));
+        rv_emit32(p, rv_addi(6, 6, Q_ZERO));
+        rv_emit32(p, rv_bge(6, 28, 8));
+        rv_emit32(p, rv_addi(6, 28, 0));
+        rv_emit32(p, rv_bge(29, 6, 8));
+        rv_emit32(p, rv_addi(6, 29, 0));
+        rv_emit32(p, rv_sw(6, 14, 0));
+        rv_emit32(p, rv_addi(14, 14, 4));
+        rv_emit32(p, rv_addi(5, 5, -1));
+        rv_emit32(p, rv_bne(5, 0, (int32_t)pass - (int32_t)p->len));
+    }
+    rv_emit32(p, rv_ecall());
+}
+
+int main(void) {
+    static matrix_2x2_t host[TILES];
+    static rv_program_t program;
+
+    for (int i = 0; i < TILES; i++) {
+        for (int e = 0; e < MATRIX_SIZE; e++) host[i].m[e / 2][e % 2] = (i * 5 + e * 3) % 16 - 8;
+    }
+
+    printf("=== Requantization Epilogue ===\n");
+    printf("Batch of %d tiles, scale %d, shift %d, zero point %d\n\n", BATCH, Q_SCALE, Q_SHIFT, Q_ZERO);
+    printf("%-22s %10s %10s %8s\n", "method", "insns", "cycles", "misses");
+    int32_t checksum[2];
+    for (int v = 0; v < 2; v++) {
+        cpu_state_t *cpu = init_cpu(MEMORY_SIZE);
+        if (!cpu || timing_attach(cpu, NULL) != RISCV_SUCCESS) return 1;
+        for (int i = 0; i < BATCH; i++) {
+            write_matrix_2x2(cpu, ADDR_A + (xlen_t)i * 16, host[i % TILES]);
+            write_matrix_2x2(cpu, ADDR_B + (xlen_t)i * 16, host[(i + 1) % TILES]);
+        }
+        build_program(&program, v == 1);
+        load_image(cpu, CODE_BASE, program.bytes, program.len);
+        cpu->pc = CODE_BASE;
+        riscv_run_timed(cpu, UINT64_MAX);
+
+        checksum[v] = 0;
+        for (int i = 0; i < BATCH * MATRIX_SIZE; i++) {
+            checksum[v] += read_word(cpu, ADDR_C + (xlen_t)i * 4) * (i % 7 + 1);
+        }
+        printf("%-22s %10llu %10llu %8llu\n", v == 0 ? "matmul + guest pass" : "fused epilogue",
+               (unsigned long long)cpu->instret, (unsigned long long)cpu->timing->cycles,
+               (unsigned long long)cpu->timing->dcache_misses);
+        free_cpu(cpu);
+    }
+
+    if (checksum[0] != checksum[1]) {
+        printf("ERROR: Results differ\n");
+        return 1;
+    }
+    printf("\nResults match\n");
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+
+// Code density benchmark for the C extension
+// Builds the same unrolled batch-MATMUL kernel twice, once with plain 32-bit
+// encodings and once using 16-bit forms wherever a compiler would, then runs
+// both across predecode cache sizes. Compressed code packs more instructions
+// into each (pc >> 1)-indexed slot range, so it fits smaller caches.
+
+#define UNROLL       80
+#define OUTER_ITERS  2000
+#define ADDR_A       0x10000
+#define ADDR_C       0x20000
+#define CODE_BASE    0x1000
+
+static void emit_mv(rv_program_t *p, bool rvc, uint32_t rd, uint32_t rs) {
+    if (rvc) rv_emit16(p, rv_c_mv(rd, rs));
+    else rv_emit32(p, rv_add(rd, 0, rs));
+}
+
+static void emit_addi(rv_program_t *p, bool rvc, uint32_t rd, int32_t imm) {
+    if (rvc && imm >= -32 && imm < 32) rv_emit16(p, rv_c_addi(rd, imm));
+    else rv_emit32(p, rv_addi(rd, rd, imm));
+}
+
+static void emit_add(rv_program_t *p, bool rvc, uint32_t rd, uint32_t rs) {
+    if (rvc) rv_emit16(p, rv_c_add(rd, rs));
+    else rv_emit32(p, rv_add(rd, rd, rs));
+}
+
+static void emit_lw(rv_program_t *p, bool rvc, uint32_t rd, uint32_t rs1) {
+    if (rvc) rv_emit16(p, rv_c_lw(rd, rs1, 0));
+    else rv_emit32(p, rv_lw(rd, rs1, 0));
+}
+
+// x8 = A/B pairs, x9 = results, x15 = checksum, x16 = outer counter
+static void build_kernel(rv_program_t *p, bool rvc) {
+    p->len = 0;
+    rv_emit32(p, rv_addi(16, 0, OUTER_ITERS));
+    size_t outer = p->len;
+    rv_emit32(p, rv_lui(8, ADDR_A));
+    rv_emit32(p, rv_lui(9, ADDR_C));
+
+    for (int i = 0; i < UNROLL; i++) {
+        emit_mv(p, rvc, 12, 8);
+        emit_mv(p, rvc, 13, 8);
+        emit_addi(p, rvc, 13, 16);
+        emit_mv(p, rvc, 14, 9);
+        rv_emit32(p, rv_matmul(14, 12, 13));
+        emit_lw(p, rvc, 10, 14);
+        rv_emit32(p, rv_mul(11, 10, 10));
+        emit_add(p, rvc, 15, 11);
+        emit_addi(p, rvc, 8, 31);
+        emit_addi(p, rvc, 8, 1);
+        emit_addi(p, rvc, 9, 16);
+    }
+
+    emit_addi(p, rvc, 16, -1);
+    rv_emit32(p, rv_bne(16, 0, (int32_t)outer - (int32_t)p->len));
+    emit_mv(p, rvc, 10, 15);
+    rv_emit32(p, rv_ecall());
+}
+
+static void setup_matrices(cpu_state_t *cpu) {
+    for (int i = 0; i < UNROLL; i++) {
+        matrix_2x2_t a = {{{i, 1}, {2, i}}};
+        matrix_2x2_t b = {{{1, i}, {i, 3}}};
+        write_matrix_2x2(cpu, ADDR_A + (xlen_t)i * 32, a);
+        write_matrix_2x2(cpu, ADDR_A + (xlen_t)i * 32 + 16, b);
+    }
+}
+
+int main(void) {
+    static const size_t cache_sizes[] = { 256, 512, 1024, 2048, 4096 };
+    static rv_program_t programs[2];
+
+    printf("=== RVC Code Density vs Predecode Cache ===\n");
+    printf("Kernel: %d unrolled MATMUL iterations x %d passes\n\n", UNROLL, OUTER_ITERS);
+
+    build_kernel(&programs[0], false);
+    build_kernel(&programs[1], true);
+    printf("Code size: RV%dIM %zu bytes, RV%dIMC %zu bytes (%.1f%% smaller)\n\n",
+           XLEN, programs[0].len, XLEN, programs[1].len,
+           100.0 * (1.0 - (double)programs[1].len / (double)programs[0].len));
+
+    printf("%-8s %8s %12s %12s %10s %10s\n",
+           "ISA", "entries", "instret", "misses", "miss %", "ns/insn");
+
+    int checksum[2] = { 0, 0 };
+    for (int variant = 0; variant < 2; variant++) {
+        for (size_t s = 0; s < sizeof(cache_sizes) / sizeof(cache_sizes[0]); s++) {
+            cpu_state_t *cpu = init_cpu(256 * 1024);
+            if (!cpu) return 1;
+
+            setup_matrices(cpu);
+            predecode_configure(cpu, cache_sizes[s]);
+            load_image(cpu, CODE_BASE, programs[variant].bytes, programs[variant].len);
+            cpu->pc = CODE_BASE;
+
+            clock_t start = clock();
+            int status = riscv_run(cpu, UINT64_MAX);
+            double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+            if (status != RISCV_SUCCESS || !cpu->halted) {
+                printf("ERROR: kernel did not complete\n");
+                free_cpu(cpu);
+                return 1;
+            }
+
+            checksum[variant] = cpu->exit_code;
+            printf("%-8s %8zu %12llu %12llu %9.2f%% %10.2f\n",
+                   variant ? "IMC" : "IM", cache_sizes[s],
+                   (unsigned long long)cpu->instret,
+                   (unsigned long long)cpu->predecode->misses,
+                   100.0 * (double)cpu->predecode->misses / (double)cpu->instret,
+                   seconds * 1e9 / (double)cpu->instret);
+            free_cpu(cpu);
+        }
+    }
+
+    printf("\nChecksums %s (0x%08x)\n",
+           checksum[0] == checksum[1] ? "match" : "DIFFER", (unsigned)checksum[0]);
+    return checksum[0] == checksum[1] ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/server.h"
+
+// Simulator daemon load test
+// Small MATMUL jobs (PAIRS tile pairs each) submitted three ways:
+//   process  - fork + exec of build/matmul_simulator per job, the cost the
+//              daemon removes (the demo does less work than a job)
+//   cold     - in-process init_cpu + load_image + run + free_cpu per job
+//   daemon   - jobs over the Unix socket to warm pooled CPUs, from CLIENTS
+//              threads with DEPTH jobs in flight per connection
+// Usage: bench_server [socket]  - with a socket, load-test a running
+// matmul_server instead of starting one in process.
+
+#define PAIRS          8
+#define JOBS           20000
+#define PROCESS_JOBS   200
+#define MEMORY_SIZE    (1024 * 1024)
+#define SOCKET_PATH    "build/bench_server.sock"
+#define ADDR_CODE      0x1000
+#define ADDR_IN        0x2000
+#define ADDR_OUT       0x3000
+
+static rv_program_t program;
+static int32_t input[PAIRS * 2 * MATRIX_SIZE];
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void build_job(server_job_t *job) {
+    program.len = 0;
+    rv_emit32(&program, rv_addi(5, 11, 0));
+    size_t loop = program.len;
+    rv_emit32(&program, rv_addi(6, 10, MATRIX_BYTES));
+    rv_emit32(&program, rv_matmul(12, 10, 6));
+    rv_emit32(&program, rv_addi(10, 10, 2 * MATRIX_BYTES));
+    rv_emit32(&program, rv_addi(12, 12, MATRIX_BYTES));
+    rv_emit32(&program, rv_addi(5, 5, -1));
+    rv_emit32(&program, rv_bne(5, 0, (int32_t)loop - (int32_t)program.len));
+    rv_emit32(&program, rv_ecall());
+    for (size_t i = 0; i < sizeof(input) / sizeof(input[0]); i++) input[i] = (int32_t)(i % 7) - 3;
+
+    memset(job, 0, sizeof(*job));
+    job->magic = SERVER_JOB_MAGIC;
+    job->image_base = job->entry = ADDR_CODE;
+    job->image_len = (uint32_t)program.len;
+    job->max_instructions = 1000000;
+    job->input_base = job->args[0] = ADDR_IN;
+    job->args[1] = PAIRS;
+    job->output_base = job->args[2] = ADDR_OUT;
+    job->input_len = sizeof(input);
+    job->output_len = PAIRS * MATRIX_BYTES;
+}
+
+typedef struct {
+    const char *path;
+    const server_job_t *job;
+    int jobs;
+    int depth;
+    double *latency;            // per job, seconds
+    bool ok;
+} client_t;
+
+static void* run_client(void *arg) {
+    client_t *c = arg;
+    int fd = server_connect(c->path);
+    c->ok = fd >= 0;
+    double *sent_at = malloc(c->depth * sizeof(double));
+    uint8_t output[PAIRS * MATRIX_BYTES];
+    int sent = 0;
+    for (int done = 0; c->ok && done < c->jobs; done++) {
+        while (c->ok && sent < c->jobs && sent - done < c->depth) {
+            sent_at[sent % c->depth] = now_seconds();
+            c->ok = server_send_job(fd, c->job, program.bytes, input) == RISCV_SUCCESS;
+            sent++;
+        }
+        server_result_t result;
+        c->ok = c->ok && server_recv_result(fd, &result, output, sizeof(output)) == RISCV_SUCCESS &&
+                result.status == RISCV_SUCCESS && result.halted;
+        c->latency[done] = now_seconds() - sent_at[done % c->depth];
+    }
+    free(sent_at);
+    if (fd >= 0) close(fd);
+    return NULL;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void* serve_thread(void *arg) {
+    server_serve(arg);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    server_job_t job;
+    build_job(&job);
+    printf("=== Simulator Daemon Load Test ===\n");
+    printf("Jobs of %d MATMUL tile pairs, %zu-byte image\n\n", PAIRS, program.len);
+    printf("%-22s %10s %12s %10s %10s\n", "mode", "jobs", "jobs/s", "p50 us", "p99 us");
+
+    const char *path = argc > 1 ? argv[1] : SOCKET_PATH;
+    if (argc == 1) {
+        // Process per job
+        double start = now_seconds();
+        int spawned = 0;
+        for (; spawned < PROCESS_JOBS; spawned++) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                int null = open("/dev/null", O_WRONLY);
+                if (null >= 0) dup2(null, STDOUT_FILENO);
+                execl("build/matmul_simulator", "matmul_simulator", (char *)NULL);
+                _exit(127);
+            }
+            int status;
+            if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) break;
+        }
+        double seconds = now_seconds() - start;
+        if (spawned == PROCESS_JOBS) {
+            printf("%-22s %10d %12.0f %10.1f %10s\n", "process per job", spawned, spawned / seconds,
+                   seconds / spawned * 1e6, "-");
+        } else {
+            printf("%-22s (build/matmul_simulator not runnable, skipped)\n", "process per job");
+        }
+
+        // Cold CPU per job, in process
+        int32_t out[PAIRS * MATRIX_SIZE];
+        start = now_seconds();
+        for (int j = 0; j < JOBS; j++) {
+            cpu_state_t *cpu = init_cpu(MEMORY_SIZE);
+            if (!cpu) return 1;
+            load_image(cpu, ADDR_CODE, program.bytes, program.len);
+            load_image(cpu, ADDR_IN, input, sizeof(input));
+            for (int a = 0; a < 3; a++) cpu->regs[10 + a] = (xlen_t)job.args[a];
+            cpu->pc = ADDR_CODE;
+            riscv_run(cpu, job.max_instructions);
+            mem_read(cpu, ADDR_OUT, out, sizeof(out));
+            free_cpu(cpu);
+        }
+        seconds = now_seconds() - start;
+        printf("%-22s %10d %12.0f %10.1f %10s\n", "cold cpu per job", JOBS, JOBS / seconds,
+               seconds / JOBS * 1e6, "-");
+    }
+
+    sim_server_t *server = NULL;
+    pthread_t thread;
+    if (argc == 1) {
+        server_config_t config;
+        server_config_default(&config);
+        config.memory_size = MEMORY_SIZE;
+        server = server_create(&config);
+        if (!server || server_listen(server, path) != RISCV_SUCCESS) return 1;
+        pthread_create(&thread, NULL, serve_thread, server);
+    }
+
+    static const struct { int clients, depth; } loads[] = { {1, 1}, {1, 16}, {4, 1}, {4, 16} };
+    double *latency = malloc(JOBS * sizeof(double));
+    for (size_t l = 0; l < sizeof(loads) / sizeof(loads[0]); l++) {
+        int clients = loads[l].clients;
+        client_t c[4];
+        pthread_t threads[4];
+        double start = now_seconds();
+        for (int i = 0; i < clients; i++) {
+            c[i] = (client_t){ path, &job, JOBS / clients, loads[l].depth, latency + i * (JOBS / clients), false };
+            pthread_create(&threads[i], NULL, run_client, &c[i]);
+        }
+        bool ok = true;
+        for (int i = 0; i < clients; i++) {
+            pthread_join(threads[i], NULL);
+            ok &= c[i].ok;
+        }
+        double seconds = now_seconds() - start;
+        if (!ok) {
+            printf("ERROR: Job failed or connection lost\n");
+            return 1;
+        }
+        qsort(latency, JOBS, sizeof(double), compare_double);
+        char mode[32];
+        snprintf(mode, sizeof(mode), "daemon %dx, depth %d", clients, loads[l].depth);
+        printf("%-22s %10d %12.0f %10.1f %10.1f\n", mode, JOBS, JOBS / seconds,
+               latency[JOBS / 2] * 1e6, latency[JOBS * 99 / 100] * 1e6);
+    }
+    free(latency);
+
+    if (server) {
+        server_stop(server);
+        pthread_join(thread, NULL);
+        server_stats_t stats;
+        server_get_stats(server, &stats);
+        printf("\n%llu jobs in %llu batches, %llu image loads\n", (unsigned long long)stats.jobs,
+               (unsigned long long)stats.batches, (unsigned long long)stats.image_loads);
+        server_destroy(server);
+    }
+    return 0;
+}
@@ -0,0 +1,186 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/syscall.h"
+#include "../simulator/shm_ring.h"
+
+// Host-to-guest matrix stream benchmark
+// A host model produces PAIRS A/B tile pairs; the guest multiplies each.
+//   read()      - host writes pairs to a file, guest read()s each pair into
+//                 RAM through the proxy syscalls: two copies and one
+//                 syscall per pair
+//   ring        - host builds each pair in its slot of the shared region
+//                 and pushes a descriptor; one thread, the guest stops at
+//                 the empty marker for refills
+//   ring+thread - the same with the producer on its own host thread and
+//                 the guest spinning while the ring is empty
+// Wall time covers producing and consuming.
+
+#define PAIRS       1000000
+#define CAPACITY    256
+#define CODE_BASE   0x1000
+#define ADDR_PATH   0x2000
+#define ADDR_BUF    0x3000
+#define ADDR_C      0x3100
+#define RING_BASE   0x100000
+#define DATA_PATH   "build/bench_shm_ring.bin"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void make_pair(uint32_t i, matrix_2x2_t *a, matrix_2x2_t *b) {
+    for (int e = 0; e < MATRIX_SIZE; e++) {
+        a->m[e / 2][e % 2] = (int32_t)((i + e) % 17) - 8;
+        b->m[e / 2][e % 2] = (int32_t)((i * 3 + e) % 13) - 6;
+    }
+}
+
+static void emit_call(rv_program_t *p, int number) {
+    rv_emit_li(p, 17, number);
+    rv_emit32(p, rv_ecall());
+}
+
+// open the file, then PAIRS x { read 32 bytes into ADDR_BUF; MATMUL }
+static void build_read_consumer(rv_program_t *p) {
+    rv_emit_li(p, 10, ADDR_PATH);
+    rv_emit_li(p, 11, GUEST_O_RDONLY);
+    emit_call(p, SYS_OPEN);
+    rv_emit32(p, rv_addi(8, 10, 0));
+    rv_emit_li(p, 20, PAIRS);
+    rv_emit_li(p, 13, ADDR_C);
+    size_t loop = p->len;
+    rv_emit32(p, rv_addi(10, 8, 0));
+    rv_emit_li(p, 11, ADDR_BUF);
+    rv_emit32(p, rv_addi(12, 0, 2 * MATRIX_BYTES));
+    emit_call(p, SYS_READ);
+    rv_emit32(p, rv_addi(6, 11, MATRIX_BYTES));
+    rv_emit32(p, rv_matmul(13, 11, 6));
+    rv_emit32(p, rv_addi(20, 20, -1));
+    rv_emit32(p, rv_bne(20, 0, (int32_t)loop - (int32_t)p->len));
+    rv_emit32(p, rv_addi(10, 0, 0));
+    emit_call(p, SYS_EXIT);
+}
+
+typedef struct {
+    shm_ring_t *ring;
+    matrix_2x2_t *slots;            // CAPACITY x {A, B, C}
+    xlen_t slots_guest;
+    uint32_t produced;
+    uint32_t limit;
+} producer_t;
+
+// Fill every free slot and push it; returns how many were pushed
+static uint32_t produce(producer_t *p) {
+    uint32_t space = shm_ring_space(p->ring);
+    uint32_t n = 0;
+    for (; n < space && p->produced < p->limit; n++, p->produced++) {
+        uint32_t slot = p->ring->head & (CAPACITY - 1);
+        matrix_2x2_t *t = &p->slots[slot * 3];
+        make_pair(p->produced, &t[0], &t[1]);
+        xlen_t g = p->slots_guest + (xlen_t)slot * 3 * MATRIX_BYTES;
+        shm_ring_push(p->ring, g, g + MATRIX_BYTES, g + 2 * MATRIX_BYTES, p->produced);
+    }
+    return n;
+}
+
+static void* producer_thread(void *arg) {
+    producer_t *p = arg;
+    while (p->produced < p->limit) {
+        if (produce(p) == 0) sched_yield();
+    }
+    return NULL;
+}
+
+int main(void) {
+    static rv_program_t program;
+    matrix_2x2_t a, b, last_expected;
+    make_pair(PAIRS - 1, &a, &b);
+    last_expected = matrix_multiply_2x2(a, b);
+
+    printf("=== Host-to-Guest Matrix Stream ===\n");
+    printf("%d tile pairs, ring of %d\n\n", PAIRS, CAPACITY);
+    printf("%-12s %10s %12s %14s\n", "method", "ms", "pairs/s", "guest insns");
+
+    // read(): produce into a file, consume through proxy syscalls
+    double start = now_seconds();
+    FILE *f = fopen(DATA_PATH, "wb");
+    if (!f) return 1;
+    for (uint32_t i = 0; i < PAIRS; i++) {
+        make_pair(i, &a, &b);
+        fwrite(&a, sizeof(a), 1, f);
+        fwrite(&b, sizeof(b), 1, f);
+    }
+    fclose(f);
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    if (!cpu || syscall_attach(cpu, 0x8000, 0x8000) != RISCV_SUCCESS) return 1;
+    build_read_consumer(&program);
+    load_image(cpu, CODE_BASE, program.bytes, program.len);
+    load_image(cpu, ADDR_PATH, DATA_PATH, sizeof(DATA_PATH));
+    cpu->pc = CODE_BASE;
+    riscv_run(cpu, UINT64_MAX);
+    double seconds = now_seconds() - start;
+    matrix_2x2_t got = read_matrix_2x2(cpu, ADDR_C);
+    bool ok = cpu->halted && memcmp(&got, &last_expected, sizeof(got)) == 0;
+    printf("%-12s %10.1f %12.0f %14llu\n", "read()", seconds * 1e3, PAIRS / seconds,
+           (unsigned long long)cpu->instret);
+    free_cpu(cpu);
+    remove(DATA_PATH);
+    if (!ok) {
+        printf("ERROR: read() stream produced a wrong result\n");
+        return 1;
+    }
+
+    for (int threaded = 0; threaded < 2; threaded++) {
+        shm_ring_t *ring = shm_ring_create(64 * 1024, CAPACITY, RING_BASE);
+        cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+        if (!ring || !cpu || shm_ring_map(cpu, ring) != RISCV_SUCCESS) return 1;
+        producer_t producer = { ring, NULL, 0, 0, PAIRS };
+        producer.slots = shm_ring_alloc(ring, CAPACITY * 3 * MATRIX_BYTES, &producer.slots_guest);
+        if (!producer.slots) return 1;
+        program.len = 0;
+        shm_ring_emit_consumer(&program, ring, PAIRS);
+        load_image(cpu, CODE_BASE, program.bytes, program.len);
+        cpu->pc = CODE_BASE;
+
+        start = now_seconds();
+        if (threaded) {
+            pthread_t thread;
+            pthread_create(&thread, NULL, producer_thread, &producer);
+            while (!cpu->halted) riscv_run(cpu, UINT64_MAX);
+            pthread_join(thread, NULL);
+        } else {
+            cpu->stop_on_marker = true;
+            while (!cpu->halted) {
+                produce(&producer);
+                riscv_run(cpu, UINT64_MAX);
+            }
+        }
+        seconds = now_seconds() - start;
+
+        uint32_t slot = (PAIRS - 1) & (CAPACITY - 1);
+        ok = shm_ring_consumed(ring) == PAIRS &&
+             memcmp(&producer.slots[slot * 3 + 2], &last_expected, sizeof(last_expected)) == 0;
+        printf("%-12s %10.1f %12.0f %14llu\n", threaded ? "ring+thread" : "ring", seconds * 1e3,
+               PAIRS / seconds, (unsigned long long)cpu->instret);
+        free_cpu(cpu);
+        shm_ring_free(ring);
+        if (!ok) {
+            printf("ERROR: ring stream produced a wrong result\n");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/timing.h"
+#include "../simulator/sampling.h"
+
+// SimPoint sampling benchmark
+// A phased guest program (ALU loop, then a cache-missing MATMUL sweep,
+// repeated) is timed in full and then estimated from BBV-selected
+// simulation points. Reports host time and the cycle estimate error.
+
+#define ROUNDS       40
+#define ALU_ITERS    200000
+#define SWEEP_ITERS  30000
+#define SWEEP_BASE   0x10000
+#define CODE_BASE    0x1000
+#define MEMORY_SIZE  (4 * 1024 * 1024)
+
+static void build_program(rv_program_t *p) {
+    p->len = 0;
+    rv_emit32(p, rv_addi(20, 0, ROUNDS));
+    size_t round = p->len;
+    rv_emit_li(p, 5, ALU_ITERS);
+    rv_emit32(p, rv_addi(6, 6, 1));
+    rv_emit32(p, rv_mul(7, 6, 6));
+    rv_emit32(p, rv_add(8, 8, 7));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, -16));
+    rv_emit_li(p, 5, SWEEP_ITERS);
+    rv_emit32(p, rv_lui(12, SWEEP_BASE));
+    rv_emit32(p, rv_addi(14, 12, 16));
+    rv_emit32(p, rv_matmul(14, 12, 12));
+    rv_emit32(p, rv_lw(10, 14, 0));
+    rv_emit32(p, rv_add(15, 15, 10));
+    rv_emit32(p, rv_addi(12, 12, 64));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, -24));
+    rv_emit32(p, rv_addi(20, 20, -1));
+    rv_emit32(p, rv_bne(20, 0, (int32_t)round - (int32_t)p->len));
+    rv_emit32(p, rv_add(10, 8, 15));
+    rv_emit32(p, rv_ecall());
+}
+
+static cpu_state_t* setup_cpu(const rv_program_t *program) {
+    cpu_state_t *cpu = init_cpu(MEMORY_SIZE);
+    if (!cpu) return NULL;
+    if (timing_attach(cpu, NULL) != RISCV_SUCCESS) {
+        free_cpu(cpu);
+        return NULL;
+    }
+    load_image(cpu, CODE_BASE, program->bytes, program->len);
+    cpu->pc = CODE_BASE;
+    return cpu;
+}
+
+int main(void) {
+    static rv_program_t program;
+    build_program(&program);
+
+    printf("=== SimPoint Sampled Simulation ===\n");
+    printf("Program: %d rounds of %d ALU + %d MATMUL sweep iterations\n\n",
+           ROUNDS, ALU_ITERS, SWEEP_ITERS);
+
+    cpu_state_t *cpu = setup_cpu(&program);
+    if (!cpu) return 1;
+    clock_t start = clock();
+    int status = riscv_run_timed(cpu, UINT64_MAX);
+    double full_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    double full_cycles = (double)cpu->timing->cycles;
+    uint64_t total_insns = cpu->instret;
+    int exit_code = cpu->exit_code;
+    free_cpu(cpu);
+    if (status != RISCV_SUCCESS) return 1;
+
+    cpu = setup_cpu(&program);
+    if (!cpu) return 1;
+    simpoint_config_t config;
+    simpoint_result_t result;
+    simpoint_default_config(&config);
+    start = clock();
+    status = simpoint_run(cpu, &config, UINT64_MAX, &result);
+    double sampled_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    bool same_exit = cpu->exit_code == exit_code;
+    free_cpu(cpu);
+    if (status != RISCV_SUCCESS) return 1;
+
+    printf("%-10s %14s %14s %12s %10s\n", "run", "insns timed", "cycles", "CPI", "seconds");
+    printf("%-10s %14llu %14.0f %12.3f %10.3f\n", "full",
+           (unsigned long long)total_insns, full_cycles, full_cycles / (double)total_insns,
+           full_seconds);
+    printf("%-10s %14llu %14.0f %12.3f %10.3f\n", "simpoint",
+           (unsigned long long)result.detailed_insns, result.estimated_cycles,
+           result.estimated_cpi, sampled_seconds);
+
+    printf("\n%llu intervals, %d simulation points:\n",
+           (unsigned long long)result.intervals, result.count);
+    for (int p = 0; p < result.count; p++) {
+        printf("  interval %6llu  weight %.3f  CPI %.3f\n",
+               (unsigned long long)result.points[p].interval, result.points[p].weight,
+               (double)result.points[p].cycles / (double)result.points[p].insns);
+    }
+
+    printf("\nCycle estimate error: %+.2f%%, exit codes %s\n",
+           100.0 * (result.estimated_cycles - full_cycles) / full_cycles,
+           same_exit ? "match" : "DIFFER");
+    return same_exit ? 0 : 1;
+}
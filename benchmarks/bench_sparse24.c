@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/timing.h"
+#include "../simulator/sparse24.h"
+
+// 2:4 structured-sparsity benchmark
+// C (2x2) = A (2x4, two non-zeros per row) * B (4x2) over a batch.
+// 1. Host kernel: two dense 2x2 products plus an add versus the
+//    compressed kernel.
+// 2. Guest: A stored densely as two 2x2 tiles (two MATMULs, then the
+//    halves added in guest code) versus one matmul.sp on the 20-byte tile.
+
+#define HOST_TILES   1024
+#define HOST_ROUNDS  20000
+#define BATCH        4096
+#define CODE_BASE    0x1000
+#define ADDR_A       0x10000
+#define ADDR_B       0x30000
+#define ADDR_C       0x50000
+#define ADDR_TMP     0x70000
+#define MEMORY_SIZE  (1024 * 1024)
+
+static void dense_tile(int i, int32_t a[2][4]) {
+    memset(a, 0, 2 * 4 * sizeof(int32_t));
+    for (int r = 0; r < 2; r++) {
+        int c0 = (i + r) % 4, c1 = (i + r + 1 + (i >> 2) % 3) % 4;
+        a[r][c0] = (i * 7 + r) % 13 - 6;
+        a[r][c1] = (i * 5 + r) % 11 - 5;
+    }
+}
+
+static void b_tile(int i, int32_t b[4][2]) {
+    for (int e = 0; e < 8; e++) b[e / 2][e % 2] = (i * 3 + e) % 9 - 4;
+}
+
+static void split(const int32_t a[2][4], matrix_2x2_t *lo, matrix_2x2_t *hi) {
+    for (int r = 0; r < 2; r++) {
+        for (int c = 0; c < 2; c++) {
+            lo->m[r][c] = a[r][c];
+            hi->m[r][c] = a[r][c + 2];
+        }
+    }
+}
+
+// Dense: A tile i at ADDR_A + 32 * i is [A_lo | A_hi], B tile at ADDR_B + 32 * i
+// is [B_top | B_bottom]. Sparse: A tile at ADDR_A + 20 * i.
+// x5 = counter, x12/x13/x14 = A/B/C cursors, x15/x16 = scratch products
+static void build_program(rv_program_t *p, bool sparse) {
+    p->len = 0;
+    rv_emit_li(p, 5, BATCH);
+    rv_emit_li(p, 12, ADDR_A);
+    rv_emit_li(p, 13, ADDR_B);
+    rv_emit_li(p, 14, ADDR_C);
+    rv_emit_li(p, 15, ADDR_TMP);
+    rv_emit_li(p, 16, ADDR_TMP + 16);
+    size_t loop = p->len;
+    if (sparse) {
+        rv_emit32(p, rv_matmul_sp(14, 12, 13));
+        rv_emit32(p, rv_addi(12, 12, SPARSE24_TILE_BYTES));
+    } else {
+        rv_emit32(p, rv_matmul(15, 12, 13));
+        rv_emit32(p, rv_addi(12, 12, 16));
+        rv_emit32(p, rv_addi(13, 13, 16));
+        rv_emit32(p, rv_matmul(16, 12, 13));
+        rv_emit32(p, rv_addi(12, 12, 16));
+        rv_emit32(p, rv_addi(13, 13, -16));
+        for (int e = 0; e < 4; e++) {
+            rv_emit32(p, rv_lw(6, 15, 4 * e));
+            rv_emit32(p, rv_lw(7, 16, 4 * e));
+            rv_emit32(p, rv_add(6, 6, 7));
+            rv_emit32(p, rv_sw(6, 14, 4 * e));
+        }
+    }
+    rv_emit32(p, rv_addi(13, 13, (int32_t)SPARSE24_B_BYTES));
+    rv_emit32(p, rv_addi(14, 14, 16));
+    rv_emit32(p, rv_addi(5, 5, -1));
+    rv_emit32(p, rv_bne(5, 0, (int32_t)loop - (int32_t)p->len));
+    rv_emit32(p, rv_ecall());
+}
+
+int main(void) {
+    static int32_t a[HOST_TILES][2][4], b[HOST_TILES][4][2];
+    static sparse24_tile_t packed[HOST_TILES];
+    static matrix_2x2_t lo[HOST_TILES], hi[HOST_TILES], b_top[HOST_TILES], b_bot[HOST_TILES];
+    static rv_program_t program;
+    int32_t sink = 0;
+
+    for (int i = 0; i < HOST_TILES; i++) {
+        dense_tile(i, a[i]);
+        b_tile(i, b[i]);
+        if (sparse24_pack(a[i], &packed[i]) != RISCV_SUCCESS) return 1;
+        split(a[i], &lo[i], &hi[i]);
+        memcpy(&b_top[i], b[i][0], MATRIX_BYTES);
+        memcpy(&b_bot[i], b[i][2], MATRIX_BYTES);
+    }
+
+    printf("=== 2:4 Sparse MATMUL ===\n\n");
+    printf("Host kernel (%d tiles x %d rounds)\n", HOST_TILES, HOST_ROUNDS);
+    double ns[2];
+    for (int v = 0; v < 2; v++) {
+        int32_t acc = 0;
+        clock_t start = clock();
+        for (int r = 0; r < HOST_ROUNDS; r++) {
+            for (int i = 0; i < HOST_TILES; i++) {
+                matrix_2x2_t c;
+                if (v == 0) {
+                    matrix_2x2_t x = matrix_multiply_2x2(lo[i], b_top[i]);
+                    matrix_2x2_t y = matrix_multiply_2x2(hi[i], b_bot[i]);
+                    c.m[0][1] = x.m[0][1] + y.m[0][1];
+                    c.m[1][0] = x.m[1][0] + y.m[1][0];
+                } else {
+                    c = sparse24_multiply(&packed[i], b[i]);
+                }
+                acc += c.m[0][1] ^ c.m[1][0];
+            }
+        }
+        sink += acc;
+        ns[v] = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / ((double)HOST_ROUNDS * HOST_TILES);
+    }
+    printf("  %-8s %6.2f ns/op  16 MACs\n", "dense", ns[0]);
+    printf("  %-8s %6.2f ns/op   8 MACs\n", "sparse", ns[1]);
+
+    printf("\nGuest batch of %d tiles\n", BATCH);
+    printf("  %-8s %10s %10s %8s %8s\n", "method", "insns", "cycles", "misses", "A bytes");
+    int32_t checksum[2];
+    for (int v = 0; v < 2; v++) {
+        cpu_state_t *cpu = init_cpu(MEMORY_SIZE);
+        if (!cpu || timing_attach(cpu, NULL) != RISCV_SUCCESS) return 1;
+        for (int i = 0; i < BATCH; i++) {
+            int t = i % HOST_TILES;
+            load_image(cpu, ADDR_B + (xlen_t)i * SPARSE24_B_BYTES, b[t], SPARSE24_B_BYTES);
+            if (v == 0) {
+                write_matrix_2x2(cpu, ADDR_A + (xlen_t)i * 32, lo[t]);
+                write_matrix_2x2(cpu, ADDR_A + (xlen_t)i * 32 + 16, hi[t]);
+            } else {
+                load_image(cpu, ADDR_A + (xlen_t)i * SPARSE24_TILE_BYTES, &packed[t], SPARSE24_TILE_BYTES);
+            }
+        }
+        build_program(&program, v == 1);
+        load_image(cpu, CODE_BASE, program.bytes, program.len);
+        cpu->pc = CODE_BASE;
+        riscv_run_timed(cpu, UINT64_MAX);
+
+        checksum[v] = 0;
+        for (int i = 0; i < BATCH * 4; i++) checksum[v] += read_word(cpu, ADDR_C + (xlen_t)i * 4) * (i % 5 + 1);
+        printf("  %-8s %10llu %10llu %8llu %8d\n", v == 0 ? "dense" : "sparse",
+               (unsigned long long)cpu->instret, (unsigned long long)cpu->timing->cycles,
+               (unsigned long long)cpu->timing->dcache_misses, v == 0 ? 32 : SPARSE24_TILE_BYTES);
+        free_cpu(cpu);
+    }
+
+    if (checksum[0] != checksum[1]) {
+        printf("ERROR: Results differ\n");
+        return 1;
+    }
+    printf("\nResults match (sink %d)\n", sink);
+    return 0;
+}
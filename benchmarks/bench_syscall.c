@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/syscall.h"
+
+// Proxy syscall benchmark
+// 1. Output: a guest printing LINES short lines to a file, with the host
+//    write buffer versus writing each call straight through.
+// 2. Input: loading a DATA_BYTES matrix file into guest memory, either by
+//    the guest's read() landing directly in guest RAM or by the host
+//    reading into a bounce buffer and copying it in with load_image.
+
+#define LINES        20000
+#define LINE_BYTES   24
+#define DATA_BYTES   (16 * 1024 * 1024)
+#define CODE_BASE    0x1000
+#define ADDR_PATH    0x2000
+#define ADDR_LINE    0x3000
+#define ADDR_DATA    0x100000
+#define MEMORY_SIZE  (ADDR_DATA + DATA_BYTES)
+#define HEAP_BASE    0x10000
+#define OUT_PATH     "build/bench_syscall_out.txt"
+#define DATA_PATH    "build/bench_syscall_data.bin"
+
+static double now_seconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static void emit_call(rv_program_t *p, int number) {
+    rv_emit_li(p, 17, number);
+    rv_emit32(p, rv_ecall());
+}
+
+// open(path, flags); then either LINES writes of the line buffer or one
+// read of DATA_BYTES; close; exit
+static void build_program(rv_program_t *p, bool output) {
+    p->len = 0;
+    rv_emit_li(p, 10, ADDR_PATH);
+    rv_emit_li(p, 11, output ? GUEST_O_WRONLY | GUEST_O_CREAT | GUEST_O_TRUNC : GUEST_O_RDONLY);
+    rv_emit_li(p, 12, 0644);
+    emit_call(p, SYS_OPEN);
+    rv_emit32(p, rv_addi(8, 10, 0));
+    if (output) {
+        rv_emit_li(p, 5, LINES);
+        size_t loop = p->len;
+        rv_emit32(p, rv_addi(10, 8, 0));
+        rv_emit_li(p, 11, ADDR_LINE);
+        rv_emit32(p, rv_addi(12, 0, LINE_BYTES));
+        emit_call(p, SYS_WRITE);
+        rv_emit32(p, rv_addi(5, 5, -1));
+        rv_emit32(p, rv_bne(5, 0, (int32_t)loop - (int32_t)p->len));
+    } else {
+        rv_emit32(p, rv_addi(10, 8, 0));
+        rv_emit_li(p, 11, ADDR_DATA);
+        rv_emit_li(p, 12, DATA_BYTES);
+        emit_call(p, SYS_READ);
+        rv_emit32(p, rv_addi(9, 10, 0));
+    }
+    rv_emit32(p, rv_addi(10, 8, 0));
+    emit_call(p, SYS_CLOSE);
+    rv_emit32(p, rv_addi(10, 0, 0));
+    emit_call(p, SYS_EXIT);
+}
+
+static cpu_state_t* start_guest(rv_program_t *p, const char *path) {
+    cpu_state_t *cpu = init_cpu(MEMORY_SIZE);
+    if (!cpu || syscall_attach(cpu, HEAP_BASE, HEAP_BASE) != RISCV_SUCCESS) return NULL;
+    load_image(cpu, CODE_BASE, p->bytes, p->len);
+    load_image(cpu, ADDR_PATH, path, strlen(path) + 1);
+    load_image(cpu, ADDR_LINE, "matrix[12][34] = 56789\n\n", LINE_BYTES);
+    cpu->pc = CODE_BASE;
+    return cpu;
+}
+
+int main(void) {
+    static rv_program_t program;
+
+    printf("=== Proxy Syscalls ===\n\n");
+    printf("Guest output: %d writes of %d bytes\n", LINES, LINE_BYTES);
+    printf("  %-10s %12s %12s %12s\n", "mode", "host writes", "ms", "ns/call");
+    build_program(&program, true);
+    for (int v = 0; v < 2; v++) {
+        cpu_state_t *cpu = start_guest(&program, OUT_PATH);
+        if (!cpu) return 1;
+        if (v == 1) cpu->syscalls->out_capacity = 0;
+        double start = now_seconds();
+        riscv_run(cpu, UINT64_MAX);
+        syscall_flush(cpu->syscalls);
+        double seconds = now_seconds() - start;
+        uint64_t writes = cpu->syscalls->host_writes, bytes = cpu->syscalls->bytes_written;
+        bool ok = cpu->halted && bytes == (uint64_t)LINES * LINE_BYTES;
+        free_cpu(cpu);
+        if (!ok) {
+            printf("ERROR: Guest output incomplete\n");
+            return 1;
+        }
+        printf("  %-10s %12llu %12.2f %12.1f\n", v == 0 ? "buffered" : "direct",
+               (unsigned long long)writes, seconds * 1e3, seconds * 1e9 / LINES);
+    }
+    remove(OUT_PATH);
+
+    uint8_t *data = malloc(DATA_BYTES);
+    if (!data) return 1;
+    for (size_t i = 0; i < DATA_BYTES; i++) data[i] = (uint8_t)(i * 2654435761u >> 24);
+    FILE *f = fopen(DATA_PATH, "wb");
+    if (!f || fwrite(data, 1, DATA_BYTES, f) != DATA_BYTES) return 1;
+    fclose(f);
+
+    printf("\nInput: %d MiB file into guest memory (best of 3)\n", DATA_BYTES >> 20);
+    printf("  %-10s %12s %12s\n", "method", "ms", "GB/s");
+    build_program(&program, false);
+    for (int v = 0; v < 2; v++) {
+        double best = 1e9;
+        bool ok = true;
+        for (int round = 0; round < 3; round++) {
+            cpu_state_t *cpu = start_guest(&program, DATA_PATH);
+            if (!cpu) return 1;
+            uint8_t *bounce = v == 1 ? malloc(DATA_BYTES) : NULL;
+            double start = now_seconds();
+            if (v == 0) {
+                riscv_run(cpu, UINT64_MAX);
+                ok &= cpu->regs[9] == DATA_BYTES;
+            } else {
+                f = fopen(DATA_PATH, "rb");
+                ok &= f && bounce && fread(bounce, 1, DATA_BYTES, f) == DATA_BYTES;
+                if (f) fclose(f);
+                ok &= load_image(cpu, ADDR_DATA, bounce, DATA_BYTES) == RISCV_SUCCESS;
+            }
+            double seconds = now_seconds() - start;
+            if (seconds < best) best = seconds;
+            ok &= memcmp(cpu->memory + ADDR_DATA, data, DATA_BYTES) == 0;
+            free(bounce);
+            free_cpu(cpu);
+        }
+        if (!ok) {
+            printf("ERROR: Guest memory does not match the file\n");
+            return 1;
+        }
+        printf("  %-10s %12.2f %12.2f\n", v == 0 ? "pread" : "bounce", best * 1e3,
+               DATA_BYTES / best / 1e9);
+    }
+    remove(DATA_PATH);
+    free(data);
+    return 0;
+}
@@ -22,26 +22,42 @@ if errorlevel 1 (
 echo Found GCC compiler
 gcc --version | findstr "gcc"
 
+REM Simulator core sources (compiled once per XLEN)
+set CORE_SRCS=simulator\matmul_simulator.c simulator\sparse_memory.c simulator\interpreter.c simulator\lockstep.c simulator\timing.c simulator\checkpoint.c simulator\sampling.c simulator\multihart.c simulator\csr.c simulator\replay.c simulator\host_memory.c simulator\host_numa.c simulator\sparse24.c simulator\conv2d.c simulator\dma.c simulator\layout.c simulator\syscall.c simulator\file_map.c simulator\server.c simulator\shm_ring.c
+set CFLAGS=-Wall -Wextra -std=c99 -O2 -g -pthread
+
 REM Build simulator
 echo.
 echo Building simulator...
-gcc -Wall -Wextra -std=c99 -O2 -g -o build\matmul_simulator.exe simulator\matmul_simulator.c
+gcc %CFLAGS% -DXLEN=32 -o build\matmul_simulator.exe simulator\main.c %CORE_SRCS%
 if errorlevel 1 (
     echo ERROR: Failed to build simulator
     pause
     exit /b 1
 )
+gcc %CFLAGS% -DXLEN=64 -o build\matmul_simulator_rv64.exe simulator\main.c %CORE_SRCS%
+if errorlevel 1 (
+    echo ERROR: Failed to build RV64 simulator
+    pause
+    exit /b 1
+)
 echo ✓ Simulator built successfully
 
 REM Build test runner
 echo.
 echo Building test runner...
-gcc -Wall -Wextra -std=c99 -O2 -g -o build\test_runner.exe tests\test_matmul.c
+gcc %CFLAGS% -DXLEN=32 -o build\test_runner.exe tests\test_matmul.c %CORE_SRCS%
 if errorlevel 1 (
     echo ERROR: Failed to build test runner
     pause
     exit /b 1
 )
+gcc %CFLAGS% -DXLEN=64 -o build\test_runner_rv64.exe tests\test_matmul.c %CORE_SRCS%
+if errorlevel 1 (
+    echo ERROR: Failed to build RV64 test runner
+    pause
+    exit /b 1
+)
 echo ✓ Test runner built successfully
 
 echo.
@@ -77,6 +93,7 @@ goto end
 echo.
 echo === Running Test Suite ===
 build\test_runner.exe
+build\test_runner_rv64.exe
 goto end
 
 :translate
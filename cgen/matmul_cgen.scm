@@ -11,7 +11,7 @@
     ;; Read matrices from memory locations pointed by rs1 and rs2
     (set (mem SI rs1) (matrix-multiply-2x2 (mem SI rs1) (mem SI rs2)))
     ;; Store result at location pointed by rd
-    (set (mem SI rd) (get-temp-result)))
+    (set (mem SI rd) (epilogue (get-temp-result))))
   ())
 
 ;; Define the custom opcode
@@ -38,6 +38,35 @@
     (set rd    f-rd)
     (set opcode f-opcode)))
 
+;; Requantization epilogue applied to every element a matrix instruction
+;; writes when h-qmode is set: clamp(((acc * qscale + round) >> qshift) +
+;; qzero) to int8 (mode 1) or uint8 (mode 2), with the product formed in DI.
+(define-hardware (name h-qmode) (comment "Epilogue mode") (type register SI))
+(define-hardware (name h-qscale) (comment "Epilogue scale") (type register SI))
+(define-hardware (name h-qshift) (comment "Epilogue shift") (type register SI))
+(define-hardware (name h-qzero) (comment "Epilogue zero point") (type register SI))
+
+(define-pmacro (requantize acc)
+  (sequence SI ((DI x) (DI lo) (DI hi))
+    (set lo (if DI (eq h-qmode 2) 0 -128))
+    (set hi (if DI (eq h-qmode 2) 255 127))
+    (set x (add (sra (add (mul (ext DI acc) (ext DI h-qscale))
+                          (if DI (eq h-qshift 0) 0 (sll (const DI 1) (sub h-qshift 1))))
+                     h-qshift)
+                (ext DI h-qzero)))
+    (trunc SI (if DI (lt x lo) lo (if DI (gt x hi) hi x)))))
+
+(define-pmacro (epilogue acc)
+  (if SI (eq h-qmode 0) acc (requantize acc)))
+
+;; Tile row pitch for MATMUL operands: the second row of an A (B) tile is
+;; h-tilepitcha (h-tilepitchb) bytes after the first, 8 when the CSR is 0.
+(define-hardware (name h-tilepitcha) (comment "MATMUL A tile row pitch") (type register SI))
+(define-hardware (name h-tilepitchb) (comment "MATMUL B tile row pitch") (type register SI))
+
+(define-pmacro (tile-row1 addr pitch)
+  (add addr (if SI (eq pitch 0) 8 pitch)))
+
 ;; Define semantic functions
 (define-pmacro (matrix-multiply-2x2 addr-a addr-b)
   (sequence ((SI m00-a) (SI m01-a) (SI m10-a) (SI m11-a)
@@ -46,14 +75,14 @@
     ;; Load matrix A
     (set m00-a (mem SI addr-a))
     (set m01-a (mem SI (add addr-a 4)))
-    (set m10-a (mem SI (add addr-a 8))) 
-    (set m11-a (mem SI (add addr-a 12)))
+    (set m10-a (mem SI (tile-row1 addr-a h-tilepitcha)))
+    (set m11-a (mem SI (add (tile-row1 addr-a h-tilepitcha) 4)))
     
     ;; Load matrix B
     (set m00-b (mem SI addr-b))
     (set m01-b (mem SI (add addr-b 4)))
-    (set m10-b (mem SI (add addr-b 8)))
-    (set m11-b (mem SI (add addr-b 12)))
+    (set m10-b (mem SI (tile-row1 addr-b h-tilepitchb)))
+    (set m11-b (mem SI (add (tile-row1 addr-b h-tilepitchb) 4)))
     
     ;; Compute result matrix C = A * B
     (set c00 (add (mul m00-a m00-b) (mul m01-a m10-b)))
@@ -78,7 +107,7 @@
   (+ OP_CUSTOM_1 rd (f-func3 #b111) rs1 rs2 (f-func7 #b0000001))
   (sequence ()
     ;; Implementation will be generated by CGEN
-    (set rd (matrix-multiply-2x2 rs1 rs2)))
+    (set rd (epilogue (matrix-multiply-2x2 rs1 rs2))))
   ())
 
 ;; Define instruction attributes for optimization
@@ -86,3 +115,146 @@
   (list (cons 'MACH '(rv32i rv64i))
         (cons 'PIPE 'PIPE-MULT)
         (cons 'DELAY '3)))  ; 3-cycle matrix multiply
+
+;; Transpose-on-load variants: func7 bit 1 reads A transposed, bit 2 reads B
+;; transposed. Loads are the same as matmul, including the tile pitch; only
+;; the operand order changes.
+(define-pmacro (matrix-multiply-2x2-t addr-a addr-b ta tb)
+  (sequence ((SI a01) (SI a10) (SI b01) (SI b10))
+    ;; Off-diagonal elements swap places when an operand is transposed
+    (set a01 (if ta (mem SI (tile-row1 addr-a h-tilepitcha)) (mem SI (add addr-a 4))))
+    (set a10 (if ta (mem SI (add addr-a 4)) (mem SI (tile-row1 addr-a h-tilepitcha))))
+    (set b01 (if tb (mem SI (tile-row1 addr-b h-tilepitchb)) (mem SI (add addr-b 4))))
+    (set b10 (if tb (mem SI (add addr-b 4)) (mem SI (tile-row1 addr-b h-tilepitchb))))
+    (add (mul (mem SI addr-a) (mem SI addr-b)) (mul a01 b10))))
+
+(define-pmacro (define-matmul-t name func7 ta tb)
+  (define-insn-and-fmt name "Matrix multiply, transposed operands" f-r-type
+    (string-append name " $rd,$rs1,$rs2")
+    (+ OP_CUSTOM_1 rd (f-func3 #b111) rs1 rs2 (f-func7 func7))
+    (sequence ()
+      (set rd (epilogue (matrix-multiply-2x2-t rs1 rs2 ta tb))))
+    ()))
+
+(define-matmul-t "matmul.ta" #b0000011 1 0)
+(define-matmul-t "matmul.tb" #b0000101 0 1)
+(define-matmul-t "matmul.tt" #b0000111 1 1)
+
+(define-attr for-insn "matmul.ta" (list (cons 'MACH '(rv32i rv64i)) (cons 'PIPE 'PIPE-MULT) (cons 'DELAY '3)))
+(define-attr for-insn "matmul.tb" (list (cons 'MACH '(rv32i rv64i)) (cons 'PIPE 'PIPE-MULT) (cons 'DELAY '3)))
+(define-attr for-insn "matmul.tt" (list (cons 'MACH '(rv32i rv64i)) (cons 'PIPE 'PIPE-MULT) (cons 'DELAY '3)))
+
+;; Matrix-vector product: y (2 x SI at rd) = A (2x2 at rs1) * x (2 x SI at rs2)
+(define-pmacro (matrix-vector-2x2 addr-a addr-x addr-y)
+  (sequence ((SI x0) (SI x1))
+    (set x0 (mem SI addr-x))
+    (set x1 (mem SI (add addr-x 4)))
+    (set (mem SI addr-y)
+         (epilogue (add (mul (mem SI addr-a) x0) (mul (mem SI (add addr-a 4)) x1))))
+    (set (mem SI (add addr-y 4))
+         (epilogue (add (mul (mem SI (add addr-a 8)) x0) (mul (mem SI (add addr-a 12)) x1))))))
+
+(define-insn-and-fmt matvec "Matrix-vector multiply instruction" f-r-type
+  "matvec $rd,$rs1,$rs2"
+  (+ OP_CUSTOM_1 rd (f-func3 #b111) rs1 rs2 (f-func7 #b0001000))
+  (matrix-vector-2x2 rs1 rs2 rd)
+  ())
+
+(define-attr for-insn "matvec"
+  (list (cons 'MACH '(rv32i rv64i))
+        (cons 'PIPE 'PIPE-MULT)
+        (cons 'DELAY '2)))
+
+;; 2:4 sparse multiply: C (2x2 at rd) = A (compressed 2x4 at rs1) * B (4x2 at rs2)
+;; A holds two values per row then a metadata word of 2-bit column indices.
+(define-pmacro (sparse-col addr-a r k)
+  (and (srl (mem SI (add addr-a 16)) (add (mul r 4) (mul k 2))) 3))
+
+(define-pmacro (sparse-dot addr-a addr-b r j)
+  (add (mul (mem SI (add addr-a (mul r 8)))
+            (mem SI (add addr-b (add (mul (sparse-col addr-a r 0) 8) (mul j 4)))))
+       (mul (mem SI (add addr-a (add (mul r 8) 4)))
+            (mem SI (add addr-b (add (mul (sparse-col addr-a r 1) 8) (mul j 4)))))))
+
+(define-pmacro (matrix-multiply-sparse24 addr-a addr-b addr-c)
+  (sequence ((SI c00) (SI c01) (SI c10) (SI c11))
+    (set c00 (sparse-dot addr-a addr-b 0 0))
+    (set c01 (sparse-dot addr-a addr-b 0 1))
+    (set c10 (sparse-dot addr-a addr-b 1 0))
+    (set c11 (sparse-dot addr-a addr-b 1 1))
+    (set (mem SI addr-c) (epilogue c00))
+    (set (mem SI (add addr-c 4)) (epilogue c01))
+    (set (mem SI (add addr-c 8)) (epilogue c10))
+    (set (mem SI (add addr-c 12)) (epilogue c11))))
+
+(define-insn-and-fmt matmul.sp "2:4 sparse matrix multiply instruction" f-r-type
+  "matmul.sp $rd,$rs1,$rs2"
+  (+ OP_CUSTOM_1 rd (f-func3 #b111) rs1 rs2 (f-func7 #b0010000))
+  (matrix-multiply-sparse24 rs1 rs2 rd)
+  ())
+
+(define-attr for-insn "matmul.sp"
+  (list (cons 'MACH '(rv32i rv64i))
+        (cons 'PIPE 'PIPE-MULT)
+        (cons 'DELAY '3)))
+
+;; Direct 3x3 convolution: O (2x2 at rd) from the input window at rs1 and
+;; the 3x3 kernel at rs2. Row pitch and stride come from the convpitch and
+;; convstride CSRs, modelled here as hardware registers.
+(define-hardware (name h-convpitch) (comment "CONV2D input row pitch") (type register SI))
+(define-hardware (name h-convstride) (comment "CONV2D stride") (type register SI))
+
+(define-pmacro (conv-pitch)
+  (if SI (eq h-convpitch 0) (mul (add h-convstride 3) 4) h-convpitch))
+
+(define-pmacro (conv-tap addr-in addr-k r c i j)
+  (mul (mem SI (add addr-in (add (mul (add (mul r h-convstride) i) (conv-pitch))
+                                 (mul (add (mul c h-convstride) j) 4))))
+       (mem SI (add addr-k (add (mul i 12) (mul j 4))))))
+
+(define-pmacro (conv-out addr-in addr-k r c)
+  (add (add (add (conv-tap addr-in addr-k r c 0 0) (conv-tap addr-in addr-k r c 0 1))
+            (add (conv-tap addr-in addr-k r c 0 2) (conv-tap addr-in addr-k r c 1 0)))
+       (add (add (conv-tap addr-in addr-k r c 1 1) (conv-tap addr-in addr-k r c 1 2))
+            (add (add (conv-tap addr-in addr-k r c 2 0) (conv-tap addr-in addr-k r c 2 1))
+                 (conv-tap addr-in addr-k r c 2 2)))))
+
+(define-pmacro (conv2d-3x3 addr-in addr-k addr-out)
+  (sequence ((SI o00) (SI o01) (SI o10) (SI o11))
+    (set o00 (conv-out addr-in addr-k 0 0))
+    (set o01 (conv-out addr-in addr-k 0 1))
+    (set o10 (conv-out addr-in addr-k 1 0))
+    (set o11 (conv-out addr-in addr-k 1 1))
+    (set (mem SI addr-out) (epilogue o00))
+    (set (mem SI (add addr-out 4)) (epilogue o01))
+    (set (mem SI (add addr-out 8)) (epilogue o10))
+    (set (mem SI (add addr-out 12)) (epilogue o11))))
+
+(define-insn-and-fmt conv2d "3x3 convolution tile instruction" f-r-type
+  "conv2d $rd,$rs1,$rs2"
+  (+ OP_CUSTOM_1 rd (f-func3 #b111) rs1 rs2 (f-func7 #b0100000))
+  (conv2d-3x3 rs1 rs2 rd)
+  ())
+
+(define-attr for-insn "conv2d"
+  (list (cons 'MACH '(rv32i rv64i))
+        (cons 'PIPE 'PIPE-MULT)
+        (cons 'DELAY '5)))
+
+;; DMA engine: transfers are launched by writing the dmalen CSR and are
+;; modelled outside the instruction semantics; dma.fence blocks until the
+;; channel is idle.
+(define-hardware (name h-dmasrc) (comment "DMA source") (type register SI))
+(define-hardware (name h-dmadst) (comment "DMA destination") (type register SI))
+(define-hardware (name h-dmalen) (comment "DMA length, write launches") (type register SI))
+
+(define-insn-and-fmt dma.fence "Wait for outstanding DMA transfers" f-r-type
+  "dma.fence"
+  (+ OP_CUSTOM_1 (f-rd 0) (f-func3 #b111) (f-rs1 0) (f-rs2 0) (f-func7 #b1000000))
+  (c-call VOID "dma_wait_all")
+  ())
+
+(define-attr for-insn "dma.fence"
+  (list (cons 'MACH '(rv32i rv64i))
+        (cons 'PIPE 'PIPE-MULT)
+        (cons 'DELAY '1)))
@@ -0,0 +1,559 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/checkpoint.h"
+
+// CPython bindings for the simulator core
+// Guest memory and the register file are exported through the buffer
+// protocol, so memoryview(cpu), cpu.array(...) and cpu.regs are views of
+// the simulator's own storage: numpy.asarray() on any of them copies
+// nothing. run() and run_all() release the GIL while the guest executes, so
+// CPUs driven from different Python threads run in parallel.
+//
+// Writes through a view bypass guest_ptr, so the dirty tracking behind
+// riscv_cpu_reset is done at export time: every writable export marks its
+// range dirty, and reset() marks the ranges of views still alive again
+// afterwards. Code written through a view is only seen by the predecoder
+// after load() or reset(); load code with load().
+
+#if XLEN == 64
+#define MODULE_NAME "matmul_sim64"
+#define MODULE_INIT PyInit_matmul_sim64
+#define REG_FORMAT "Q"
+#else
+#define MODULE_NAME "matmul_sim"
+#define MODULE_INIT PyInit_matmul_sim
+#define REG_FORMAT "I"
+#endif
+
+static PyObject *SimulatorError;
+
+typedef struct {
+    PyObject_HEAD
+    cpu_state_t *cpu;
+    int running;                // run() in progress without the GIL
+    Py_ssize_t exports;         // live writable buffer exports
+    size_t export_lo;           // RAM range covered by writable exports
+    size_t export_hi;           // since the last reset with none alive
+} CpuObject;
+
+typedef struct {
+    PyObject_HEAD
+    CpuObject *owner;
+    char *data;
+    Py_ssize_t itemsize;
+    int ndim;
+    Py_ssize_t shape[2];
+    Py_ssize_t strides[2];
+    const char *format;
+    int readonly;
+    int tracked;                // counted in owner->exports
+} ArrayObject;
+
+static PyTypeObject CpuType;
+static PyTypeObject ArrayType;
+
+static int check_idle(CpuObject *self) {
+    if (self->running) {
+        PyErr_SetString(PyExc_RuntimeError, "CPU is running in another thread");
+        return -1;
+    }
+    return 0;
+}
+
+static int raise_status(int status) {
+    if (status == RISCV_SUCCESS) return 0;
+    PyErr_Format(SimulatorError, "simulator error %d", status);
+    return -1;
+}
+
+// Record a writable export of RAM [lo, hi) for reset()
+static void note_export(CpuObject *self, size_t lo, size_t hi) {
+    if (hi <= lo) return;
+    guest_ptr(self->cpu, (xlen_t)lo, hi - lo, true);
+    if (self->export_hi == 0) {
+        self->export_lo = lo;
+        self->export_hi = hi;
+    } else {
+        if (lo < self->export_lo) self->export_lo = lo;
+        if (hi > self->export_hi) self->export_hi = hi;
+    }
+    self->exports++;
+}
+
+static void release_export(CpuObject *self) {
+    self->exports--;
+}
+
+/* Cpu */
+
+static PyObject* Cpu_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = { "memory_size", NULL };
+    Py_ssize_t memory_size = DEFAULT_MEMORY_SIZE;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|n", kwlist, &memory_size)) return NULL;
+    if (memory_size <= 0) {
+        PyErr_SetString(PyExc_ValueError, "memory_size must be positive");
+        return NULL;
+    }
+    CpuObject *self = (CpuObject *)type->tp_alloc(type, 0);
+    if (!self) return NULL;
+    self->cpu = init_cpu((size_t)memory_size);
+    if (!self->cpu) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    return (PyObject *)self;
+}
+
+static void Cpu_dealloc(CpuObject *self) {
+    free_cpu(self->cpu);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+// Buffer protocol: the whole flat RAM as unsigned bytes
+static int Cpu_getbuffer(CpuObject *self, Py_buffer *view, int flags) {
+    if (PyBuffer_FillInfo(view, (PyObject *)self, self->cpu->memory,
+                          (Py_ssize_t)self->cpu->memory_size, 0, flags) != 0) {
+        return -1;
+    }
+    note_export(self, 0, self->cpu->memory_size);
+    return 0;
+}
+
+static void Cpu_releasebuffer(CpuObject *self, Py_buffer *view) {
+    (void)view;
+    release_export(self);
+}
+
+static PyBufferProcs Cpu_as_buffer = {
+    .bf_getbuffer = (getbufferproc)Cpu_getbuffer,
+    .bf_releasebuffer = (releasebufferproc)Cpu_releasebuffer,
+};
+
+static PyObject* Cpu_load(CpuObject *self, PyObject *args) {
+    unsigned long long addr;
+    Py_buffer data;
+    if (!PyArg_ParseTuple(args, "Ky*", &addr, &data)) return NULL;
+    int failed = check_idle(self) || raise_status(load_image(self->cpu, (xlen_t)addr, data.buf, (size_t)data.len));
+    PyBuffer_Release(&data);
+    if (failed) return NULL;
+    Py_RETURN_NONE;
+}
+
+static PyObject* Cpu_read(CpuObject *self, PyObject *args) {
+    unsigned long long addr;
+    Py_ssize_t size;
+    if (!PyArg_ParseTuple(args, "Kn", &addr, &size) || check_idle(self)) return NULL;
+    if (size < 0) {
+        PyErr_SetString(PyExc_ValueError, "negative size");
+        return NULL;
+    }
+    PyObject *bytes = PyBytes_FromStringAndSize(NULL, size);
+    if (!bytes) return NULL;
+    if (raise_status(mem_read(self->cpu, (xlen_t)addr, PyBytes_AS_STRING(bytes), (size_t)size))) {
+        Py_DECREF(bytes);
+        return NULL;
+    }
+    return bytes;
+}
+
+// cpu.array(addr, rows, cols=1, pitch=0, format="i"): zero-copy view of a
+// row-major matrix in RAM; pitch is the row stride in bytes (0 = packed)
+static PyObject* Cpu_array(CpuObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = { "addr", "rows", "cols", "pitch", "format", NULL };
+    unsigned long long addr;
+    Py_ssize_t rows, cols = 1, pitch = 0;
+    const char *format = "i";
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "Kn|nns", kwlist, &addr, &rows, &cols, &pitch, &format)) {
+        return NULL;
+    }
+
+    static const struct { const char *format; Py_ssize_t size; } formats[] = {
+        { "b", 1 }, { "B", 1 }, { "h", 2 }, { "H", 2 }, { "i", 4 }, { "I", 4 }, { "q", 8 }, { "Q", 8 },
+    };
+    Py_ssize_t itemsize = 0;
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (strcmp(format, formats[i].format) == 0) {
+            format = formats[i].format;
+            itemsize = formats[i].size;
+        }
+    }
+    if (itemsize == 0 || rows <= 0 || cols <= 0 || pitch < 0) {
+        PyErr_SetString(PyExc_ValueError, "bad format or shape");
+        return NULL;
+    }
+    if (pitch == 0) pitch = cols * itemsize;
+    if (pitch < cols * itemsize) {
+        PyErr_SetString(PyExc_ValueError, "pitch is smaller than a row");
+        return NULL;
+    }
+    size_t extent = (size_t)(rows - 1) * (size_t)pitch + (size_t)(cols * itemsize);
+    size_t memory_size = self->cpu->memory_size;
+    if (addr > memory_size || extent > memory_size - addr) {
+        PyErr_SetString(PyExc_IndexError, "view must lie inside guest RAM");
+        return NULL;
+    }
+
+    ArrayObject *array = PyObject_New(ArrayObject, &ArrayType);
+    if (!array) return NULL;
+    Py_INCREF(self);
+    array->owner = self;
+    array->data = (char *)self->cpu->memory + addr;
+    array->itemsize = itemsize;
+    array->format = format;
+    array->readonly = 0;
+    array->tracked = 1;
+    array->ndim = cols == 1 ? 1 : 2;
+    array->shape[0] = rows;
+    array->shape[1] = cols;
+    array->strides[0] = pitch;
+    array->strides[1] = itemsize;
+    note_export(self, (size_t)addr, (size_t)addr + extent);
+    return (PyObject *)array;
+}
+
+static PyObject* Cpu_run(CpuObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = { "max_instructions", NULL };
+    unsigned long long max = UINT64_MAX;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|K", kwlist, &max)) return NULL;
+    if (check_idle(self)) return NULL;
+
+    cpu_state_t *cpu = self->cpu;
+    uint64_t before = cpu->instret;
+    int status;
+    self->running = 1;
+    Py_BEGIN_ALLOW_THREADS
+    status = riscv_run(cpu, max);
+    Py_END_ALLOW_THREADS
+    self->running = 0;
+    if (raise_status(status)) return NULL;
+    return PyLong_FromUnsignedLongLong(cpu->instret - before);
+}
+
+static PyObject* Cpu_execute(CpuObject *self, PyObject *args) {
+    unsigned int insn;
+    if (!PyArg_ParseTuple(args, "I", &insn)) return NULL;
+    if (check_idle(self) || raise_status(execute_instruction(self->cpu, insn))) return NULL;
+    Py_RETURN_NONE;
+}
+
+static PyObject* Cpu_set_base(CpuObject *self, PyObject *unused) {
+    (void)unused;
+    if (check_idle(self) || raise_status(riscv_cpu_set_base(self->cpu))) return NULL;
+    // Pages written through live views since the snapshot must be restored
+    if (self->exports > 0) guest_ptr(self->cpu, (xlen_t)self->export_lo, self->export_hi - self->export_lo, true);
+    Py_RETURN_NONE;
+}
+
+static PyObject* Cpu_reset(CpuObject *self, PyObject *unused) {
+    (void)unused;
+    if (check_idle(self)) return NULL;
+    cpu_state_t *cpu = self->cpu;
+    if (self->export_hi > self->export_lo) {
+        guest_ptr(cpu, (xlen_t)self->export_lo, self->export_hi - self->export_lo, true);
+    }
+    int status = riscv_cpu_reset(cpu);
+    if (self->exports > 0) {
+        guest_ptr(cpu, (xlen_t)self->export_lo, self->export_hi - self->export_lo, true);
+    } else {
+        self->export_lo = self->export_hi = 0;
+    }
+    if (raise_status(status)) return NULL;
+    Py_RETURN_NONE;
+}
+
+static PyObject* Cpu_get_pc(CpuObject *self, void *closure) {
+    (void)closure;
+    return PyLong_FromUnsignedLongLong(self->cpu->pc);
+}
+
+static int Cpu_set_pc(CpuObject *self, PyObject *value, void *closure) {
+    (void)closure;
+    if (!value) {
+        PyErr_SetString(PyExc_AttributeError, "cannot delete pc");
+        return -1;
+    }
+    unsigned long long pc = PyLong_AsUnsignedLongLong(value);
+    if (PyErr_Occurred() || check_idle(self)) return -1;
+    self->cpu->pc = (xlen_t)pc;
+    return 0;
+}
+
+static PyObject* Cpu_get_regs(CpuObject *self, void *closure) {
+    (void)closure;
+    ArrayObject *array = PyObject_New(ArrayObject, &ArrayType);
+    if (!array) return NULL;
+    Py_INCREF(self);
+    array->owner = self;
+    array->data = (char *)self->cpu->regs;
+    array->itemsize = sizeof(xlen_t);
+    array->format = REG_FORMAT;
+    array->readonly = 0;
+    array->tracked = 0;
+    array->ndim = 1;
+    array->shape[0] = NUM_REGISTERS;
+    array->strides[0] = sizeof(xlen_t);
+    return (PyObject *)array;
+}
+
+static PyObject* Cpu_get_halted(CpuObject *self, void *closure) {
+    (void)closure;
+    return PyBool_FromLong(self->cpu->halted);
+}
+
+static int Cpu_set_halted(CpuObject *self, PyObject *value, void *closure) {
+    (void)closure;
+    int halted = value ? PyObject_IsTrue(value) : -1;
+    if (halted < 0 || check_idle(self)) {
+        if (!PyErr_Occurred()) PyErr_SetString(PyExc_AttributeError, "cannot delete halted");
+        return -1;
+    }
+    self->cpu->halted = halted;
+    return 0;
+}
+
+static PyObject* Cpu_get_exit_code(CpuObject *self, void *closure) {
+    (void)closure;
+    return PyLong_FromLong(self->cpu->exit_code);
+}
+
+static PyObject* Cpu_get_instret(CpuObject *self, void *closure) {
+    (void)closure;
+    return PyLong_FromUnsignedLongLong(self->cpu->instret);
+}
+
+static PyObject* Cpu_get_matrix_ops(CpuObject *self, void *closure) {
+    (void)closure;
+    return PyLong_FromUnsignedLongLong(self->cpu->hpm.matrix_ops);
+}
+
+static PyObject* Cpu_get_memory_size(CpuObject *self, void *closure) {
+    (void)closure;
+    return PyLong_FromSize_t(self->cpu->memory_size);
+}
+
+static PyMethodDef Cpu_methods[] = {
+    { "load", (PyCFunction)Cpu_load, METH_VARARGS,
+      "load(addr, data): copy a bytes-like image into guest memory" },
+    { "read", (PyCFunction)Cpu_read, METH_VARARGS,
+      "read(addr, size) -> bytes: copy guest memory out" },
+    { "array", (PyCFunction)(void (*)(void))Cpu_array, METH_VARARGS | METH_KEYWORDS,
+      "array(addr, rows, cols=1, pitch=0, format='i'): zero-copy view of guest RAM" },
+    { "run", (PyCFunction)(void (*)(void))Cpu_run, METH_VARARGS | METH_KEYWORDS,
+      "run(max_instructions=2**64-1) -> instructions executed; releases the GIL" },
+    { "execute", (PyCFunction)Cpu_execute, METH_VARARGS,
+      "execute(insn): execute one 32-bit instruction word" },
+    { "set_base", (PyCFunction)Cpu_set_base, METH_NOARGS,
+      "set_base(): take the current state as the reset image" },
+    { "reset", (PyCFunction)Cpu_reset, METH_NOARGS,
+      "reset(): return to the reset image" },
+    { NULL, NULL, 0, NULL }
+};
+
+static PyGetSetDef Cpu_getset[] = {
+    { "pc", (getter)Cpu_get_pc, (setter)Cpu_set_pc, "program counter", NULL },
+    { "regs", (getter)Cpu_get_regs, NULL, "zero-copy view of x0..x31 (do not write x0)", NULL },
+    { "halted", (getter)Cpu_get_halted, (setter)Cpu_set_halted, "guest executed ecall/ebreak", NULL },
+    { "exit_code", (getter)Cpu_get_exit_code, NULL, "a0 at ecall", NULL },
+    { "instret", (getter)Cpu_get_instret, NULL, "instructions retired", NULL },
+    { "matrix_ops", (getter)Cpu_get_matrix_ops, NULL, "matrix instructions retired", NULL },
+    { "memory_size", (getter)Cpu_get_memory_size, NULL, "bytes of flat RAM", NULL },
+    { NULL, NULL, NULL, NULL, NULL }
+};
+
+static PyTypeObject CpuType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = MODULE_NAME ".Cpu",
+    .tp_doc = "Cpu(memory_size=65536): an RV" Py_STRINGIFY(XLEN) " hart with the matrix extension",
+    .tp_basicsize = sizeof(CpuObject),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = Cpu_new,
+    .tp_dealloc = (destructor)Cpu_dealloc,
+    .tp_as_buffer = &Cpu_as_buffer,
+    .tp_methods = Cpu_methods,
+    .tp_getset = Cpu_getset,
+};
+
+/* GuestArray: strided view exported through the buffer protocol */
+
+static void Array_dealloc(ArrayObject *self) {
+    if (self->tracked) release_export(self->owner);
+    Py_DECREF(self->owner);
+    PyObject_Free(self);
+}
+
+static int Array_getbuffer(ArrayObject *self, Py_buffer *view, int flags) {
+    if ((flags & PyBUF_WRITABLE) && self->readonly) {
+        PyErr_SetString(PyExc_BufferError, "view is read-only");
+        view->obj = NULL;
+        return -1;
+    }
+    bool packed = self->strides[0] == self->itemsize * (self->ndim == 2 ? self->shape[1] : 1);
+    if (!packed && (flags & PyBUF_STRIDES) != PyBUF_STRIDES) {
+        PyErr_SetString(PyExc_BufferError, "pitched view needs a strided buffer");
+        view->obj = NULL;
+        return -1;
+    }
+    Py_INCREF(self);
+    view->obj = (PyObject *)self;
+    view->buf = self->data;
+    view->len = self->shape[0] * (self->ndim == 2 ? self->shape[1] : 1) * self->itemsize;
+    view->readonly = self->readonly;
+    view->itemsize = self->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? (char *)self->format : NULL;
+    view->ndim = self->ndim;
+    view->shape = (flags & PyBUF_ND) == PyBUF_ND ? self->shape : NULL;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? self->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+static PyBufferProcs Array_as_buffer = {
+    .bf_getbuffer = (getbufferproc)Array_getbuffer,
+};
+
+static PyObject* Array_tolist(ArrayObject *self, PyObject *unused) {
+    (void)unused;
+    PyObject *view = PyMemoryView_FromObject((PyObject *)self);
+    if (!view) return NULL;
+    PyObject *list = PyObject_CallMethod(view, "tolist", NULL);
+    Py_DECREF(view);
+    return list;
+}
+
+static PyObject* Array_get_shape(ArrayObject *self, void *closure) {
+    (void)closure;
+    return self->ndim == 2 ? Py_BuildValue("(nn)", self->shape[0], self->shape[1])
+                           : Py_BuildValue("(n)", self->shape[0]);
+}
+
+static PyMethodDef Array_methods[] = {
+    { "tolist", (PyCFunction)Array_tolist, METH_NOARGS, "copy the view into nested lists" },
+    { NULL, NULL, 0, NULL }
+};
+
+static PyGetSetDef Array_getset[] = {
+    { "shape", (getter)Array_get_shape, NULL, "view shape", NULL },
+    { NULL, NULL, NULL, NULL, NULL }
+};
+
+static PyTypeObject ArrayType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = MODULE_NAME ".GuestArray",
+    .tp_doc = "Zero-copy view of guest state; use memoryview() or numpy.asarray()",
+    .tp_basicsize = sizeof(ArrayObject),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor)Array_dealloc,
+    .tp_as_buffer = &Array_as_buffer,
+    .tp_methods = Array_methods,
+    .tp_getset = Array_getset,
+};
+
+/* run_all */
+
+typedef struct {
+    cpu_state_t *cpu;
+    uint64_t max;
+    int status;
+} run_job_t;
+
+static void* run_thread(void *arg) {
+    run_job_t *job = arg;
+    job->status = riscv_run(job->cpu, job->max);
+    return NULL;
+}
+
+// run_all(cpus, max_instructions): one host thread per CPU, GIL released
+static PyObject* module_run_all(PyObject *module, PyObject *args) {
+    (void)module;
+    PyObject *seq;
+    unsigned long long max = UINT64_MAX;
+    if (!PyArg_ParseTuple(args, "O|K", &seq, &max)) return NULL;
+    PyObject *fast = PySequence_Fast(seq, "run_all expects a sequence of Cpu");
+    if (!fast) return NULL;
+
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(fast);
+    run_job_t *jobs = PyMem_Calloc((size_t)n + 1, sizeof(run_job_t));
+    pthread_t *threads = PyMem_Calloc((size_t)n + 1, sizeof(pthread_t));
+    Py_ssize_t started = 0;
+    PyObject *result = NULL;
+    if (!jobs || !threads) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    for (Py_ssize_t i = 0; i < n; i++) {
+        PyObject *item = PySequence_Fast_GET_ITEM(fast, i);
+        if (!PyObject_TypeCheck(item, &CpuType)) {
+            PyErr_SetString(PyExc_TypeError, "run_all expects a sequence of Cpu");
+            goto done;
+        }
+        for (Py_ssize_t j = 0; j < i; j++) {
+            if (PySequence_Fast_GET_ITEM(fast, j) == item) {
+                PyErr_SetString(PyExc_ValueError, "the same Cpu appears twice");
+                goto done;
+            }
+        }
+        if (check_idle((CpuObject *)item)) goto done;
+        jobs[i].cpu = ((CpuObject *)item)->cpu;
+        jobs[i].max = max;
+    }
+
+    for (Py_ssize_t i = 0; i < n; i++) ((CpuObject *)PySequence_Fast_GET_ITEM(fast, i))->running = 1;
+    Py_BEGIN_ALLOW_THREADS
+    for (; started < n; started++) {
+        if (pthread_create(&threads[started], NULL, run_thread, &jobs[started]) != 0) break;
+    }
+    for (Py_ssize_t i = started; i < n; i++) run_thread(&jobs[i]);
+    for (Py_ssize_t i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    Py_END_ALLOW_THREADS
+    for (Py_ssize_t i = 0; i < n; i++) ((CpuObject *)PySequence_Fast_GET_ITEM(fast, i))->running = 0;
+
+    result = PyList_New(n);
+    for (Py_ssize_t i = 0; result && i < n; i++) PyList_SET_ITEM(result, i, PyLong_FromLong(jobs[i].status));
+
+done:
+    PyMem_Free(threads);
+    PyMem_Free(jobs);
+    Py_DECREF(fast);
+    return result;
+}
+
+static PyMethodDef module_methods[] = {
+    { "run_all", module_run_all, METH_VARARGS,
+      "run_all(cpus, max_instructions=2**64-1) -> [status]: run CPUs in parallel host threads" },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef module_def = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = MODULE_NAME,
+    .m_doc = "RISC-V matrix extension simulator (RV" Py_STRINGIFY(XLEN) ")",
+    .m_size = -1,
+    .m_methods = module_methods,
+};
+
+PyMODINIT_FUNC MODULE_INIT(void) {
+    if (PyType_Ready(&CpuType) < 0 || PyType_Ready(&ArrayType) < 0) return NULL;
+    PyObject *module = PyModule_Create(&module_def);
+    if (!module) return NULL;
+
+    SimulatorError = PyErr_NewException(MODULE_NAME ".SimulatorError", NULL, NULL);
+    Py_INCREF(&CpuType);
+    Py_INCREF(&ArrayType);
+    if (!SimulatorError || PyModule_AddObject(module, "Cpu", (PyObject *)&CpuType) < 0 ||
+        PyModule_AddObject(module, "GuestArray", (PyObject *)&ArrayType) < 0 ||
+        PyModule_AddObject(module, "SimulatorError", SimulatorError) < 0 ||
+        PyModule_AddIntConstant(module, "XLEN", XLEN) < 0 ||
+        PyModule_AddIntConstant(module, "MATRIX_BYTES", MATRIX_BYTES) < 0) {
+        Py_DECREF(module);
+        return NULL;
+    }
+    return module;
+}
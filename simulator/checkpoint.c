@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "riscv_matrix_ext.h"
+#include "sparse_memory.h"
+#include "interpreter.h"
+#include "timing.h"
+#include "checkpoint.h"
+#include "csr.h"
+#include "file_map.h"
+
+// Architectural checkpoints
+// A checkpoint is a deep copy: flat RAM is copied whole and every backed
+// sparse page is stored with its page number. Restoring zeroes sparse
+// pages the checkpoint does not know about, so memory matches exactly.
+// Copy-on-write file mappings contribute the pages the guest wrote since
+// their last reset; restoring maps the file again and copies those pages
+// back in.
+// The syscall proxy's break and open files are saved with syscall_save.
+//
+// Fast reset keeps one checkpoint as the CPU's base image. guest_ptr marks
+// each flat RAM page a write touches, so a reset copies back only those
+// pages. Sparse pages are not tracked individually: if any was written, all
+// of them are restored as in checkpoint_restore.
+
+static void count_page(uint64_t page_number, uint8_t *page, void *ctx) {
+    (void)page_number;
+    (void)page;
+    (*(size_t*)ctx)++;
+}
+
+static void copy_page(uint64_t page_number, uint8_t *page, void *ctx) {
+    riscv_checkpoint_t *ckpt = ctx;
+    ckpt->page_numbers[ckpt->page_count] = page_number;
+    memcpy(ckpt->pages + ckpt->page_count * SPARSE_PAGE_SIZE, page, SPARSE_PAGE_SIZE);
+    ckpt->page_count++;
+}
+
+static void count_mapped_page(xlen_t addr, const uint8_t *data, size_t len, void *ctx) {
+    (void)addr;
+    (void)data;
+    (void)len;
+    (*(size_t*)ctx)++;
+}
+
+static void copy_mapped_page(xlen_t addr, const uint8_t *data, size_t len, void *ctx) {
+    riscv_checkpoint_t *ckpt = ctx;
+    ckpt->mapped_addrs[ckpt->mapped_page_count] = addr;
+    memcpy(ckpt->mapped_pages + ckpt->mapped_page_count * FILE_MAP_ALIGN, data, len);
+    ckpt->mapped_page_count++;
+}
+
+static void clear_page(uint64_t page_number, uint8_t *page, void *ctx) {
+    (void)page_number;
+    (void)ctx;
+    memset(page, 0, SPARSE_PAGE_SIZE);
+}
+
+riscv_checkpoint_t* checkpoint_save(cpu_state_t *cpu) {
+    riscv_checkpoint_t *ckpt = calloc(1, sizeof(riscv_checkpoint_t));
+    if (!ckpt) return NULL;
+
+    memcpy(ckpt->regs, cpu->regs, sizeof(ckpt->regs));
+    ckpt->pc = cpu->pc;
+    ckpt->instret = cpu->instret;
+    ckpt->halted = cpu->halted;
+    ckpt->exit_code = cpu->exit_code;
+    ckpt->mcfg = cpu->mcfg;
+    ckpt->hpm = cpu->hpm;
+
+    ckpt->memory_size = cpu->memory_size;
+    ckpt->memory = malloc(cpu->memory_size);
+    if (!ckpt->memory) {
+        checkpoint_free(ckpt);
+        return NULL;
+    }
+    memcpy(ckpt->memory, cpu->memory, cpu->memory_size);
+
+    if (cpu->sparse) {
+        size_t pages = 0;
+        sparse_memory_foreach(cpu->sparse, count_page, &pages);
+        if (pages > 0) {
+            ckpt->page_numbers = malloc(pages * sizeof(uint64_t));
+            ckpt->pages = malloc(pages * SPARSE_PAGE_SIZE);
+            if (!ckpt->page_numbers || !ckpt->pages) {
+                checkpoint_free(ckpt);
+                return NULL;
+            }
+            sparse_memory_foreach(cpu->sparse, copy_page, ckpt);
+        }
+    }
+
+    if (cpu->mappings) {
+        size_t pages = 0;
+        file_map_foreach_modified(cpu, count_mapped_page, &pages);
+        if (pages > 0) {
+            ckpt->mapped_addrs = malloc(pages * sizeof(xlen_t));
+            ckpt->mapped_pages = calloc(pages, FILE_MAP_ALIGN);
+            if (!ckpt->mapped_addrs || !ckpt->mapped_pages) {
+                checkpoint_free(ckpt);
+                return NULL;
+            }
+            file_map_foreach_modified(cpu, copy_mapped_page, ckpt);
+        }
+    }
+
+    if (cpu->syscalls && !(ckpt->syscalls = syscall_save(cpu->syscalls))) {
+        checkpoint_free(ckpt);
+        return NULL;
+    }
+
+    return ckpt;
+}
+
+void checkpoint_free(riscv_checkpoint_t *ckpt) {
+    if (!ckpt) return;
+    free(ckpt->memory);
+    free(ckpt->page_numbers);
+    free(ckpt->pages);
+    free(ckpt->mapped_addrs);
+    free(ckpt->mapped_pages);
+    syscall_snapshot_free(ckpt->syscalls);
+    free(ckpt);
+}
+
+// Zero every backed sparse page, then copy in the checkpoint's pages
+static int restore_sparse(cpu_state_t *cpu, const riscv_checkpoint_t *ckpt) {
+    if (!cpu->sparse) return RISCV_SUCCESS;
+
+    sparse_memory_foreach(cpu->sparse, clear_page, NULL);
+    for (size_t i = 0; i < ckpt->page_count; i++) {
+        uint8_t *page = sparse_memory_page(cpu->sparse, ckpt->page_numbers[i], true);
+        if (!page) return RISCV_ERROR_MEMORY;
+        memcpy(page, ckpt->pages + i * SPARSE_PAGE_SIZE, SPARSE_PAGE_SIZE);
+    }
+    return RISCV_SUCCESS;
+}
+
+// Copy-on-write mapping holding the checkpoint page at addr, or NULL
+static file_mapping_t* cow_mapping(cpu_state_t *cpu, xlen_t addr) {
+    file_mapping_t *m = cpu->mappings ? file_map_find(cpu, addr, 1) : NULL;
+    if (!m || !m->writable || m->shared || (addr - m->base) % FILE_MAP_ALIGN != 0) {
+        printf("ERROR: Checkpoint has a file mapping page at 0x%" PRIxXLEN
+               " but CPU has no copy-on-write mapping there\n", addr);
+        return NULL;
+    }
+    return m;
+}
+
+// Drop guest writes to copy-on-write mappings, then copy in the
+// checkpoint's modified pages
+static int restore_mappings(cpu_state_t *cpu, const riscv_checkpoint_t *ckpt) {
+    if (cpu->mappings) file_map_reset(cpu);
+    for (size_t i = 0; i < ckpt->mapped_page_count; i++) {
+        xlen_t addr = ckpt->mapped_addrs[i];
+        file_mapping_t *m = cow_mapping(cpu, addr);
+        if (!m) return RISCV_ERROR_MEMORY;
+        size_t offset = (size_t)(addr - m->base);
+        size_t len = m->size - offset;
+        if (len > FILE_MAP_ALIGN) len = FILE_MAP_ALIGN;
+        memcpy(m->data + offset, ckpt->mapped_pages + i * FILE_MAP_ALIGN, len);
+        file_map_touch(m, offset, len);
+        predecode_invalidate(cpu, addr, len);
+    }
+    return RISCV_SUCCESS;
+}
+
+// Proxy state from the checkpoint; one taken before the proxy was attached
+// means a fresh proxy
+static int restore_syscalls(cpu_state_t *cpu, const riscv_checkpoint_t *ckpt) {
+    if (!cpu->syscalls) return RISCV_SUCCESS;
+    if (!ckpt->syscalls) {
+        syscall_reset(cpu->syscalls);
+        return RISCV_SUCCESS;
+    }
+    return syscall_restore(cpu->syscalls, ckpt->syscalls);
+}
+
+int checkpoint_restore(cpu_state_t *cpu, const riscv_checkpoint_t *ckpt) {
+    if (cpu->memory_size != ckpt->memory_size) {
+        printf("ERROR: Checkpoint memory size %zu does not match CPU (%zu)\n",
+               ckpt->memory_size, cpu->memory_size);
+        return RISCV_ERROR_BOUNDS;
+    }
+    if (ckpt->page_count > 0 && !cpu->sparse) {
+        printf("ERROR: Checkpoint has sparse pages but CPU has no sparse memory\n");
+        return RISCV_ERROR_MEMORY;
+    }
+    for (size_t i = 0; i < ckpt->mapped_page_count; i++) {
+        if (!cow_mapping(cpu, ckpt->mapped_addrs[i])) return RISCV_ERROR_MEMORY;
+    }
+
+    memcpy(cpu->regs, ckpt->regs, sizeof(cpu->regs));
+    cpu->pc = ckpt->pc;
+    cpu->instret = ckpt->instret;
+    cpu->halted = ckpt->halted;
+    cpu->exit_code = ckpt->exit_code;
+    cpu->mcfg = ckpt->mcfg;
+    cpu->hpm = ckpt->hpm;
+    memcpy(cpu->memory, ckpt->memory, ckpt->memory_size);
+
+    // Memory may now differ from the reset image anywhere
+    memset(cpu->dirty, 0xFF, RESET_DIRTY_WORDS(cpu->memory_size) * sizeof(uint64_t));
+    cpu->sparse_dirty = true;
+
+    int status = restore_sparse(cpu, ckpt);
+    if (status == RISCV_SUCCESS) status = restore_mappings(cpu, ckpt);
+    if (status == RISCV_SUCCESS) status = restore_syscalls(cpu, ckpt);
+    predecode_flush(cpu);
+    return status;
+}
+
+int riscv_cpu_set_base(cpu_state_t *cpu) {
+    riscv_checkpoint_t *base = checkpoint_save(cpu);
+    if (!base) {
+        printf("ERROR: Failed to save reset image\n");
+        return RISCV_ERROR_MEMORY;
+    }
+
+    checkpoint_free(cpu->base);
+    cpu->base = base;
+    memset(cpu->dirty, 0, RESET_DIRTY_WORDS(cpu->memory_size) * sizeof(uint64_t));
+    cpu->sparse_dirty = false;
+    return RISCV_SUCCESS;
+}
+
+int riscv_cpu_reset(cpu_state_t *cpu) {
+    static const riscv_checkpoint_t empty;
+    const riscv_checkpoint_t *base = cpu->base;
+    size_t words = RESET_DIRTY_WORDS(cpu->memory_size);
+
+    for (size_t w = 0; w < words; w++) {
+        uint64_t bits = cpu->dirty[w];
+        cpu->dirty[w] = 0;
+        while (bits) {
+            size_t page = w * 64 + (size_t)__builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            size_t offset = page << RESET_PAGE_BITS;
+            size_t len = cpu->memory_size - offset;
+            if (len > RESET_PAGE_SIZE) len = RESET_PAGE_SIZE;
+            if (base) {
+                memcpy(cpu->memory + offset, base->memory + offset, len);
+            } else {
+                memset(cpu->memory + offset, 0, len);
+            }
+            predecode_invalidate(cpu, (xlen_t)offset, len);
+        }
+    }
+
+    int status = RISCV_SUCCESS;
+    if (cpu->sparse_dirty) {
+        status = restore_sparse(cpu, base ? base : &empty);
+        predecode_flush(cpu);
+        cpu->sparse_dirty = false;
+    }
+    if (cpu->mappings) {
+        int mapped = restore_mappings(cpu, base ? base : &empty);
+        if (status == RISCV_SUCCESS) status = mapped;
+    }
+    int proxied = restore_syscalls(cpu, base ? base : &empty);
+    if (status == RISCV_SUCCESS) status = proxied;
+
+    if (base) {
+        memcpy(cpu->regs, base->regs, sizeof(cpu->regs));
+        cpu->pc = base->pc;
+        cpu->instret = base->instret;
+        cpu->halted = base->halted;
+        cpu->exit_code = base->exit_code;
+        cpu->mcfg = base->mcfg;
+        cpu->hpm = base->hpm;
+    } else {
+        memset(cpu->regs, 0, sizeof(cpu->regs));
+        cpu->pc = 0;
+        cpu->instret = 0;
+        cpu->halted = false;
+        cpu->exit_code = 0;
+        csr_config_reset(&cpu->mcfg);
+        memset(&cpu->hpm, 0, sizeof(cpu->hpm));
+    }
+    cpu->stop_requested = false;
+    cpu->last_marker = 0;
+    if (cpu->timing) timing_reset(cpu->timing);
+    return status;
+}
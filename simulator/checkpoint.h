@@ -0,0 +1,57 @@
+/**
+ * Architectural Checkpoints
+ * Snapshots of registers, pc, guest memory (flat RAM, sparse pages and
+ * the modified pages of copy-on-write file mappings) and proxy syscall
+ * state that can be restored into a CPU of the same memory size with the
+ * same mappings
+ */
+
+#ifndef RISCV_CHECKPOINT_H
+#define RISCV_CHECKPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv_matrix_ext.h"
+#include "syscall.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct riscv_checkpoint {
+    xlen_t regs[NUM_REGISTERS];
+    xlen_t pc;
+    uint64_t instret;
+    bool halted;
+    int exit_code;
+    matrix_config_t mcfg;
+    hpm_counters_t hpm;
+
+    uint8_t *memory;            // copy of flat RAM
+    size_t memory_size;
+
+    size_t page_count;          // sparse pages, SPARSE_PAGE_SIZE bytes each
+    uint64_t *page_numbers;
+    uint8_t *pages;
+
+    size_t mapped_page_count;   // copy-on-write mapping pages written since
+    xlen_t *mapped_addrs;       // their reset, FILE_MAP_ALIGN bytes each
+    uint8_t *mapped_pages;
+
+    syscall_snapshot_t *syscalls;   // proxy state, NULL without a proxy
+} riscv_checkpoint_t;
+
+riscv_checkpoint_t* checkpoint_save(cpu_state_t *cpu);
+void checkpoint_free(riscv_checkpoint_t *ckpt);
+
+// Restore architectural state. The predecode cache is flushed; the timing
+// model is not part of a checkpoint and is left to the caller.
+int checkpoint_restore(cpu_state_t *cpu, const riscv_checkpoint_t *ckpt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_CHECKPOINT_H */
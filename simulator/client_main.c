@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "riscv_matrix_ext.h"
+#include "server.h"
+
+// RISC-V Matrix Extension Simulator - job client
+// Submits one program image to a running matmul_server and prints the
+// result, statistics and (optionally) a range of guest memory as words.
+
+#define CLIENT_PIPELINE 16      // jobs in flight with -r
+
+static void usage(void) {
+    printf("Usage: matmul_client [options] image.bin\n");
+    printf("  -s socket       server socket (default %s)\n", SERVER_DEFAULT_SOCKET);
+    printf("  -b addr         image load address and entry point (default 0x1000)\n");
+    printf("  -n count        instruction budget (default 100000000)\n");
+    printf("  -a a0,a1,...    initial argument registers\n");
+    printf("  -i file@addr    write file into guest memory before the run\n");
+    printf("  -o addr:len     print len bytes of guest memory after the run\n");
+    printf("  -r count        submit the job count times, pipelined\n");
+}
+
+static uint8_t* read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        printf("ERROR: Cannot open %s\n", path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(size > 0 ? (size_t)size : 1);
+    if (size < 0 || !data || fread(data, 1, (size_t)size, f) != (size_t)size) {
+        printf("ERROR: Cannot read %s\n", path);
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *len = size > 0 ? (size_t)size : 0;
+    return data;
+}
+
+int main(int argc, char **argv) {
+    const char *path = SERVER_DEFAULT_SOCKET;
+    const char *image_path = NULL, *input_path = NULL;
+    unsigned long repeat = 1;
+    server_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.magic = SERVER_JOB_MAGIC;
+    job.image_base = job.entry = 0x1000;
+    job.max_instructions = 100000000;
+
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            image_path = argv[i];
+            continue;
+        }
+        if (i + 1 >= argc || strlen(argv[i]) != 2) {
+            usage();
+            return 1;
+        }
+        char *value = argv[++i], *end;
+        switch (argv[i - 1][1]) {
+        case 's': path = value; break;
+        case 'b': job.image_base = job.entry = strtoull(value, NULL, 0); break;
+        case 'n': job.max_instructions = strtoull(value, NULL, 0); break;
+        case 'r': repeat = strtoul(value, NULL, 0); break;
+        case 'a':
+            for (int a = 0; a < SERVER_JOB_ARGS && *value; a++) {
+                job.args[a] = strtoull(value, &end, 0);
+                value = *end == ',' ? end + 1 : end;
+            }
+            break;
+        case 'i': {
+            char *at = strchr(value, '@');
+            if (!at) {
+                usage();
+                return 1;
+            }
+            *at = '\0';
+            input_path = value;
+            job.input_base = strtoull(at + 1, NULL, 0);
+            break;
+        }
+        case 'o':
+            job.output_base = strtoull(value, &end, 0);
+            if (*end != ':') {
+                usage();
+                return 1;
+            }
+            job.output_len = (uint32_t)strtoul(end + 1, NULL, 0);
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+    if (!image_path || repeat == 0) {
+        usage();
+        return 1;
+    }
+
+    size_t image_len, input_len = 0;
+    uint8_t *image = read_file(image_path, &image_len);
+    uint8_t *input = input_path ? read_file(input_path, &input_len) : NULL;
+    uint8_t *output = malloc(job.output_len ? job.output_len : 1);
+    if (!image || (input_path && !input) || !output) return 1;
+    job.image_len = (uint32_t)image_len;
+    job.input_len = (uint32_t)input_len;
+
+    int fd = server_connect(path);
+    if (fd < 0) {
+        printf("ERROR: Cannot connect to %s\n", path);
+        return 1;
+    }
+    int exit_status = 0;
+    unsigned long sent = 0;
+    for (unsigned long r = 0; r < repeat; r++) {
+        while (sent < repeat && sent - r < CLIENT_PIPELINE) {
+            if (server_send_job(fd, &job, image, input) != RISCV_SUCCESS) {
+                printf("ERROR: Lost connection while submitting\n");
+                return 1;
+            }
+            sent++;
+        }
+        server_result_t result;
+        if (server_recv_result(fd, &result, output, job.output_len) != RISCV_SUCCESS) {
+            printf("ERROR: Lost connection while waiting for results\n");
+            return 1;
+        }
+        printf("job %lu: status %d, %s, exit %d, %llu instructions, %llu matrix ops, "
+               "%llu predecode misses, %.1f us, batch of %u\n",
+               r, result.status, result.halted ? "halted" : "budget exhausted", result.exit_code,
+               (unsigned long long)result.instret, (unsigned long long)result.matrix_ops,
+               (unsigned long long)result.predecode_misses, result.run_ns / 1e3, result.batch);
+        if (result.status != RISCV_SUCCESS || !result.halted) exit_status = 1;
+        if (r + 1 == repeat) {
+            printf("a0 = 0x%llx, a1 = 0x%llx\n",
+                   (unsigned long long)result.regs[10], (unsigned long long)result.regs[11]);
+            for (uint32_t off = 0; off + 4 <= result.output_len; off += 4) {
+                int32_t word;
+                memcpy(&word, output + off, sizeof(word));
+                if (off % 16 == 0) printf("%s0x%llx:", off ? "\n" : "", (unsigned long long)(job.output_base + off));
+                printf(" %d", word);
+            }
+            if (result.output_len >= 4) printf("\n");
+        }
+    }
+
+    close(fd);
+    free(output);
+    free(input);
+    free(image);
+    return exit_status;
+}
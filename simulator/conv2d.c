@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "riscv_matrix_ext.h"
+#include "conv2d.h"
+
+// Direct 3x3 convolution
+// The kernel is blocked over the whole 2x2 output tile: each weight is
+// broadcast once and multiplied against the four input samples it meets,
+//   C += [k k k k] * [w(i, j) w(i, j + s) w(i + s, j) w(i + s, j + s)]
+// so every weight is loaded once for the tile instead of once per output.
+// The input side is not deduplicated: each tap loads its four samples, 36
+// loads per tile, and taps that overlap reload the samples they share (a
+// stride-1 window has only 16 distinct elements).
+
+#if defined(__GNUC__) || defined(__clang__)
+typedef uint32_t conv_v4 __attribute__((vector_size(16)));
+#endif
+
+matrix_2x2_t conv2d_tile(const int32_t *window, size_t pitch, const int32_t kernel[CONV_K][CONV_K],
+                         int stride) {
+    matrix_2x2_t result;
+    size_t s = (size_t)stride;
+#if defined(__GNUC__) || defined(__clang__)
+    conv_v4 acc = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < CONV_K; i++) {
+        const int32_t *top = window + i * pitch;
+        const int32_t *bottom = top + s * pitch;
+        for (size_t j = 0; j < CONV_K; j++) {
+            uint32_t k = (uint32_t)kernel[i][j];
+            conv_v4 w = { (uint32_t)top[j], (uint32_t)top[j + s],
+                          (uint32_t)bottom[j], (uint32_t)bottom[j + s] };
+            acc += (conv_v4){ k, k, k, k } * w;
+        }
+    }
+    memcpy(&result, &acc, sizeof(result));
+#else
+    for (size_t r = 0; r < MATRIX_DIM; r++) {
+        for (size_t c = 0; c < MATRIX_DIM; c++) {
+            uint32_t sum = 0;
+            for (size_t i = 0; i < CONV_K; i++) {
+                for (size_t j = 0; j < CONV_K; j++) {
+                    sum += (uint32_t)window[(r * s + i) * pitch + c * s + j] * (uint32_t)kernel[i][j];
+                }
+            }
+            result.m[r][c] = (int32_t)sum;
+        }
+    }
+#endif
+    return result;
+}
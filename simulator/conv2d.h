@@ -0,0 +1,37 @@
+/**
+ * Direct 2D Convolution
+ * 3x3 convolution producing a 2x2 output tile straight from an input
+ * window in guest memory, with no im2col expansion
+ */
+
+#ifndef RISCV_CONV2D_H
+#define RISCV_CONV2D_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONV_K 3                            // kernel is CONV_K x CONV_K
+#define CONV_KERNEL_BYTES (CONV_K * CONV_K * sizeof(int32_t))
+#define CONV_MAX_STRIDE 2
+
+// Side of the input window a 2x2 output tile reads at a given stride
+#define CONV_WINDOW(stride) ((MATRIX_DIM - 1) * (stride) + CONV_K)
+#define CONV_MAX_WINDOW CONV_WINDOW(CONV_MAX_STRIDE)
+
+// out[r][c] = sum over i, j of window[(r * stride + i) * pitch + c * stride + j]
+// * kernel[i][j] (cross-correlation, as in CNN frameworks). pitch is the
+// window's row pitch in elements; arithmetic wraps like the rest of the ISA.
+matrix_2x2_t conv2d_tile(const int32_t *window, size_t pitch, const int32_t kernel[CONV_K][CONV_K],
+                         int stride);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_CONV2D_H */
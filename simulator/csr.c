@@ -0,0 +1,233 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "riscv_matrix_ext.h"
+#include "timing.h"
+#include "replay.h"
+#include "csr.h"
+#include "conv2d.h"
+#include "dma.h"
+
+// CSR file
+// cycle comes from the timing model when one is attached. Functional runs
+// have no cycle count, so cycle falls back to host nanoseconds and time is
+// always host wall-clock time. Both host readings are nondeterministic and
+// go through the record/replay log when one is attached.
+
+static uint64_t host_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t host_time(cpu_state_t *cpu, uint64_t live) {
+    return cpu->replay ? rr_value(cpu->replay, RR_EVENT_HOST_TIME, live) : live;
+}
+
+// Live value of counter n (numbered like the CSRs: 0 cycle, 1 time,
+// 2 instret, 3..6 hpmcounter), before any guest-written offset
+static uint64_t counter_source(cpu_state_t *cpu, uint32_t n) {
+    switch (n) {
+    case 0:
+        return cpu->timing ? cpu->timing->cycles : host_time(cpu, host_ns());
+    case 1:
+        return host_time(cpu, host_ns() / (1000000000ull / CSR_TIME_HZ));
+    case 2:
+        return cpu->instret;
+    case 3:
+        return cpu->hpm.matrix_ops;
+    case 4:
+        return cpu->hpm.matrix_load_bytes;
+    case 5:
+        return cpu->hpm.matrix_store_bytes;
+    default:
+        return cpu->hpm.stall_cycles;
+    }
+}
+
+// Counter number behind a counter CSR (either half, unprivileged or
+// machine alias), -1 for anything else. There is no mtime CSR, and the
+// upper halves only exist on RV32.
+static int counter_index(uint32_t csr) {
+    uint32_t n = csr & 0x1F;
+    uint32_t base = csr & ~0x9Fu;
+
+    if (n >= HPM_COUNTERS || (XLEN != 32 && (csr & 0x80))) return -1;
+    if (base == CSR_CYCLE || (base == CSR_MCYCLE && n != 1)) return (int)n;
+    return -1;
+}
+
+// hpmcounter7..31 and mhpmcounter7..31 (with their RV32 upper halves) and
+// mhpmevent7..31: the privileged spec requires them to exist, so they are
+// hard-wired to zero rather than trapping on guests that probe counters
+static bool counter_unimplemented(uint32_t csr) {
+    uint32_t n = csr & 0x1F;
+    uint32_t base = csr & ~0x9Fu;
+
+    if (csr >= CSR_MHPMEVENT3 + HPM_EVENTS && csr <= CSR_MHPMEVENT31) return true;
+    if (n < HPM_COUNTERS || (XLEN != 32 && (csr & 0x80))) return false;
+    return base == CSR_CYCLE || base == CSR_MCYCLE;
+}
+
+void csr_config_reset(matrix_config_t *mcfg) {
+    mcfg->conv_pitch = 0;
+    mcfg->conv_stride = 1;
+    mcfg->quant_mode = QUANT_MODE_OFF;
+    mcfg->quant_scale = 1;
+    mcfg->quant_shift = 0;
+    mcfg->quant_zero = 0;
+    mcfg->dma_src = 0;
+    mcfg->dma_dst = 0;
+    mcfg->dma_len = 0;
+    mcfg->tile_pitch_a = 0;
+    mcfg->tile_pitch_b = 0;
+}
+
+int csr_read(cpu_state_t *cpu, uint32_t csr, xlen_t *value) {
+    int n = counter_index(csr);
+    if (n >= 0) {
+        uint64_t counter = counter_source(cpu, (uint32_t)n) + cpu->hpm.offset[n];
+        *value = (csr & 0x80) ? (xlen_t)(counter >> 32) : (xlen_t)counter;
+        return RISCV_SUCCESS;
+    }
+    if (csr >= CSR_MHPMEVENT3 && csr < CSR_MHPMEVENT3 + HPM_EVENTS) {
+        *value = csr - CSR_MHPMEVENT3 + HPM_EVENT_MATRIX_OPS;
+        return RISCV_SUCCESS;
+    }
+    if (counter_unimplemented(csr)) {
+        *value = 0;
+        return RISCV_SUCCESS;
+    }
+
+    switch (csr) {
+    case CSR_CONVPITCH:
+        *value = cpu->mcfg.conv_pitch;
+        return RISCV_SUCCESS;
+    case CSR_CONVSTRIDE:
+        *value = cpu->mcfg.conv_stride;
+        return RISCV_SUCCESS;
+    case CSR_QMODE:
+        *value = cpu->mcfg.quant_mode;
+        return RISCV_SUCCESS;
+    case CSR_QSCALE:
+        *value = (xlen_t)(sxlen_t)cpu->mcfg.quant_scale;
+        return RISCV_SUCCESS;
+    case CSR_QSHIFT:
+        *value = cpu->mcfg.quant_shift;
+        return RISCV_SUCCESS;
+    case CSR_QZERO:
+        *value = (xlen_t)(sxlen_t)cpu->mcfg.quant_zero;
+        return RISCV_SUCCESS;
+    case CSR_DMASRC:
+        *value = cpu->mcfg.dma_src;
+        return RISCV_SUCCESS;
+    case CSR_DMADST:
+        *value = cpu->mcfg.dma_dst;
+        return RISCV_SUCCESS;
+    case CSR_DMALEN:
+        *value = cpu->mcfg.dma_len;
+        return RISCV_SUCCESS;
+    case CSR_TILEPITCHA:
+        *value = cpu->mcfg.tile_pitch_a;
+        return RISCV_SUCCESS;
+    case CSR_TILEPITCHB:
+        *value = cpu->mcfg.tile_pitch_b;
+        return RISCV_SUCCESS;
+    default:
+        printf("ERROR: Unknown CSR 0x%03x\n", csr);
+        return RISCV_ERROR_INSTRUCTION;
+    }
+}
+
+int csr_write(cpu_state_t *cpu, uint32_t csr, xlen_t value) {
+    // Machine counters keep counting from the written value; on RV32 each
+    // write replaces one half
+    int n = counter_index(csr);
+    if (n >= 0 && (csr >> 8) == (CSR_MCYCLE >> 8)) {
+        uint64_t live = counter_source(cpu, (uint32_t)n);
+        uint64_t counter = live + cpu->hpm.offset[n];
+        if (csr & 0x80) {
+            counter = (counter & 0xFFFFFFFFull) | ((uint64_t)value << 32);
+        } else if (XLEN == 32) {
+            counter = (counter & ~0xFFFFFFFFull) | (uint32_t)value;
+        } else {
+            counter = (uint64_t)value;
+        }
+        cpu->hpm.offset[n] = counter - live;
+        return RISCV_SUCCESS;
+    }
+    if (csr >= CSR_MHPMEVENT3 && csr < CSR_MHPMEVENT3 + HPM_EVENTS) return RISCV_SUCCESS;
+    if (counter_unimplemented(csr) && (csr >> 8) != (CSR_CYCLE >> 8)) return RISCV_SUCCESS;
+
+    switch (csr) {
+    case CSR_CONVPITCH:
+        if (value % sizeof(int32_t) != 0) {
+            printf("ERROR: convpitch 0x%" PRIxXLEN " is not word aligned\n", value);
+            return RISCV_ERROR_INSTRUCTION;
+        }
+        cpu->mcfg.conv_pitch = value;
+        return RISCV_SUCCESS;
+    case CSR_CONVSTRIDE:
+        if (value < 1 || value > CONV_MAX_STRIDE) {
+            printf("ERROR: convstride %" PRIuXLEN " unsupported (1..%d)\n", value, CONV_MAX_STRIDE);
+            return RISCV_ERROR_INSTRUCTION;
+        }
+        cpu->mcfg.conv_stride = (uint32_t)value;
+        return RISCV_SUCCESS;
+    case CSR_QMODE:
+        if (value > QUANT_MODE_UINT8) {
+            printf("ERROR: qmode %" PRIuXLEN " unsupported\n", value);
+            return RISCV_ERROR_INSTRUCTION;
+        }
+        cpu->mcfg.quant_mode = (uint32_t)value;
+        return RISCV_SUCCESS;
+    case CSR_QSCALE:
+        cpu->mcfg.quant_scale = (int32_t)value;
+        return RISCV_SUCCESS;
+    case CSR_QSHIFT:
+        if (value > QUANT_MAX_SHIFT) {
+            printf("ERROR: qshift %" PRIuXLEN " out of range (0..%d)\n", value, QUANT_MAX_SHIFT);
+            return RISCV_ERROR_INSTRUCTION;
+        }
+        cpu->mcfg.quant_shift = (uint32_t)value;
+        return RISCV_SUCCESS;
+    case CSR_QZERO:
+        cpu->mcfg.quant_zero = (int32_t)value;
+        return RISCV_SUCCESS;
+    case CSR_DMASRC:
+        cpu->mcfg.dma_src = value;
+        return RISCV_SUCCESS;
+    case CSR_DMADST:
+        cpu->mcfg.dma_dst = value;
+        return RISCV_SUCCESS;
+    case CSR_DMALEN:
+        if (dma_start(cpu, cpu->mcfg.dma_src, cpu->mcfg.dma_dst, value) != RISCV_SUCCESS) {
+            return RISCV_ERROR_INSTRUCTION;
+        }
+        cpu->mcfg.dma_len = value;
+        return RISCV_SUCCESS;
+    case CSR_TILEPITCHA:
+    case CSR_TILEPITCHB:
+        if (value % sizeof(int32_t) != 0) {
+            printf("ERROR: Tile pitch 0x%" PRIxXLEN " is not word aligned\n", value);
+            return RISCV_ERROR_INSTRUCTION;
+        }
+        if (csr == CSR_TILEPITCHA) cpu->mcfg.tile_pitch_a = value;
+        else cpu->mcfg.tile_pitch_b = value;
+        return RISCV_SUCCESS;
+    default:
+        break;
+    }
+
+    // csr[11:10] == 3 marks the read-only space
+    if ((csr >> 10) == 3) {
+        printf("ERROR: Write to read-only CSR 0x%03x\n", csr);
+    } else {
+        printf("ERROR: Unknown CSR 0x%03x\n", csr);
+    }
+    return RISCV_ERROR_INSTRUCTION;
+}
@@ -0,0 +1,74 @@
+/**
+ * Control and Status Registers
+ * Zicsr register file: the unprivileged and machine counters, including
+ * the matrix event counters, plus the matrix extension's configuration
+ * registers
+ */
+
+#ifndef RISCV_CSR_H
+#define RISCV_CSR_H
+
+#include <stdint.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Unprivileged counters (read-only)
+#define CSR_CYCLE     0xC00
+#define CSR_TIME      0xC01
+#define CSR_INSTRET   0xC02
+#define CSR_CYCLEH    0xC80
+#define CSR_TIMEH     0xC81
+#define CSR_INSTRETH  0xC82
+#define CSR_HPMCOUNTER3   0xC03     // read-only shadows of mhpmcounter3..6
+#define CSR_HPMCOUNTER3H  0xC83
+
+// Machine counters (read/write; the unprivileged counters read the same
+// values). mhpmcounterN counts event N - 2, reported by mhpmeventN.
+#define CSR_MCYCLE          0xB00
+#define CSR_MINSTRET        0xB02
+#define CSR_MHPMCOUNTER3    0xB03
+#define CSR_MCYCLEH         0xB80
+#define CSR_MINSTRETH       0xB82
+#define CSR_MHPMCOUNTER3H   0xB83
+#define CSR_MHPMEVENT3      0x323   // hard-wired event selectors (writes ignored)
+#define CSR_MHPMEVENT31     0x33F   // counters and events 7..31 read 0, writes ignored
+
+#define HPM_EVENT_MATRIX_OPS     1  // MATMUL, MATVEC, MATMUL.SP, CONV2D retired
+#define HPM_EVENT_MATRIX_LOADS   2  // operand bytes read by matrix instructions
+#define HPM_EVENT_MATRIX_STORES  3  // result bytes written by matrix instructions
+#define HPM_EVENT_STALL_CYCLES   4  // timing model stalls and matrix operand fills, 0 in functional runs
+#define HPM_EVENTS               4
+
+// Matrix extension configuration (custom read/write space)
+#define CSR_CONVPITCH   0x800   // CONV2D input row pitch in bytes, 0 = packed window
+#define CSR_CONVSTRIDE  0x801   // CONV2D stride, 1 or 2
+#define CSR_QMODE       0x802   // requantization epilogue, QUANT_MODE_*
+#define CSR_QSCALE      0x803   // epilogue multiplier (signed 32-bit)
+#define CSR_QSHIFT      0x804   // epilogue right shift, 0..62
+#define CSR_QZERO       0x805   // epilogue zero point (signed 32-bit)
+#define CSR_DMASRC      0x806   // DMA source address
+#define CSR_DMADST      0x807   // DMA destination address
+#define CSR_DMALEN      0x808   // DMA length in bytes; writing it launches the copy
+#define CSR_TILEPITCHA  0x809   // MATMUL A tile row pitch in bytes, 0 = packed
+#define CSR_TILEPITCHB  0x80A   // MATMUL B tile row pitch in bytes, 0 = packed
+
+// time ticks at 1 MHz of host wall-clock time
+#define CSR_TIME_HZ 1000000
+
+// Power-on values of the matrix configuration CSRs
+void csr_config_reset(matrix_config_t *mcfg);
+
+// Read/write a CSR. Unknown CSRs and writes to read-only CSRs return
+// RISCV_ERROR_INSTRUCTION (illegal instruction).
+int csr_read(cpu_state_t *cpu, uint32_t csr, xlen_t *value);
+int csr_write(cpu_state_t *cpu, uint32_t csr, xlen_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_CSR_H */
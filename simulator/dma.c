@@ -0,0 +1,38 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "riscv_matrix_ext.h"
+#include "dma.h"
+
+// DMA engine
+// Functionally a transfer is a memmove performed when it is launched, so
+// runs stay deterministic with no helper thread. Software must still fence
+// before reading the destination or reusing the source; the timing model
+// (timing.c) charges the transfer asynchronously and stalls dma.fence until
+// the modelled completion cycle.
+
+int dma_start(cpu_state_t *cpu, xlen_t src, xlen_t dst, xlen_t len) {
+    uint8_t chunk[DMA_CHUNK_BYTES];
+
+    if (len > DMA_MAX_BYTES) {
+        printf("ERROR: DMA length %" PRIuXLEN " exceeds %" PRIuXLEN " bytes\n", len, DMA_MAX_BYTES);
+        return RISCV_ERROR_BOUNDS;
+    }
+
+    // Copy backwards when the destination overlaps the tail of the source
+    bool backward = dst > src && dst - src < len;
+    xlen_t done = 0;
+    while (done < len) {
+        xlen_t n = len - done < DMA_CHUNK_BYTES ? len - done : DMA_CHUNK_BYTES;
+        xlen_t offset = backward ? len - done - n : done;
+        if (mem_read(cpu, src + offset, chunk, n) != RISCV_SUCCESS ||
+            mem_write(cpu, dst + offset, chunk, n) != RISCV_SUCCESS) {
+            printf("ERROR: DMA out of bounds: 0x%" PRIxXLEN " -> 0x%" PRIxXLEN " (%" PRIuXLEN " bytes)\n",
+                   src, dst, len);
+            return RISCV_ERROR_BOUNDS;
+        }
+        done += n;
+    }
+    return RISCV_SUCCESS;
+}
@@ -0,0 +1,31 @@
+/**
+ * DMA Engine
+ * Guest-programmed tile copies between memory regions, launched through
+ * CSRs and completed by the dma.fence instruction
+ */
+
+#ifndef RISCV_DMA_H
+#define RISCV_DMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DMA_MAX_BYTES ((xlen_t)1 << 20)     // largest single transfer
+#define DMA_CHUNK_BYTES 4096                // bounce-buffer size for the copy
+
+// Copy len bytes from src to dst with memmove semantics. Called when the
+// guest writes dmalen; the data lands immediately and the timing model
+// decides when the transfer would have completed.
+int dma_start(cpu_state_t *cpu, xlen_t src, xlen_t dst, xlen_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_DMA_H */
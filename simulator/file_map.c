@@ -0,0 +1,260 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "riscv_matrix_ext.h"
+#include "interpreter.h"
+#include "file_map.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define FILE_MAP_MMAP 1
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+// Memory-mapped files
+// A mapping is a private host mmap of the file, so startup cost does not
+// depend on the file size and the guest's loads are served by the host page
+// cache. Copy-on-write mappings are writable private mappings: the kernel
+// copies a page on the first guest store, and the file never changes. To
+// undo those stores on reset the range is mapped again in place
+// (MAP_FIXED), which drops the private copies. Shared mappings are
+// MAP_SHARED: guest stores reach the file (or memfd) and every other view
+// of it, and reset leaves them alone. Copy-on-write mappings keep a bitmap
+// of the pages written since the last reset, like flat RAM, so a checkpoint
+// costs the pages written rather than the size of the file. Hosts without mmap fall back to
+// reading the range into a heap buffer and cannot share.
+//
+// guest_ptr only consults mappings for addresses outside flat RAM, so the
+// RAM fast path is unchanged.
+
+static size_t host_page_size(void) {
+#ifdef FILE_MAP_MMAP
+    long page = sysconf(_SC_PAGESIZE);
+    return page > 0 ? (size_t)page : 4096;
+#else
+    return 4096;
+#endif
+}
+
+// (Re)create the host view of m->fd; an existing view is replaced in place
+static int map_range(file_mapping_t *m) {
+#ifdef FILE_MAP_MMAP
+    int prot = PROT_READ | (m->writable ? PROT_WRITE : 0);
+    int flags = (m->shared ? MAP_SHARED : MAP_PRIVATE) | (m->map ? MAP_FIXED : 0);
+    void *p = mmap(m->map, m->map_len, prot, flags, m->fd, (off_t)m->map_offset);
+    if (p == MAP_FAILED) return RISCV_ERROR_MEMORY;
+    m->map = p;
+    return RISCV_SUCCESS;
+#else
+    if (!m->map && !(m->map = malloc(m->map_len))) return RISCV_ERROR_MEMORY;
+    if (lseek(m->fd, (off_t)m->map_offset, SEEK_SET) < 0) return RISCV_ERROR_MEMORY;
+    size_t done = 0;
+    while (done < m->map_len) {
+        ssize_t n = read(m->fd, m->map + done, m->map_len - done);
+        if (n <= 0) return RISCV_ERROR_MEMORY;
+        done += (size_t)n;
+    }
+    return RISCV_SUCCESS;
+#endif
+}
+
+static void release(file_mapping_t *m) {
+#ifdef FILE_MAP_MMAP
+    if (m->map) munmap(m->map, m->map_len);
+#else
+    free(m->map);
+#endif
+    if (m->fd >= 0) close(m->fd);
+    free(m->written);
+    free(m);
+}
+
+file_mapping_t* file_map_find(cpu_state_t *cpu, xlen_t addr, size_t size) {
+    for (file_mapping_t *m = cpu->mappings; m; m = m->next) {
+        xlen_t offset = addr - m->base;
+        if (offset < m->size && size <= m->size - offset) return m;
+    }
+    return NULL;
+}
+
+// Validate and install a mapping of fd, which the mapping takes ownership
+// of; name is only used in messages
+static int map_fd(cpu_state_t *cpu, xlen_t base, int fd, const char *name, uint64_t offset, size_t size, int mode) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        printf("ERROR: Cannot open %s for mapping\n", name);
+        close(fd);
+        return RISCV_ERROR_MEMORY;
+    }
+#ifndef FILE_MAP_MMAP
+    if (mode & FILE_MAP_SHARED) {
+        printf("ERROR: Shared mappings need mmap, not available on this host\n");
+        close(fd);
+        return RISCV_ERROR_MEMORY;
+    }
+#endif
+    uint64_t file_size = (uint64_t)st.st_size;
+    if (size == 0 && offset < file_size) size = (size_t)(file_size - offset);
+    if (size == 0 || offset > file_size || size > file_size - offset) {
+        printf("ERROR: Mapping %zu bytes at offset %llu exceeds %s (%llu bytes)\n",
+               size, (unsigned long long)offset, name, (unsigned long long)file_size);
+        close(fd);
+        return RISCV_ERROR_BOUNDS;
+    }
+
+    // Last guest byte must fit in XLEN and not fall inside another mapping
+    xlen_t last = base + (xlen_t)(size - 1);
+    if ((uint64_t)size - 1 > (uint64_t)(~(xlen_t)0 - base)) {
+        printf("ERROR: File mapping of %zu bytes does not fit above 0x%" PRIxXLEN "\n", size, base);
+        close(fd);
+        return RISCV_ERROR_BOUNDS;
+    }
+    for (file_mapping_t *m = cpu->mappings; m; m = m->next) {
+        if (base <= m->base + (xlen_t)(m->size - 1) && m->base <= last) {
+            printf("ERROR: File mapping at 0x%" PRIxXLEN " overlaps the mapping at 0x%" PRIxXLEN "\n",
+                   base, m->base);
+            close(fd);
+            return RISCV_ERROR_BOUNDS;
+        }
+    }
+
+    file_mapping_t *m = calloc(1, sizeof(file_mapping_t));
+    if (!m) {
+        close(fd);
+        return RISCV_ERROR_MEMORY;
+    }
+    // mmap offsets must be host-page aligned
+    m->map_offset = offset & ~(uint64_t)(host_page_size() - 1);
+    m->map_len = size + (size_t)(offset - m->map_offset);
+    m->fd = fd;
+    m->base = base;
+    m->size = size;
+    m->shared = (mode & FILE_MAP_SHARED) != 0;
+    m->writable = m->shared || (mode & FILE_MAP_COPY_ON_WRITE) != 0;
+    if (m->writable && !m->shared) {
+        size_t pages = (size + FILE_MAP_ALIGN - 1) / FILE_MAP_ALIGN;
+        m->written = calloc((pages + 63) / 64, sizeof(uint64_t));
+        if (!m->written) {
+            release(m);
+            return RISCV_ERROR_MEMORY;
+        }
+    }
+    if (map_range(m) != RISCV_SUCCESS) {
+        printf("ERROR: Cannot map %s\n", name);
+        release(m);
+        return RISCV_ERROR_MEMORY;
+    }
+    m->data = m->map + (offset - m->map_offset);
+#if defined(FILE_MAP_MMAP) && defined(MADV_SEQUENTIAL)
+    if (mode & FILE_MAP_SEQUENTIAL) madvise(m->map, m->map_len, MADV_SEQUENTIAL);
+#endif
+
+    m->next = cpu->mappings;
+    cpu->mappings = m;
+    return RISCV_SUCCESS;
+}
+
+static int check_base(cpu_state_t *cpu, xlen_t base) {
+    if (base % FILE_MAP_ALIGN != 0) {
+        printf("ERROR: File mapping base 0x%" PRIxXLEN " is not 4 KiB aligned\n", base);
+        return RISCV_ERROR_ALIGNMENT;
+    }
+    if (base < cpu->memory_size) {
+        printf("ERROR: File mapping at 0x%" PRIxXLEN " overlaps guest RAM\n", base);
+        return RISCV_ERROR_BOUNDS;
+    }
+    return RISCV_SUCCESS;
+}
+
+int file_map(cpu_state_t *cpu, xlen_t base, const char *path, uint64_t offset, size_t size, int mode) {
+    int status = check_base(cpu, base);
+    if (status != RISCV_SUCCESS) return status;
+    int fd = open(path, ((mode & FILE_MAP_SHARED) ? O_RDWR : O_RDONLY) | O_BINARY);
+    if (fd < 0) {
+        printf("ERROR: Cannot open %s for mapping\n", path);
+        return RISCV_ERROR_MEMORY;
+    }
+    return map_fd(cpu, base, fd, path, offset, size, mode);
+}
+
+int file_map_fd(cpu_state_t *cpu, xlen_t base, int fd, uint64_t offset, size_t size, int mode) {
+    int status = check_base(cpu, base);
+    if (status != RISCV_SUCCESS) return status;
+    int own = dup(fd);
+    if (own < 0) {
+        printf("ERROR: Cannot duplicate fd %d for mapping\n", fd);
+        return RISCV_ERROR_MEMORY;
+    }
+    return map_fd(cpu, base, own, "descriptor", offset, size, mode);
+}
+
+int file_unmap(cpu_state_t *cpu, xlen_t base) {
+    for (file_mapping_t **link = &cpu->mappings; *link; link = &(*link)->next) {
+        file_mapping_t *m = *link;
+        if (m->base == base) {
+            *link = m->next;
+            predecode_invalidate(cpu, m->base, m->size);
+            release(m);
+            return RISCV_SUCCESS;
+        }
+    }
+    printf("ERROR: No file mapping at 0x%" PRIxXLEN "\n", base);
+    return RISCV_ERROR_BOUNDS;
+}
+
+void file_map_free_all(cpu_state_t *cpu) {
+    while (cpu->mappings) {
+        file_mapping_t *m = cpu->mappings;
+        cpu->mappings = m->next;
+        release(m);
+    }
+}
+
+void file_map_reset(cpu_state_t *cpu) {
+    for (file_mapping_t *m = cpu->mappings; m; m = m->next) {
+        if (!m->dirty || m->shared) continue;
+        if (map_range(m) != RISCV_SUCCESS) {
+            printf("ERROR: Cannot restore the file mapping at 0x%" PRIxXLEN "\n", m->base);
+            continue;
+        }
+        m->dirty = false;
+        size_t pages = (m->size + FILE_MAP_ALIGN - 1) / FILE_MAP_ALIGN;
+        memset(m->written, 0, (pages + 63) / 64 * sizeof(uint64_t));
+        predecode_invalidate(cpu, m->base, m->size);
+    }
+}
+
+void file_map_touch(file_mapping_t *m, size_t offset, size_t len) {
+    m->dirty = true;
+    if (!m->written || len == 0) return;
+    size_t last = (offset + len - 1) / FILE_MAP_ALIGN;
+    for (size_t page = offset / FILE_MAP_ALIGN; page <= last; page++) {
+        m->written[page / 64] |= (uint64_t)1 << (page % 64);
+    }
+}
+
+void file_map_foreach_modified(cpu_state_t *cpu, file_map_page_fn fn, void *ctx) {
+    for (file_mapping_t *m = cpu->mappings; m; m = m->next) {
+        if (!m->dirty || !m->written) continue;
+        size_t pages = (m->size + FILE_MAP_ALIGN - 1) / FILE_MAP_ALIGN;
+        for (size_t w = 0; w < (pages + 63) / 64; w++) {
+            uint64_t bits = m->written[w];
+            while (bits) {
+                size_t offset = (w * 64 + (size_t)__builtin_ctzll(bits)) * FILE_MAP_ALIGN;
+                bits &= bits - 1;
+                size_t len = m->size - offset;
+                if (len > FILE_MAP_ALIGN) len = FILE_MAP_ALIGN;
+                fn(m->base + (xlen_t)offset, m->data + offset, len, ctx);
+            }
+        }
+    }
+}
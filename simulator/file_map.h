@@ -0,0 +1,76 @@
+/**
+ * Memory-Mapped Files
+ * Host files mapped into the guest address space above RAM, so large
+ * matrix datasets are read straight from the host page cache instead of
+ * being copied into guest memory at startup
+ */
+
+#ifndef RISCV_FILE_MAP_H
+#define RISCV_FILE_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Mapping modes; FILE_MAP_SEQUENTIAL may be or'ed in to ask the host for
+// aggressive readahead when the guest streams through the file
+#define FILE_MAP_READ_ONLY      0   // guest stores fault
+#define FILE_MAP_COPY_ON_WRITE  1   // guest stores go to private copies, never the file
+#define FILE_MAP_SEQUENTIAL     2
+#define FILE_MAP_SHARED         4   // guest stores reach the file and other views of it
+
+#define FILE_MAP_ALIGN ((xlen_t)4096)   // guest base alignment
+
+typedef struct file_mapping {
+    struct file_mapping *next;
+    xlen_t base;                // guest range [base, base + size)
+    size_t size;
+    uint8_t *data;              // host address of guest byte base
+    uint8_t *map;               // host mapping (page-aligned, covers data)
+    size_t map_len;
+    uint64_t map_offset;        // file offset of map
+    int fd;                     // kept open to drop private copies on reset
+    bool writable;
+    bool shared;                // MAP_SHARED, never reset
+    bool dirty;                 // guest wrote to a copy-on-write mapping
+    uint64_t *written;          // copy-on-write: bit per FILE_MAP_ALIGN page
+                                // written since the last reset
+} file_mapping_t;
+
+// Map size bytes of the file at path, starting at file offset, at guest
+// address base (FILE_MAP_ALIGN-aligned, above RAM, not overlapping another
+// mapping). size 0 maps the rest of the file. Mapped ranges shadow sparse
+// pages.
+int file_map(cpu_state_t *cpu, xlen_t base, const char *path, uint64_t offset, size_t size, int mode);
+// Same for an open descriptor (e.g. a memfd shared with the host); the
+// mapping keeps its own dup of fd
+int file_map_fd(cpu_state_t *cpu, xlen_t base, int fd, uint64_t offset, size_t size, int mode);
+int file_unmap(cpu_state_t *cpu, xlen_t base);
+void file_map_free_all(cpu_state_t *cpu);
+
+// Drop guest writes to copy-on-write mappings (riscv_cpu_reset)
+void file_map_reset(cpu_state_t *cpu);
+
+// Record a guest write to [offset, offset + len) of m (guest_ptr)
+void file_map_touch(file_mapping_t *m, size_t offset, size_t len);
+
+// Call fn for every FILE_MAP_ALIGN-sized page of a copy-on-write mapping
+// that was written since the mapping was last reset (checkpoint_save). The
+// last page of a mapping may be shorter.
+typedef void (*file_map_page_fn)(xlen_t addr, const uint8_t *data, size_t len, void *ctx);
+void file_map_foreach_modified(cpu_state_t *cpu, file_map_page_fn fn, void *ctx);
+
+// Mapping containing [addr, addr + size), or NULL
+file_mapping_t* file_map_find(cpu_state_t *cpu, xlen_t addr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_FILE_MAP_H */
@@ -0,0 +1,103 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_memory.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// Host memory backing
+// Guest RAM is one flat buffer, so a 256 MiB guest needs 65536 host 4 KiB
+// pages but only 128 huge pages. Explicit hugetlbfs pages are only there
+// if the admin reserved them (vm.nr_hugepages); transparent huge pages
+// work without setup when THP is in "madvise" or "always" mode. THP wants
+// 2 MiB-aligned ranges, so the mapping is over-allocated and trimmed.
+
+#ifdef __linux__
+static size_t round_huge(size_t size) {
+    return (size + HOST_HUGE_PAGE_SIZE - 1) & ~(HOST_HUGE_PAGE_SIZE - 1);
+}
+
+static void* alloc_hugetlb(size_t size) {
+#ifdef MAP_HUGETLB
+    void *p = mmap(NULL, round_huge(size), PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+#else
+    (void)size;
+    return NULL;
+#endif
+}
+
+static void* alloc_thp(size_t size) {
+#ifdef MADV_HUGEPAGE
+    size_t len = round_huge(size);
+    uint8_t *raw = mmap(NULL, len + HOST_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+
+    uintptr_t start = ((uintptr_t)raw + HOST_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HOST_HUGE_PAGE_SIZE - 1);
+    uint8_t *p = (uint8_t*)start;
+    size_t head = (size_t)(p - raw);
+    size_t tail = HOST_HUGE_PAGE_SIZE - head;
+    if (head) munmap(raw, head);
+    if (tail) munmap(p + len, tail);
+
+    if (madvise(p, len, MADV_HUGEPAGE) != 0) {
+        munmap(p, len);
+        return NULL;
+    }
+    return p;
+#else
+    (void)size;
+    return NULL;
+#endif
+}
+#endif
+
+void* host_alloc(size_t size, bool huge, host_pages_t *kind) {
+#ifdef __linux__
+    if (huge && size > 0) {
+        void *p = alloc_hugetlb(size);
+        if (p) {
+            *kind = HOST_PAGES_HUGETLB;
+            return p;
+        }
+        p = alloc_thp(size);
+        if (p) {
+            *kind = HOST_PAGES_THP;
+            return p;
+        }
+    }
+#else
+    (void)huge;
+#endif
+    *kind = HOST_PAGES_SMALL;
+    return calloc(size, 1);
+}
+
+void host_free(void *ptr, size_t size, host_pages_t kind) {
+    if (!ptr) return;
+#ifdef __linux__
+    if (kind != HOST_PAGES_SMALL) {
+        munmap(ptr, round_huge(size));
+        return;
+    }
+#else
+    (void)size;
+    (void)kind;
+#endif
+    free(ptr);
+}
+
+const char* host_pages_name(host_pages_t kind) {
+    switch (kind) {
+    case HOST_PAGES_HUGETLB: return "hugetlbfs";
+    case HOST_PAGES_THP:     return "THP";
+    default:                 return "4K";
+    }
+}
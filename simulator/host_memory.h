@@ -0,0 +1,40 @@
+/**
+ * Host Memory Backing
+ * Allocates the host buffer behind guest RAM, optionally on 2 MiB pages so
+ * large guest address spaces do not thrash the host dTLB
+ */
+
+#ifndef RISCV_HOST_MEMORY_H
+#define RISCV_HOST_MEMORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOST_HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+// How a buffer is backed; host_free needs to know
+typedef enum {
+    HOST_PAGES_SMALL,       // calloc, 4 KiB host pages
+    HOST_PAGES_HUGETLB,     // mmap from the hugetlbfs pool
+    HOST_PAGES_THP          // mmap + madvise(MADV_HUGEPAGE)
+} host_pages_t;
+
+// Zeroed buffer of size bytes. With huge set, hugetlbfs is tried first, then
+// transparent huge pages; either falls back silently to HOST_PAGES_SMALL
+// when unavailable (non-Linux hosts always get small pages). *kind reports
+// what was used.
+void* host_alloc(size_t size, bool huge, host_pages_t *kind);
+void host_free(void *ptr, size_t size, host_pages_t kind);
+
+const char* host_pages_name(host_pages_t kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_HOST_MEMORY_H */
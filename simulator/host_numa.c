@@ -0,0 +1,162 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "riscv_matrix_ext.h"
+#include "host_numa.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+// Host NUMA placement
+// Topology comes from /sys/devices/system/node/node<N>/cpulist. Pages are
+// placed with the mbind syscall and queried with get_mempolicy; the
+// constants below match <linux/mempolicy.h>. Everything degrades to a
+// single node and no-op placement on hosts without these interfaces.
+
+#define HOST_MPOL_BIND        2
+#define HOST_MPOL_INTERLEAVE  3
+#define HOST_MPOL_MF_MOVE     (1 << 1)
+#define HOST_MPOL_F_NODE      (1 << 0)
+#define HOST_MPOL_F_ADDR      (1 << 1)
+
+static void set_cpu(uint64_t *mask, int cpu) {
+    if (cpu >= 0 && cpu < HOST_NUMA_MAX_CPUS) mask[cpu / 64] |= (uint64_t)1 << (cpu % 64);
+}
+
+// Parse a cpulist such as "0-3,8-11" into mask; returns the CPU count
+static int parse_cpulist(const char *list, uint64_t *mask) {
+    int count = 0;
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p) break;
+        long last = first;
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            set_cpu(mask, (int)cpu);
+            count++;
+        }
+        p = (*end == ',') ? end + 1 : end;
+        if (*p == '\n') break;
+    }
+    return count;
+}
+
+void host_numa_topology(host_numa_topology_t *topo) {
+    memset(topo, 0, sizeof(*topo));
+
+    for (int node = 0; node < HOST_NUMA_MAX_NODES; node++) {
+        char path[64], list[1024];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE *f = fopen(path, "r");
+        if (!f) break;
+        if (fgets(list, sizeof(list), f)) {
+            topo->cpu_count[node] = parse_cpulist(list, topo->cpus[node]);
+        }
+        fclose(f);
+        topo->nodes = node + 1;
+    }
+
+    if (topo->nodes == 0) {
+        int cpus = 1;
+#ifdef __linux__
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        if (online > 0) cpus = online > HOST_NUMA_MAX_CPUS ? HOST_NUMA_MAX_CPUS : (int)online;
+#endif
+        topo->nodes = 1;
+        topo->cpu_count[0] = cpus;
+        for (int cpu = 0; cpu < cpus; cpu++) set_cpu(topo->cpus[0], cpu);
+    }
+}
+
+int host_numa_pin_thread(const host_numa_topology_t *topo, int node) {
+    if (node < 0 || node >= topo->nodes) {
+        printf("ERROR: NUMA node %d out of range (%d nodes)\n", node, topo->nodes);
+        return RISCV_ERROR_BOUNDS;
+    }
+    if (topo->cpu_count[node] == 0) return RISCV_SUCCESS;  // memory-only node
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < HOST_NUMA_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+        if (topo->cpus[node][cpu / 64] & ((uint64_t)1 << (cpu % 64))) CPU_SET(cpu, &set);
+    }
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        printf("ERROR: Cannot pin thread to node %d: %s\n", node, strerror(err));
+        return RISCV_ERROR_INSTRUCTION;
+    }
+#endif
+    return RISCV_SUCCESS;
+}
+
+#ifdef __linux__
+static int place_pages(void *addr, size_t size, int mode, const uint64_t *nodemask) {
+    long page = sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t)addr + (uintptr_t)page - 1) & ~(uintptr_t)(page - 1);
+    uintptr_t end = ((uintptr_t)addr + size) & ~(uintptr_t)(page - 1);
+    if (end <= start) return RISCV_SUCCESS;
+
+    if (syscall(SYS_mbind, (void*)start, (unsigned long)(end - start), mode, nodemask,
+                (unsigned long)HOST_NUMA_MAX_NODES + 1, HOST_MPOL_MF_MOVE) != 0) {
+        printf("ERROR: mbind failed: %s\n", strerror(errno));
+        return RISCV_ERROR_MEMORY;
+    }
+    return RISCV_SUCCESS;
+}
+#endif
+
+int host_numa_bind(void *addr, size_t size, int node) {
+    if (node < 0 || node >= HOST_NUMA_MAX_NODES) {
+        printf("ERROR: NUMA node %d out of range\n", node);
+        return RISCV_ERROR_BOUNDS;
+    }
+#ifdef __linux__
+    uint64_t nodemask = (uint64_t)1 << node;
+    return place_pages(addr, size, HOST_MPOL_BIND, &nodemask);
+#else
+    (void)addr;
+    (void)size;
+    return RISCV_SUCCESS;
+#endif
+}
+
+int host_numa_interleave(void *addr, size_t size, const host_numa_topology_t *topo) {
+#ifdef __linux__
+    uint64_t nodemask = topo->nodes >= 64 ? UINT64_MAX : ((uint64_t)1 << topo->nodes) - 1;
+    return place_pages(addr, size, HOST_MPOL_INTERLEAVE, &nodemask);
+#else
+    (void)addr;
+    (void)size;
+    (void)topo;
+    return RISCV_SUCCESS;
+#endif
+}
+
+int host_numa_node_of(void *addr) {
+#ifdef __linux__
+    int node = -1;
+    *(volatile uint8_t*)addr = *(volatile uint8_t*)addr;
+    if (syscall(SYS_get_mempolicy, &node, NULL, 0UL, addr,
+                HOST_MPOL_F_NODE | HOST_MPOL_F_ADDR) != 0) {
+        return -1;
+    }
+    return node;
+#else
+    (void)addr;
+    return -1;
+#endif
+}
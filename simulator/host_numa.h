@@ -0,0 +1,47 @@
+/**
+ * Host NUMA Placement
+ * Node topology, thread pinning and page placement for multi-hart runs,
+ * using sysfs and raw syscalls so no libnuma is needed
+ */
+
+#ifndef RISCV_HOST_NUMA_H
+#define RISCV_HOST_NUMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOST_NUMA_MAX_NODES 64
+#define HOST_NUMA_MAX_CPUS  1024
+#define HOST_NUMA_CPU_WORDS (HOST_NUMA_MAX_CPUS / 64)
+
+typedef struct {
+    int nodes;                  // node ids 0..nodes-1
+    int cpu_count[HOST_NUMA_MAX_NODES];
+    uint64_t cpus[HOST_NUMA_MAX_NODES][HOST_NUMA_CPU_WORDS];
+} host_numa_topology_t;
+
+// Read /sys/devices/system/node. Hosts without it (or without NUMA) are
+// reported as one node holding every online CPU.
+void host_numa_topology(host_numa_topology_t *topo);
+
+// Restrict the calling thread to the CPUs of node
+int host_numa_pin_thread(const host_numa_topology_t *topo, int node);
+
+// Page placement for [addr, addr + size); only whole host pages inside the
+// range are affected. Pages already faulted in are migrated.
+int host_numa_bind(void *addr, size_t size, int node);
+int host_numa_interleave(void *addr, size_t size, const host_numa_topology_t *topo);
+
+// Node currently holding the page at addr (faulting it in), -1 if unknown
+int host_numa_node_of(void *addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_HOST_NUMA_H */
@@ -0,0 +1,698 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sched.h>
+#endif
+
+#include "riscv_matrix_ext.h"
+#include "riscv_encode.h"
+#include "interpreter.h"
+#include "csr.h"
+#include "syscall.h"
+
+// RISC-V Interpreter
+// Instructions are fetched once, expanded from RVC if needed, decoded into
+// decoded_insn_t and kept in a direct-mapped predecode cache. The run loop
+// only dispatches on predecoded ops; fence.i (or load_image) drops the cache.
+
+// Extract bits hi..lo of x
+#define BITS(x, hi, lo) (((x) >> (lo)) & ((1u << ((hi) - (lo) + 1)) - 1))
+
+// Tag value that never matches a fetch address (pc is always even)
+#define PREDECODE_INVALID_TAG ((xlen_t)1)
+
+static int32_t sign_extend(uint32_t value, int bits) {
+    uint32_t m = 1u << (bits - 1);
+    value &= (bits == 32) ? 0xFFFFFFFFu : ((1u << bits) - 1);
+    return (int32_t)((value ^ m) - m);
+}
+
+// Compressed instruction expansion
+
+// Register field of the 3-bit rd'/rs1'/rs2' forms
+#define CREG(x) (8 + (x))
+
+uint32_t riscv_expand_compressed(uint16_t insn) {
+    uint32_t c = insn;
+    uint32_t quadrant = c & 0x3;
+    uint32_t funct3 = BITS(c, 15, 13);
+    uint32_t rd = BITS(c, 11, 7);
+    uint32_t rs2 = BITS(c, 6, 2);
+    uint32_t rdp = CREG(BITS(c, 4, 2));
+    uint32_t rs1p = CREG(BITS(c, 9, 7));
+    int32_t imm6 = sign_extend((BITS(c, 12, 12) << 5) | BITS(c, 6, 2), 6);
+
+    if (c == 0) return 0;  // defined illegal
+
+    switch (quadrant) {
+    case 0:
+        switch (funct3) {
+        case 0: {  // c.addi4spn
+            uint32_t nzuimm = (BITS(c, 12, 11) << 4) | (BITS(c, 10, 7) << 6) |
+                              (BITS(c, 6, 6) << 2) | (BITS(c, 5, 5) << 3);
+            if (nzuimm == 0) return 0;
+            return rv_addi(rdp, 2, (int32_t)nzuimm);
+        }
+        case 2: {  // c.lw
+            uint32_t uimm = (BITS(c, 12, 10) << 3) | (BITS(c, 6, 6) << 2) | (BITS(c, 5, 5) << 6);
+            return rv_lw(rdp, rs1p, (int32_t)uimm);
+        }
+        case 6: {  // c.sw
+            uint32_t uimm = (BITS(c, 12, 10) << 3) | (BITS(c, 6, 6) << 2) | (BITS(c, 5, 5) << 6);
+            return rv_sw(rdp, rs1p, (int32_t)uimm);
+        }
+#if XLEN == 64
+        case 3: {  // c.ld
+            uint32_t uimm = (BITS(c, 12, 10) << 3) | (BITS(c, 6, 5) << 6);
+            return rv_ld(rdp, rs1p, (int32_t)uimm);
+        }
+        case 7: {  // c.sd
+            uint32_t uimm = (BITS(c, 12, 10) << 3) | (BITS(c, 6, 5) << 6);
+            return rv_sd(rdp, rs1p, (int32_t)uimm);
+        }
+#endif
+        default:   // floating-point loads/stores are not implemented
+            return 0;
+        }
+
+    case 1:
+        switch (funct3) {
+        case 0:    // c.addi / c.nop
+            return rv_addi(rd, rd, imm6);
+        case 1:
+#if XLEN == 64
+            // c.addiw
+            if (rd == 0) return 0;
+            return rv_enc_i(RV_OP_IMM_32, rd, 0, rd, imm6);
+#else
+        {   // c.jal
+            int32_t off = sign_extend((BITS(c, 12, 12) << 11) | (BITS(c, 11, 11) << 4) |
+                                      (BITS(c, 10, 9) << 8) | (BITS(c, 8, 8) << 10) |
+                                      (BITS(c, 7, 7) << 6) | (BITS(c, 6, 6) << 7) |
+                                      (BITS(c, 5, 3) << 1) | (BITS(c, 2, 2) << 5), 12);
+            return rv_jal(1, off);
+        }
+#endif
+        case 2:    // c.li
+            return rv_addi(rd, 0, imm6);
+        case 3:
+            if (rd == 2) {  // c.addi16sp
+                int32_t nzimm = sign_extend((BITS(c, 12, 12) << 9) | (BITS(c, 6, 6) << 4) |
+                                            (BITS(c, 5, 5) << 6) | (BITS(c, 4, 3) << 7) |
+                                            (BITS(c, 2, 2) << 5), 10);
+                if (nzimm == 0) return 0;
+                return rv_addi(2, 2, nzimm);
+            } else {        // c.lui
+                if (imm6 == 0) return 0;
+                return rv_lui(rd, (int32_t)((uint32_t)imm6 << 12));
+            }
+        case 4: {
+            uint32_t shamt = (BITS(c, 12, 12) << 5) | BITS(c, 6, 2);
+            switch (BITS(c, 11, 10)) {
+            case 0:  // c.srli
+                if (XLEN == 32 && (shamt & 0x20)) return 0;
+                return rv_srli(rs1p, rs1p, shamt);
+            case 1:  // c.srai
+                if (XLEN == 32 && (shamt & 0x20)) return 0;
+                return rv_enc_i(RV_OP_IMM, rs1p, 5, rs1p, (int32_t)(shamt | 0x400));
+            case 2:  // c.andi
+                return rv_andi(rs1p, rs1p, imm6);
+            default: {
+                uint32_t rs2p = rdp;
+                if (BITS(c, 12, 12) == 0) {
+                    switch (BITS(c, 6, 5)) {
+                    case 0: return rv_sub(rs1p, rs1p, rs2p);
+                    case 1: return rv_enc_r(RV_OP_OP, rs1p, 4, rs1p, rs2p, 0);  // c.xor
+                    case 2: return rv_enc_r(RV_OP_OP, rs1p, 6, rs1p, rs2p, 0);  // c.or
+                    default: return rv_enc_r(RV_OP_OP, rs1p, 7, rs1p, rs2p, 0); // c.and
+                    }
+                }
+#if XLEN == 64
+                switch (BITS(c, 6, 5)) {
+                case 0: return rv_enc_r(RV_OP_OP_32, rs1p, 0, rs1p, rs2p, 0x20);  // c.subw
+                case 1: return rv_enc_r(RV_OP_OP_32, rs1p, 0, rs1p, rs2p, 0);     // c.addw
+                default: return 0;
+                }
+#else
+                return 0;
+#endif
+            }
+            }
+        }
+        case 5: {  // c.j
+            int32_t off = sign_extend((BITS(c, 12, 12) << 11) | (BITS(c, 11, 11) << 4) |
+                                      (BITS(c, 10, 9) << 8) | (BITS(c, 8, 8) << 10) |
+                                      (BITS(c, 7, 7) << 6) | (BITS(c, 6, 6) << 7) |
+                                      (BITS(c, 5, 3) << 1) | (BITS(c, 2, 2) << 5), 12);
+            return rv_jal(0, off);
+        }
+        default: { // c.beqz / c.bnez
+            int32_t off = sign_extend((BITS(c, 12, 12) << 8) | (BITS(c, 11, 10) << 3) |
+                                      (BITS(c, 6, 5) << 6) | (BITS(c, 4, 3) << 1) |
+                                      (BITS(c, 2, 2) << 5), 9);
+            return funct3 == 6 ? rv_beq(rs1p, 0, off) : rv_bne(rs1p, 0, off);
+        }
+        }
+
+    case 2:
+        switch (funct3) {
+        case 0: {  // c.slli
+            uint32_t shamt = (BITS(c, 12, 12) << 5) | BITS(c, 6, 2);
+            if (XLEN == 32 && (shamt & 0x20)) return 0;
+            return rv_slli(rd, rd, shamt);
+        }
+        case 2: {  // c.lwsp
+            uint32_t uimm = (BITS(c, 12, 12) << 5) | (BITS(c, 6, 4) << 2) | (BITS(c, 3, 2) << 6);
+            if (rd == 0) return 0;
+            return rv_lw(rd, 2, (int32_t)uimm);
+        }
+        case 4:
+            if (BITS(c, 12, 12) == 0) {
+                if (rs2 == 0) {  // c.jr
+                    if (rd == 0) return 0;
+                    return rv_jalr(0, rd, 0);
+                }
+                return rv_add(rd, 0, rs2);  // c.mv
+            }
+            if (rd == 0 && rs2 == 0) return rv_ebreak();  // c.ebreak
+            if (rs2 == 0) return rv_jalr(1, rd, 0);       // c.jalr
+            return rv_add(rd, rd, rs2);                    // c.add
+        case 6: {  // c.swsp
+            uint32_t uimm = (BITS(c, 12, 9) << 2) | (BITS(c, 8, 7) << 6);
+            return rv_sw(rs2, 2, (int32_t)uimm);
+        }
+#if XLEN == 64
+        case 3: {  // c.ldsp
+            uint32_t uimm = (BITS(c, 12, 12) << 5) | (BITS(c, 6, 5) << 3) | (BITS(c, 4, 2) << 6);
+            if (rd == 0) return 0;
+            return rv_ld(rd, 2, (int32_t)uimm);
+        }
+        case 7: {  // c.sdsp
+            uint32_t uimm = (BITS(c, 12, 10) << 3) | (BITS(c, 9, 7) << 6);
+            return rv_sd(rs2, 2, (int32_t)uimm);
+        }
+#endif
+        default:
+            return 0;
+        }
+
+    default:
+        return 0;  // quadrant 3 is not compressed
+    }
+}
+
+// Decoder behind the public riscv_decode_instruction API: 16-bit forms are
+// returned in their expanded 32-bit encoding
+riscv_instruction_t riscv_decode_instruction(uint32_t raw) {
+    riscv_instruction_t inst;
+    inst.raw = ((raw & 0x3) == 0x3) ? raw : riscv_expand_compressed((uint16_t)raw);
+    return inst;
+}
+
+// 32-bit predecode
+
+void riscv_predecode(uint32_t insn, decoded_insn_t *out) {
+    uint32_t opcode = insn & 0x7F;
+    uint32_t func3 = BITS(insn, 14, 12);
+    uint32_t func7 = BITS(insn, 31, 25);
+    int32_t imm_i = (int32_t)insn >> 20;
+    int32_t imm_s = sign_extend((BITS(insn, 31, 25) << 5) | BITS(insn, 11, 7), 12);
+    int32_t imm_b = sign_extend((BITS(insn, 31, 31) << 12) | (BITS(insn, 7, 7) << 11) |
+                                (BITS(insn, 30, 25) << 5) | (BITS(insn, 11, 8) << 1), 13);
+    int32_t imm_u = (int32_t)(insn & 0xFFFFF000u);
+    int32_t imm_j = sign_extend((BITS(insn, 31, 31) << 20) | (BITS(insn, 19, 12) << 12) |
+                                (BITS(insn, 20, 20) << 11) | (BITS(insn, 30, 21) << 1), 21);
+    uint8_t op = OP_ILLEGAL;
+    int32_t imm = 0;
+
+    switch (opcode) {
+    case RV_OP_LUI:   op = OP_LUI;   imm = imm_u; break;
+    case RV_OP_AUIPC: op = OP_AUIPC; imm = imm_u; break;
+    case RV_OP_JAL:   op = OP_JAL;   imm = imm_j; break;
+    case RV_OP_JALR:
+        if (func3 == 0) { op = OP_JALR; imm = imm_i; }
+        break;
+    case RV_OP_BRANCH: {
+        static const uint8_t ops[8] = { OP_BEQ, OP_BNE, OP_ILLEGAL, OP_ILLEGAL,
+                                        OP_BLT, OP_BGE, OP_BLTU, OP_BGEU };
+        op = ops[func3];
+        imm = imm_b;
+        break;
+    }
+    case RV_OP_LOAD: {
+        static const uint8_t ops[8] = { OP_LB, OP_LH, OP_LW, OP_LD,
+                                        OP_LBU, OP_LHU, OP_LWU, OP_ILLEGAL };
+        op = ops[func3];
+        if (XLEN == 32 && (op == OP_LD || op == OP_LWU)) op = OP_ILLEGAL;
+        imm = imm_i;
+        break;
+    }
+    case RV_OP_STORE: {
+        static const uint8_t ops[8] = { OP_SB, OP_SH, OP_SW, OP_SD,
+                                        OP_ILLEGAL, OP_ILLEGAL, OP_ILLEGAL, OP_ILLEGAL };
+        op = ops[func3];
+        if (XLEN == 32 && op == OP_SD) op = OP_ILLEGAL;
+        imm = imm_s;
+        break;
+    }
+    case RV_OP_IMM: {
+        // Shift amounts are XLEN-1 wide; the bits above must be 0 (or the
+        // arithmetic-shift marker)
+        uint32_t shamt = BITS(insn, 25, 20) & (XLEN - 1);
+        uint32_t shift_hi = (XLEN == 64) ? BITS(insn, 31, 26) << 1 : func7;
+        imm = imm_i;
+        switch (func3) {
+        case 0: op = OP_ADDI; break;
+        case 2:  // slti x0, x0, id is a simulation marker
+            op = (BITS(insn, 11, 7) == 0 && BITS(insn, 19, 15) == 0) ? OP_MARKER : OP_SLTI;
+            break;
+        case 3: op = OP_SLTIU; break;
+        case 4: op = OP_XORI; break;
+        case 6: op = OP_ORI; break;
+        case 7: op = OP_ANDI; break;
+        case 1:
+            if (shift_hi == 0) { op = OP_SLLI; imm = (int32_t)shamt; }
+            break;
+        default:
+            if (shift_hi == 0) { op = OP_SRLI; imm = (int32_t)shamt; }
+            else if (shift_hi == 0x20) { op = OP_SRAI; imm = (int32_t)shamt; }
+            break;
+        }
+        break;
+    }
+    case RV_OP_OP:
+        if (func7 == 0x00) {
+            static const uint8_t ops[8] = { OP_ADD, OP_SLL, OP_SLT, OP_SLTU,
+                                            OP_XOR, OP_SRL, OP_OR, OP_AND };
+            op = ops[func3];
+        } else if (func7 == 0x20) {
+            if (func3 == 0) op = OP_SUB;
+            else if (func3 == 5) op = OP_SRA;
+        } else if (func7 == RV_FUNC7_MULDIV) {
+            static const uint8_t ops[8] = { OP_MUL, OP_MULH, OP_MULHSU, OP_MULHU,
+                                            OP_DIV, OP_DIVU, OP_REM, OP_REMU };
+            op = ops[func3];
+        }
+        break;
+#if XLEN == 64
+    case RV_OP_IMM_32:
+        imm = imm_i;
+        if (func3 == 0) op = OP_ADDIW;
+        else if (func3 == 1 && func7 == 0) { op = OP_SLLIW; imm = (int32_t)BITS(insn, 24, 20); }
+        else if (func3 == 5 && func7 == 0) { op = OP_SRLIW; imm = (int32_t)BITS(insn, 24, 20); }
+        else if (func3 == 5 && func7 == 0x20) { op = OP_SRAIW; imm = (int32_t)BITS(insn, 24, 20); }
+        break;
+    case RV_OP_OP_32:
+        if (func7 == 0x00) {
+            if (func3 == 0) op = OP_ADDW;
+            else if (func3 == 1) op = OP_SLLW;
+            else if (func3 == 5) op = OP_SRLW;
+        } else if (func7 == 0x20) {
+            if (func3 == 0) op = OP_SUBW;
+            else if (func3 == 5) op = OP_SRAW;
+        } else if (func7 == RV_FUNC7_MULDIV) {
+            static const uint8_t ops[8] = { OP_MULW, OP_ILLEGAL, OP_ILLEGAL, OP_ILLEGAL,
+                                            OP_DIVW, OP_DIVUW, OP_REMW, OP_REMUW };
+            op = ops[func3];
+        }
+        break;
+#endif
+    case RV_OP_MISC_MEM:
+        if (func3 == 0) op = OP_FENCE;
+        else if (func3 == 1) op = OP_FENCE_I;
+        break;
+    case RV_OP_SYSTEM:
+        if (insn == rv_ecall()) op = OP_ECALL;
+        else if (insn == rv_ebreak()) op = OP_EBREAK;
+        else if (func3 != 0 && func3 != 4) {
+            static const uint8_t ops[8] = { OP_ILLEGAL, OP_CSRRW, OP_CSRRS, OP_CSRRC,
+                                            OP_ILLEGAL, OP_CSRRWI, OP_CSRRSI, OP_CSRRCI };
+            op = ops[func3];
+            imm = (int32_t)BITS(insn, 31, 20);  // CSR number
+        }
+        break;
+    case OPCODE_CUSTOM_1:
+        op = OP_CUSTOM;
+        break;
+    default:
+        break;
+    }
+
+    out->op = op;
+    out->imm = imm;
+    out->raw = insn;
+    out->rd = (uint8_t)BITS(insn, 11, 7);
+    out->rs1 = (uint8_t)BITS(insn, 19, 15);
+    out->rs2 = (uint8_t)BITS(insn, 24, 20);
+    out->len = 4;
+}
+
+// Predecode cache
+
+int predecode_configure(cpu_state_t *cpu, size_t entries) {
+    if (entries == 0 || (entries & (entries - 1)) != 0) {
+        printf("ERROR: Predecode cache size must be a power of two: %zu\n", entries);
+        return RISCV_ERROR_INSTRUCTION;
+    }
+
+    struct predecode_cache *cache = calloc(1, sizeof(*cache));
+    if (!cache) return RISCV_ERROR_MEMORY;
+
+    cache->entries = malloc(entries * sizeof(decoded_insn_t));
+    if (!cache->entries) {
+        free(cache);
+        return RISCV_ERROR_MEMORY;
+    }
+    cache->mask = entries - 1;
+
+    predecode_cache_free(cpu->predecode);
+    cpu->predecode = cache;
+    predecode_flush(cpu);
+    return RISCV_SUCCESS;
+}
+
+void predecode_flush(cpu_state_t *cpu) {
+    struct predecode_cache *cache = cpu->predecode;
+    if (!cache) return;
+
+    for (size_t i = 0; i <= cache->mask; i++) {
+        cache->entries[i].pc = PREDECODE_INVALID_TAG;
+    }
+}
+
+// Drop entries decoded from [addr, addr + size) after that memory changed
+// behind the cache's back
+void predecode_invalidate(cpu_state_t *cpu, xlen_t addr, size_t size) {
+    struct predecode_cache *cache = cpu->predecode;
+    if (!cache) return;
+
+    if (size / 2 > cache->mask) {
+        for (size_t i = 0; i <= cache->mask; i++) {
+            if (cache->entries[i].pc - addr < size) cache->entries[i].pc = PREDECODE_INVALID_TAG;
+        }
+        return;
+    }
+    for (size_t off = 0; off < size; off += 2) {
+        decoded_insn_t *d = &cache->entries[((addr + off) >> 1) & cache->mask];
+        if (d->pc - addr < size) d->pc = PREDECODE_INVALID_TAG;
+    }
+}
+
+void predecode_cache_free(struct predecode_cache *cache) {
+    if (cache) {
+        free(cache->entries);
+        free(cache);
+    }
+}
+
+static decoded_insn_t* fetch_decoded(cpu_state_t *cpu, struct predecode_cache *cache, xlen_t pc) {
+    decoded_insn_t *d = &cache->entries[(pc >> 1) & cache->mask];
+    if (d->pc == pc) return d;
+
+    cache->misses++;
+
+    uint16_t lo, hi;
+    if (mem_read(cpu, pc, &lo, sizeof(lo)) != RISCV_SUCCESS) {
+        printf("ERROR: Instruction fetch fault at 0x%" PRIxXLEN "\n", pc);
+        return NULL;
+    }
+
+    if ((lo & 0x3) != 0x3) {
+        riscv_predecode(riscv_expand_compressed(lo), d);
+        d->len = 2;
+    } else {
+        if (mem_read(cpu, pc + 2, &hi, sizeof(hi)) != RISCV_SUCCESS) {
+            printf("ERROR: Instruction fetch fault at 0x%" PRIxXLEN "\n", pc + 2);
+            return NULL;
+        }
+        riscv_predecode((uint32_t)lo | ((uint32_t)hi << 16), d);
+    }
+    d->pc = pc;
+    return d;
+}
+
+// Execution
+
+// Upper XLEN bits of a full-width product
+static xlen_t mul_high(xlen_t a, xlen_t b, bool a_signed, bool b_signed) {
+#if XLEN == 64
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
+    uint64_t mid = (p0 >> 32) + (uint32_t)p1 + (uint32_t)p2;
+    uint64_t hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+
+    // Two's complement correction for signed operands
+    if (a_signed && (int64_t)a < 0) hi -= b;
+    if (b_signed && (int64_t)b < 0) hi -= a;
+    return hi;
+#else
+    // Widen with sign extension where signed, multiply modulo 2^64: the
+    // exact product fits in 64 bits, and unsigned arithmetic cannot overflow
+    uint64_t wa = a_signed ? (uint64_t)(int64_t)(int32_t)a : (uint64_t)a;
+    uint64_t wb = b_signed ? (uint64_t)(int64_t)(int32_t)b : (uint64_t)b;
+    return (xlen_t)((wa * wb) >> 32);
+#endif
+}
+
+#define LOAD(type) do { \
+    type t_; \
+    if (mem_read(cpu, a + (xlen_t)d->imm, &t_, sizeof(t_)) != RISCV_SUCCESS) \
+        return RISCV_ERROR_MEMORY; \
+    v = (xlen_t)(sxlen_t)t_; \
+} while (0)
+
+#define STORE(type) do { \
+    type t_ = (type)b; \
+    wb = false; \
+    if (mem_write(cpu, a + (xlen_t)d->imm, &t_, sizeof(t_)) != RISCV_SUCCESS) \
+        return RISCV_ERROR_MEMORY; \
+} while (0)
+
+#define BRANCH(cond) do { \
+    wb = false; \
+    if (cond) next = d->pc + (xlen_t)d->imm; \
+} while (0)
+
+int riscv_execute_decoded(cpu_state_t *cpu, const decoded_insn_t *d) {
+    xlen_t *x = cpu->regs;
+    xlen_t a = x[d->rs1];
+    xlen_t b = x[d->rs2];
+    xlen_t next = d->pc + d->len;
+    xlen_t v = 0;
+    bool wb = true;
+
+    switch (d->op) {
+    case OP_LUI:   v = (xlen_t)d->imm; break;
+    case OP_AUIPC: v = d->pc + (xlen_t)d->imm; break;
+    case OP_JAL:   v = next; next = d->pc + (xlen_t)d->imm; break;
+    case OP_JALR:  v = next; next = (a + (xlen_t)d->imm) & ~(xlen_t)1; break;
+
+    case OP_BEQ:  BRANCH(a == b); break;
+    case OP_BNE:  BRANCH(a != b); break;
+    case OP_BLT:  BRANCH((sxlen_t)a < (sxlen_t)b); break;
+    case OP_BGE:  BRANCH((sxlen_t)a >= (sxlen_t)b); break;
+    case OP_BLTU: BRANCH(a < b); break;
+    case OP_BGEU: BRANCH(a >= b); break;
+
+    case OP_LB:  LOAD(int8_t); break;
+    case OP_LH:  LOAD(int16_t); break;
+    case OP_LW:  LOAD(int32_t); break;
+    case OP_LBU: LOAD(uint8_t); break;
+    case OP_LHU: LOAD(uint16_t); break;
+#if XLEN == 64
+    case OP_LWU: LOAD(uint32_t); break;
+    case OP_LD:  LOAD(int64_t); break;
+#endif
+
+    case OP_SB: STORE(uint8_t); break;
+    case OP_SH: STORE(uint16_t); break;
+    case OP_SW: STORE(uint32_t); break;
+#if XLEN == 64
+    case OP_SD: STORE(uint64_t); break;
+#endif
+
+    case OP_ADDI:  v = a + (xlen_t)d->imm; break;
+    case OP_SLTI:  v = (sxlen_t)a < d->imm; break;
+    case OP_SLTIU: v = a < (xlen_t)d->imm; break;
+    case OP_XORI:  v = a ^ (xlen_t)d->imm; break;
+    case OP_ORI:   v = a | (xlen_t)d->imm; break;
+    case OP_ANDI:  v = a & (xlen_t)d->imm; break;
+    case OP_SLLI:  v = a << d->imm; break;
+    case OP_SRLI:  v = a >> d->imm; break;
+    case OP_SRAI:  v = (xlen_t)((sxlen_t)a >> d->imm); break;
+
+    case OP_ADD:  v = a + b; break;
+    case OP_SUB:  v = a - b; break;
+    case OP_SLL:  v = a << (b & (XLEN - 1)); break;
+    case OP_SLT:  v = (sxlen_t)a < (sxlen_t)b; break;
+    case OP_SLTU: v = a < b; break;
+    case OP_XOR:  v = a ^ b; break;
+    case OP_SRL:  v = a >> (b & (XLEN - 1)); break;
+    case OP_SRA:  v = (xlen_t)((sxlen_t)a >> (b & (XLEN - 1))); break;
+    case OP_OR:   v = a | b; break;
+    case OP_AND:  v = a & b; break;
+
+    case OP_MUL:    v = a * b; break;
+    case OP_MULH:   v = mul_high(a, b, true, true); break;
+    case OP_MULHSU: v = mul_high(a, b, true, false); break;
+    case OP_MULHU:  v = mul_high(a, b, false, false); break;
+    case OP_DIV:
+        if (b == 0) v = ~(xlen_t)0;
+        else if ((sxlen_t)a == SXLEN_MIN && (sxlen_t)b == -1) v = a;
+        else v = (xlen_t)((sxlen_t)a / (sxlen_t)b);
+        break;
+    case OP_DIVU: v = (b == 0) ? ~(xlen_t)0 : a / b; break;
+    case OP_REM:
+        if (b == 0) v = a;
+        else if ((sxlen_t)a == SXLEN_MIN && (sxlen_t)b == -1) v = 0;
+        else v = (xlen_t)((sxlen_t)a % (sxlen_t)b);
+        break;
+    case OP_REMU: v = (b == 0) ? a : a % b; break;
+
+#if XLEN == 64
+    case OP_ADDIW: v = (xlen_t)(int64_t)(int32_t)(uint32_t)(a + (xlen_t)d->imm); break;
+    case OP_SLLIW: v = (xlen_t)(int64_t)(int32_t)((uint32_t)a << d->imm); break;
+    case OP_SRLIW: v = (xlen_t)(int64_t)(int32_t)((uint32_t)a >> d->imm); break;
+    case OP_SRAIW: v = (xlen_t)(int64_t)((int32_t)a >> d->imm); break;
+    case OP_ADDW:  v = (xlen_t)(int64_t)(int32_t)(uint32_t)(a + b); break;
+    case OP_SUBW:  v = (xlen_t)(int64_t)(int32_t)(uint32_t)(a - b); break;
+    case OP_SLLW:  v = (xlen_t)(int64_t)(int32_t)((uint32_t)a << (b & 31)); break;
+    case OP_SRLW:  v = (xlen_t)(int64_t)(int32_t)((uint32_t)a >> (b & 31)); break;
+    case OP_SRAW:  v = (xlen_t)(int64_t)((int32_t)a >> (b & 31)); break;
+    case OP_MULW:  v = (xlen_t)(int64_t)(int32_t)((uint32_t)a * (uint32_t)b); break;
+    case OP_DIVW: {
+        int32_t sa = (int32_t)a, sb = (int32_t)b;
+        if (sb == 0) v = ~(xlen_t)0;
+        else if (sa == INT32_MIN && sb == -1) v = (xlen_t)(int64_t)sa;
+        else v = (xlen_t)(int64_t)(sa / sb);
+        break;
+    }
+    case OP_DIVUW:
+        v = ((uint32_t)b == 0) ? ~(xlen_t)0
+                               : (xlen_t)(int64_t)(int32_t)((uint32_t)a / (uint32_t)b);
+        break;
+    case OP_REMW: {
+        int32_t sa = (int32_t)a, sb = (int32_t)b;
+        if (sb == 0) v = (xlen_t)(int64_t)sa;
+        else if (sa == INT32_MIN && sb == -1) v = 0;
+        else v = (xlen_t)(int64_t)(sa % sb);
+        break;
+    }
+    case OP_REMUW:
+        v = ((uint32_t)b == 0) ? (xlen_t)(int64_t)(int32_t)a
+                               : (xlen_t)(int64_t)(int32_t)((uint32_t)a % (uint32_t)b);
+        break;
+#endif
+
+    case OP_FENCE:
+        // Guest memory may be shared with host threads (FILE_MAP_SHARED),
+        // so a guest fence is a host fence, and a guest spinning on it
+        // (Zihintpause) gives the host CPU to the thread it waits for
+        wb = false;
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#ifndef _WIN32
+        if (d->raw == rv_pause()) sched_yield();
+#endif
+        break;
+    case OP_FENCE_I:
+        wb = false;
+        predecode_flush(cpu);
+        break;
+    case OP_ECALL:
+        wb = false;
+        if (cpu->syscalls) {
+            if (syscall_handle(cpu) != RISCV_SUCCESS) return RISCV_ERROR_INSTRUCTION;
+            break;
+        }
+        cpu->halted = true;
+        cpu->exit_code = (int)x[10];
+        break;
+    case OP_EBREAK:
+        wb = false;
+        cpu->halted = true;
+        break;
+    case OP_MARKER:
+        wb = false;
+        cpu->last_marker = (int)d->imm;
+        cpu->stop_requested = cpu->stop_on_marker;
+        break;
+
+    case OP_CSRRW: case OP_CSRRS: case OP_CSRRC:
+    case OP_CSRRWI: case OP_CSRRSI: case OP_CSRRCI: {
+        // rs1 holds the 5-bit immediate in the I forms. csrrw skips the
+        // read when rd is x0; csrrs/csrrc skip the write when rs1 is x0.
+        uint32_t csr = (uint32_t)d->imm;
+        bool swap = (d->op == OP_CSRRW || d->op == OP_CSRRWI);
+        xlen_t src = (d->op >= OP_CSRRWI) ? (xlen_t)d->rs1 : a;
+        if ((!swap || d->rd != 0) && csr_read(cpu, csr, &v) != RISCV_SUCCESS) {
+            return RISCV_ERROR_INSTRUCTION;
+        }
+        if (swap || d->rs1 != 0) {
+            xlen_t value = swap ? src
+                         : (d->op == OP_CSRRS || d->op == OP_CSRRSI) ? (v | src) : (v & ~src);
+            if (csr_write(cpu, csr, value) != RISCV_SUCCESS) return RISCV_ERROR_INSTRUCTION;
+        }
+        break;
+    }
+
+    case OP_CUSTOM:
+        wb = false;
+        if (execute_instruction(cpu, d->raw) != RISCV_SUCCESS) {
+            return RISCV_ERROR_INSTRUCTION;
+        }
+        break;
+
+    default:
+        printf("ERROR: Illegal instruction 0x%08x at 0x%" PRIxXLEN "\n", d->raw, d->pc);
+        return RISCV_ERROR_INSTRUCTION;
+    }
+
+    if (wb && d->rd != 0) {
+        x[d->rd] = v;
+    }
+    cpu->pc = next;
+    return RISCV_SUCCESS;
+}
+
+static struct predecode_cache* ensure_predecode(cpu_state_t *cpu) {
+    if (!cpu->predecode && predecode_configure(cpu, PREDECODE_DEFAULT_ENTRIES) != RISCV_SUCCESS) {
+        return NULL;
+    }
+    return cpu->predecode;
+}
+
+const decoded_insn_t* predecode_fetch(cpu_state_t *cpu, xlen_t pc) {
+    struct predecode_cache *cache = ensure_predecode(cpu);
+    return cache ? fetch_decoded(cpu, cache, pc) : NULL;
+}
+
+int riscv_step(cpu_state_t *cpu) {
+    return riscv_run(cpu, 1);
+}
+
+int riscv_run(cpu_state_t *cpu, uint64_t max_insns) {
+    struct predecode_cache *cache = ensure_predecode(cpu);
+    if (!cache) return RISCV_ERROR_MEMORY;
+
+    // instret is kept live so rdinstret sees the count so far
+    uint64_t end = (max_insns > UINT64_MAX - cpu->instret) ? UINT64_MAX : cpu->instret + max_insns;
+    int status = RISCV_SUCCESS;
+    cpu->stop_requested = false;            // a marker stop ends only the run it happened in
+
+    while (cpu->instret < end && !cpu->halted && cpu->pc != cpu->stop_pc) {
+        const decoded_insn_t *d = fetch_decoded(cpu, cache, cpu->pc);
+        if (!d) {
+            status = RISCV_ERROR_MEMORY;
+            break;
+        }
+        status = riscv_execute_decoded(cpu, d);
+        if (status != RISCV_SUCCESS) break;
+        cpu->instret++;
+        if (cpu->stop_requested) break;
+    }
+
+    return status;
+}
@@ -0,0 +1,90 @@
+/**
+ * RISC-V Interpreter
+ * Predecoding fetch/execute loop for the base integer ISA plus the
+ * M, C and custom matrix extensions
+ */
+
+#ifndef RISCV_INTERPRETER_H
+#define RISCV_INTERPRETER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Operations produced by the predecoder
+typedef enum {
+    OP_ILLEGAL = 0,
+    OP_LUI, OP_AUIPC, OP_JAL, OP_JALR,
+    OP_BEQ, OP_BNE, OP_BLT, OP_BGE, OP_BLTU, OP_BGEU,
+    OP_LB, OP_LH, OP_LW, OP_LBU, OP_LHU, OP_LWU, OP_LD,
+    OP_SB, OP_SH, OP_SW, OP_SD,
+    OP_ADDI, OP_SLTI, OP_SLTIU, OP_XORI, OP_ORI, OP_ANDI,
+    OP_SLLI, OP_SRLI, OP_SRAI,
+    OP_ADD, OP_SUB, OP_SLL, OP_SLT, OP_SLTU, OP_XOR, OP_SRL, OP_SRA, OP_OR, OP_AND,
+    OP_MUL, OP_MULH, OP_MULHSU, OP_MULHU, OP_DIV, OP_DIVU, OP_REM, OP_REMU,
+    OP_ADDIW, OP_SLLIW, OP_SRLIW, OP_SRAIW,
+    OP_ADDW, OP_SUBW, OP_SLLW, OP_SRLW, OP_SRAW,
+    OP_MULW, OP_DIVW, OP_DIVUW, OP_REMW, OP_REMUW,
+    OP_FENCE, OP_FENCE_I, OP_ECALL, OP_EBREAK,
+    OP_MARKER,              // slti x0, x0, id simulation marker hint
+    OP_CSRRW, OP_CSRRS, OP_CSRRC, OP_CSRRWI, OP_CSRRSI, OP_CSRRCI,
+    OP_CUSTOM,              // custom-1 matrix instructions, see execute_instruction
+    OP_COUNT
+} riscv_op_t;
+
+// A predecoded instruction. Compressed instructions are expanded before
+// they get here, so the hot loop only sees 32-bit semantics; len keeps the
+// original size for pc updates.
+typedef struct {
+    xlen_t pc;              // tag: address this entry was decoded from
+    sxlen_t imm;
+    uint32_t raw;           // expanded 32-bit instruction word
+    uint8_t op;             // riscv_op_t
+    uint8_t rd, rs1, rs2;
+    uint8_t len;            // 2 or 4 bytes
+} decoded_insn_t;
+
+// Direct-mapped predecode cache indexed by pc >> 1
+#define PREDECODE_DEFAULT_ENTRIES 4096
+
+struct predecode_cache {
+    decoded_insn_t *entries;
+    size_t mask;
+    uint64_t misses;
+};
+
+// Expand a 16-bit RVC instruction to its 32-bit equivalent (0 if illegal)
+uint32_t riscv_expand_compressed(uint16_t insn);
+
+// Decode a 32-bit instruction word into its predecoded form
+void riscv_predecode(uint32_t insn, decoded_insn_t *out);
+
+// Predecode cache management; entries must be a power of two
+int predecode_configure(cpu_state_t *cpu, size_t entries);
+void predecode_flush(cpu_state_t *cpu);
+void predecode_invalidate(cpu_state_t *cpu, xlen_t addr, size_t size);
+void predecode_cache_free(struct predecode_cache *cache);
+
+// Predecoded instruction at pc, filling the cache on a miss (NULL on fetch fault)
+const decoded_insn_t* predecode_fetch(cpu_state_t *cpu, xlen_t pc);
+
+// Execute one predecoded instruction against cpu; updates regs and pc but
+// not instret
+int riscv_execute_decoded(cpu_state_t *cpu, const decoded_insn_t *d);
+
+// Execute a single instruction / run until halt, max_insns instructions or
+// a run-control stop (stop_pc, marker). riscv_run is the functional fast
+// path and never touches cpu->timing; see timing.h for the detailed loop.
+int riscv_step(cpu_state_t *cpu);
+int riscv_run(cpu_state_t *cpu, uint64_t max_insns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_INTERPRETER_H */
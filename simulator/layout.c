@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "riscv_matrix_ext.h"
+#include "layout.h"
+
+// Matrix layouts
+// Row-major matrices are read tile by tile with two 8-byte row accesses a
+// stride apart; blocked and Z-order matrices keep each tile's 16 bytes
+// together, Z-order additionally keeping neighbouring tiles in nearby
+// lines in both directions. The gather resolves each tile to a host
+// pointer once and prefetches the tiles LAYOUT_PREFETCH_DISTANCE ahead, so
+// scattered (Z-order, strided) walks overlap their host cache misses.
+
+static bool is_power_of_two(uint32_t x) {
+    return x != 0 && (x & (x - 1)) == 0;
+}
+
+static xlen_t row_stride(const matrix_layout_t *layout) {
+    return layout->stride ? layout->stride : (xlen_t)layout->cols * sizeof(int32_t);
+}
+
+// Spread the low 32 bits of x to the even bit positions
+static uint64_t spread_bits(uint32_t x) {
+    uint64_t v = x;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+    v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+    v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    v = (v | (v << 2)) & 0x3333333333333333ull;
+    v = (v | (v << 1)) & 0x5555555555555555ull;
+    return v;
+}
+
+// Morton index: tj bits at even positions, ti bits at odd positions
+static uint64_t morton(uint32_t ti, uint32_t tj) {
+    return spread_bits(tj) | (spread_bits(ti) << 1);
+}
+
+int layout_validate(const matrix_layout_t *layout) {
+    if (layout->rows == 0 || layout->cols == 0 || layout->rows % MATRIX_DIM || layout->cols % MATRIX_DIM) {
+        printf("ERROR: Layout %ux%u is not a whole number of 2x2 tiles\n", layout->rows, layout->cols);
+        return RISCV_ERROR_ALIGNMENT;
+    }
+    switch (layout->kind) {
+    case LAYOUT_ROW_MAJOR:
+        if (row_stride(layout) < (xlen_t)layout->cols * sizeof(int32_t) ||
+            row_stride(layout) % sizeof(int32_t)) {
+            printf("ERROR: Row stride %" PRIuXLEN " does not cover a %u-column row\n",
+                   row_stride(layout), layout->cols);
+            return RISCV_ERROR_ALIGNMENT;
+        }
+        return RISCV_SUCCESS;
+    case LAYOUT_BLOCKED:
+        return RISCV_SUCCESS;
+    case LAYOUT_ZORDER:
+        if (layout->rows != layout->cols || !is_power_of_two(layout->rows / MATRIX_DIM)) {
+            printf("ERROR: Z-order needs a square power-of-two tile grid (got %ux%u)\n",
+                   layout->rows, layout->cols);
+            return RISCV_ERROR_ALIGNMENT;
+        }
+        return RISCV_SUCCESS;
+    }
+    printf("ERROR: Unknown layout %d\n", (int)layout->kind);
+    return RISCV_ERROR_ALIGNMENT;
+}
+
+size_t layout_bytes(const matrix_layout_t *layout) {
+    if (layout->kind == LAYOUT_ROW_MAJOR) {
+        return (size_t)row_stride(layout) * (layout->rows - 1) + (size_t)layout->cols * sizeof(int32_t);
+    }
+    return (size_t)layout->rows * layout->cols * sizeof(int32_t);
+}
+
+xlen_t layout_tile_offset(const matrix_layout_t *layout, uint32_t ti, uint32_t tj) {
+    switch (layout->kind) {
+    case LAYOUT_ROW_MAJOR:
+        return (xlen_t)(MATRIX_DIM * ti) * row_stride(layout) + (xlen_t)(MATRIX_DIM * tj) * sizeof(int32_t);
+    case LAYOUT_BLOCKED:
+        return ((xlen_t)ti * (layout->cols / MATRIX_DIM) + tj) * MATRIX_BYTES;
+    default:
+        return (xlen_t)morton(ti, tj) * MATRIX_BYTES;
+    }
+}
+
+xlen_t layout_tile_pitch(const matrix_layout_t *layout) {
+    return layout->kind == LAYOUT_ROW_MAJOR ? row_stride(layout) : (xlen_t)VECTOR_BYTES;
+}
+
+// Host pointers to a tile's two rows, NULL if either is unmapped
+static bool tile_rows_ptr(cpu_state_t *cpu, xlen_t addr, xlen_t pitch, bool write,
+                          uint8_t **row0, uint8_t **row1) {
+    *row0 = guest_ptr(cpu, addr, VECTOR_BYTES, write);
+    *row1 = guest_ptr(cpu, addr + pitch, VECTOR_BYTES, write);
+    return *row0 && *row1;
+}
+
+int layout_gather(cpu_state_t *cpu, xlen_t base, const matrix_layout_t *layout,
+                  const uint32_t *tile_rows, const uint32_t *tile_cols, size_t count,
+                  matrix_2x2_t *out, bool prefetch) {
+    xlen_t pitch = layout_tile_pitch(layout);
+    size_t distance = prefetch ? LAYOUT_PREFETCH_DISTANCE : 0;
+    uint8_t *ring[LAYOUT_PREFETCH_DISTANCE + 1][MATRIX_DIM];
+
+    // Tile i is resolved (and prefetched) distance tiles before it is
+    // copied; its row pointers wait in the ring until then
+    for (size_t i = 0; i < count + distance; i++) {
+        if (i < count) {
+            uint8_t **rows = ring[i % (LAYOUT_PREFETCH_DISTANCE + 1)];
+            xlen_t addr = base + layout_tile_offset(layout, tile_rows[i], tile_cols[i]);
+            if (!tile_rows_ptr(cpu, addr, pitch, false, &rows[0], &rows[1])) {
+                printf("ERROR: Tile (%u, %u) out of bounds at 0x%" PRIxXLEN "\n",
+                       tile_rows[i], tile_cols[i], addr);
+                return RISCV_ERROR_BOUNDS;
+            }
+#if defined(__GNUC__) || defined(__clang__)
+            if (distance) {
+                __builtin_prefetch(rows[0], 0, 3);
+                __builtin_prefetch(rows[1], 0, 3);
+            }
+#endif
+        }
+        if (i >= distance) {
+            size_t t = i - distance;
+            uint8_t **rows = ring[t % (LAYOUT_PREFETCH_DISTANCE + 1)];
+            memcpy(out[t].m[0], rows[0], VECTOR_BYTES);
+            memcpy(out[t].m[1], rows[1], VECTOR_BYTES);
+        }
+    }
+    return RISCV_SUCCESS;
+}
+
+// Copy every tile from src into guest memory, or out of it into dst (the
+// other is NULL); both are row-major and cols wide
+static int copy_tiles(cpu_state_t *cpu, xlen_t base, const matrix_layout_t *layout,
+                      const int32_t *src, int32_t *dst) {
+    int status = layout_validate(layout);
+    if (status != RISCV_SUCCESS) return status;
+    xlen_t pitch = layout_tile_pitch(layout);
+
+    for (uint32_t ti = 0; ti < layout->rows / MATRIX_DIM; ti++) {
+        for (uint32_t tj = 0; tj < layout->cols / MATRIX_DIM; tj++) {
+            xlen_t addr = base + layout_tile_offset(layout, ti, tj);
+            uint8_t *row[MATRIX_DIM];
+            if (!tile_rows_ptr(cpu, addr, pitch, src != NULL, &row[0], &row[1])) {
+                printf("ERROR: Tile (%u, %u) out of bounds at 0x%" PRIxXLEN "\n", ti, tj, addr);
+                return RISCV_ERROR_BOUNDS;
+            }
+            for (int r = 0; r < MATRIX_DIM; r++) {
+                size_t host = (size_t)(MATRIX_DIM * ti + r) * layout->cols + MATRIX_DIM * tj;
+                if (src) memcpy(row[r], src + host, VECTOR_BYTES);
+                else memcpy(dst + host, row[r], VECTOR_BYTES);
+            }
+        }
+    }
+    return RISCV_SUCCESS;
+}
+
+int layout_store(cpu_state_t *cpu, xlen_t base, const matrix_layout_t *layout, const int32_t *dense) {
+    return copy_tiles(cpu, base, layout, dense, NULL);
+}
+
+int layout_load(cpu_state_t *cpu, xlen_t base, const matrix_layout_t *layout, int32_t *dense) {
+    return copy_tiles(cpu, base, layout, NULL, dense);
+}
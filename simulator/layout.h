@@ -0,0 +1,64 @@
+/**
+ * Matrix Layouts
+ * Descriptors for where the 2x2 tiles of a large matrix live in guest
+ * memory (row-major with a stride, tile-blocked, Z-order), plus a
+ * prefetching host-side tile gather
+ */
+
+#ifndef RISCV_LAYOUT_H
+#define RISCV_LAYOUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    LAYOUT_ROW_MAJOR,       // element (r, c) at r * stride + 4 * c
+    LAYOUT_BLOCKED,         // 16-byte tiles, row-major by tile
+    LAYOUT_ZORDER           // 16-byte tiles in Morton order of (tile row, tile col)
+} layout_kind_t;
+
+typedef struct {
+    layout_kind_t kind;
+    uint32_t rows;          // elements; even
+    uint32_t cols;
+    xlen_t stride;          // LAYOUT_ROW_MAJOR row pitch in bytes, 0 = 4 * cols
+} matrix_layout_t;
+
+// Tiles gathered ahead of the one being copied
+#define LAYOUT_PREFETCH_DISTANCE 8
+
+// Check dimensions: even rows/cols, a row-major stride covering a row, and
+// square power-of-two tile grids for Z-order
+int layout_validate(const matrix_layout_t *layout);
+
+size_t layout_bytes(const matrix_layout_t *layout);
+
+// Byte offset of tile (ti, tj)'s top-left element, and the distance from
+// its first row to its second: the stride for row-major, 8 otherwise. The
+// pitch is what MATMUL's tilepitcha/tilepitchb CSRs take (see csr.h).
+xlen_t layout_tile_offset(const matrix_layout_t *layout, uint32_t ti, uint32_t tj);
+xlen_t layout_tile_pitch(const matrix_layout_t *layout);
+
+// Copy count tiles at (tile_rows[i], tile_cols[i]) of the matrix at base
+// into out, prefetching LAYOUT_PREFETCH_DISTANCE tiles ahead when
+// prefetch is set. Fails if any tile is outside guest memory.
+int layout_gather(cpu_state_t *cpu, xlen_t base, const matrix_layout_t *layout,
+                  const uint32_t *tile_rows, const uint32_t *tile_cols, size_t count,
+                  matrix_2x2_t *out, bool prefetch);
+
+// Host copies between a dense row-major array and guest memory
+int layout_store(cpu_state_t *cpu, xlen_t base, const matrix_layout_t *layout, const int32_t *dense);
+int layout_load(cpu_state_t *cpu, xlen_t base, const matrix_layout_t *layout, int32_t *dense);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_LAYOUT_H */
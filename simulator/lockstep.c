@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "riscv_matrix_ext.h"
+#include "interpreter.h"
+#include "lockstep.h"
+
+// Lockstep multi-hart execution
+// Every step picks the lanes with the lowest pc (min-pc reconvergence) and
+// executes that instruction for all of them at once. While the lanes agree
+// this is every live lane; after a data-dependent branch the lanes that fell
+// behind run first until they catch up. ALU, MUL and control-flow ops are
+// applied with fixed-width lane loops over the SoA register file, which the
+// compiler turns into SSE/AVX2/AVX-512 code depending on the target flags
+// (see SIMD_FLAGS in the Makefile). Memory, custom and system instructions
+// fall back to the scalar interpreter lane by lane.
+
+#define FOR_LANES for (int l = 0; l < LOCKSTEP_MAX_LANES; l++)
+
+lockstep_group_t* lockstep_create(int lanes, size_t memory_size) {
+    if (lanes != 8 && lanes != 16) {
+        printf("ERROR: Lockstep groups support 8 or 16 lanes, not %d\n", lanes);
+        return NULL;
+    }
+
+    lockstep_group_t *group = calloc(1, sizeof(lockstep_group_t));
+    if (!group) return NULL;
+
+    group->lanes = lanes;
+    for (int l = 0; l < LOCKSTEP_MAX_LANES; l++) {
+        // Lanes beyond the group size stay halted and are never scheduled
+        group->halted[l] = (l >= lanes);
+        if (l >= lanes) continue;
+
+        group->cpu[l] = init_cpu(memory_size);
+        if (!group->cpu[l]) {
+            lockstep_free(group);
+            return NULL;
+        }
+    }
+
+    return group;
+}
+
+void lockstep_free(lockstep_group_t *group) {
+    if (!group) return;
+
+    for (int l = 0; l < LOCKSTEP_MAX_LANES; l++) {
+        free_cpu(group->cpu[l]);
+    }
+    free(group);
+}
+
+int lockstep_load_image(lockstep_group_t *group, xlen_t addr, const void *data, size_t size) {
+    for (int l = 0; l < group->lanes; l++) {
+        int status = load_image(group->cpu[l], addr, data, size);
+        if (status != RISCV_SUCCESS) return status;
+    }
+    return RISCV_SUCCESS;
+}
+
+void lockstep_set_pc(lockstep_group_t *group, xlen_t pc) {
+    for (int l = 0; l < group->lanes; l++) {
+        group->pc[l] = pc;
+        group->halted[l] = false;
+        // The scalar path copies cpu->halted back into the lane, so a halt
+        // left over from the previous run would stop the lane again
+        group->cpu[l]->halted = false;
+        group->cpu[l]->exit_code = 0;
+    }
+}
+
+// Apply d to every lane in mask with vector lane loops. Returns false if the
+// op has no vector form and must take the scalar path.
+static bool lockstep_vector(lockstep_group_t *group, const decoded_insn_t *d,
+                            const xlen_t *mask) {
+    const xlen_t *ra = group->regs[d->rs1];
+    const xlen_t *rb = group->regs[d->rs2];
+    const xlen_t imm = (xlen_t)d->imm;
+    const xlen_t fall = d->pc + d->len;
+    const xlen_t target = d->pc + imm;
+    xlen_t v[LOCKSTEP_MAX_LANES];
+    xlen_t next[LOCKSTEP_MAX_LANES];
+    bool wb = true;
+
+    FOR_LANES next[l] = fall;
+
+#define LANE_ALU(expr) \
+    FOR_LANES { xlen_t a = ra[l], b = rb[l]; (void)a; (void)b; v[l] = (expr); } \
+    break
+
+#define LANE_BRANCH(cond) \
+    wb = false; \
+    FOR_LANES { xlen_t a = ra[l], b = rb[l]; next[l] = (cond) ? target : fall; } \
+    break
+
+    switch (d->op) {
+    case OP_LUI:   LANE_ALU(imm);
+    case OP_AUIPC: LANE_ALU(d->pc + imm);
+    case OP_JAL:   FOR_LANES { v[l] = fall; next[l] = target; } break;
+    case OP_JALR:  FOR_LANES { v[l] = fall; next[l] = (ra[l] + imm) & ~(xlen_t)1; } break;
+
+    case OP_BEQ:  LANE_BRANCH(a == b);
+    case OP_BNE:  LANE_BRANCH(a != b);
+    case OP_BLT:  LANE_BRANCH((sxlen_t)a < (sxlen_t)b);
+    case OP_BGE:  LANE_BRANCH((sxlen_t)a >= (sxlen_t)b);
+    case OP_BLTU: LANE_BRANCH(a < b);
+    case OP_BGEU: LANE_BRANCH(a >= b);
+
+    case OP_ADDI:  LANE_ALU(a + imm);
+    case OP_SLTI:  LANE_ALU((xlen_t)((sxlen_t)a < (sxlen_t)imm));
+    case OP_SLTIU: LANE_ALU((xlen_t)(a < imm));
+    case OP_XORI:  LANE_ALU(a ^ imm);
+    case OP_ORI:   LANE_ALU(a | imm);
+    case OP_ANDI:  LANE_ALU(a & imm);
+    case OP_SLLI:  LANE_ALU(a << d->imm);
+    case OP_SRLI:  LANE_ALU(a >> d->imm);
+    case OP_SRAI:  LANE_ALU((xlen_t)((sxlen_t)a >> d->imm));
+
+    case OP_ADD:  LANE_ALU(a + b);
+    case OP_SUB:  LANE_ALU(a - b);
+    case OP_SLL:  LANE_ALU(a << (b & (XLEN - 1)));
+    case OP_SLT:  LANE_ALU((xlen_t)((sxlen_t)a < (sxlen_t)b));
+    case OP_SLTU: LANE_ALU((xlen_t)(a < b));
+    case OP_XOR:  LANE_ALU(a ^ b);
+    case OP_SRL:  LANE_ALU(a >> (b & (XLEN - 1)));
+    case OP_SRA:  LANE_ALU((xlen_t)((sxlen_t)a >> (b & (XLEN - 1))));
+    case OP_OR:   LANE_ALU(a | b);
+    case OP_AND:  LANE_ALU(a & b);
+    case OP_MUL:  LANE_ALU(a * b);
+
+    case OP_FENCE:
+    case OP_MARKER:
+        wb = false;
+        break;
+
+    default:
+        return false;
+    }
+
+#undef LANE_ALU
+#undef LANE_BRANCH
+
+    if (wb && d->rd != 0) {
+        xlen_t *rd = group->regs[d->rd];
+        FOR_LANES rd[l] = (v[l] & mask[l]) | (rd[l] & ~mask[l]);
+    }
+    FOR_LANES group->pc[l] = (next[l] & mask[l]) | (group->pc[l] & ~mask[l]);
+    return true;
+}
+
+// Scalar fallback: run d on each masked lane through the interpreter
+static int lockstep_scalar(lockstep_group_t *group, const decoded_insn_t *d,
+                           const xlen_t *mask) {
+    for (int l = 0; l < group->lanes; l++) {
+        if (!mask[l]) continue;
+
+        cpu_state_t *cpu = group->cpu[l];
+        for (int r = 0; r < NUM_REGISTERS; r++) {
+            cpu->regs[r] = group->regs[r][l];
+        }
+        cpu->pc = group->pc[l];
+
+        int status = riscv_execute_decoded(cpu, d);
+
+        for (int r = 0; r < NUM_REGISTERS; r++) {
+            group->regs[r][l] = cpu->regs[r];
+        }
+        group->pc[l] = cpu->pc;
+        group->halted[l] = cpu->halted;
+        group->scalar_lane_insns++;
+
+        if (status != RISCV_SUCCESS) {
+            group->halted[l] = true;
+            return status;
+        }
+    }
+    return RISCV_SUCCESS;
+}
+
+int lockstep_run(lockstep_group_t *group, uint64_t max_steps) {
+    xlen_t mask[LOCKSTEP_MAX_LANES];
+    int status = RISCV_SUCCESS;
+
+    for (uint64_t step = 0; step < max_steps; step++) {
+        // Pick the lowest pc among live lanes
+        int leader = -1;
+        int live = 0;
+        for (int l = 0; l < group->lanes; l++) {
+            if (group->halted[l]) continue;
+            live++;
+            if (leader < 0 || group->pc[l] < group->pc[leader]) leader = l;
+        }
+        if (leader < 0) break;
+
+        xlen_t pc = group->pc[leader];
+        int active = 0;
+        FOR_LANES {
+            bool on = !group->halted[l] && group->pc[l] == pc;
+            mask[l] = on ? ~(xlen_t)0 : 0;
+            active += on;
+        }
+
+        if (active == live) group->converged_steps++;
+        else group->divergent_steps++;
+
+        const decoded_insn_t *d = predecode_fetch(group->cpu[0], pc);
+        if (!d) {
+            status = RISCV_ERROR_MEMORY;
+            break;
+        }
+
+        if (!lockstep_vector(group, d, mask)) {
+            status = lockstep_scalar(group, d, mask);
+            if (status != RISCV_SUCCESS) break;
+        }
+
+        for (int l = 0; l < group->lanes; l++) {
+            group->cpu[l]->instret += mask[l] & 1;
+        }
+    }
+
+    return status;
+}
@@ -0,0 +1,51 @@
+/**
+ * Lockstep Multi-Hart Execution
+ * Runs 8 or 16 independent copies of one guest program with their register
+ * files in structure-of-arrays form, so converged lanes execute each
+ * instruction as a single vector operation
+ */
+
+#ifndef RISCV_LOCKSTEP_H
+#define RISCV_LOCKSTEP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOCKSTEP_MAX_LANES 16
+
+typedef struct {
+    int lanes;                                          // 8 or 16
+    xlen_t regs[NUM_REGISTERS][LOCKSTEP_MAX_LANES];     // regs[r][lane]
+    xlen_t pc[LOCKSTEP_MAX_LANES];
+    bool halted[LOCKSTEP_MAX_LANES];
+
+    // Per-lane memory and exit status. Lane 0 also holds the shared
+    // predecode cache, so all lanes must run the same (unmodified) code.
+    cpu_state_t *cpu[LOCKSTEP_MAX_LANES];
+
+    uint64_t converged_steps;       // all live lanes at the same pc
+    uint64_t divergent_steps;       // only a subset of lanes advanced
+    uint64_t scalar_lane_insns;     // lane instructions taking the scalar path
+} lockstep_group_t;
+
+lockstep_group_t* lockstep_create(int lanes, size_t memory_size);
+void lockstep_free(lockstep_group_t *group);
+
+// Copy the program into every lane and point all lanes at entry
+int lockstep_load_image(lockstep_group_t *group, xlen_t addr, const void *data, size_t size);
+void lockstep_set_pc(lockstep_group_t *group, xlen_t pc);
+
+// Run until all lanes halt or max_steps group steps have been taken
+int lockstep_run(lockstep_group_t *group, uint64_t max_steps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_LOCKSTEP_H */
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "riscv_matrix_ext.h"
+
+// RISC-V Matrix Extension Simulator - demo driver
+
+// Utility function to print matrix from memory
+void print_matrix_at_address(cpu_state_t *cpu, xlen_t addr, const char* name) {
+    matrix_2x2_t matrix = read_matrix_2x2(cpu, addr);
+    printf("%s at 0x%" PRIxXLEN ": [[%d, %d], [%d, %d]]\n", name, addr,
+           matrix.m[0][0], matrix.m[0][1],
+           matrix.m[1][0], matrix.m[1][1]);
+}
+
+// Demo function
+void run_matmul_demo(cpu_state_t *cpu) {
+    printf("=== RISC-V MATMUL Instruction Demo ===\n\n");
+    
+    // Set up test matrices in memory
+    xlen_t addr_a = 0x1000;
+    xlen_t addr_b = 0x1020;
+    xlen_t addr_result = 0x1040;
+    
+    // Matrix A = [[1, 2], [3, 4]]
+    write_word(cpu, addr_a + 0,  1);
+    write_word(cpu, addr_a + 4,  2);
+    write_word(cpu, addr_a + 8,  3);
+    write_word(cpu, addr_a + 12, 4);
+    
+    // Matrix B = [[5, 6], [7, 8]]
+    write_word(cpu, addr_b + 0,  5);
+    write_word(cpu, addr_b + 4,  6);
+    write_word(cpu, addr_b + 8,  7);
+    write_word(cpu, addr_b + 12, 8);
+    
+    // Set up registers (rd=x1, rs1=x2, rs2=x3)
+    cpu->regs[1] = addr_result;  // rd
+    cpu->regs[2] = addr_a;       // rs1
+    cpu->regs[3] = addr_b;       // rs2
+    
+    printf("Initial setup:\n");
+    print_matrix_at_address(cpu, addr_a, "Matrix A");
+    print_matrix_at_address(cpu, addr_b, "Matrix B");
+    printf("\n");
+    
+    // Create MATMUL instruction: func7=1, rs2=3, rs1=2, func3=7, rd=1, opcode=0x2B
+    uint32_t matmul_inst = (FUNC7_MATMUL << 25) | (3 << 20) | (2 << 15) | 
+                          (FUNC3_MATMUL << 12) | (1 << 7) | OPCODE_CUSTOM_1;
+    
+    printf("Instruction encoding: 0x%08x\n", matmul_inst);
+    printf("Executing instruction...\n\n");
+    
+    // Execute the instruction
+    if (execute_instruction(cpu, matmul_inst) == 0) {
+        printf("\nResult after execution:\n");
+        print_matrix_at_address(cpu, addr_result, "Result Matrix");
+        printf("\nExpected: [[19, 22], [43, 50]] (1*5+2*7=19, 1*6+2*8=22, etc.)\n");
+    }
+
+#if XLEN == 64
+    // RV64: the same instruction with operands far above the flat RAM
+    xlen_t high_base = 0x00007f0000000000ull;
+    write_matrix_2x2(cpu, high_base + 0x000, read_matrix_2x2(cpu, addr_a));
+    write_matrix_2x2(cpu, high_base + 0x2000, read_matrix_2x2(cpu, addr_b));
+    cpu->regs[1] = high_base + 0x4000;
+    cpu->regs[2] = high_base + 0x000;
+    cpu->regs[3] = high_base + 0x2000;
+
+    printf("\nRV64 sparse addressing:\n");
+    if (execute_instruction(cpu, matmul_inst) == 0) {
+        print_matrix_at_address(cpu, high_base + 0x4000, "Result Matrix");
+    }
+#endif
+}
+
+int main() {
+    cpu_state_t *cpu = init_cpu(64 * 1024);  // 64KB memory
+    if (!cpu) {
+        printf("Failed to initialize CPU\n");
+        return 1;
+    }
+    
+    riscv_debug_enable(cpu, true);
+    run_matmul_demo(cpu);
+    
+    free_cpu(cpu);
+    return 0;
+}
@@ -0,0 +1,527 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "riscv_matrix_ext.h"
+#include "sparse_memory.h"
+#include "interpreter.h"
+#include "timing.h"
+#include "replay.h"
+#include "multihart.h"
+
+// Multi-hart timing
+// Harts interact through a shared memory bus. Every cache line fetched on
+// a miss needs one bus slot (bus_cycles long) at or after the miss; if the
+// slot is taken the line waits for the next free one. The bus is a
+// calendar rather than a single "free at" time, so a request that arrives
+// out of time order fills the gap it belongs in instead of queueing
+// behind requests from the future.
+//
+// In serial mode the hart with the lowest cycle count always steps next,
+// which is the reference ordering. The parallel modes let each hart run
+// ahead on its own thread to the end of the current quantum.
+// MULTIHART_PARALLEL claims slots in the shared calendar under a lock, so
+// results depend on thread scheduling. MULTIHART_DETERMINISTIC keeps each
+// hart's claims private until the quantum ends and merges them in hart
+// order; harts then only miss each other's traffic within one quantum.
+// That makes the bus timing independent of scheduling, but the harts
+// still run at once over shared RAM, so the results are deterministic
+// only when their working sets are disjoint. Harts that share data need
+// the serialized turns below.
+//
+// With a record/replay log attached, the harts of a quantum take turns
+// instead of running at once, so a hart sees exactly the stores of the
+// harts that ran before it. Each hart logs its turn and the delay the bus
+// gave it. Replay runs the harts in the logged order and hands the logged
+// delays back without touching the calendar or the lock, which reproduces
+// a parallel run exactly, including harts that share data in RAM.
+//
+// NUMA placement assigns harts to host nodes in contiguous blocks so that
+// neighbouring harts (and their neighbouring regions) share a node. Worker
+// threads pin themselves to their node before the first quantum.
+
+#define DEFAULT_BUS_CYCLES 8
+#define BUS_SLOT_MASK ((uint64_t)MULTIHART_BUS_SLOTS - 1)
+
+static bool slot_taken(const multihart_t *system, int hart, uint64_t slot) {
+    size_t i = (size_t)(slot & BUS_SLOT_MASK);
+    if (system->bus_slots[i]) return true;
+    return system->mode == MULTIHART_DETERMINISTIC && system->bus_own[hart][i];
+}
+
+static void claim_slot(multihart_t *system, int hart, uint64_t slot) {
+    size_t i = (size_t)(slot & BUS_SLOT_MASK);
+    if (system->mode != MULTIHART_DETERMINISTIC) {
+        system->bus_slots[i] = 1;
+        return;
+    }
+
+    if (system->claim_count[hart] == system->claim_capacity[hart]) {
+        size_t capacity = system->claim_capacity[hart] ? system->claim_capacity[hart] * 2 : 256;
+        uint64_t *claims = realloc(system->bus_claims[hart], capacity * sizeof(uint64_t));
+        if (!claims) return;  // untracked: costs accuracy, not correctness
+        system->bus_claims[hart] = claims;
+        system->claim_capacity[hart] = capacity;
+    }
+    system->bus_claims[hart][system->claim_count[hart]++] = slot;
+    system->bus_own[hart][i] = 1;
+}
+
+static uint64_t bus_acquire(void *ctx, uint64_t cycle, uint32_t lines) {
+    multihart_port_t *port = ctx;
+    multihart_t *system = port->system;
+    rr_stream_t *log = system->cpu[port->hart]->replay;
+    if (log && log->mode == RR_REPLAY && !log->diverged) {
+        return rr_value(log, RR_EVENT_BUS_DELAY, 0);
+    }
+
+    uint64_t slot = cycle / system->bus_cycles;
+    if (slot < system->bus_base) slot = system->bus_base;
+    uint64_t last = slot;
+
+    if (system->mode == MULTIHART_PARALLEL) pthread_mutex_lock(&system->bus_lock);
+
+    for (uint32_t l = 0; l < lines; l++) {
+        while (slot - system->bus_base < MULTIHART_BUS_SLOTS &&
+               slot_taken(system, port->hart, slot)) {
+            slot++;
+        }
+        if (slot - system->bus_base >= MULTIHART_BUS_SLOTS) break;  // beyond the horizon
+        claim_slot(system, port->hart, slot);
+        last = slot++;
+    }
+
+    if (system->mode == MULTIHART_PARALLEL) pthread_mutex_unlock(&system->bus_lock);
+
+    uint64_t finish = (last + 1) * system->bus_cycles;
+    uint64_t uncontended = cycle + (uint64_t)lines * system->bus_cycles;
+    uint64_t delay = finish > uncontended ? finish - uncontended : 0;
+    return log ? rr_value(log, RR_EVENT_BUS_DELAY, delay) : delay;
+}
+
+// Forget slots before cycle; no hart can request them any more
+static void bus_retire(multihart_t *system, uint64_t cycle) {
+    uint64_t base = cycle / system->bus_cycles;
+    if (base <= system->bus_base) return;
+
+    if (base - system->bus_base >= MULTIHART_BUS_SLOTS) {
+        memset(system->bus_slots, 0, MULTIHART_BUS_SLOTS);
+    } else {
+        for (uint64_t slot = system->bus_base; slot < base; slot++) {
+            system->bus_slots[slot & BUS_SLOT_MASK] = 0;
+        }
+    }
+    system->bus_base = base;
+}
+
+// Move private claims into the shared calendar, in hart order
+static void bus_merge(multihart_t *system) {
+    for (int h = 0; h < system->harts; h++) {
+        for (size_t c = 0; c < system->claim_count[h]; c++) {
+            uint64_t claimed = system->bus_claims[h][c];
+            uint64_t slot = (claimed < system->bus_base) ? system->bus_base : claimed;
+            while (slot - system->bus_base < MULTIHART_BUS_SLOTS &&
+                   system->bus_slots[slot & BUS_SLOT_MASK]) {
+                slot++;
+            }
+            if (slot - system->bus_base < MULTIHART_BUS_SLOTS) {
+                system->bus_slots[slot & BUS_SLOT_MASK] = 1;
+            }
+            system->bus_own[h][claimed & BUS_SLOT_MASK] = 0;
+        }
+        system->claim_count[h] = 0;
+    }
+}
+
+// Lowest cycle count among running harts (UINT64_MAX if all halted)
+static uint64_t min_running_cycle(const multihart_t *system) {
+    uint64_t min = UINT64_MAX;
+    for (int h = 0; h < system->harts; h++) {
+        const cpu_state_t *cpu = system->cpu[h];
+        if (!cpu->halted && cpu->timing->cycles < min) min = cpu->timing->cycles;
+    }
+    return min;
+}
+
+multihart_t* multihart_create(int harts, size_t memory_size, const timing_config_t *config) {
+    if (harts < 1 || harts > MULTIHART_MAX_HARTS) {
+        printf("ERROR: Hart count must be 1..%d, not %d\n", MULTIHART_MAX_HARTS, harts);
+        return NULL;
+    }
+
+    multihart_t *system = calloc(1, sizeof(multihart_t));
+    if (!system) return NULL;
+
+    system->memory = calloc(memory_size, 1);
+    system->memory_size = memory_size;
+    system->bus_cycles = DEFAULT_BUS_CYCLES;
+    system->bus_slots = calloc(MULTIHART_BUS_SLOTS, 1);
+    pthread_mutex_init(&system->bus_lock, NULL);
+    if (!system->memory || !system->bus_slots) {
+        multihart_free(system);
+        return NULL;
+    }
+
+    for (int h = 0; h < harts; h++) {
+        cpu_state_t *cpu = init_cpu(1);
+        system->cpu[h] = cpu;
+        system->harts = h + 1;
+        system->bus_own[h] = calloc(MULTIHART_BUS_SLOTS, 1);
+        if (!cpu || !system->bus_own[h] || timing_attach(cpu, config) != RISCV_SUCCESS) {
+            multihart_free(system);
+            return NULL;
+        }
+
+        host_free(cpu->memory, cpu->memory_size, cpu->memory_pages);
+        cpu->memory = system->memory;
+        cpu->memory_size = memory_size;
+        cpu->memory_pages = HOST_PAGES_SMALL;
+        sparse_memory_free(cpu->sparse);
+        cpu->sparse = NULL;
+
+        // Each hart tracks only its own writes to the shared RAM
+        free(cpu->dirty);
+        cpu->dirty = calloc(RESET_DIRTY_WORDS(memory_size), sizeof(uint64_t));
+        if (!cpu->dirty) {
+            multihart_free(system);
+            return NULL;
+        }
+
+        system->port[h].system = system;
+        system->port[h].hart = h;
+        cpu->timing->miss_hook = bus_acquire;
+        cpu->timing->miss_ctx = &system->port[h];
+        cpu->regs[10] = (xlen_t)h;  // a0 = hart index at reset
+    }
+
+    host_numa_topology(&system->topology);
+    for (int h = 0; h < harts; h++) {
+        system->hart_node[h] = h * system->topology.nodes / harts;
+    }
+    return system;
+}
+
+void multihart_free(multihart_t *system) {
+    if (!system) return;
+
+    for (int h = 0; h < system->harts; h++) {
+        cpu_state_t *cpu = system->cpu[h];
+        free(system->bus_own[h]);
+        free(system->bus_claims[h]);
+        if (!cpu) continue;
+        if (cpu->memory == system->memory) cpu->memory = NULL;
+        free_cpu(cpu);
+    }
+    pthread_mutex_destroy(&system->bus_lock);
+    free(system->bus_slots);
+    free(system->memory);
+    free(system);
+}
+
+int multihart_load_image(multihart_t *system, xlen_t addr, const void *data, size_t size) {
+    int status = load_image(system->cpu[0], addr, data, size);
+    for (int h = 1; h < system->harts; h++) {
+        predecode_flush(system->cpu[h]);
+    }
+    return status;
+}
+
+int multihart_attach_log(multihart_t *system, rr_log_t *log) {
+    if (log && log->streams != system->harts) {
+        printf("ERROR: Replay log has %d streams for %d harts\n", log->streams, system->harts);
+        return RISCV_ERROR_INSTRUCTION;
+    }
+    for (int h = 0; h < system->harts; h++) {
+        system->cpu[h]->replay = log ? &log->stream[h] : NULL;
+    }
+    return RISCV_SUCCESS;
+}
+
+typedef struct {
+    multihart_t *system;
+    int hart;
+    int status;
+} numa_toucher_t;
+
+// Fault in one hart's region from a thread on that hart's node
+static void* numa_touch(void *arg) {
+    numa_toucher_t *toucher = arg;
+    multihart_t *system = toucher->system;
+    const multihart_numa_t *numa = &system->numa;
+
+    toucher->status = host_numa_pin_thread(&system->topology, system->hart_node[toucher->hart]);
+    size_t offset = (size_t)numa->region_base + (size_t)toucher->hart * numa->region_size;
+    volatile uint8_t *region = system->memory + offset;
+    for (size_t i = 0; i < numa->region_size; i += 4096) {
+        region[i] = region[i];
+    }
+    return NULL;
+}
+
+int multihart_set_numa(multihart_t *system, const multihart_numa_t *numa) {
+    if (numa->policy != MULTIHART_NUMA_NONE &&
+        ((size_t)numa->region_base > system->memory_size ||
+         numa->region_size > (system->memory_size - (size_t)numa->region_base) / (size_t)system->harts)) {
+        printf("ERROR: NUMA regions do not fit in %zu bytes of guest RAM\n", system->memory_size);
+        return RISCV_ERROR_BOUNDS;
+    }
+    system->numa = *numa;
+
+    int status = RISCV_SUCCESS;
+    switch (numa->policy) {
+    case MULTIHART_NUMA_NONE:
+        break;
+
+    case MULTIHART_NUMA_FIRST_TOUCH: {
+        numa_toucher_t touchers[MULTIHART_MAX_HARTS];
+        pthread_t threads[MULTIHART_MAX_HARTS];
+        int started = 0;
+        for (int h = 0; h < system->harts; h++) {
+            touchers[h] = (numa_toucher_t){ .system = system, .hart = h, .status = RISCV_SUCCESS };
+            if (pthread_create(&threads[h], NULL, numa_touch, &touchers[h]) != 0) {
+                printf("ERROR: Failed to start first-touch thread %d\n", h);
+                status = RISCV_ERROR_MEMORY;
+                break;
+            }
+            started++;
+        }
+        for (int h = 0; h < started; h++) {
+            pthread_join(threads[h], NULL);
+            if (touchers[h].status != RISCV_SUCCESS) status = touchers[h].status;
+        }
+        break;
+    }
+
+    case MULTIHART_NUMA_BIND:
+        for (int h = 0; h < system->harts && status == RISCV_SUCCESS; h++) {
+            size_t offset = (size_t)numa->region_base + (size_t)h * numa->region_size;
+            status = host_numa_bind(system->memory + offset, numa->region_size, system->hart_node[h]);
+        }
+        break;
+
+    case MULTIHART_NUMA_INTERLEAVE:
+        status = host_numa_interleave(system->memory, system->memory_size, &system->topology);
+        break;
+    }
+    return status;
+}
+
+static int run_serial(multihart_t *system, uint64_t max_cycles) {
+    for (;;) {
+        cpu_state_t *next = NULL;
+        for (int h = 0; h < system->harts; h++) {
+            cpu_state_t *cpu = system->cpu[h];
+            if (cpu->halted || cpu->timing->cycles >= max_cycles) continue;
+            if (!next || cpu->timing->cycles < next->timing->cycles) next = cpu;
+        }
+        if (!next) return RISCV_SUCCESS;
+
+        bus_retire(system, next->timing->cycles);
+        int status = riscv_run_timed(next, 1);
+        if (status != RISCV_SUCCESS) return status;
+    }
+}
+
+// Shared state of one parallel run. The barrier is hand-rolled (mutex +
+// condition variable) since pthread_barrier_t is optional in POSIX.
+typedef struct {
+    multihart_t *system;
+    uint64_t quantum;
+    uint64_t max_cycles;
+    uint64_t limit;             // end of the current quantum
+    bool done;
+    int status;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int waiting;
+    unsigned generation;
+
+    // Log attached: one hart runs at a time, in the logged order on replay
+    bool serialize;
+    bool busy;                  // a hart is running its turn
+    int turn;                   // turns taken this quantum
+    int runnable;               // harts not halted when the quantum began
+    int arrived;                // replaying harts waiting for their turn
+    uint64_t want[MULTIHART_MAX_HARTS];  // logged turn of a waiting hart
+} parallel_run_t;
+
+typedef struct {
+    parallel_run_t *run;
+    int hart;
+} hart_worker_t;
+
+static int count_runnable(const multihart_t *system) {
+    int runnable = 0;
+    for (int h = 0; h < system->harts; h++) runnable += !system->cpu[h]->halted;
+    return runnable;
+}
+
+// Runs on the last thread to reach the barrier, with every other hart
+// stopped
+static void quantum_end(parallel_run_t *run) {
+    multihart_t *system = run->system;
+
+    if (system->mode == MULTIHART_DETERMINISTIC) bus_merge(system);
+    uint64_t min_cycle = min_running_cycle(system);
+    bool all_halted = (min_cycle == UINT64_MAX);
+    if (!all_halted) bus_retire(system, min_cycle);
+
+    system->quanta++;
+    run->turn = 0;
+    run->runnable = count_runnable(system);
+    if (all_halted || run->status != RISCV_SUCCESS || run->limit >= run->max_cycles) {
+        run->done = true;
+    } else {
+        run->limit = (run->max_cycles - run->limit > run->quantum) ? run->limit + run->quantum
+                                                                   : run->max_cycles;
+    }
+}
+
+static void quantum_barrier(parallel_run_t *run) {
+    pthread_mutex_lock(&run->lock);
+    unsigned generation = run->generation;
+    if (++run->waiting == run->system->harts) {
+        quantum_end(run);
+        run->waiting = 0;
+        run->generation++;
+        pthread_cond_broadcast(&run->cond);
+    } else {
+        while (generation == run->generation) {
+            pthread_cond_wait(&run->cond, &run->lock);
+        }
+    }
+    pthread_mutex_unlock(&run->lock);
+}
+
+// Replay: a waiting hart may go out of its logged order only when every
+// hart still due this quantum is waiting and it has the lowest logged turn,
+// so a diverged log cannot deadlock the run
+static bool replay_turn_ready(const parallel_run_t *run, uint64_t want) {
+    if (want == (uint64_t)run->turn) return true;
+    if (run->arrived < run->runnable - run->turn) return false;
+    for (int h = 0; h < run->system->harts; h++) {
+        if (run->want[h] < want) return false;
+    }
+    return true;
+}
+
+// Wait until this hart may run. Recording takes turns first come, first
+// served and logs each one; replay waits for the logged turn.
+static void turn_begin(parallel_run_t *run, int hart) {
+    rr_stream_t *log = run->system->cpu[hart]->replay;
+    pthread_mutex_lock(&run->lock);
+    if (log->mode == RR_RECORD) {
+        while (run->busy && !run->done) pthread_cond_wait(&run->cond, &run->lock);
+        rr_value(log, RR_EVENT_TURN, (uint64_t)run->turn);
+    } else {
+        uint64_t want = log->diverged ? UINT64_MAX : rr_value(log, RR_EVENT_TURN, UINT64_MAX);
+        run->want[hart] = want;
+        run->arrived++;
+        while ((run->busy || !replay_turn_ready(run, want)) && !run->done) {
+            pthread_cond_wait(&run->cond, &run->lock);
+        }
+        run->arrived--;
+        run->want[hart] = UINT64_MAX;
+    }
+    run->busy = true;
+    pthread_mutex_unlock(&run->lock);
+}
+
+static void turn_end(parallel_run_t *run) {
+    pthread_mutex_lock(&run->lock);
+    run->busy = false;
+    run->turn++;
+    pthread_cond_broadcast(&run->cond);
+    pthread_mutex_unlock(&run->lock);
+}
+
+static void* hart_worker(void *arg) {
+    hart_worker_t *worker = arg;
+    parallel_run_t *run = worker->run;
+    cpu_state_t *cpu = run->system->cpu[worker->hart];
+
+    if (run->system->numa.policy != MULTIHART_NUMA_NONE) {
+        // A failed pin only costs locality
+        host_numa_pin_thread(&run->system->topology, run->system->hart_node[worker->hart]);
+    }
+
+    while (!run->done) {
+        if (!cpu->halted) {
+            if (run->serialize) turn_begin(run, worker->hart);
+            int status = riscv_run_timed_until(cpu, run->limit);
+            if (status != RISCV_SUCCESS) {
+                pthread_mutex_lock(&run->lock);
+                run->status = status;
+                pthread_mutex_unlock(&run->lock);
+                cpu->halted = true;
+            }
+            if (run->serialize) turn_end(run);
+        }
+        quantum_barrier(run);
+    }
+    return NULL;
+}
+
+static int run_parallel(multihart_t *system, uint64_t quantum, uint64_t max_cycles) {
+    parallel_run_t run = { .system = system, .quantum = quantum, .max_cycles = max_cycles,
+                           .status = RISCV_SUCCESS };
+    hart_worker_t workers[MULTIHART_MAX_HARTS];
+    pthread_t threads[MULTIHART_MAX_HARTS];
+
+    uint64_t start = UINT64_MAX;
+    for (int h = 0; h < system->harts; h++) {
+        if (system->cpu[h]->timing->cycles < start) start = system->cpu[h]->timing->cycles;
+    }
+    run.limit = (max_cycles - start > quantum) ? start + quantum : max_cycles;
+    run.serialize = system->cpu[0]->replay != NULL;
+    run.runnable = count_runnable(system);
+    for (int h = 0; h < system->harts; h++) run.want[h] = UINT64_MAX;
+
+    pthread_mutex_init(&run.lock, NULL);
+    pthread_cond_init(&run.cond, NULL);
+
+    int started = 0;
+    for (int h = 0; h < system->harts; h++) {
+        workers[h].run = &run;
+        workers[h].hart = h;
+        if (pthread_create(&threads[h], NULL, hart_worker, &workers[h]) != 0) break;
+        started++;
+    }
+
+    if (started < system->harts) {
+        // The barrier can never fill; stop the started workers by hand
+        printf("ERROR: Failed to start hart thread %d\n", started);
+        pthread_mutex_lock(&run.lock);
+        run.done = true;
+        run.status = RISCV_ERROR_MEMORY;
+        run.generation++;
+        pthread_cond_broadcast(&run.cond);
+        pthread_mutex_unlock(&run.lock);
+    }
+
+    for (int h = 0; h < started; h++) {
+        pthread_join(threads[h], NULL);
+    }
+
+    pthread_cond_destroy(&run.cond);
+    pthread_mutex_destroy(&run.lock);
+    return run.status;
+}
+
+int multihart_run(multihart_t *system, multihart_mode_t mode, uint64_t quantum,
+                  uint64_t max_cycles) {
+    if (mode != MULTIHART_SERIAL && quantum == 0) {
+        printf("ERROR: Parallel multi-hart runs need a non-zero quantum\n");
+        return RISCV_ERROR_INSTRUCTION;
+    }
+
+    system->mode = mode;
+    system->quanta = 0;
+    if (mode == MULTIHART_SERIAL) return run_serial(system, max_cycles);
+    return run_parallel(system, quantum, max_cycles);
+}
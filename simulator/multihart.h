@@ -0,0 +1,115 @@
+/**
+ * Multi-Hart Timing Simulation
+ * Several harts share guest RAM and a memory bus. The serial mode
+ * interleaves harts in global cycle order; the parallel modes run each
+ * hart's timing model on its own thread and synchronize every quantum.
+ */
+
+#ifndef RISCV_MULTIHART_H
+#define RISCV_MULTIHART_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "riscv_matrix_ext.h"
+#include "timing.h"
+#include "replay.h"
+#include "host_numa.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MULTIHART_MAX_HARTS 64
+#define MULTIHART_BUS_SLOTS (1u << 16)     // bus calendar horizon, power of two
+
+typedef enum {
+    MULTIHART_SERIAL,           // one thread, lowest-cycle hart steps next
+    MULTIHART_PARALLEL,         // threads share the bus state under a lock
+    MULTIHART_DETERMINISTIC     // threads see the bus as of the last quantum
+} multihart_mode_t;
+
+// Host NUMA placement of hart threads and their guest memory
+typedef enum {
+    MULTIHART_NUMA_NONE,            // OS default; threads float
+    MULTIHART_NUMA_FIRST_TOUCH,     // pinned harts fault in their own region
+    MULTIHART_NUMA_BIND,            // regions bound to their hart's node
+    MULTIHART_NUMA_INTERLEAVE       // RAM interleaved over all nodes, harts pinned
+} multihart_numa_policy_t;
+
+// Hart h's working set is region_base + h * region_size. Harts are spread
+// over nodes in contiguous blocks.
+typedef struct {
+    multihart_numa_policy_t policy;
+    xlen_t region_base;
+    size_t region_size;
+} multihart_numa_t;
+
+typedef struct multihart multihart_t;
+
+// Per-hart context handed to the timing model's miss hook
+typedef struct {
+    multihart_t *system;
+    int hart;
+} multihart_port_t;
+
+struct multihart {
+    int harts;
+    uint8_t *memory;            // shared guest RAM
+    size_t memory_size;
+    cpu_state_t *cpu[MULTIHART_MAX_HARTS];
+    multihart_port_t port[MULTIHART_MAX_HARTS];
+
+    // Shared bus calendar: time is cut into slots of bus_cycles, each of
+    // which carries one cache line. bus_slots is a ring covering
+    // MULTIHART_BUS_SLOTS slots from bus_base on.
+    uint32_t bus_cycles;
+    uint8_t *bus_slots;
+    uint64_t bus_base;
+    multihart_mode_t mode;
+    pthread_mutex_t bus_lock;
+
+    // Deterministic mode: slots each hart claimed this quantum, kept out of
+    // the shared calendar until the quantum ends
+    uint8_t *bus_own[MULTIHART_MAX_HARTS];
+    uint64_t *bus_claims[MULTIHART_MAX_HARTS];
+    size_t claim_count[MULTIHART_MAX_HARTS];
+    size_t claim_capacity[MULTIHART_MAX_HARTS];
+
+    uint64_t quanta;            // synchronization rounds in the last run
+
+    multihart_numa_t numa;
+    host_numa_topology_t topology;
+    int hart_node[MULTIHART_MAX_HARTS];
+};
+
+// Harts share one RAM of memory_size bytes. Sparse memory is disabled:
+// its page table is not thread safe. NULL config uses timing defaults.
+multihart_t* multihart_create(int harts, size_t memory_size, const timing_config_t *config);
+void multihart_free(multihart_t *system);
+
+int multihart_load_image(multihart_t *system, xlen_t addr, const void *data, size_t size);
+
+// Record or replay every hart's bus outcomes, its turn in each quantum and
+// host-time reads; the log needs one stream per hart. While a log is
+// attached, parallel runs execute the harts of a quantum one at a time.
+// NULL detaches.
+int multihart_attach_log(multihart_t *system, rr_log_t *log);
+
+// Apply a NUMA policy to the guest RAM; parallel runs then pin each hart
+// thread to its node (serial runs stay on the calling thread). First touch
+// only places pages not yet faulted in, so set it before loading data.
+int multihart_set_numa(multihart_t *system, const multihart_numa_t *numa);
+
+// Run every hart to halt or max_cycles. quantum (cycles) is ignored in
+// serial mode.
+int multihart_run(multihart_t *system, multihart_mode_t mode, uint64_t quantum,
+                  uint64_t max_cycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_MULTIHART_H */
@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "riscv_matrix_ext.h"
+#include "replay.h"
+
+// Record/replay log
+// Every event is a one-byte tag followed by an LEB128 value (or a length
+// and raw bytes for input). Most bus delays and timer deltas fit in one or
+// two bytes. Streams are independent, so parallel harts record and replay
+// without locking. On replay a tag mismatch or an exhausted stream marks
+// the stream diverged and hands back the live value from then on.
+//
+// File layout: "RVRR", u32 version, u32 stream count, then per stream a
+// u64 length and its bytes. Integers are little-endian.
+
+#define RR_MAGIC "RVRR"
+#define RR_VERSION 1
+
+rr_log_t* rr_create(int streams) {
+    if (streams < 1 || streams > RR_MAX_STREAMS) {
+        printf("ERROR: Replay log supports 1..%d streams, not %d\n", RR_MAX_STREAMS, streams);
+        return NULL;
+    }
+
+    rr_log_t *log = calloc(1, sizeof(rr_log_t));
+    if (!log) return NULL;
+
+    log->mode = RR_RECORD;
+    log->streams = streams;
+    for (int i = 0; i < streams; i++) {
+        log->stream[i].mode = RR_RECORD;
+        log->stream[i].id = i;
+    }
+    return log;
+}
+
+void rr_free(rr_log_t *log) {
+    if (!log) return;
+    for (int i = 0; i < log->streams; i++) {
+        free(log->stream[i].data);
+    }
+    free(log);
+}
+
+static bool rr_reserve(rr_stream_t *stream, size_t extra) {
+    if (extra > SIZE_MAX - stream->len) {
+        printf("ERROR: Replay log stream %d out of memory\n", stream->id);
+        return false;
+    }
+    size_t needed = stream->len + extra;
+    if (needed <= stream->capacity) return true;
+
+    size_t capacity = stream->capacity ? stream->capacity : 4096;
+    while (capacity < needed) capacity = (capacity > SIZE_MAX / 2) ? needed : capacity * 2;
+    uint8_t *data = realloc(stream->data, capacity);
+    if (!data) {
+        printf("ERROR: Replay log stream %d out of memory\n", stream->id);
+        return false;
+    }
+    stream->data = data;
+    stream->capacity = capacity;
+    return true;
+}
+
+static void put_varint(rr_stream_t *stream, uint64_t value) {
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        stream->data[stream->len++] = byte | (value ? 0x80 : 0);
+    } while (value);
+}
+
+static bool get_varint(rr_stream_t *stream, uint64_t *value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (stream->pos >= stream->len) return false;
+        uint8_t byte = stream->data[stream->pos++];
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void diverge(rr_stream_t *stream, rr_event_t event) {
+    if (!stream->diverged) {
+        printf("ERROR: Replay diverged on stream %d at event %llu (expected tag %d)\n",
+               stream->id, (unsigned long long)stream->events, (int)event);
+    }
+    stream->diverged = true;
+}
+
+// Consume the tag of the next replayed event
+static bool replay_tag(rr_stream_t *stream, rr_event_t event) {
+    if (stream->diverged) return false;
+    if (stream->pos >= stream->len || stream->data[stream->pos] != event) {
+        diverge(stream, event);
+        return false;
+    }
+    stream->pos++;
+    return true;
+}
+
+uint64_t rr_value(rr_stream_t *stream, rr_event_t event, uint64_t live) {
+    if (stream->mode == RR_RECORD) {
+        if (rr_reserve(stream, 11)) {
+            stream->data[stream->len++] = (uint8_t)event;
+            put_varint(stream, live);
+        }
+        stream->events++;
+        return live;
+    }
+
+    uint64_t value;
+    if (!replay_tag(stream, event)) return live;
+    if (!get_varint(stream, &value)) {
+        diverge(stream, event);
+        return live;
+    }
+    stream->events++;
+    return value;
+}
+
+void rr_bytes(rr_stream_t *stream, rr_event_t event, void *buf, size_t len) {
+    if (stream->mode == RR_RECORD) {
+        if (rr_reserve(stream, 11 + len)) {
+            stream->data[stream->len++] = (uint8_t)event;
+            put_varint(stream, len);
+            memcpy(stream->data + stream->len, buf, len);
+            stream->len += len;
+        }
+        stream->events++;
+        return;
+    }
+
+    uint64_t logged;
+    if (!replay_tag(stream, event)) return;
+    if (!get_varint(stream, &logged) || logged != len || stream->len - stream->pos < len) {
+        diverge(stream, event);
+        return;
+    }
+    memcpy(buf, stream->data + stream->pos, len);
+    stream->pos += len;
+    stream->events++;
+}
+
+size_t rr_size(const rr_log_t *log) {
+    size_t total = 0;
+    for (int i = 0; i < log->streams; i++) {
+        total += log->stream[i].len;
+    }
+    return total;
+}
+
+bool rr_diverged(const rr_log_t *log) {
+    for (int i = 0; i < log->streams; i++) {
+        if (log->stream[i].diverged) return true;
+    }
+    return false;
+}
+
+static void write_le(FILE *file, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        fputc((int)((value >> (8 * i)) & 0xFF), file);
+    }
+}
+
+static bool read_le(FILE *file, uint64_t *value, int bytes) {
+    uint64_t result = 0;
+    for (int i = 0; i < bytes; i++) {
+        int c = fgetc(file);
+        if (c == EOF) return false;
+        result |= (uint64_t)c << (8 * i);
+    }
+    *value = result;
+    return true;
+}
+
+int rr_save(const rr_log_t *log, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        printf("ERROR: Cannot write replay log %s\n", path);
+        return RISCV_ERROR_MEMORY;
+    }
+
+    fwrite(RR_MAGIC, 1, 4, file);
+    write_le(file, RR_VERSION, 4);
+    write_le(file, (uint64_t)log->streams, 4);
+    for (int i = 0; i < log->streams; i++) {
+        write_le(file, log->stream[i].len, 8);
+        if (log->stream[i].len > 0) {
+            fwrite(log->stream[i].data, 1, log->stream[i].len, file);
+        }
+    }
+
+    int status = ferror(file) ? RISCV_ERROR_MEMORY : RISCV_SUCCESS;
+    if (fclose(file) != 0) status = RISCV_ERROR_MEMORY;
+    return status;
+}
+
+rr_log_t* rr_load(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        printf("ERROR: Cannot open replay log %s\n", path);
+        return NULL;
+    }
+
+    char magic[4];
+    uint64_t version, streams;
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, RR_MAGIC, 4) != 0 ||
+        !read_le(file, &version, 4) || version != RR_VERSION ||
+        !read_le(file, &streams, 4)) {
+        printf("ERROR: %s is not a replay log\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    rr_log_t *log = rr_create((int)streams);
+    if (!log) {
+        fclose(file);
+        return NULL;
+    }
+
+    // Stream lengths are checked against what is left of the file so a
+    // corrupt length fails cleanly instead of asking for a huge buffer
+    long start = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long end = ftell(file);
+    fseek(file, start, SEEK_SET);
+    uint64_t remaining = (start >= 0 && end >= start) ? (uint64_t)(end - start) : 0;
+
+    log->mode = RR_REPLAY;
+    for (int i = 0; i < log->streams; i++) {
+        rr_stream_t *stream = &log->stream[i];
+        uint64_t len;
+        stream->mode = RR_REPLAY;
+        if (!read_le(file, &len, 8) || remaining < 8 || len > remaining - 8 ||
+            (len > 0 && !rr_reserve(stream, (size_t)len)) ||
+            fread(stream->data, 1, (size_t)len, file) != len) {
+            printf("ERROR: Truncated replay log %s\n", path);
+            rr_free(log);
+            fclose(file);
+            return NULL;
+        }
+        stream->len = (size_t)len;
+        remaining -= 8 + len;
+    }
+
+    fclose(file);
+    return log;
+}
@@ -0,0 +1,75 @@
+/**
+ * Record/Replay
+ * Logs the nondeterministic inputs of a run (shared-bus outcomes and hart
+ * order in parallel multi-hart runs, host time read through counter CSRs,
+ * file input) so the run can be reproduced bit-exactly
+ */
+
+#ifndef RISCV_REPLAY_H
+#define RISCV_REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RR_MAX_STREAMS 64
+
+typedef enum {
+    RR_RECORD,
+    RR_REPLAY
+} rr_mode_t;
+
+// Event tags, checked on replay to catch divergence early
+typedef enum {
+    RR_EVENT_BUS_DELAY = 1,     // extra miss cycles from the shared bus
+    RR_EVENT_HOST_TIME,         // cycle/time CSR read without a timing model
+    RR_EVENT_INPUT,             // bytes read from a host file
+    RR_EVENT_TURN               // position of a hart's run within a quantum
+} rr_event_t;
+
+// One stream per hart; only that hart's thread touches it
+typedef struct rr_stream {
+    rr_mode_t mode;
+    int id;
+    uint8_t *data;
+    size_t len;
+    size_t capacity;
+    size_t pos;                 // replay read position
+    uint64_t events;
+    bool diverged;
+} rr_stream_t;
+
+typedef struct {
+    rr_mode_t mode;
+    int streams;
+    rr_stream_t stream[RR_MAX_STREAMS];
+} rr_log_t;
+
+rr_log_t* rr_create(int streams);
+void rr_free(rr_log_t *log);
+
+// Write a recorded log / load one for replay
+int rr_save(const rr_log_t *log, const char *path);
+rr_log_t* rr_load(const char *path);
+
+// Record: log live and return it. Replay: return the logged value.
+uint64_t rr_value(rr_stream_t *stream, rr_event_t event, uint64_t live);
+
+// Record: log len bytes from buf. Replay: overwrite buf with logged bytes.
+void rr_bytes(rr_stream_t *stream, rr_event_t event, void *buf, size_t len);
+
+// Total log payload and whether any replay stream diverged
+size_t rr_size(const rr_log_t *log);
+bool rr_diverged(const rr_log_t *log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_REPLAY_H */
@@ -0,0 +1,240 @@
+/**
+ * RISC-V Instruction Encoders
+ * Builds 32-bit and compressed (RVC) instruction words for the simulator's
+ * decoder, the test suite and the benchmarks
+ */
+
+#ifndef RISCV_ENCODE_H
+#define RISCV_ENCODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Major opcodes
+#define RV_OP_LOAD      0x03
+#define RV_OP_MISC_MEM  0x0F
+#define RV_OP_IMM       0x13
+#define RV_OP_AUIPC     0x17
+#define RV_OP_IMM_32    0x1B
+#define RV_OP_STORE     0x23
+#define RV_OP_OP        0x33
+#define RV_OP_LUI       0x37
+#define RV_OP_OP_32     0x3B
+#define RV_OP_BRANCH    0x63
+#define RV_OP_JALR      0x67
+#define RV_OP_JAL       0x6F
+#define RV_OP_SYSTEM    0x73
+
+// func7 value selecting the M extension in OP / OP-32
+#define RV_FUNC7_MULDIV 0x01
+
+// Base formats
+static inline uint32_t rv_enc_r(uint32_t opcode, uint32_t rd, uint32_t func3,
+                                uint32_t rs1, uint32_t rs2, uint32_t func7) {
+    return (func7 << 25) | (rs2 << 20) | (rs1 << 15) | (func3 << 12) | (rd << 7) | opcode;
+}
+
+static inline uint32_t rv_enc_i(uint32_t opcode, uint32_t rd, uint32_t func3,
+                                uint32_t rs1, int32_t imm) {
+    return ((uint32_t)imm << 20) | (rs1 << 15) | (func3 << 12) | (rd << 7) | opcode;
+}
+
+static inline uint32_t rv_enc_s(uint32_t opcode, uint32_t func3, uint32_t rs1,
+                                uint32_t rs2, int32_t imm) {
+    uint32_t u = (uint32_t)imm;
+    return (((u >> 5) & 0x7F) << 25) | (rs2 << 20) | (rs1 << 15) |
+           (func3 << 12) | ((u & 0x1F) << 7) | opcode;
+}
+
+static inline uint32_t rv_enc_b(uint32_t func3, uint32_t rs1, uint32_t rs2, int32_t offset) {
+    uint32_t u = (uint32_t)offset;
+    return (((u >> 12) & 1) << 31) | (((u >> 5) & 0x3F) << 25) | (rs2 << 20) |
+           (rs1 << 15) | (func3 << 12) | (((u >> 1) & 0xF) << 8) |
+           (((u >> 11) & 1) << 7) | RV_OP_BRANCH;
+}
+
+static inline uint32_t rv_enc_u(uint32_t opcode, uint32_t rd, int32_t imm) {
+    return ((uint32_t)imm & 0xFFFFF000u) | (rd << 7) | opcode;
+}
+
+static inline uint32_t rv_enc_j(uint32_t rd, int32_t offset) {
+    uint32_t u = (uint32_t)offset;
+    return (((u >> 20) & 1) << 31) | (((u >> 1) & 0x3FF) << 21) |
+           (((u >> 11) & 1) << 20) | (((u >> 12) & 0xFF) << 12) | (rd << 7) | RV_OP_JAL;
+}
+
+// Common instructions
+static inline uint32_t rv_lui(uint32_t rd, int32_t imm)   { return rv_enc_u(RV_OP_LUI, rd, imm); }
+static inline uint32_t rv_addi(uint32_t rd, uint32_t rs1, int32_t imm) { return rv_enc_i(RV_OP_IMM, rd, 0, rs1, imm); }
+static inline uint32_t rv_andi(uint32_t rd, uint32_t rs1, int32_t imm) { return rv_enc_i(RV_OP_IMM, rd, 7, rs1, imm); }
+static inline uint32_t rv_slli(uint32_t rd, uint32_t rs1, uint32_t sh) { return rv_enc_i(RV_OP_IMM, rd, 1, rs1, (int32_t)sh); }
+static inline uint32_t rv_srli(uint32_t rd, uint32_t rs1, uint32_t sh) { return rv_enc_i(RV_OP_IMM, rd, 5, rs1, (int32_t)sh); }
+static inline uint32_t rv_srai(uint32_t rd, uint32_t rs1, uint32_t sh) { return rv_enc_i(RV_OP_IMM, rd, 5, rs1, (int32_t)(0x400 | sh)); }
+static inline uint32_t rv_add(uint32_t rd, uint32_t rs1, uint32_t rs2) { return rv_enc_r(RV_OP_OP, rd, 0, rs1, rs2, 0x00); }
+static inline uint32_t rv_sub(uint32_t rd, uint32_t rs1, uint32_t rs2) { return rv_enc_r(RV_OP_OP, rd, 0, rs1, rs2, 0x20); }
+static inline uint32_t rv_and(uint32_t rd, uint32_t rs1, uint32_t rs2) { return rv_enc_r(RV_OP_OP, rd, 7, rs1, rs2, 0x00); }
+static inline uint32_t rv_mul(uint32_t rd, uint32_t rs1, uint32_t rs2) { return rv_enc_r(RV_OP_OP, rd, 0, rs1, rs2, RV_FUNC7_MULDIV); }
+static inline uint32_t rv_mulh(uint32_t rd, uint32_t rs1, uint32_t rs2) { return rv_enc_r(RV_OP_OP, rd, 1, rs1, rs2, RV_FUNC7_MULDIV); }
+static inline uint32_t rv_mulhsu(uint32_t rd, uint32_t rs1, uint32_t rs2) { return rv_enc_r(RV_OP_OP, rd, 2, rs1, rs2, RV_FUNC7_MULDIV); }
+static inline uint32_t rv_mulhu(uint32_t rd, uint32_t rs1, uint32_t rs2) { return rv_enc_r(RV_OP_OP, rd, 3, rs1, rs2, RV_FUNC7_MULDIV); }
+static inline uint32_t rv_div(uint32_t rd, uint32_t rs1, uint32_t rs2) { return rv_enc_r(RV_OP_OP, rd, 4, rs1, rs2, RV_FUNC7_MULDIV); }
+static inline uint32_t rv_divu(uint32_t rd, uint32_t rs1, uint32_t rs2) { return rv_enc_r(RV_OP_OP, rd, 5, rs1, rs2, RV_FUNC7_MULDIV); }
+static inline uint32_t rv_rem(uint32_t rd, uint32_t rs1, uint32_t rs2) { return rv_enc_r(RV_OP_OP, rd, 6, rs1, rs2, RV_FUNC7_MULDIV); }
+static inline uint32_t rv_lw(uint32_t rd, uint32_t rs1, int32_t imm)  { return rv_enc_i(RV_OP_LOAD, rd, 2, rs1, imm); }
+static inline uint32_t rv_ld(uint32_t rd, uint32_t rs1, int32_t imm)  { return rv_enc_i(RV_OP_LOAD, rd, 3, rs1, imm); }
+static inline uint32_t rv_sw(uint32_t rs2, uint32_t rs1, int32_t imm) { return rv_enc_s(RV_OP_STORE, 2, rs1, rs2, imm); }
+static inline uint32_t rv_sd(uint32_t rs2, uint32_t rs1, int32_t imm) { return rv_enc_s(RV_OP_STORE, 3, rs1, rs2, imm); }
+static inline uint32_t rv_beq(uint32_t rs1, uint32_t rs2, int32_t off) { return rv_enc_b(0, rs1, rs2, off); }
+static inline uint32_t rv_bne(uint32_t rs1, uint32_t rs2, int32_t off) { return rv_enc_b(1, rs1, rs2, off); }
+static inline uint32_t rv_blt(uint32_t rs1, uint32_t rs2, int32_t off) { return rv_enc_b(4, rs1, rs2, off); }
+static inline uint32_t rv_bge(uint32_t rs1, uint32_t rs2, int32_t off) { return rv_enc_b(5, rs1, rs2, off); }
+static inline uint32_t rv_jal(uint32_t rd, int32_t off)                { return rv_enc_j(rd, off); }
+static inline uint32_t rv_jalr(uint32_t rd, uint32_t rs1, int32_t imm) { return rv_enc_i(RV_OP_JALR, rd, 0, rs1, imm); }
+static inline uint32_t rv_ecall(void)  { return RV_OP_SYSTEM; }
+static inline uint32_t rv_ebreak(void) { return (1u << 20) | RV_OP_SYSTEM; }
+static inline uint32_t rv_fence_i(void) { return (1u << 12) | RV_OP_MISC_MEM; }
+
+// fence pred, succ: each an I/O/R/W bit set
+#define RV_FENCE_W  0x1
+#define RV_FENCE_R  0x2
+#define RV_FENCE_RW 0x3
+static inline uint32_t rv_fence(uint32_t pred, uint32_t succ) { return (pred << 24) | (succ << 20) | RV_OP_MISC_MEM; }
+// Zihintpause spin-wait hint: fence w, 0
+static inline uint32_t rv_pause(void) { return rv_fence(RV_FENCE_W, 0); }
+
+// Zicsr: csrrs rd, csr, rs1 (rdcycle rd = csrrs rd, cycle, x0)
+static inline uint32_t rv_csrrw(uint32_t rd, uint32_t csr, uint32_t rs1) { return rv_enc_i(RV_OP_SYSTEM, rd, 1, rs1, (int32_t)csr); }
+static inline uint32_t rv_csrrs(uint32_t rd, uint32_t csr, uint32_t rs1) { return rv_enc_i(RV_OP_SYSTEM, rd, 2, rs1, (int32_t)csr); }
+static inline uint32_t rv_csrrc(uint32_t rd, uint32_t csr, uint32_t rs1) { return rv_enc_i(RV_OP_SYSTEM, rd, 3, rs1, (int32_t)csr); }
+static inline uint32_t rv_csrrwi(uint32_t rd, uint32_t csr, uint32_t uimm) { return rv_enc_i(RV_OP_SYSTEM, rd, 5, uimm, (int32_t)csr); }
+
+// Simulation markers: slti x0, x0, id sits in the HINT space the base ISA
+// designates for custom use, so it is a nop on any other core
+#define RV_MARKER_ROI_BEGIN 1
+#define RV_MARKER_ROI_END   2
+static inline uint32_t rv_marker(int32_t id) { return rv_enc_i(RV_OP_IMM, 0, 2, 0, id); }
+
+// MATMUL rd, rs1, rs2 (custom-1)
+static inline uint32_t rv_matmul(uint32_t rd, uint32_t rs1, uint32_t rs2) {
+    return rv_enc_r(OPCODE_CUSTOM_1, rd, FUNC3_MATMUL, rs1, rs2, FUNC7_MATMUL);
+}
+
+// matmul.ta / matmul.tb / matmul.tt: transpose is MATMUL_TRANSPOSE_A|B
+static inline uint32_t rv_matmul_t(uint32_t rd, uint32_t rs1, uint32_t rs2, int transpose) {
+    uint32_t func7 = FUNC7_MATMUL | ((transpose & MATMUL_TRANSPOSE_A) ? FUNC7_MATMUL_TA : 0) |
+                     ((transpose & MATMUL_TRANSPOSE_B) ? FUNC7_MATMUL_TB : 0);
+    return rv_enc_r(OPCODE_CUSTOM_1, rd, FUNC3_MATMUL, rs1, rs2, func7);
+}
+
+// MATVEC rd, rs1, rs2 (custom-1): y[rd] = A[rs1] * x[rs2]
+static inline uint32_t rv_matvec(uint32_t rd, uint32_t rs1, uint32_t rs2) {
+    return rv_enc_r(OPCODE_CUSTOM_1, rd, FUNC3_MATMUL, rs1, rs2, FUNC7_MATVEC);
+}
+
+// MATMUL.SP rd, rs1, rs2 (custom-1): 2:4-sparse A tile, see sparse24.h
+static inline uint32_t rv_matmul_sp(uint32_t rd, uint32_t rs1, uint32_t rs2) {
+    return rv_enc_r(OPCODE_CUSTOM_1, rd, FUNC3_MATMUL, rs1, rs2, FUNC7_MATMUL_SP);
+}
+
+// CONV2D rd, rs1, rs2 (custom-1): 3x3 convolution tile, see conv2d.h
+static inline uint32_t rv_conv2d(uint32_t rd, uint32_t rs1, uint32_t rs2) {
+    return rv_enc_r(OPCODE_CUSTOM_1, rd, FUNC3_MATMUL, rs1, rs2, FUNC7_CONV2D);
+}
+
+// DMA.FENCE (custom-1): wait for outstanding DMA transfers
+static inline uint32_t rv_dma_fence(void) {
+    return rv_enc_r(OPCODE_CUSTOM_1, 0, FUNC3_MATMUL, 0, 0, FUNC7_DMA_FENCE);
+}
+
+// Compressed (RVC) instructions. Registers named rd'/rs1'/rs2' must be x8-x15.
+static inline uint16_t rv_c_addi(uint32_t rd, int32_t imm) {
+    uint32_t u = (uint32_t)imm;
+    return (uint16_t)((0x0u << 13) | (((u >> 5) & 1) << 12) | (rd << 7) | ((u & 0x1F) << 2) | 0x1);
+}
+
+static inline uint16_t rv_c_li(uint32_t rd, int32_t imm) {
+    uint32_t u = (uint32_t)imm;
+    return (uint16_t)((0x2u << 13) | (((u >> 5) & 1) << 12) | (rd << 7) | ((u & 0x1F) << 2) | 0x1);
+}
+
+static inline uint16_t rv_c_slli(uint32_t rd, uint32_t shamt) {
+    return (uint16_t)((0x0u << 13) | (((shamt >> 5) & 1) << 12) | (rd << 7) | ((shamt & 0x1F) << 2) | 0x2);
+}
+
+static inline uint16_t rv_c_mv(uint32_t rd, uint32_t rs2) {
+    return (uint16_t)((0x4u << 13) | (rd << 7) | (rs2 << 2) | 0x2);
+}
+
+static inline uint16_t rv_c_add(uint32_t rd, uint32_t rs2) {
+    return (uint16_t)((0x4u << 13) | (1u << 12) | (rd << 7) | (rs2 << 2) | 0x2);
+}
+
+static inline uint16_t rv_c_sub(uint32_t rd, uint32_t rs2) {
+    return (uint16_t)((0x4u << 13) | (0x3u << 10) | ((rd - 8) << 7) | ((rs2 - 8) << 2) | 0x1);
+}
+
+static inline uint16_t rv_c_lw(uint32_t rd, uint32_t rs1, uint32_t uimm) {
+    return (uint16_t)((0x2u << 13) | (((uimm >> 3) & 0x7) << 10) | ((rs1 - 8) << 7) |
+                      (((uimm >> 2) & 1) << 6) | (((uimm >> 6) & 1) << 5) | ((rd - 8) << 2) | 0x0);
+}
+
+static inline uint16_t rv_c_sw(uint32_t rs2, uint32_t rs1, uint32_t uimm) {
+    return (uint16_t)((0x6u << 13) | (((uimm >> 3) & 0x7) << 10) | ((rs1 - 8) << 7) |
+                      (((uimm >> 2) & 1) << 6) | (((uimm >> 6) & 1) << 5) | ((rs2 - 8) << 2) | 0x0);
+}
+
+static inline uint16_t rv_c_bnez(uint32_t rs1, int32_t off) {
+    uint32_t u = (uint32_t)off;
+    return (uint16_t)((0x7u << 13) | (((u >> 8) & 1) << 12) | (((u >> 3) & 0x3) << 10) |
+                      ((rs1 - 8) << 7) | (((u >> 6) & 0x3) << 5) | (((u >> 1) & 0x3) << 3) |
+                      (((u >> 5) & 1) << 2) | 0x1);
+}
+
+static inline uint16_t rv_c_j(int32_t off) {
+    uint32_t u = (uint32_t)off;
+    return (uint16_t)((0x5u << 13) | (((u >> 11) & 1) << 12) | (((u >> 4) & 1) << 11) |
+                      (((u >> 8) & 0x3) << 9) | (((u >> 10) & 1) << 8) | (((u >> 6) & 1) << 7) |
+                      (((u >> 7) & 1) << 6) | (((u >> 1) & 0x7) << 3) | (((u >> 5) & 1) << 2) | 0x1);
+}
+
+// Fixed-size code buffer for building guest programs
+typedef struct {
+    uint8_t bytes[16384];
+    size_t len;
+} rv_program_t;
+
+static inline void rv_emit32(rv_program_t *prog, uint32_t insn) {
+    if (prog->len + 4 <= sizeof(prog->bytes)) {
+        memcpy(prog->bytes + prog->len, &insn, 4);
+        prog->len += 4;
+    }
+}
+
+static inline void rv_emit16(rv_program_t *prog, uint16_t insn) {
+    if (prog->len + 2 <= sizeof(prog->bytes)) {
+        memcpy(prog->bytes + prog->len, &insn, 2);
+        prog->len += 2;
+    }
+}
+
+// li rd, value as lui + addi (the addi immediate is sign-extended, so the
+// upper part is rounded to compensate)
+static inline void rv_emit_li(rv_program_t *prog, uint32_t rd, int32_t value) {
+    uint32_t u = (uint32_t)value;
+    int32_t lo = (int32_t)((u & 0xFFF) ^ 0x800) - 0x800;
+    rv_emit32(prog, rv_lui(rd, (int32_t)(u - (uint32_t)lo)));
+    rv_emit32(prog, rv_addi(rd, rd, lo));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_ENCODE_H */
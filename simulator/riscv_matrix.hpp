@@ -0,0 +1,433 @@
+/**
+ * C++ API for the RISC-V Matrix Extension Simulator
+ * Header-only C++17 layer over riscv_matrix_ext.h: move-only CPU handles,
+ * matrices sized at compile time and span-based batch calls. Nothing here
+ * allocates once a Cpu exists, and failures are the core's RISCV_* codes
+ */
+
+#ifndef RISCV_MATRIX_HPP
+#define RISCV_MATRIX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "riscv_matrix_ext.h"
+#include "interpreter.h"
+
+namespace riscv {
+
+template <typename T>
+class Span;
+
+namespace detail {
+template <typename T> struct is_span : std::false_type {};
+template <typename T> struct is_span<Span<T>> : std::true_type {};
+}
+
+// Non-owning view of contiguous elements (std::span is C++20). Built from a
+// pointer and length, a C array, or any container with data() and size()
+// such as std::array and std::vector.
+template <typename T>
+class Span {
+public:
+    constexpr Span() noexcept = default;
+    constexpr Span(T *data, std::size_t size) noexcept : data_(data), size_(size) {}
+    template <std::size_t N>
+    constexpr Span(T (&array)[N]) noexcept : data_(array), size_(N) {}
+    template <typename Container,
+              typename = std::enable_if_t<!detail::is_span<std::remove_cv_t<Container>>::value &&
+                  std::is_convertible_v<std::remove_pointer_t<decltype(std::declval<Container &>().data())> (*)[],
+                                         T (*)[]>>>
+    constexpr Span(Container &c) noexcept : data_(c.data()), size_(c.size()) {}
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+    constexpr Span(Span<U> other) noexcept : data_(other.data()), size_(other.size()) {}
+
+    constexpr T *data() const noexcept { return data_; }
+    constexpr std::size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+    constexpr T &operator[](std::size_t i) const noexcept { return data_[i]; }
+    constexpr T *begin() const noexcept { return data_; }
+    constexpr T *end() const noexcept { return data_ + size_; }
+    constexpr Span subspan(std::size_t offset, std::size_t count) const noexcept {
+        return Span(data_ + offset, count);
+    }
+
+private:
+    T *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// Row-major Rows x Cols matrix held by value. An aggregate, so
+// Matrix<int32_t, 2> a = {{{1, 2}, {3, 4}}}; and its layout is the one
+// guest memory and matrix_2x2_t use.
+template <typename T, std::size_t Rows, std::size_t Cols = Rows>
+struct Matrix {
+    static_assert(std::is_arithmetic_v<T>, "Matrix elements must be arithmetic");
+    static constexpr std::size_t rows = Rows;
+    static constexpr std::size_t cols = Cols;
+
+    T m[Rows][Cols];
+
+    constexpr T &operator()(std::size_t i, std::size_t j) noexcept { return m[i][j]; }
+    constexpr const T &operator()(std::size_t i, std::size_t j) const noexcept { return m[i][j]; }
+
+    static constexpr Matrix zero() noexcept { return Matrix{}; }
+    static constexpr Matrix identity() noexcept {
+        static_assert(Rows == Cols, "identity needs a square matrix");
+        Matrix r{};
+        for (std::size_t i = 0; i < Rows; i++) r.m[i][i] = T(1);
+        return r;
+    }
+
+    friend constexpr bool operator==(const Matrix &a, const Matrix &b) noexcept {
+        for (std::size_t i = 0; i < Rows; i++) {
+            for (std::size_t j = 0; j < Cols; j++) {
+                if (a.m[i][j] != b.m[i][j]) return false;
+            }
+        }
+        return true;
+    }
+    friend constexpr bool operator!=(const Matrix &a, const Matrix &b) noexcept { return !(a == b); }
+};
+
+// The MATMUL operand: one 2x2 tile of int32_t
+using Tile = Matrix<std::int32_t, MATRIX_DIM>;
+static_assert(sizeof(Tile) == sizeof(matrix_2x2_t) && std::is_trivially_copyable_v<Tile>,
+              "Tile must share matrix_2x2_t's layout");
+
+inline Tile from_c(const matrix_2x2_t &c) noexcept {
+    Tile t;
+    std::memcpy(t.m, c.m, sizeof(t.m));
+    return t;
+}
+
+inline matrix_2x2_t to_c(const Tile &t) noexcept {
+    matrix_2x2_t c;
+    std::memcpy(c.m, t.m, sizeof(c.m));
+    return c;
+}
+
+namespace detail {
+// Integer products wrap like MATMUL's 32-bit lanes instead of overflowing
+template <typename T>
+constexpr T mul_add(T acc, T a, T b) noexcept {
+    if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        using U = std::make_unsigned_t<T>;
+        return static_cast<T>(static_cast<U>(acc) + static_cast<U>(a) * static_cast<U>(b));
+    } else {
+        return static_cast<T>(acc + a * b);
+    }
+}
+}
+
+// C = A * B; for Tile the result matches matrix_multiply_2x2 bit for bit
+template <typename T, std::size_t R, std::size_t K, std::size_t C>
+constexpr Matrix<T, R, C> multiply(const Matrix<T, R, K> &a, const Matrix<T, K, C> &b) noexcept {
+    Matrix<T, R, C> c{};
+    for (std::size_t i = 0; i < R; i++) {
+        for (std::size_t k = 0; k < K; k++) {
+            for (std::size_t j = 0; j < C; j++) c.m[i][j] = detail::mul_add(c.m[i][j], a.m[i][k], b.m[k][j]);
+        }
+    }
+    return c;
+}
+
+// Expression templates
+// a * b * c builds a Product tree and computes nothing. Converting it to a
+// Matrix (or calling eval) flattens the tree into its chain of operands and
+// picks the association with the fewest scalar multiplies by the
+// matrix-chain dynamic program. Every shape is a template argument, so the
+// plan is made at compile time. Intermediates are locals, never heap
+// temporaries. A chain of Tiles runs in 4-lane vectors like
+// matrix_multiply_2x2_transposed, in one pass: each operand is loaded once
+// and the result is stored once.
+//
+// A Product refers to its Matrix operands. Evaluate it within the full
+// expression or while the operands live: assign it to a Matrix, not auto.
+template <typename L, typename R>
+class Product;
+
+namespace detail {
+template <typename E> struct chain_traits;
+
+template <typename T, std::size_t R, std::size_t C>
+struct chain_traits<Matrix<T, R, C>> {
+    using value_type = T;
+    static constexpr std::size_t length = 1;
+    static constexpr std::size_t rows = R;
+    static constexpr std::size_t cols = C;
+    // Operand i of the chain is dim(i) x dim(i + 1)
+    static constexpr std::size_t dim(std::size_t i) noexcept { return i == 0 ? R : C; }
+    template <std::size_t I>
+    static constexpr const Matrix<T, R, C> &leaf(const Matrix<T, R, C> &m) noexcept { return m; }
+};
+
+template <typename L, typename R>
+struct chain_traits<Product<L, R>> {
+    using value_type = typename chain_traits<L>::value_type;
+    static constexpr std::size_t length = chain_traits<L>::length + chain_traits<R>::length;
+    static constexpr std::size_t rows = chain_traits<L>::rows;
+    static constexpr std::size_t cols = chain_traits<R>::cols;
+    static constexpr std::size_t dim(std::size_t i) noexcept {
+        return i < chain_traits<L>::length ? chain_traits<L>::dim(i) : chain_traits<R>::dim(i - chain_traits<L>::length);
+    }
+    template <std::size_t I>
+    static constexpr const auto &leaf(const Product<L, R> &e) noexcept {
+        if constexpr (I < chain_traits<L>::length) {
+            return chain_traits<L>::template leaf<I>(e.left());
+        } else {
+            return chain_traits<R>::template leaf<I - chain_traits<L>::length>(e.right());
+        }
+    }
+};
+
+template <typename E, typename = void> struct is_chain : std::false_type {};
+template <typename E> struct is_chain<E, std::void_t<decltype(chain_traits<E>::length)>> : std::true_type {};
+
+// cost[i][j] is the fewest scalar multiplies for operands i..j and
+// split[i][j] the operand the optimal order splits after
+template <typename E>
+struct ChainPlan {
+    static constexpr std::size_t n = chain_traits<E>::length;
+    std::uint64_t cost[n][n];
+    std::size_t split[n][n];
+
+    constexpr ChainPlan() noexcept : cost{}, split{} {
+        for (std::size_t len = 2; len <= n; len++) {
+            for (std::size_t i = 0; i + len <= n; i++) {
+                std::size_t j = i + len - 1;
+                cost[i][j] = UINT64_MAX;
+                for (std::size_t k = i; k < j; k++) {
+                    std::uint64_t c = cost[i][k] + cost[k + 1][j] + (std::uint64_t)chain_traits<E>::dim(i) *
+                                      chain_traits<E>::dim(k + 1) * chain_traits<E>::dim(j + 1);
+                    if (c < cost[i][j]) {
+                        cost[i][j] = c;
+                        split[i][j] = k;
+                    }
+                }
+            }
+        }
+    }
+};
+
+template <typename E>
+inline constexpr ChainPlan<E> chain_plan{};
+
+template <typename E, std::size_t I, std::size_t J>
+constexpr decltype(auto) eval_range(const E &e) noexcept {
+    if constexpr (I == J) {
+        return chain_traits<E>::template leaf<I>(e);
+    } else {
+        constexpr std::size_t K = chain_plan<E>.split[I][J];
+        return multiply(eval_range<E, I, K>(e), eval_range<E, K + 1, J>(e));
+    }
+}
+
+template <typename E>
+constexpr bool is_tile_chain() noexcept {
+    if (!std::is_same_v<typename chain_traits<E>::value_type, std::int32_t>) return false;
+    for (std::size_t i = 0; i <= chain_traits<E>::length; i++) {
+        if (chain_traits<E>::dim(i) != MATRIX_DIM) return false;
+    }
+    return true;
+}
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated) && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 12))
+#define RISCV_MATRIX_TILE_V4 1
+typedef std::uint32_t tile_v4 __attribute__((vector_size(16)));
+
+inline tile_v4 load_tile(const Tile &t) noexcept {
+    tile_v4 v;
+    std::memcpy(&v, t.m, sizeof(v));
+    return v;
+}
+
+// [a00 a00 a10 a10] * [b00 b01 b00 b01] + [a01 a01 a11 a11] * [b10 b11 b10 b11]
+inline tile_v4 multiply_tile(tile_v4 a, tile_v4 b) noexcept {
+    return __builtin_shufflevector(a, a, 0, 0, 2, 2) * __builtin_shufflevector(b, b, 0, 1, 0, 1) +
+           __builtin_shufflevector(a, a, 1, 1, 3, 3) * __builtin_shufflevector(b, b, 2, 3, 2, 3);
+}
+
+// Square chains cost the same in any order, so fold left in registers
+template <typename E, std::size_t... I>
+inline Tile eval_tiles(const E &e, std::index_sequence<I...>) noexcept {
+    tile_v4 acc = load_tile(chain_traits<E>::template leaf<0>(e));
+    ((acc = multiply_tile(acc, load_tile(chain_traits<E>::template leaf<I + 1>(e)))), ...);
+    Tile result;
+    std::memcpy(result.m, &acc, sizeof(result.m));
+    return result;
+}
+#endif
+#endif
+}
+
+template <typename L, typename R>
+class Product {
+    using LT = detail::chain_traits<L>;
+    using RT = detail::chain_traits<R>;
+    static_assert(std::is_same_v<typename LT::value_type, typename RT::value_type>,
+                  "operands of a product must have the same element type");
+    static_assert(LT::cols == RT::rows, "inner dimensions of a product must match");
+
+    template <typename E>
+    using operand_t = std::conditional_t<(detail::chain_traits<E>::length == 1), const E &, E>;
+
+public:
+    using value_type = typename LT::value_type;
+    static constexpr std::size_t rows = LT::rows;
+    static constexpr std::size_t cols = RT::cols;
+    using matrix_type = Matrix<value_type, rows, cols>;
+
+    constexpr Product(const L &left, const R &right) noexcept : left_(left), right_(right) {}
+
+    constexpr const L &left() const noexcept { return left_; }
+    constexpr const R &right() const noexcept { return right_; }
+
+    // Scalar multiplies the chosen association performs
+    static constexpr std::uint64_t cost() noexcept {
+        return detail::chain_plan<Product>.cost[0][detail::chain_traits<Product>::length - 1];
+    }
+
+    constexpr matrix_type eval() const noexcept {
+#ifdef RISCV_MATRIX_TILE_V4
+        if constexpr (detail::is_tile_chain<Product>()) {
+            if (!__builtin_is_constant_evaluated()) {
+                return detail::eval_tiles(*this, std::make_index_sequence<detail::chain_traits<Product>::length - 1>{});
+            }
+        }
+#endif
+        return detail::eval_range<Product, 0, detail::chain_traits<Product>::length - 1>(*this);
+    }
+
+    constexpr operator matrix_type() const noexcept { return eval(); }
+
+private:
+    operand_t<L> left_;                 // Matrix operands by reference, products by value
+    operand_t<R> right_;
+};
+
+template <typename L, typename R,
+          typename = std::enable_if_t<detail::is_chain<L>::value && detail::is_chain<R>::value>>
+constexpr Product<L, R> operator*(const L &a, const R &b) noexcept {
+    return Product<L, R>(a, b);
+}
+
+template <typename T, std::size_t R, std::size_t C>
+constexpr Matrix<T, R, C> eval(const Matrix<T, R, C> &m) noexcept { return m; }
+
+template <typename L, typename R>
+constexpr typename Product<L, R>::matrix_type eval(const Product<L, R> &e) noexcept { return e.eval(); }
+
+// c[i] = a[i] * b[i] for every i; c must hold a.size() tiles
+inline int multiply(Span<const Tile> a, Span<const Tile> b, Span<Tile> c) noexcept {
+    if (a.size() != b.size() || c.size() < a.size()) return RISCV_ERROR_BOUNDS;
+    for (std::size_t i = 0; i < a.size(); i++) c[i] = multiply(a[i], b[i]);
+    return RISCV_SUCCESS;
+}
+
+// One MATMUL by guest address: C = A * B
+struct MatmulOp {
+    xlen_t a;
+    xlen_t b;
+    xlen_t c;
+};
+
+// Owning handle for a simulated core. Move-only; the destructor frees the
+// CPU. Cpu::create returns an empty handle (false in a boolean context) if
+// init_cpu fails.
+class Cpu {
+public:
+    Cpu() noexcept = default;
+    explicit Cpu(cpu_state_t *cpu) noexcept : cpu_(cpu) {}
+    ~Cpu() { free_cpu(cpu_); }
+
+    Cpu(const Cpu &) = delete;
+    Cpu &operator=(const Cpu &) = delete;
+    Cpu(Cpu &&other) noexcept : cpu_(std::exchange(other.cpu_, nullptr)) {}
+    Cpu &operator=(Cpu &&other) noexcept {
+        if (this != &other) {
+            free_cpu(cpu_);
+            cpu_ = std::exchange(other.cpu_, nullptr);
+        }
+        return *this;
+    }
+
+    static Cpu create(std::size_t memory_size = DEFAULT_MEMORY_SIZE) noexcept { return Cpu(init_cpu(memory_size)); }
+
+    explicit operator bool() const noexcept { return cpu_ != nullptr; }
+    cpu_state_t *get() const noexcept { return cpu_; }
+    cpu_state_t *operator->() const noexcept { return cpu_; }
+    cpu_state_t *release() noexcept { return std::exchange(cpu_, nullptr); }
+
+    // Guest memory
+    int load(xlen_t addr, const void *data, std::size_t size) noexcept { return load_image(cpu_, addr, data, size); }
+    template <typename T>
+    int load(xlen_t addr, Span<const T> data) noexcept {
+        static_assert(std::is_trivially_copyable_v<T>, "images must be trivially copyable");
+        return load_image(cpu_, addr, data.data(), data.size() * sizeof(T));
+    }
+
+    template <typename T, std::size_t R, std::size_t C>
+    int read(xlen_t addr, Matrix<T, R, C> &out) const noexcept { return mem_read(cpu_, addr, out.m, sizeof(out.m)); }
+    template <typename T, std::size_t R, std::size_t C>
+    int write(xlen_t addr, const Matrix<T, R, C> &in) noexcept { return mem_write(cpu_, addr, in.m, sizeof(in.m)); }
+
+    // Consecutive packed tiles, as a MATMUL loop over an array reads them
+    int read(xlen_t addr, Span<Tile> out) const noexcept {
+        return mem_read(cpu_, addr, out.data(), out.size() * sizeof(Tile));
+    }
+    int write(xlen_t addr, Span<const Tile> in) noexcept {
+        return mem_write(cpu_, addr, in.data(), in.size() * sizeof(Tile));
+    }
+
+    // Execution
+    int run(std::uint64_t max_instructions = UINT64_MAX) noexcept { return riscv_run(cpu_, max_instructions); }
+    int step() noexcept { return riscv_step(cpu_); }
+    int execute(std::uint32_t instruction) noexcept { return execute_instruction(cpu_, instruction); }
+    int set_base() noexcept { return riscv_cpu_set_base(cpu_); }
+    int reset() noexcept { return riscv_cpu_reset(cpu_); }
+
+    // Run every op as a MATMUL issued by the host, so tile pitches,
+    // requantization and the matrix counters apply as they would to the
+    // guest's own. The scratch registers are restored afterwards.
+    int matmul(Span<const MatmulOp> ops) noexcept {
+        const r_type_inst_t inst = decode_r_type(riscv_encode_matmul(SCRATCH_C, SCRATCH_A, SCRATCH_B));
+        const xlen_t saved[3] = { cpu_->regs[SCRATCH_A], cpu_->regs[SCRATCH_B], cpu_->regs[SCRATCH_C] };
+        int status = RISCV_SUCCESS;
+        for (const MatmulOp &op : ops) {
+            cpu_->regs[SCRATCH_A] = op.a;
+            cpu_->regs[SCRATCH_B] = op.b;
+            cpu_->regs[SCRATCH_C] = op.c;
+            status = execute_matmul(cpu_, inst);
+            if (status != RISCV_SUCCESS) break;
+        }
+        cpu_->regs[SCRATCH_A] = saved[0];
+        cpu_->regs[SCRATCH_B] = saved[1];
+        cpu_->regs[SCRATCH_C] = saved[2];
+        return status;
+    }
+
+    // Architectural state
+    xlen_t pc() const noexcept { return cpu_->pc; }
+    void set_pc(xlen_t pc) noexcept { cpu_->pc = pc; }
+    xlen_t reg(unsigned index) const noexcept { return cpu_->regs[index]; }
+    void set_reg(unsigned index, xlen_t value) noexcept {
+        if (index != 0) cpu_->regs[index] = value;
+    }
+    bool halted() const noexcept { return cpu_->halted; }
+    int exit_code() const noexcept { return cpu_->exit_code; }
+    std::uint64_t instret() const noexcept { return cpu_->instret; }
+    std::uint64_t matrix_ops() const noexcept { return cpu_->hpm.matrix_ops; }
+
+private:
+    static constexpr unsigned SCRATCH_A = 5, SCRATCH_B = 6, SCRATCH_C = 7;
+    cpu_state_t *cpu_ = nullptr;
+};
+
+} // namespace riscv
+
+#endif /* RISCV_MATRIX_HPP */
@@ -6,8 +6,12 @@
 #ifndef RISCV_MATRIX_EXT_H
 #define RISCV_MATRIX_EXT_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <inttypes.h>
+
+#include "host_memory.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,12 +21,55 @@ extern "C" {
 #define MATRIX_DIM 2
 #define MATRIX_SIZE (MATRIX_DIM * MATRIX_DIM)
 #define MATRIX_BYTES (MATRIX_SIZE * sizeof(int32_t))
+#define VECTOR_BYTES (MATRIX_DIM * sizeof(int32_t))
 
 // Instruction encoding constants
 #define OPCODE_CUSTOM_1  0x2B
 #define FUNC3_MATMUL     0x7
 #define FUNC7_MATMUL     0x1
 
+// MATMUL operand modifiers (func7 bits): read A and/or B transposed
+#define FUNC7_MATMUL_TA  0x2
+#define FUNC7_MATMUL_TB  0x4
+#define MATMUL_TRANSPOSE_A 1
+#define MATMUL_TRANSPOSE_B 2
+
+// MATVEC rd, rs1, rs2: 2-element vector at rd = tile at rs1 * vector at rs2
+#define FUNC7_MATVEC     0x8
+
+// MATMUL.SP rd, rs1, rs2: 2x2 at rd = 2:4-compressed 2x4 A at rs1 (see
+// sparse24.h) * 4x2 B at rs2
+#define FUNC7_MATMUL_SP  0x10
+
+// CONV2D rd, rs1, rs2: 2x2 output tile at rd = 3x3 kernel at rs2 slid over
+// the input window at rs1 (see conv2d.h); pitch and stride come from CSRs
+#define FUNC7_CONV2D     0x20
+
+// DMA.FENCE: wait for all DMA transfers launched through the dma CSRs
+#define FUNC7_DMA_FENCE  0x40
+
+// Base integer width: the core is compiled once per XLEN (-DXLEN=32 or
+// -DXLEN=64) so each interpreter is specialized with no runtime XLEN checks
+#ifndef XLEN
+#define XLEN 32
+#endif
+
+#if XLEN == 64
+typedef uint64_t xlen_t;
+typedef int64_t  sxlen_t;
+#define SXLEN_MIN INT64_MIN
+#define PRIxXLEN PRIx64
+#define PRIuXLEN PRIu64
+#elif XLEN == 32
+typedef uint32_t xlen_t;
+typedef int32_t  sxlen_t;
+#define SXLEN_MIN INT32_MIN
+#define PRIxXLEN PRIx32
+#define PRIuXLEN PRIu32
+#else
+#error "XLEN must be 32 or 64"
+#endif
+
 // Register file size
 #define NUM_REGISTERS 32
 #define REGISTER_BITS 5
@@ -31,6 +78,20 @@ extern "C" {
 #define DEFAULT_MEMORY_SIZE (64 * 1024)  // 64KB
 #define MEMORY_ALIGNMENT 4
 
+// Dirty tracking granularity for riscv_cpu_reset
+#define RESET_PAGE_BITS 12
+#define RESET_PAGE_SIZE ((size_t)1 << RESET_PAGE_BITS)
+#define RESET_DIRTY_WORDS(memory_size) \
+    (((((memory_size) + RESET_PAGE_SIZE - 1) >> RESET_PAGE_BITS) + 63) / 64)
+
+// RV64 guests see a sparse address space: anything above the flat RAM is
+// backed by lazily allocated pages (see sparse_memory.h)
+#if XLEN == 64
+#define SPARSE_MEMORY_DEFAULT true
+#else
+#define SPARSE_MEMORY_DEFAULT false
+#endif
+
 // Matrix data structure
 typedef struct {
     int32_t m[MATRIX_DIM][MATRIX_DIM];
@@ -49,30 +110,136 @@ typedef union {
     } r_type;
 } riscv_instruction_t;
 
+// Decoded R-type fields as used by the simulator core
+typedef struct {
+    uint32_t opcode : 7;
+    uint32_t rd     : 5;
+    uint32_t func3  : 3;
+    uint32_t rs1    : 5;
+    uint32_t rs2    : 5;
+    uint32_t func7  : 7;
+} r_type_inst_t;
+
+struct sparse_memory;
+struct predecode_cache;
+struct timing_model;
+struct rr_stream;
+struct syscall_proxy;
+struct file_mapping;
+struct riscv_checkpoint;
+
+// Requantization epilogue modes (qmode CSR)
+#define QUANT_MODE_OFF   0
+#define QUANT_MODE_INT8  1              // clamp to [-128, 127]
+#define QUANT_MODE_UINT8 2              // clamp to [0, 255]
+#define QUANT_MAX_SHIFT  62             // keeps acc * qscale + round within int64
+
+// Matrix extension configuration, written through CSRs (see csr.h)
+typedef struct {
+    xlen_t conv_pitch;                  // CONV2D input row pitch in bytes, 0 = packed window
+    uint32_t conv_stride;               // CONV2D stride, 1 or 2
+    uint32_t quant_mode;                // QUANT_MODE_*: epilogue on matrix results
+    int32_t quant_scale;                // out = clamp(((acc * scale) >> shift, rounded) + zero)
+    uint32_t quant_shift;
+    int32_t quant_zero;
+    xlen_t dma_src;                     // next DMA transfer; writing dma_len launches it
+    xlen_t dma_dst;
+    xlen_t dma_len;
+    xlen_t tile_pitch_a;                // bytes between the rows of MATMUL's A/B tiles,
+    xlen_t tile_pitch_b;                // 0 = packed 16-byte tile
+} matrix_config_t;
+
+// Guest performance counters: the per-hart event counts behind
+// mhpmcounter3..6 (see csr.h). Guest writes to a machine counter are kept
+// as an offset from the live value, so the sources are never rewound.
+#define HPM_COUNTERS 7                  // indexed like the CSRs: cycle, time, instret, 3..6
+typedef struct {
+    uint64_t matrix_ops;                // matrix instructions retired
+    uint64_t matrix_load_bytes;         // operand bytes read by matrix instructions
+    uint64_t matrix_store_bytes;        // result bytes written by matrix instructions
+    uint64_t stall_cycles;              // timing model: issue stalls plus matrix operand fills
+    uint64_t offset[HPM_COUNTERS];
+} hpm_counters_t;
+
+// stop_pc value that never matches a fetch address (pc is always even)
+#define RISCV_NO_STOP_PC ((xlen_t)1)
+
 // CPU state representation
 typedef struct {
-    uint32_t regs[NUM_REGISTERS];
-    uint32_t pc;
-    uint8_t *memory;
+    xlen_t regs[NUM_REGISTERS];
+    xlen_t pc;
+    uint8_t *memory;                    // flat RAM mapped at guest address 0
     size_t memory_size;
+    host_pages_t memory_pages;          // host page size backing memory
+    struct sparse_memory *sparse;       // pages above RAM, NULL if disabled
+    struct file_mapping *mappings;      // host files mapped above RAM (file_map.h)
+    struct predecode_cache *predecode;  // allocated on first run
+    struct timing_model *timing;        // detailed timing, NULL for functional runs
+    struct rr_stream *replay;           // record/replay stream, NULL when off
+    struct syscall_proxy *syscalls;     // ecall proxy, NULL makes ecall halt
+    uint64_t instret;
+    bool halted;
+    int exit_code;
     bool debug_enabled;
+    matrix_config_t mcfg;
+    hpm_counters_t hpm;
+
+    // Run control: riscv_run returns before executing stop_pc, and after a
+    // marker hint when stop_on_marker is set
+    xlen_t stop_pc;
+    bool stop_on_marker;
+    bool stop_requested;
+    int last_marker;
+
+    // Fast reset: one bit per RESET_PAGE_SIZE page of flat RAM written since
+    // the last reset, and the image riscv_cpu_reset restores (NULL restores
+    // the power-on state)
+    uint64_t *dirty;
+    bool sparse_dirty;
+    struct riscv_checkpoint *base;
 } cpu_state_t;
 
+// Simulator core (matmul_simulator.c)
+cpu_state_t* init_cpu(size_t memory_size);
+cpu_state_t* init_cpu_huge(size_t memory_size);     // RAM on 2 MiB host pages if possible
+void free_cpu(cpu_state_t *cpu);
+int32_t read_word(cpu_state_t *cpu, xlen_t addr);
+void write_word(cpu_state_t *cpu, xlen_t addr, int32_t value);
+matrix_2x2_t read_matrix_2x2(cpu_state_t *cpu, xlen_t addr);
+matrix_2x2_t read_matrix_2x2_pitched(cpu_state_t *cpu, xlen_t addr, xlen_t pitch);
+void write_matrix_2x2(cpu_state_t *cpu, xlen_t addr, matrix_2x2_t matrix);
+uint8_t* guest_ptr(cpu_state_t *cpu, xlen_t addr, size_t size, bool write);
+int mem_read(cpu_state_t *cpu, xlen_t addr, void *dst, size_t size);
+int mem_write(cpu_state_t *cpu, xlen_t addr, const void *src, size_t size);
+int load_image(cpu_state_t *cpu, xlen_t addr, const void *data, size_t size);
+matrix_2x2_t matrix_multiply_2x2(matrix_2x2_t a, matrix_2x2_t b);
+matrix_2x2_t matrix_multiply_2x2_transposed(matrix_2x2_t a, matrix_2x2_t b, int transpose);
+matrix_2x2_t matrix_requantize(matrix_2x2_t acc, const matrix_config_t *mcfg);
+r_type_inst_t decode_r_type(uint32_t instruction);
+int execute_matmul(cpu_state_t *cpu, r_type_inst_t inst);
+int execute_matvec(cpu_state_t *cpu, r_type_inst_t inst);
+int execute_matmul_sparse(cpu_state_t *cpu, r_type_inst_t inst);
+int execute_conv2d(cpu_state_t *cpu, r_type_inst_t inst);
+int execute_instruction(cpu_state_t *cpu, uint32_t instruction);
+
 // Function prototypes
 
 // CPU management
 cpu_state_t* riscv_cpu_init(size_t memory_size);
 void riscv_cpu_free(cpu_state_t *cpu);
-void riscv_cpu_reset(cpu_state_t *cpu);
+// Take the current state as the reset image; riscv_cpu_reset then copies
+// back only the pages written since. Implemented in checkpoint.c.
+int riscv_cpu_set_base(cpu_state_t *cpu);
+int riscv_cpu_reset(cpu_state_t *cpu);
 
 // Memory operations
-int32_t riscv_mem_read_word(cpu_state_t *cpu, uint32_t addr);
-void riscv_mem_write_word(cpu_state_t *cpu, uint32_t addr, int32_t value);
-bool riscv_mem_check_bounds(cpu_state_t *cpu, uint32_t addr, size_t size);
+int32_t riscv_mem_read_word(cpu_state_t *cpu, xlen_t addr);
+void riscv_mem_write_word(cpu_state_t *cpu, xlen_t addr, int32_t value);
+bool riscv_mem_check_bounds(cpu_state_t *cpu, xlen_t addr, size_t size);
 
 // Matrix operations
-matrix_2x2_t riscv_matrix_read(cpu_state_t *cpu, uint32_t addr);
-void riscv_matrix_write(cpu_state_t *cpu, uint32_t addr, matrix_2x2_t matrix);
+matrix_2x2_t riscv_matrix_read(cpu_state_t *cpu, xlen_t addr);
+void riscv_matrix_write(cpu_state_t *cpu, xlen_t addr, matrix_2x2_t matrix);
 matrix_2x2_t riscv_matrix_multiply(matrix_2x2_t a, matrix_2x2_t b);
 void riscv_matrix_print(matrix_2x2_t matrix, const char* name);
 
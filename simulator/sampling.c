@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "riscv_matrix_ext.h"
+#include "interpreter.h"
+#include "timing.h"
+#include "checkpoint.h"
+#include "syscall.h"
+#include "sampling.h"
+
+// SimPoint-style sampling
+// 1. Functional pass: split execution into fixed-size intervals and count
+//    instructions per basic block, hashed into BBV_DIMS buckets (a cheap
+//    stand-in for SimPoint's random projection).
+// 2. Normalize each vector and cluster with k-means (k-means++ seeding).
+//    The interval closest to each centroid represents its cluster, weighted
+//    by the cluster's share of instructions.
+// 3. Replay functionally from the initial checkpoint, checkpointing just
+//    before each representative (minus warm-up).
+// 4. Time each representative from its checkpoint with a fresh timing
+//    model and extrapolate CPI to the whole run.
+// Steps 3 and 4 re-execute code the functional pass already ran, so the
+// syscall proxy is quiet for them: guest output is not repeated on the
+// host and reopened files are not truncated again.
+
+#define KMEANS_MAX_ITERS 100
+
+typedef struct {
+    double v[BBV_DIMS];
+    uint64_t insns;
+} bbv_t;
+
+void simpoint_default_config(simpoint_config_t *config) {
+    config->interval_insns = 100000;
+    config->clusters = 8;
+    config->warmup_insns = 10000;
+    config->seed = 1;
+}
+
+static size_t bbv_bucket(xlen_t block_pc) {
+    return (size_t)(((uint64_t)block_pc * 0x9E3779B97F4A7C15ull) >> 32) % BBV_DIMS;
+}
+
+static int bbv_push(bbv_t **vecs, size_t *count, size_t *capacity,
+                    const uint64_t *counts, uint64_t insns) {
+    if (*count == *capacity) {
+        size_t new_capacity = *capacity ? *capacity * 2 : 64;
+        bbv_t *grown = realloc(*vecs, new_capacity * sizeof(bbv_t));
+        if (!grown) return RISCV_ERROR_MEMORY;
+        *vecs = grown;
+        *capacity = new_capacity;
+    }
+
+    bbv_t *b = &(*vecs)[(*count)++];
+    for (int i = 0; i < BBV_DIMS; i++) {
+        b->v[i] = (double)counts[i] / (double)insns;
+    }
+    b->insns = insns;
+    return RISCV_SUCCESS;
+}
+
+// Functional pass collecting one BBV per interval
+static int bbv_profile(cpu_state_t *cpu, uint64_t interval_insns, uint64_t max_insns,
+                       bbv_t **vecs, size_t *count) {
+    uint64_t counts[BBV_DIMS] = { 0 };
+    size_t capacity = 0;
+    xlen_t block_pc = cpu->pc;
+    uint64_t block_len = 0;
+    uint64_t interval_len = 0;
+    uint64_t executed = 0;
+    int status = RISCV_SUCCESS;
+
+    *vecs = NULL;
+    *count = 0;
+
+    while (executed < max_insns && !cpu->halted) {
+        const decoded_insn_t *d = predecode_fetch(cpu, cpu->pc);
+        if (!d) {
+            status = RISCV_ERROR_MEMORY;
+            break;
+        }
+        status = riscv_execute_decoded(cpu, d);
+        if (status != RISCV_SUCCESS) break;
+        cpu->instret++;
+        executed++;
+        block_len++;
+        interval_len++;
+
+        bool block_end = (d->op >= OP_JAL && d->op <= OP_BGEU) || cpu->pc != d->pc + d->len;
+        if (block_end || interval_len == interval_insns) {
+            counts[bbv_bucket(block_pc)] += block_len;
+            block_pc = cpu->pc;
+            block_len = 0;
+        }
+        if (interval_len == interval_insns) {
+            status = bbv_push(vecs, count, &capacity, counts, interval_len);
+            if (status != RISCV_SUCCESS) break;
+            memset(counts, 0, sizeof(counts));
+            interval_len = 0;
+        }
+    }
+
+    if (status == RISCV_SUCCESS && interval_len > 0) {
+        counts[bbv_bucket(block_pc)] += block_len;
+        status = bbv_push(vecs, count, &capacity, counts, interval_len);
+    }
+
+    return status;
+}
+
+static double bbv_distance(const double *a, const double *b) {
+    double sum = 0.0;
+    for (int i = 0; i < BBV_DIMS; i++) {
+        double diff = a[i] - b[i];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+static double lcg_unit(uint32_t *state) {
+    *state = *state * 1103515245u + 12345u;
+    return (double)(*state >> 8) / (double)(1u << 24);
+}
+
+// k-means++ seeding followed by Lloyd iterations; fills assign[n]
+static void kmeans(const bbv_t *vecs, size_t n, int k, uint32_t seed,
+                   double (*centroids)[BBV_DIMS], int *assign) {
+    double *nearest = malloc(n * sizeof(double));
+    uint32_t state = seed;
+
+    size_t first = (size_t)(lcg_unit(&state) * (double)n);
+    memcpy(centroids[0], vecs[first].v, sizeof(centroids[0]));
+    for (int c = 1; c < k; c++) {
+        double total = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            double best = bbv_distance(vecs[i].v, centroids[0]);
+            for (int j = 1; j < c; j++) {
+                double dist = bbv_distance(vecs[i].v, centroids[j]);
+                if (dist < best) best = dist;
+            }
+            if (nearest) nearest[i] = best;
+            total += best;
+        }
+
+        // Pick proportionally to squared distance; duplicates of existing
+        // centroids have zero weight
+        size_t pick = n - 1;
+        if (nearest && total > 0.0) {
+            double target = lcg_unit(&state) * total;
+            for (size_t i = 0; i < n; i++) {
+                target -= nearest[i];
+                if (target < 0.0) {
+                    pick = i;
+                    break;
+                }
+            }
+        }
+        memcpy(centroids[c], vecs[pick].v, sizeof(centroids[c]));
+    }
+    free(nearest);
+
+    for (size_t i = 0; i < n; i++) assign[i] = -1;
+
+    for (int iter = 0; iter < KMEANS_MAX_ITERS; iter++) {
+        bool changed = false;
+        for (size_t i = 0; i < n; i++) {
+            int best = 0;
+            double best_dist = bbv_distance(vecs[i].v, centroids[0]);
+            for (int c = 1; c < k; c++) {
+                double dist = bbv_distance(vecs[i].v, centroids[c]);
+                if (dist < best_dist) {
+                    best = c;
+                    best_dist = dist;
+                }
+            }
+            if (assign[i] != best) {
+                assign[i] = best;
+                changed = true;
+            }
+        }
+        if (!changed) break;
+
+        for (int c = 0; c < k; c++) {
+            double sum[BBV_DIMS] = { 0 };
+            size_t members = 0;
+            for (size_t i = 0; i < n; i++) {
+                if (assign[i] != c) continue;
+                for (int d = 0; d < BBV_DIMS; d++) sum[d] += vecs[i].v[d];
+                members++;
+            }
+            if (members == 0) continue;  // keep the old centroid
+            for (int d = 0; d < BBV_DIMS; d++) centroids[c][d] = sum[d] / (double)members;
+        }
+    }
+}
+
+static int sample(cpu_state_t *cpu, const simpoint_config_t *config, uint64_t max_insns,
+                  simpoint_result_t *result) {
+    if (!cpu->timing) {
+        printf("ERROR: simpoint_run needs a timing model (timing_attach)\n");
+        return RISCV_ERROR_INSTRUCTION;
+    }
+    if (config->clusters < 1 || config->clusters > SIMPOINT_MAX_CLUSTERS ||
+        config->interval_insns == 0) {
+        printf("ERROR: Invalid SimPoint configuration (k = %d)\n", config->clusters);
+        return RISCV_ERROR_INSTRUCTION;
+    }
+
+    memset(result, 0, sizeof(*result));
+
+    riscv_checkpoint_t *initial = checkpoint_save(cpu);
+    if (!initial) return RISCV_ERROR_MEMORY;
+
+    bbv_t *vecs = NULL;
+    size_t n = 0;
+    int status = bbv_profile(cpu, config->interval_insns, max_insns, &vecs, &n);
+    riscv_checkpoint_t *final = (status == RISCV_SUCCESS) ? checkpoint_save(cpu) : NULL;
+    if (status == RISCV_SUCCESS && !final) status = RISCV_ERROR_MEMORY;
+    if (status != RISCV_SUCCESS || n == 0) {
+        free(vecs);
+        checkpoint_free(initial);
+        checkpoint_free(final);
+        return status;
+    }
+
+    int k = config->clusters < (int)n ? config->clusters : (int)n;
+    double (*centroids)[BBV_DIMS] = malloc((size_t)k * sizeof(*centroids));
+    int *assign = malloc(n * sizeof(int));
+    if (!centroids || !assign) {
+        free(centroids);
+        free(assign);
+        free(vecs);
+        checkpoint_free(initial);
+        checkpoint_free(final);
+        return RISCV_ERROR_MEMORY;
+    }
+    kmeans(vecs, n, k, config->seed, centroids, assign);
+
+    for (size_t i = 0; i < n; i++) result->total_insns += vecs[i].insns;
+    result->intervals = n;
+
+    // One representative per non-empty cluster, ordered by position
+    for (int c = 0; c < k; c++) {
+        size_t best = n;
+        double best_dist = 0.0;
+        uint64_t cluster_insns = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (assign[i] != c) continue;
+            cluster_insns += vecs[i].insns;
+            double dist = bbv_distance(vecs[i].v, centroids[c]);
+            if (best == n || dist < best_dist) {
+                best = i;
+                best_dist = dist;
+            }
+        }
+        if (best == n) continue;
+
+        simpoint_t point = { .interval = best,
+                             .weight = (double)cluster_insns / (double)result->total_insns };
+        int pos = result->count++;
+        while (pos > 0 && result->points[pos - 1].interval > point.interval) {
+            result->points[pos] = result->points[pos - 1];
+            pos--;
+        }
+        result->points[pos] = point;
+    }
+
+    // Replay functionally, checkpointing ahead of each representative
+    riscv_checkpoint_t *ckpts[SIMPOINT_MAX_CLUSTERS] = { NULL };
+    uint64_t warmups[SIMPOINT_MAX_CLUSTERS];
+    bool quiet = cpu->syscalls && cpu->syscalls->quiet;
+    if (cpu->syscalls) cpu->syscalls->quiet = true;
+    status = checkpoint_restore(cpu, initial);
+    for (int p = 0; p < result->count && status == RISCV_SUCCESS; p++) {
+        uint64_t start = result->points[p].interval * config->interval_insns;
+        warmups[p] = config->warmup_insns < start ? config->warmup_insns : start;
+        uint64_t position = cpu->instret - initial->instret;
+        status = riscv_run(cpu, start - warmups[p] - position);
+        if (status != RISCV_SUCCESS) break;
+        ckpts[p] = checkpoint_save(cpu);
+        if (!ckpts[p]) status = RISCV_ERROR_MEMORY;
+    }
+
+    // Time each representative from its checkpoint
+    double cpi = 0.0;
+    for (int p = 0; p < result->count && status == RISCV_SUCCESS; p++) {
+        simpoint_t *point = &result->points[p];
+        status = checkpoint_restore(cpu, ckpts[p]);
+        if (status != RISCV_SUCCESS) break;
+        timing_reset(cpu->timing);
+
+        status = riscv_run_timed(cpu, warmups[p]);
+        if (status != RISCV_SUCCESS) break;
+        uint64_t cycles = cpu->timing->cycles;
+        uint64_t insns = cpu->instret;
+
+        status = riscv_run_timed(cpu, vecs[point->interval].insns);
+        if (status != RISCV_SUCCESS) break;
+        point->cycles = cpu->timing->cycles - cycles;
+        point->insns = cpu->instret - insns;
+        result->detailed_insns += warmups[p] + point->insns;
+        if (point->insns > 0) cpi += point->weight * (double)point->cycles / (double)point->insns;
+    }
+
+    for (int p = 0; p < result->count; p++) checkpoint_free(ckpts[p]);
+    if (cpu->syscalls) cpu->syscalls->quiet = quiet;
+
+    if (status == RISCV_SUCCESS) {
+        result->estimated_cpi = cpi;
+        result->estimated_cycles = cpi * (double)result->total_insns;
+        status = checkpoint_restore(cpu, final);
+    }
+
+    free(centroids);
+    free(assign);
+    free(vecs);
+    checkpoint_free(initial);
+    checkpoint_free(final);
+    return status;
+}
+
+int simpoint_run(cpu_state_t *cpu, const simpoint_config_t *config, uint64_t max_insns,
+                 simpoint_result_t *result) {
+    // The profiling pass ignores stop pcs and markers, so the replay and
+    // timed phases must too or they would stop short of their intervals
+    xlen_t saved_stop_pc = cpu->stop_pc;
+    bool saved_stop_on_marker = cpu->stop_on_marker;
+    cpu->stop_pc = RISCV_NO_STOP_PC;
+    cpu->stop_on_marker = false;
+
+    int status = sample(cpu, config, max_insns, result);
+
+    cpu->stop_pc = saved_stop_pc;
+    cpu->stop_on_marker = saved_stop_on_marker;
+    cpu->stop_requested = false;
+    return status;
+}
@@ -0,0 +1,61 @@
+/**
+ * SimPoint-Style Sampled Simulation
+ * Profiles basic-block vectors per interval in a functional pass, clusters
+ * them with k-means, and times one representative interval per cluster
+ * from a checkpoint to estimate whole-program cycles
+ */
+
+#ifndef RISCV_SAMPLING_H
+#define RISCV_SAMPLING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Basic blocks are hashed into this many BBV dimensions
+#define BBV_DIMS 32
+
+#define SIMPOINT_MAX_CLUSTERS 16
+
+typedef struct {
+    uint64_t interval_insns;    // instructions per interval
+    int clusters;               // k, at most SIMPOINT_MAX_CLUSTERS
+    uint64_t warmup_insns;      // timed before each sample but not counted
+    uint32_t seed;              // k-means++ seeding
+} simpoint_config_t;
+
+typedef struct {
+    uint64_t interval;          // index of the representative interval
+    double weight;              // share of all instructions in its cluster
+    uint64_t insns;             // measured in detail
+    uint64_t cycles;
+} simpoint_t;
+
+typedef struct {
+    uint64_t total_insns;
+    uint64_t intervals;
+    int count;                  // simulation points (non-empty clusters)
+    simpoint_t points[SIMPOINT_MAX_CLUSTERS];
+    uint64_t detailed_insns;    // timed instructions including warm-up
+    double estimated_cpi;
+    double estimated_cycles;
+} simpoint_result_t;
+
+// Defaults: 100k-instruction intervals, k = 8, 10k warm-up
+void simpoint_default_config(simpoint_config_t *config);
+
+// Profile, cluster and sample cpu from its current state. Requires
+// cpu->timing. On return cpu holds the final state of the functional pass.
+int simpoint_run(cpu_state_t *cpu, const simpoint_config_t *config, uint64_t max_insns,
+                 simpoint_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_SAMPLING_H */
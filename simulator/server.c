@@ -0,0 +1,556 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "riscv_matrix_ext.h"
+#include "interpreter.h"
+#include "checkpoint.h"
+#include "server.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#endif
+
+// Simulator daemon
+// Each pooled CPU remembers the image it last ran. A job with the same
+// image (same bytes at the same base) reuses it: the image was taken as the
+// reset base when it was loaded, so riscv_cpu_reset only copies back the
+// pages the previous job wrote, and the code pages, never written, keep
+// their predecode entries. Only a different image pays for load_image, a
+// predecode flush and a new reset base.
+//
+// A connection thread gathers every complete job already waiting on its
+// socket (up to max_batch), runs them back to back on one CPU checkout and
+// sends all the replies with one write, so small pipelined jobs cost one
+// pool lock and one host write per batch rather than per job.
+
+typedef struct {
+    cpu_state_t *cpu;
+    uint8_t *image;                     // resident image, NULL before the first job
+    size_t image_len;
+    uint64_t image_base;
+} server_slot_t;
+
+struct sim_server {
+    server_config_t config;
+    server_slot_t *slots;
+    size_t *free_slots;                 // stack of idle slot indices
+    size_t free_count;
+    pthread_mutex_t lock;
+    pthread_cond_t slot_available;
+    pthread_cond_t connections_done;
+    server_stats_t stats;
+
+    int listen_fd;
+    char path[108];
+    volatile sig_atomic_t stopping;
+    int clients[SERVER_MAX_CONNECTIONS];
+    size_t client_count;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void server_config_default(server_config_t *config) {
+    config->memory_size = SERVER_DEFAULT_MEMORY;
+    config->pool_size = SERVER_DEFAULT_POOL;
+    config->max_batch = SERVER_DEFAULT_BATCH;
+}
+
+sim_server_t* server_create(const server_config_t *config) {
+    sim_server_t *server = calloc(1, sizeof(sim_server_t));
+    if (!server) return NULL;
+    server->config = *config;
+    if (server->config.pool_size == 0) server->config.pool_size = 1;
+    if (server->config.max_batch == 0) server->config.max_batch = 1;
+    server->listen_fd = -1;
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->slot_available, NULL);
+    pthread_cond_init(&server->connections_done, NULL);
+
+    size_t n = server->config.pool_size;
+    server->slots = calloc(n, sizeof(server_slot_t));
+    server->free_slots = calloc(n, sizeof(size_t));
+    if (!server->slots || !server->free_slots) {
+        server_destroy(server);
+        return NULL;
+    }
+    for (size_t i = 0; i < n; i++) {
+        server->slots[i].cpu = init_cpu(server->config.memory_size);
+        if (!server->slots[i].cpu) {
+            printf("ERROR: Failed to allocate pooled CPU %zu\n", i);
+            server_destroy(server);
+            return NULL;
+        }
+        server->free_slots[server->free_count++] = i;
+    }
+    return server;
+}
+
+void server_destroy(sim_server_t *server) {
+    if (!server) return;
+    if (server->slots) {
+        for (size_t i = 0; i < server->config.pool_size; i++) {
+            free_cpu(server->slots[i].cpu);
+            free(server->slots[i].image);
+        }
+    }
+#ifndef _WIN32
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        unlink(server->path);
+    }
+#endif
+    pthread_cond_destroy(&server->connections_done);
+    pthread_cond_destroy(&server->slot_available);
+    pthread_mutex_destroy(&server->lock);
+    free(server->free_slots);
+    free(server->slots);
+    free(server);
+}
+
+void server_get_stats(sim_server_t *server, server_stats_t *stats) {
+    pthread_mutex_lock(&server->lock);
+    *stats = server->stats;
+    pthread_mutex_unlock(&server->lock);
+}
+
+// Make slot's CPU hold job's image with the reset base taken just after
+// loading it; returns whether the image had to be loaded
+static int prepare_image(server_slot_t *slot, const server_request_t *req, bool *loaded) {
+    const server_job_t *job = &req->job;
+    if (slot->image && slot->image_len == job->image_len && slot->image_base == job->image_base &&
+        memcmp(slot->image, req->image, job->image_len) == 0) {
+        return riscv_cpu_reset(slot->cpu);
+    }
+
+    size_t old_len = slot->image ? slot->image_len : 0;
+    uint64_t old_base = slot->image_base;
+    free(slot->image);
+    slot->image = malloc(job->image_len ? job->image_len : 1);
+    if (!slot->image) return RISCV_ERROR_MEMORY;
+    memcpy(slot->image, req->image, job->image_len);
+    slot->image_len = job->image_len;
+    slot->image_base = job->image_base;
+    *loaded = true;
+
+    // Back to power-on state: drop the previous image's base, then clear
+    // what the power-on reset leaves behind, the previous image itself
+    cpu_state_t *cpu = slot->cpu;
+    checkpoint_free(cpu->base);
+    cpu->base = NULL;
+    int status = riscv_cpu_reset(cpu);
+    static const uint8_t zeros[4096];
+    for (size_t done = 0; status == RISCV_SUCCESS && done < old_len; done += sizeof(zeros)) {
+        size_t chunk = old_len - done < sizeof(zeros) ? old_len - done : sizeof(zeros);
+        status = mem_write(cpu, (xlen_t)(old_base + done), zeros, chunk);
+    }
+    if (status == RISCV_SUCCESS) status = load_image(cpu, (xlen_t)job->image_base, req->image, job->image_len);
+    if (status == RISCV_SUCCESS) status = riscv_cpu_set_base(cpu);
+    if (status != RISCV_SUCCESS) {
+        free(slot->image);
+        slot->image = NULL;
+    }
+    return status;
+}
+
+static void run_job(server_slot_t *slot, server_request_t *req, bool *loaded) {
+    const server_job_t *job = &req->job;
+    server_result_t *result = &req->result;
+    memset(result, 0, sizeof(*result));
+    *loaded = false;
+    result->magic = SERVER_RESULT_MAGIC;
+
+    // Guest addresses must be representable at this XLEN
+    xlen_t limit = ~(xlen_t)0;
+    if (job->image_base > limit || job->entry > limit || job->input_base > limit || job->output_base > limit) {
+        result->status = RISCV_ERROR_BOUNDS;
+        return;
+    }
+
+    int status = prepare_image(slot, req, loaded);
+    cpu_state_t *cpu = slot->cpu;
+    if (status == RISCV_SUCCESS && job->input_len > 0) {
+        status = mem_write(cpu, (xlen_t)job->input_base, req->input, job->input_len);
+        predecode_invalidate(cpu, (xlen_t)job->input_base, job->input_len);
+    }
+    if (status != RISCV_SUCCESS) {
+        result->status = status;
+        return;
+    }
+
+    for (int i = 0; i < SERVER_JOB_ARGS; i++) cpu->regs[10 + i] = (xlen_t)job->args[i];
+    cpu->pc = (xlen_t)job->entry;
+    uint64_t misses = cpu->predecode ? cpu->predecode->misses : 0;
+    uint64_t start = now_ns();
+    status = riscv_run(cpu, job->max_instructions);
+    result->run_ns = now_ns() - start;
+
+    result->predecode_misses = cpu->predecode ? cpu->predecode->misses - misses : 0;
+    result->instret = cpu->instret;
+    result->matrix_ops = cpu->hpm.matrix_ops;
+    result->halted = cpu->halted;
+    result->exit_code = cpu->exit_code;
+    for (int r = 0; r < NUM_REGISTERS; r++) result->regs[r] = cpu->regs[r];
+    if (status == RISCV_SUCCESS && job->output_len > 0) {
+        status = mem_read(cpu, (xlen_t)job->output_base, req->output, job->output_len);
+    }
+    if (status == RISCV_SUCCESS) result->output_len = job->output_len;
+    result->status = status;
+}
+
+int server_run(sim_server_t *server, server_request_t *requests, size_t count) {
+    if (count == 0) return RISCV_SUCCESS;
+
+    pthread_mutex_lock(&server->lock);
+    while (server->free_count == 0) pthread_cond_wait(&server->slot_available, &server->lock);
+    size_t index = server->free_slots[--server->free_count];
+    pthread_mutex_unlock(&server->lock);
+
+    server_slot_t *slot = &server->slots[index];
+    uint64_t loads = 0;
+    for (size_t i = 0; i < count; i++) {
+        bool loaded;
+        run_job(slot, &requests[i], &loaded);
+        requests[i].result.batch = (uint32_t)count;
+        loads += loaded;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->free_slots[server->free_count++] = index;
+    server->stats.jobs += count;
+    server->stats.batches++;
+    server->stats.image_loads += loads;
+    pthread_cond_signal(&server->slot_available);
+    pthread_mutex_unlock(&server->lock);
+    return RISCV_SUCCESS;
+}
+
+#ifndef _WIN32
+
+// Growable byte buffer for one connection's input or output
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t capacity;
+} byte_buffer_t;
+
+static bool buffer_reserve(byte_buffer_t *b, size_t extra) {
+    if (b->capacity - b->len >= extra) return true;
+    size_t capacity = b->capacity ? b->capacity : 64 * 1024;
+    while (capacity - b->len < extra) capacity *= 2;
+    uint8_t *data = realloc(b->data, capacity);
+    if (!data) return false;
+    b->data = data;
+    b->capacity = capacity;
+    return true;
+}
+
+static bool write_all(int fd, const void *data, size_t len) {
+    const uint8_t *p = data;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void *data, size_t len) {
+    uint8_t *p = data;
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// Total wire size of job, 0 if the header is malformed
+static size_t job_wire_size(const server_job_t *job) {
+    if (job->magic != SERVER_JOB_MAGIC) return 0;
+    if ((size_t)job->image_len + job->input_len + job->output_len > SERVER_MAX_PAYLOAD) return 0;
+    return sizeof(server_job_t) + job->image_len + job->input_len;
+}
+
+typedef struct {
+    sim_server_t *server;
+    int fd;
+} connection_t;
+
+static void remove_client(sim_server_t *server, int fd) {
+    pthread_mutex_lock(&server->lock);
+    for (size_t i = 0; i < server->client_count; i++) {
+        if (server->clients[i] == fd) {
+            server->clients[i] = server->clients[--server->client_count];
+            break;
+        }
+    }
+    if (server->client_count == 0) pthread_cond_broadcast(&server->connections_done);
+    pthread_mutex_unlock(&server->lock);
+}
+
+static void* serve_connection(void *arg) {
+    connection_t conn = *(connection_t *)arg;
+    free(arg);
+    sim_server_t *server = conn.server;
+    size_t max_batch = server->config.max_batch;
+
+    byte_buffer_t in = {0}, out = {0};
+    server_request_t *batch = calloc(max_batch, sizeof(server_request_t));
+    uint8_t **outputs = calloc(max_batch, sizeof(uint8_t *));
+    size_t *output_caps = calloc(max_batch, sizeof(size_t));
+    bool open = batch && outputs && output_caps;
+
+    while (open) {
+        // Collect the complete jobs at the front of the input buffer
+        size_t count = 0, consumed = 0;
+        while (count < max_batch) {
+            if (in.len - consumed < sizeof(server_job_t)) break;
+            server_job_t job;
+            memcpy(&job, in.data + consumed, sizeof(job));
+            size_t size = job_wire_size(&job);
+            if (size == 0) {
+                printf("ERROR: Malformed job on connection %d\n", conn.fd);
+                open = false;
+                break;
+            }
+            if (in.len - consumed < size) break;
+            server_request_t *req = &batch[count];
+            req->job = job;
+            req->image = in.data + consumed + sizeof(server_job_t);
+            req->input = (const uint8_t *)req->image + job.image_len;
+            if (output_caps[count] < job.output_len) {
+                uint8_t *o = realloc(outputs[count], job.output_len);
+                if (!o) {
+                    open = false;
+                    break;
+                }
+                outputs[count] = o;
+                output_caps[count] = job.output_len;
+            }
+            req->output = outputs[count];
+            consumed += size;
+            count++;
+        }
+        if (!open) break;
+
+        if (count == 0) {
+            // Need more bytes: block for them
+            if (!buffer_reserve(&in, 64 * 1024)) break;
+            ssize_t n = recv(conn.fd, in.data + in.len, in.capacity - in.len, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            in.len += (size_t)n;
+            continue;
+        }
+
+        server_run(server, batch, count);
+
+        out.len = 0;
+        for (size_t i = 0; i < count && open; i++) {
+            const server_result_t *r = &batch[i].result;
+            open = buffer_reserve(&out, sizeof(*r) + r->output_len);
+            if (!open) break;
+            memcpy(out.data + out.len, r, sizeof(*r));
+            memcpy(out.data + out.len + sizeof(*r), batch[i].output, r->output_len);
+            out.len += sizeof(*r) + r->output_len;
+        }
+        if (!open || !write_all(conn.fd, out.data, out.len)) break;
+
+        memmove(in.data, in.data + consumed, in.len - consumed);
+        in.len -= consumed;
+    }
+
+    for (size_t i = 0; outputs && i < max_batch; i++) free(outputs[i]);
+    free(outputs);
+    free(output_caps);
+    free(batch);
+    free(in.data);
+    free(out.data);
+    remove_client(server, conn.fd);
+    close(conn.fd);
+    return NULL;
+}
+
+int server_listen(sim_server_t *server, const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("ERROR: Socket path %s is too long\n", path);
+        return RISCV_ERROR_BOUNDS;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        printf("ERROR: Cannot create socket: %s\n", strerror(errno));
+        return RISCV_ERROR_MEMORY;
+    }
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SERVER_MAX_CONNECTIONS) != 0) {
+        printf("ERROR: Cannot listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return RISCV_ERROR_MEMORY;
+    }
+    server->listen_fd = fd;
+    strcpy(server->path, path);
+    return RISCV_SUCCESS;
+}
+
+int server_serve(sim_server_t *server) {
+    if (server->listen_fd < 0) return RISCV_ERROR_MEMORY;
+
+    while (!server->stopping) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+
+        pthread_mutex_lock(&server->lock);
+        bool full = server->client_count == SERVER_MAX_CONNECTIONS;
+        if (!full) server->clients[server->client_count++] = fd;
+        server->stats.connections += !full;
+        pthread_mutex_unlock(&server->lock);
+        connection_t *conn = full ? NULL : malloc(sizeof(connection_t));
+        pthread_t thread;
+        if (conn) {
+            conn->server = server;
+            conn->fd = fd;
+            if (pthread_create(&thread, NULL, serve_connection, conn) == 0) {
+                pthread_detach(thread);
+                continue;
+            }
+            free(conn);
+        }
+        printf("ERROR: Dropping connection, %s\n", full ? "too many clients" : "no thread");
+        if (!full) remove_client(server, fd);
+        close(fd);
+    }
+
+    // Unblock connection threads still waiting on their clients and wait
+    // for them to release their CPUs
+    pthread_mutex_lock(&server->lock);
+    for (size_t i = 0; i < server->client_count; i++) shutdown(server->clients[i], SHUT_RDWR);
+    while (server->client_count > 0) pthread_cond_wait(&server->connections_done, &server->lock);
+    pthread_mutex_unlock(&server->lock);
+    return RISCV_SUCCESS;
+}
+
+// Async-signal-safe: only a flag store and shutdown(2)
+void server_stop(sim_server_t *server) {
+    server->stopping = 1;
+    if (server->listen_fd >= 0) shutdown(server->listen_fd, SHUT_RDWR);
+}
+
+int server_connect(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One sendmsg for header, image and input; write_all finishes a short send
+int server_send_job(int fd, const server_job_t *job, const void *image, const void *input) {
+    struct iovec iov[3] = {
+        { (void *)job, sizeof(*job) },
+        { (void *)image, job->image_len },
+        { (void *)input, job->input_len },
+    };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 3;
+    ssize_t n;
+    do {
+        n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) return RISCV_ERROR_MEMORY;
+
+    size_t skip = (size_t)n;
+    for (int i = 0; i < 3; i++) {
+        size_t part = skip < iov[i].iov_len ? skip : iov[i].iov_len;
+        skip -= part;
+        if (!write_all(fd, (const uint8_t *)iov[i].iov_base + part, iov[i].iov_len - part)) {
+            return RISCV_ERROR_MEMORY;
+        }
+    }
+    return RISCV_SUCCESS;
+}
+
+int server_recv_result(int fd, server_result_t *result, void *output, size_t capacity) {
+    if (!read_all(fd, result, sizeof(*result)) || result->magic != SERVER_RESULT_MAGIC) {
+        return RISCV_ERROR_MEMORY;
+    }
+    size_t len = result->output_len;
+    size_t keep = output ? (len < capacity ? len : capacity) : 0;
+    if (!read_all(fd, output, keep)) return RISCV_ERROR_MEMORY;
+    uint8_t scratch[256];
+    while (keep < len) {
+        size_t chunk = len - keep < sizeof(scratch) ? len - keep : sizeof(scratch);
+        if (!read_all(fd, scratch, chunk)) return RISCV_ERROR_MEMORY;
+        keep += chunk;
+    }
+    return RISCV_SUCCESS;
+}
+
+#else
+
+int server_listen(sim_server_t *server, const char *path) {
+    (void)server;
+    printf("ERROR: Cannot listen on %s, Unix sockets are not supported on this host\n", path);
+    return RISCV_ERROR_MEMORY;
+}
+
+int server_serve(sim_server_t *server) {
+    (void)server;
+    return RISCV_ERROR_MEMORY;
+}
+
+void server_stop(sim_server_t *server) {
+    server->stopping = 1;
+}
+
+int server_connect(const char *path) {
+    (void)path;
+    return -1;
+}
+
+int server_send_job(int fd, const server_job_t *job, const void *image, const void *input) {
+    (void)fd; (void)job; (void)image; (void)input;
+    return RISCV_ERROR_MEMORY;
+}
+
+int server_recv_result(int fd, server_result_t *result, void *output, size_t capacity) {
+    (void)fd; (void)result; (void)output; (void)capacity;
+    return RISCV_ERROR_MEMORY;
+}
+
+#endif
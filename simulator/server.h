@@ -0,0 +1,116 @@
+/**
+ * Simulator Daemon
+ * A long-running job server that keeps a pool of warm CPUs (RAM allocated,
+ * program image resident, predecode cache filled) and runs jobs submitted
+ * over a local Unix socket
+ */
+
+#ifndef RISCV_SERVER_H
+#define RISCV_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SERVER_DEFAULT_SOCKET   "/tmp/matmul_server.sock"
+#define SERVER_DEFAULT_MEMORY   (1024 * 1024)
+#define SERVER_DEFAULT_POOL     4
+#define SERVER_DEFAULT_BATCH    32
+#define SERVER_MAX_CONNECTIONS  64
+#define SERVER_MAX_PAYLOAD      ((size_t)64 * 1024 * 1024)  // image + input + output per job
+
+// Wire format. Both ends are on the same host, so structures are sent as-is
+// in host byte order; every field is fixed width so RV32 and RV64 builds
+// agree. A job is a server_job_t followed by image_len image bytes and
+// input_len input bytes; the reply is a server_result_t followed by
+// output_len bytes of guest memory. Jobs may be pipelined on one
+// connection and are answered in order.
+#define SERVER_JOB_MAGIC    0x424A4D4Du     // "MMJB"
+#define SERVER_RESULT_MAGIC 0x534A4D4Du     // "MMJS"
+#define SERVER_JOB_ARGS     8               // a0..a7
+
+typedef struct {
+    uint32_t magic;
+    uint32_t image_len;
+    uint64_t image_base;                // image is loaded here
+    uint64_t entry;                     // initial pc
+    uint64_t max_instructions;          // budget; the job stops unhalted when it runs out
+    uint64_t args[SERVER_JOB_ARGS];     // initial a0..a7
+    uint64_t input_base;                // input bytes are written here before the run
+    uint64_t output_base;               // output bytes are read from here after it
+    uint32_t input_len;
+    uint32_t output_len;
+} server_job_t;
+
+typedef struct {
+    uint32_t magic;
+    int32_t status;                     // RISCV_SUCCESS or the error that stopped the job
+    uint32_t halted;                    // guest reached ecall/ebreak within the budget
+    int32_t exit_code;
+    uint64_t instret;
+    uint64_t matrix_ops;
+    uint64_t predecode_misses;          // 0 when the image and cache were already warm
+    uint64_t run_ns;                    // host time spent simulating
+    uint64_t regs[NUM_REGISTERS];
+    uint32_t output_len;
+    uint32_t batch;                     // jobs run together with this one
+} server_result_t;
+
+typedef struct {
+    size_t memory_size;                 // guest RAM per pooled CPU
+    size_t pool_size;                   // CPUs, i.e. jobs running at once
+    size_t max_batch;                   // jobs a connection runs per CPU checkout
+} server_config_t;
+
+// In-process job: image and input are borrowed, output must hold
+// job.output_len bytes
+typedef struct {
+    server_job_t job;
+    const void *image;
+    const void *input;
+    void *output;
+    server_result_t result;
+} server_request_t;
+
+typedef struct {
+    uint64_t jobs;
+    uint64_t batches;
+    uint64_t image_loads;               // jobs whose image was not already resident
+    uint64_t connections;
+} server_stats_t;
+
+typedef struct sim_server sim_server_t;
+
+void server_config_default(server_config_t *config);
+sim_server_t* server_create(const server_config_t *config);
+void server_destroy(sim_server_t *server);
+void server_get_stats(sim_server_t *server, server_stats_t *stats);
+
+// Run count jobs on one pooled CPU, blocking while every CPU is busy.
+// Per-job failures are reported in each result.
+int server_run(sim_server_t *server, server_request_t *requests, size_t count);
+
+// Socket front end (POSIX hosts). server_serve accepts connections, one
+// thread each, until server_stop is called from another thread or a signal
+// handler.
+int server_listen(sim_server_t *server, const char *path);
+int server_serve(sim_server_t *server);
+void server_stop(sim_server_t *server);
+
+// Client side; these return RISCV_SUCCESS or RISCV_ERROR_MEMORY on a
+// connection or protocol failure. output may be NULL to discard it.
+int server_connect(const char *path);
+int server_send_job(int fd, const server_job_t *job, const void *image, const void *input);
+int server_recv_result(int fd, server_result_t *result, void *output, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_SERVER_H */
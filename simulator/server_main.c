@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#include "riscv_matrix_ext.h"
+#include "server.h"
+
+// RISC-V Matrix Extension Simulator - job daemon
+// Usage: matmul_server [-s socket] [-m memory_bytes] [-p pool_size] [-b max_batch]
+
+static sim_server_t *running;
+
+static void handle_signal(int sig) {
+    (void)sig;
+    if (running) server_stop(running);
+}
+
+static void usage(void) {
+    printf("Usage: matmul_server [-s socket] [-m memory_bytes] [-p pool_size] [-b max_batch]\n");
+}
+
+int main(int argc, char **argv) {
+    const char *path = SERVER_DEFAULT_SOCKET;
+    server_config_t config;
+    server_config_default(&config);
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+            usage();
+            return 1;
+        }
+        const char *value = argv[++i];
+        switch (argv[i - 1][1]) {
+        case 's': path = value; break;
+        case 'm': config.memory_size = strtoull(value, NULL, 0); break;
+        case 'p': config.pool_size = strtoull(value, NULL, 0); break;
+        case 'b': config.max_batch = strtoull(value, NULL, 0); break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    sim_server_t *server = server_create(&config);
+    if (!server) {
+        printf("Failed to create the CPU pool\n");
+        return 1;
+    }
+    if (server_listen(server, path) != RISCV_SUCCESS) {
+        server_destroy(server);
+        return 1;
+    }
+
+    running = server;
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+    printf("RV%d matmul_server on %s: %zu CPUs x %zu bytes, batches of up to %zu\n",
+           XLEN, path, config.pool_size, config.memory_size, config.max_batch);
+    fflush(stdout);
+
+    server_serve(server);
+
+    server_stats_t stats;
+    server_get_stats(server, &stats);
+    printf("Served %llu jobs in %llu batches over %llu connections, %llu image loads\n",
+           (unsigned long long)stats.jobs, (unsigned long long)stats.batches,
+           (unsigned long long)stats.connections, (unsigned long long)stats.image_loads);
+    running = NULL;
+    server_destroy(server);
+    return 0;
+}
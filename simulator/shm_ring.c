@@ -0,0 +1,210 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "riscv_matrix_ext.h"
+#include "file_map.h"
+#include "shm_ring.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define SHM_RING_MMAP 1
+#endif
+
+// Shared-memory matrix ring
+// The host and the guest see the same physical pages: the host through its
+// own MAP_SHARED view of the memfd, the guest through a FILE_MAP_SHARED
+// mapping of it. Enqueueing writes one descriptor and publishes head with a
+// release store; the guest loads head, fences, and reads the descriptor and
+// tiles where the host left them. Neither side makes a system call or copies
+// a tile.
+//
+// Ordering: guest loads and stores are plain host memory accesses and a
+// guest FENCE is a host fence (see riscv_execute_decoded), so the guest
+// consumer's "lw head; fence r,r" pairs with the host's release store, and
+// its "fence rw,w; sw tail" with the host's acquire load of tail.
+
+static uint32_t* ring_word(const shm_ring_t *ring, size_t offset) {
+    return (uint32_t *)(ring->host + offset);
+}
+
+static shm_ring_t* map_region(int fd, size_t size, xlen_t guest_base) {
+#ifdef SHM_RING_MMAP
+    if ((uint64_t)guest_base + size > 0x80000000ull) {
+        printf("ERROR: Shared ring at 0x%" PRIxXLEN " must lie below 2 GiB\n", guest_base);
+        return NULL;
+    }
+    shm_ring_t *ring = calloc(1, sizeof(shm_ring_t));
+    if (!ring) return NULL;
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        printf("ERROR: Cannot map the shared ring\n");
+        free(ring);
+        return NULL;
+    }
+    ring->fd = fd;
+    ring->host = p;
+    ring->size = size;
+    ring->guest_base = guest_base;
+    ring->descs = (shm_desc_t *)(ring->host + SHM_RING_DESCS);
+    return ring;
+#else
+    (void)fd; (void)size; (void)guest_base;
+    printf("ERROR: Shared rings need mmap, not available on this host\n");
+    return NULL;
+#endif
+}
+
+shm_ring_t* shm_ring_create(size_t size, uint32_t capacity, xlen_t guest_base) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        printf("ERROR: Ring capacity %u is not a power of two\n", capacity);
+        return NULL;
+    }
+    size_t data_offset = (SHM_RING_DESCS + (size_t)capacity * sizeof(shm_desc_t) + 63) & ~(size_t)63;
+    if (size < data_offset) {
+        printf("ERROR: %zu-byte region cannot hold a %u-entry ring\n", size, capacity);
+        return NULL;
+    }
+
+#if defined(SHM_RING_MMAP) && defined(MFD_CLOEXEC)
+    int fd = memfd_create("matmul_ring", MFD_CLOEXEC);
+#else
+    FILE *tmp = tmpfile();
+    int fd = tmp ? dup(fileno(tmp)) : -1;
+    if (tmp) fclose(tmp);
+#endif
+    if (fd < 0 || ftruncate(fd, (off_t)size) != 0) {
+        printf("ERROR: Cannot create a %zu-byte shared region\n", size);
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+    shm_ring_t *ring = map_region(fd, size, guest_base);
+    if (!ring) {
+        close(fd);
+        return NULL;
+    }
+    ring->capacity = capacity;
+    ring->data_offset = data_offset;
+    *ring_word(ring, SHM_RING_CAPACITY) = capacity;
+    return ring;
+}
+
+shm_ring_t* shm_ring_attach(int fd, xlen_t guest_base) {
+#ifdef SHM_RING_MMAP
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < SHM_RING_DESCS) {
+        printf("ERROR: fd %d is not a shared ring\n", fd);
+        return NULL;
+    }
+    shm_ring_t *ring = map_region(fd, (size_t)st.st_size, guest_base);
+    if (!ring) return NULL;
+    ring->capacity = *ring_word(ring, SHM_RING_CAPACITY);
+    ring->data_offset = (SHM_RING_DESCS + (size_t)ring->capacity * sizeof(shm_desc_t) + 63) & ~(size_t)63;
+    uint32_t capacity = ring->capacity;
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 || ring->data_offset > ring->size) {
+        printf("ERROR: fd %d is not a shared ring\n", fd);
+        ring->fd = -1;
+        shm_ring_free(ring);
+        return NULL;
+    }
+    ring->head = __atomic_load_n(ring_word(ring, SHM_RING_HEAD), __ATOMIC_ACQUIRE);
+    ring->tail_cache = __atomic_load_n(ring_word(ring, SHM_RING_TAIL), __ATOMIC_ACQUIRE);
+    return ring;
+#else
+    (void)fd; (void)guest_base;
+    printf("ERROR: Shared rings need mmap, not available on this host\n");
+    return NULL;
+#endif
+}
+
+void shm_ring_free(shm_ring_t *ring) {
+    if (!ring) return;
+#ifdef SHM_RING_MMAP
+    munmap(ring->host, ring->size);
+#endif
+    if (ring->fd >= 0) close(ring->fd);
+    free(ring);
+}
+
+int shm_ring_map(cpu_state_t *cpu, shm_ring_t *ring) {
+    return file_map_fd(cpu, ring->guest_base, ring->fd, 0, ring->size, FILE_MAP_SHARED);
+}
+
+void* shm_ring_alloc(shm_ring_t *ring, size_t bytes, xlen_t *guest) {
+    // data_used is rounded up to 16 bytes, so offset can pass the end of a
+    // region whose size is not a multiple of 16
+    size_t offset = ring->data_offset + ring->data_used;
+    if (offset > ring->size || bytes > ring->size - offset) return NULL;
+    ring->data_used += (bytes + 15) & ~(size_t)15;
+    *guest = ring->guest_base + (xlen_t)offset;
+    return ring->host + offset;
+}
+
+xlen_t shm_ring_guest_addr(const shm_ring_t *ring, const void *host) {
+    return ring->guest_base + (xlen_t)((const uint8_t *)host - ring->host);
+}
+
+bool shm_ring_push(shm_ring_t *ring, xlen_t a, xlen_t b, xlen_t c, uint32_t tag) {
+    if (ring->head - ring->tail_cache == ring->capacity) {
+        ring->tail_cache = __atomic_load_n(ring_word(ring, SHM_RING_TAIL), __ATOMIC_ACQUIRE);
+        if (ring->head - ring->tail_cache == ring->capacity) return false;
+    }
+    shm_desc_t *d = &ring->descs[ring->head & (ring->capacity - 1)];
+    d->a = (uint32_t)a;
+    d->b = (uint32_t)b;
+    d->c = (uint32_t)c;
+    d->tag = tag;
+    ring->head++;
+    __atomic_store_n(ring_word(ring, SHM_RING_HEAD), ring->head, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t shm_ring_space(shm_ring_t *ring) {
+    ring->tail_cache = __atomic_load_n(ring_word(ring, SHM_RING_TAIL), __ATOMIC_ACQUIRE);
+    return ring->capacity - (ring->head - ring->tail_cache);
+}
+
+uint32_t shm_ring_consumed(const shm_ring_t *ring) {
+    return __atomic_load_n(ring_word(ring, SHM_RING_TAIL), __ATOMIC_ACQUIRE);
+}
+
+void shm_ring_emit_consumer(rv_program_t *prog, const shm_ring_t *ring, uint32_t count) {
+    // x8 ring base, x9 tail, x18 index mask, x19 descriptors, x20 remaining
+    rv_emit_li(prog, 8, (int32_t)ring->guest_base);
+    rv_emit32(prog, rv_lw(9, 8, SHM_RING_TAIL));
+    rv_emit32(prog, rv_lw(18, 8, SHM_RING_CAPACITY));
+    rv_emit32(prog, rv_addi(18, 18, -1));
+    rv_emit32(prog, rv_addi(19, 8, SHM_RING_DESCS));
+    rv_emit_li(prog, 20, (int32_t)count);
+
+    size_t loop = prog->len;
+    rv_emit32(prog, rv_lw(5, 8, SHM_RING_HEAD));
+    rv_emit32(prog, rv_bne(5, 9, 16));
+    rv_emit32(prog, rv_marker(SHM_RING_MARKER_EMPTY));
+    rv_emit32(prog, rv_pause());
+    rv_emit32(prog, rv_jal(0, (int32_t)loop - (int32_t)prog->len));
+    rv_emit32(prog, rv_fence(RV_FENCE_R, RV_FENCE_R));
+    rv_emit32(prog, rv_and(6, 9, 18));
+    rv_emit32(prog, rv_slli(6, 6, 4));
+    rv_emit32(prog, rv_add(6, 6, 19));
+    rv_emit32(prog, rv_lw(11, 6, 0));
+    rv_emit32(prog, rv_lw(12, 6, 4));
+    rv_emit32(prog, rv_lw(13, 6, 8));
+    rv_emit32(prog, rv_matmul(13, 11, 12));
+#if XLEN == 64
+    // addiw: keep tail sign-extended like the lw of head it is compared with
+    rv_emit32(prog, rv_enc_i(RV_OP_IMM_32, 9, 0, 9, 1));
+#else
+    rv_emit32(prog, rv_addi(9, 9, 1));
+#endif
+    rv_emit32(prog, rv_fence(RV_FENCE_RW, RV_FENCE_W));
+    rv_emit32(prog, rv_sw(9, 8, SHM_RING_TAIL));
+    rv_emit32(prog, rv_addi(20, 20, -1));
+    rv_emit32(prog, rv_bne(20, 0, (int32_t)loop - (int32_t)prog->len));
+    rv_emit32(prog, rv_addi(10, 0, 0));
+    rv_emit32(prog, rv_ecall());
+}
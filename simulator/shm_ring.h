@@ -0,0 +1,95 @@
+/**
+ * Shared-Memory Matrix Ring
+ * A memfd-backed region mapped both into the host process and into guest
+ * memory, with a single-producer single-consumer descriptor ring: the host
+ * enqueues MATMUL operand pairs and the guest consumes them in place
+ */
+
+#ifndef RISCV_SHM_RING_H
+#define RISCV_SHM_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv_matrix_ext.h"
+#include "riscv_encode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Region layout (offsets from the region base, identical in both views):
+//   0x000  head      u32, next descriptor the host will fill (host writes)
+//   0x040  tail      u32, next descriptor the guest will consume (guest writes)
+//   0x080  capacity  u32, power of two
+//   0x100  capacity descriptors, then the data area for tiles
+// head and tail are free-running; the ring is empty when they are equal and
+// full when head - tail == capacity. They sit on separate cache lines.
+#define SHM_RING_HEAD       0x000
+#define SHM_RING_TAIL       0x040
+#define SHM_RING_CAPACITY   0x080
+#define SHM_RING_DESCS      0x100
+
+// The guest consumer runs this marker, then a pause hint, whenever it finds
+// the ring empty, so a single-threaded host can set stop_on_marker and
+// refill, and a spinning guest yields the host CPU to the producer
+#define SHM_RING_MARKER_EMPTY 0x7E0
+
+// One MATMUL: C = A * B. Guest addresses are 32-bit so the same ring works
+// on both cores; the region must lie below 2 GiB in the guest.
+typedef struct {
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+    uint32_t tag;                       // free for the host, not read by the guest
+} shm_desc_t;
+
+typedef struct {
+    int fd;                             // memfd; pass to another process to share the ring
+    uint8_t *host;                      // host view of the region
+    size_t size;
+    xlen_t guest_base;                  // guest view, FILE_MAP_ALIGN-aligned above RAM
+    uint32_t capacity;
+    shm_desc_t *descs;
+    size_t data_offset;                 // start of the tile area
+    size_t data_used;                   // bytes handed out by shm_ring_alloc
+    uint32_t head;                      // producer's own copy of head
+    uint32_t tail_cache;                // last tail seen, refreshed only when the ring looks full
+} shm_ring_t;
+
+// Create a size-byte region with a capacity-entry ring (a power of two)
+// that guests will see at guest_base. shm_ring_attach maps a region another
+// process created, taking its fd.
+shm_ring_t* shm_ring_create(size_t size, uint32_t capacity, xlen_t guest_base);
+shm_ring_t* shm_ring_attach(int fd, xlen_t guest_base);
+void shm_ring_free(shm_ring_t *ring);
+
+// Map the region into a CPU's address space at ring->guest_base
+int shm_ring_map(cpu_state_t *cpu, shm_ring_t *ring);
+
+// Carve 16-byte aligned space out of the data area for the host to build
+// tiles in place; returns the host pointer (NULL when full) and the guest
+// address in *guest
+void* shm_ring_alloc(shm_ring_t *ring, size_t bytes, xlen_t *guest);
+xlen_t shm_ring_guest_addr(const shm_ring_t *ring, const void *host);
+
+// Host producer: enqueue C = A * B (guest addresses); false if the ring is
+// full. Only one thread may push. shm_ring_space is the number of pushes
+// that will succeed, so a producer that keeps one tile slot per descriptor
+// (slot = head & (capacity - 1)) knows which slots it may overwrite.
+bool shm_ring_push(shm_ring_t *ring, xlen_t a, xlen_t b, xlen_t c, uint32_t tag);
+uint32_t shm_ring_space(shm_ring_t *ring);
+
+// Descriptors the guest has finished; their C tiles are visible to the host
+uint32_t shm_ring_consumed(const shm_ring_t *ring);
+
+// Emit the guest consumer: pop count descriptors (spinning on the empty
+// marker while the ring is empty), MATMUL each, then ecall with a0 = 0
+void shm_ring_emit_consumer(rv_program_t *prog, const shm_ring_t *ring, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_SHM_RING_H */
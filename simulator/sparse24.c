@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "riscv_matrix_ext.h"
+#include "sparse24.h"
+
+// 2:4 structured sparsity
+// Each row of A keeps two values and their columns. The kernel gathers the
+// two B rows each A row needs (8 bytes apiece) straight into vector lanes:
+//   C = [a0 a0 a1 a1] * [B[i00] B[i10]] + [a0' a0' a1' a1'] * [B[i01] B[i11]]
+// which is the same shape as the dense 2x2 kernel, so a 2x4 * 4x2 product
+// costs one dense MATMUL instead of two.
+
+#if defined(__GNUC__) || defined(__clang__)
+typedef uint32_t sparse24_v4 __attribute__((vector_size(16)));
+#endif
+
+static int column(uint32_t meta, int row, int k) {
+    return (int)((meta >> (4 * row + 2 * k)) & 3);
+}
+
+int sparse24_pack(const int32_t dense[MATRIX_DIM][SPARSE24_K], sparse24_tile_t *tile) {
+    memset(tile, 0, sizeof(*tile));
+
+    for (int r = 0; r < MATRIX_DIM; r++) {
+        int kept = 0;
+        int cols[2] = { 0, 0 };
+        for (int c = 0; c < SPARSE24_K; c++) {
+            if (dense[r][c] == 0) continue;
+            if (kept == 2) {
+                printf("ERROR: Row %d has more than two non-zeros; not 2:4 sparse\n", r);
+                return RISCV_ERROR_INSTRUCTION;
+            }
+            cols[kept] = c;
+            tile->values[r][kept++] = dense[r][c];
+        }
+
+        // Pad with zero values at unused columns, keeping indices increasing
+        if (kept == 0) {
+            cols[0] = 0;
+            cols[1] = 1;
+        } else if (kept == 1) {
+            if (cols[0] == SPARSE24_K - 1) {
+                cols[1] = cols[0];
+                tile->values[r][1] = tile->values[r][0];
+                tile->values[r][0] = 0;
+                cols[0] = cols[1] - 1;
+            } else {
+                cols[1] = cols[0] + 1;
+            }
+        }
+        tile->meta |= (uint32_t)(cols[0] | (cols[1] << 2)) << (4 * r);
+    }
+    return RISCV_SUCCESS;
+}
+
+void sparse24_unpack(const sparse24_tile_t *tile, int32_t dense[MATRIX_DIM][SPARSE24_K]) {
+    memset(dense, 0, sizeof(int32_t) * MATRIX_DIM * SPARSE24_K);
+    for (int r = 0; r < MATRIX_DIM; r++) {
+        for (int k = 0; k < 2; k++) {
+            dense[r][column(tile->meta, r, k)] += tile->values[r][k];
+        }
+    }
+}
+
+matrix_2x2_t sparse24_multiply(const sparse24_tile_t *a, const int32_t b[SPARSE24_K][MATRIX_DIM]) {
+    matrix_2x2_t result;
+#if defined(__GNUC__) || defined(__clang__)
+    sparse24_v4 b_lo, b_hi;
+    memcpy((uint32_t*)&b_lo + 0, b[column(a->meta, 0, 0)], VECTOR_BYTES);
+    memcpy((uint32_t*)&b_lo + 2, b[column(a->meta, 1, 0)], VECTOR_BYTES);
+    memcpy((uint32_t*)&b_hi + 0, b[column(a->meta, 0, 1)], VECTOR_BYTES);
+    memcpy((uint32_t*)&b_hi + 2, b[column(a->meta, 1, 1)], VECTOR_BYTES);
+
+    uint32_t a00 = (uint32_t)a->values[0][0], a01 = (uint32_t)a->values[0][1];
+    uint32_t a10 = (uint32_t)a->values[1][0], a11 = (uint32_t)a->values[1][1];
+    sparse24_v4 a_lo = { a00, a00, a10, a10 };
+    sparse24_v4 a_hi = { a01, a01, a11, a11 };
+
+    sparse24_v4 c = a_lo * b_lo + a_hi * b_hi;
+    memcpy(&result, &c, sizeof(result));
+#else
+    for (int r = 0; r < MATRIX_DIM; r++) {
+        for (int j = 0; j < MATRIX_DIM; j++) {
+            uint32_t sum = 0;
+            for (int k = 0; k < 2; k++) {
+                sum += (uint32_t)a->values[r][k] * (uint32_t)b[column(a->meta, r, k)][j];
+            }
+            result.m[r][j] = (int32_t)sum;
+        }
+    }
+#endif
+    return result;
+}
@@ -0,0 +1,47 @@
+/**
+ * 2:4 Structured Sparsity
+ * Compressed A tiles for the sparse MATMUL variant: a 2x4 tile with at
+ * most two non-zeros in each row of four, stored as values plus 2-bit
+ * column indices
+ */
+
+#ifndef RISCV_SPARSE24_H
+#define RISCV_SPARSE24_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPARSE24_K 4                        // dense columns per A row
+#define SPARSE24_TILE_BYTES 20              // values + metadata word
+#define SPARSE24_B_BYTES (SPARSE24_K * MATRIX_DIM * sizeof(int32_t))
+
+// Guest layout: values row-major (offset 8 * r + 4 * k), then the metadata
+// word at offset 16. The column of values[r][k] is
+// (meta >> (4 * r + 2 * k)) & 3; only the low 8 bits are used.
+typedef struct {
+    int32_t values[MATRIX_DIM][2];
+    uint32_t meta;
+} sparse24_tile_t;
+
+// Compress a dense 2x4 tile. Rows with fewer than two non-zeros are padded
+// with zero values; indices within a row are increasing. Fails if a row
+// has more than two non-zeros.
+int sparse24_pack(const int32_t dense[MATRIX_DIM][SPARSE24_K], sparse24_tile_t *tile);
+void sparse24_unpack(const sparse24_tile_t *tile, int32_t dense[MATRIX_DIM][SPARSE24_K]);
+
+// C (2x2) = A (compressed 2x4) * B (4x2, row-major): 8 multiplies instead
+// of the dense 16
+matrix_2x2_t sparse24_multiply(const sparse24_tile_t *a, const int32_t b[SPARSE24_K][MATRIX_DIM]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_SPARSE24_H */
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sparse_memory.h"
+
+// Sparse guest memory
+// Open-addressed hash table from page number to a host page. RV64 guests
+// place matrices anywhere in a 64-bit address space, so only the pages that
+// are actually touched get host memory.
+
+#define SPARSE_INITIAL_SLOTS 64
+
+struct sparse_memory {
+    uint64_t *keys;         // page numbers
+    uint8_t **pages;        // NULL marks an empty slot
+    size_t slots;           // always a power of two
+    size_t count;
+
+    // One-entry lookup cache: matrix operands are usually on the same page
+    uint64_t last_key;
+    uint8_t *last_page;
+};
+
+static size_t hash_page(uint64_t page_number, size_t slots) {
+    return (size_t)((page_number * 0x9E3779B97F4A7C15ull) >> 32) & (slots - 1);
+}
+
+sparse_memory_t* sparse_memory_create(void) {
+    sparse_memory_t *mem = calloc(1, sizeof(sparse_memory_t));
+    if (!mem) return NULL;
+
+    mem->slots = SPARSE_INITIAL_SLOTS;
+    mem->keys = calloc(mem->slots, sizeof(uint64_t));
+    mem->pages = calloc(mem->slots, sizeof(uint8_t*));
+
+    if (!mem->keys || !mem->pages) {
+        sparse_memory_free(mem);
+        return NULL;
+    }
+
+    return mem;
+}
+
+void sparse_memory_free(sparse_memory_t *mem) {
+    if (!mem) return;
+
+    if (mem->pages) {
+        for (size_t i = 0; i < mem->slots; i++) {
+            free(mem->pages[i]);
+        }
+    }
+    free(mem->pages);
+    free(mem->keys);
+    free(mem);
+}
+
+static int sparse_memory_grow(sparse_memory_t *mem) {
+    size_t new_slots = mem->slots * 2;
+    uint64_t *keys = calloc(new_slots, sizeof(uint64_t));
+    uint8_t **pages = calloc(new_slots, sizeof(uint8_t*));
+
+    if (!keys || !pages) {
+        free(keys);
+        free(pages);
+        return -1;
+    }
+
+    for (size_t i = 0; i < mem->slots; i++) {
+        if (!mem->pages[i]) continue;
+
+        size_t slot = hash_page(mem->keys[i], new_slots);
+        while (pages[slot]) {
+            slot = (slot + 1) & (new_slots - 1);
+        }
+        keys[slot] = mem->keys[i];
+        pages[slot] = mem->pages[i];
+    }
+
+    free(mem->keys);
+    free(mem->pages);
+    mem->keys = keys;
+    mem->pages = pages;
+    mem->slots = new_slots;
+    return 0;
+}
+
+uint8_t* sparse_memory_page(sparse_memory_t *mem, uint64_t page_number, bool allocate) {
+    if (mem->last_page && mem->last_key == page_number) {
+        return mem->last_page;
+    }
+
+    size_t slot = hash_page(page_number, mem->slots);
+    while (mem->pages[slot]) {
+        if (mem->keys[slot] == page_number) {
+            mem->last_key = page_number;
+            mem->last_page = mem->pages[slot];
+            return mem->pages[slot];
+        }
+        slot = (slot + 1) & (mem->slots - 1);
+    }
+
+    if (!allocate) return NULL;
+
+    // Keep the load factor at or below one half
+    if ((mem->count + 1) * 2 > mem->slots) {
+        if (sparse_memory_grow(mem) != 0) {
+            printf("ERROR: Failed to grow sparse memory table\n");
+            return NULL;
+        }
+        slot = hash_page(page_number, mem->slots);
+        while (mem->pages[slot]) {
+            slot = (slot + 1) & (mem->slots - 1);
+        }
+    }
+
+    uint8_t *page = calloc(1, SPARSE_PAGE_SIZE);
+    if (!page) {
+        printf("ERROR: Failed to allocate sparse page 0x%llx\n",
+               (unsigned long long)page_number);
+        return NULL;
+    }
+
+    mem->keys[slot] = page_number;
+    mem->pages[slot] = page;
+    mem->count++;
+    mem->last_key = page_number;
+    mem->last_page = page;
+    return page;
+}
+
+size_t sparse_memory_page_count(const sparse_memory_t *mem) {
+    return mem->count;
+}
+
+void sparse_memory_foreach(sparse_memory_t *mem, sparse_page_fn fn, void *ctx) {
+    for (size_t i = 0; i < mem->slots; i++) {
+        if (mem->pages[i]) fn(mem->keys[i], mem->pages[i], ctx);
+    }
+}
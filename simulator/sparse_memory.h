@@ -0,0 +1,42 @@
+/**
+ * Sparse Guest Memory
+ * Lazily allocated pages for guest addresses outside the flat RAM region
+ */
+
+#ifndef SPARSE_MEMORY_H
+#define SPARSE_MEMORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Page geometry
+#define SPARSE_PAGE_BITS 12
+#define SPARSE_PAGE_SIZE ((uint64_t)1 << SPARSE_PAGE_BITS)
+#define SPARSE_PAGE_MASK (SPARSE_PAGE_SIZE - 1)
+
+typedef struct sparse_memory sparse_memory_t;
+
+sparse_memory_t* sparse_memory_create(void);
+void sparse_memory_free(sparse_memory_t *mem);
+
+// Host pointer to the page holding page_number. Unmapped pages are
+// allocated (zero-filled) when allocate is set, otherwise NULL is returned.
+uint8_t* sparse_memory_page(sparse_memory_t *mem, uint64_t page_number, bool allocate);
+
+// Number of pages currently backed by host memory
+size_t sparse_memory_page_count(const sparse_memory_t *mem);
+
+// Call fn for every backed page, in table order
+typedef void (*sparse_page_fn)(uint64_t page_number, uint8_t *page, void *ctx);
+void sparse_memory_foreach(sparse_memory_t *mem, sparse_page_fn fn, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARSE_MEMORY_H */
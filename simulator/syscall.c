@@ -0,0 +1,427 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "riscv_matrix_ext.h"
+#include "sparse_memory.h"
+#include "interpreter.h"
+#include "replay.h"
+#include "syscall.h"
+
+// Proxy syscalls
+// Guest buffers are used in place: write(2) reads straight out of guest
+// memory and reads pread(2) straight into it, one host call per contiguous
+// span (the flat RAM, or one sparse page), with no bounce buffer. Small
+// writes are the exception: they are gathered into the output buffer so a
+// printf-heavy guest costs one host write per 64 KiB rather than per call.
+//
+// Seekable files are accessed at an offset kept per guest fd, so reads and
+// writes need no host lseek. File input is nondeterministic, so with a
+// replay stream attached every open, read and file-size result goes through
+// the log; on replay the host files are not touched at all.
+//
+// Checkpoints and riscv_cpu_reset carry what the guest can observe: the
+// break and, per fd, the file and offset. A restore reuses host fds still
+// open on the same file and reopens the others by path.
+
+#ifdef _WIN32
+static ssize_t pread(int fd, void *buf, size_t len, off_t offset) {
+    if (lseek(fd, offset, SEEK_SET) < 0) return -1;
+    return read(fd, buf, len);
+}
+
+static ssize_t pwrite(int fd, const void *buf, size_t len, off_t offset) {
+    if (lseek(fd, offset, SEEK_SET) < 0) return -1;
+    return write(fd, buf, len);
+}
+#endif
+
+static bool replaying(cpu_state_t *cpu) {
+    return cpu->replay && cpu->replay->mode == RR_REPLAY;
+}
+
+// Input result through the replay log: record the live value, or return
+// the logged one
+static int64_t logged_result(cpu_state_t *cpu, int64_t live) {
+    return cpu->replay ? (int64_t)rr_value(cpu->replay, RR_EVENT_INPUT, (uint64_t)live) : live;
+}
+
+// Bytes from addr that are contiguous in host memory (at most len)
+static size_t guest_span(cpu_state_t *cpu, xlen_t addr, size_t len) {
+    size_t room = addr < cpu->memory_size ? cpu->memory_size - (size_t)addr
+                                          : SPARSE_PAGE_SIZE - (size_t)(addr & SPARSE_PAGE_MASK);
+    return len < room ? len : room;
+}
+
+static syscall_fd_t* guest_fd(syscall_proxy_t *proxy, xlen_t fd) {
+    return (fd < SYSCALL_MAX_FDS && proxy->fd[fd].open) ? &proxy->fd[fd] : NULL;
+}
+
+static bool host_write(syscall_proxy_t *proxy, const syscall_fd_t *f, const uint8_t *buf,
+                       size_t len, uint64_t pos) {
+    if (f->host < 0 || proxy->quiet) return true;
+    while (len > 0) {
+        ssize_t n = f->seekable ? pwrite(f->host, buf, len, (off_t)pos) : write(f->host, buf, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        proxy->host_writes++;
+        buf += n;
+        len -= (size_t)n;
+        pos += (uint64_t)n;
+    }
+    return true;
+}
+
+int syscall_flush(syscall_proxy_t *proxy) {
+    if (proxy->out_len == 0) return RISCV_SUCCESS;
+
+    const syscall_fd_t *f = &proxy->fd[proxy->out_fd];
+    size_t len = proxy->out_len;
+    proxy->out_len = 0;
+    if (!host_write(proxy, f, proxy->out, len, f->offset - len)) {
+        printf("ERROR: Guest output to fd %d failed, %zu bytes lost\n", proxy->out_fd, len);
+        proxy->bytes_lost += len;
+        return RISCV_ERROR_MEMORY;
+    }
+    return RISCV_SUCCESS;
+}
+
+int syscall_attach(cpu_state_t *cpu, xlen_t brk_base, xlen_t brk_limit) {
+    if (brk_base > brk_limit || brk_limit > cpu->memory_size) {
+        printf("ERROR: Heap 0x%" PRIxXLEN "-0x%" PRIxXLEN " is outside guest RAM\n",
+               brk_base, brk_limit);
+        return RISCV_ERROR_BOUNDS;
+    }
+
+    syscall_proxy_t *proxy = calloc(1, sizeof(syscall_proxy_t));
+    if (!proxy) return RISCV_ERROR_MEMORY;
+    proxy->out = malloc(SYSCALL_WRITE_BUFFER);
+    if (!proxy->out) {
+        free(proxy);
+        return RISCV_ERROR_MEMORY;
+    }
+    proxy->out_capacity = SYSCALL_WRITE_BUFFER;
+    proxy->brk_base = proxy->brk = brk_base;
+    proxy->brk_limit = brk_limit;
+
+    // stdio keeps the host's file position (it may be a shared terminal,
+    // pipe or redirected file)
+    for (int fd = 0; fd < 3; fd++) {
+        proxy->fd[fd].host = fd;
+        proxy->fd[fd].open = true;
+        proxy->fd[fd].writable = fd > 0;
+    }
+
+    syscall_free(cpu->syscalls);
+    cpu->syscalls = proxy;
+    return RISCV_SUCCESS;
+}
+
+static void close_fd(syscall_fd_t *f) {
+    if (f->host >= 0) close(f->host);
+    free(f->path);
+    f->path = NULL;
+    f->open = false;
+}
+
+void syscall_free(syscall_proxy_t *proxy) {
+    if (!proxy) return;
+    syscall_flush(proxy);
+    for (int fd = 3; fd < SYSCALL_MAX_FDS; fd++) {
+        if (proxy->fd[fd].open) close_fd(&proxy->fd[fd]);
+    }
+    free(proxy->out);
+    free(proxy);
+}
+
+void syscall_reset(syscall_proxy_t *proxy) {
+    proxy->out_len = 0;
+    for (int fd = 3; fd < SYSCALL_MAX_FDS; fd++) {
+        if (proxy->fd[fd].open) close_fd(&proxy->fd[fd]);
+    }
+    for (int fd = 0; fd < 3; fd++) proxy->fd[fd].offset = 0;
+    proxy->brk = proxy->brk_base;
+}
+
+void syscall_snapshot_free(syscall_snapshot_t *snap) {
+    if (!snap) return;
+    for (int fd = 0; fd < SYSCALL_MAX_FDS; fd++) free(snap->fd[fd].path);
+    free(snap);
+}
+
+syscall_snapshot_t* syscall_save(syscall_proxy_t *proxy) {
+    syscall_flush(proxy);
+    syscall_snapshot_t *snap = calloc(1, sizeof(syscall_snapshot_t));
+    if (!snap) return NULL;
+    snap->brk = proxy->brk;
+    for (int fd = 0; fd < SYSCALL_MAX_FDS; fd++) {
+        const syscall_fd_t *f = &proxy->fd[fd];
+        syscall_fd_t *s = &snap->fd[fd];
+        *s = *f;
+        s->host = f->host < 0 ? -1 : 0;
+        s->path = NULL;
+        if (f->path && !(s->path = strdup(f->path))) {
+            syscall_snapshot_free(snap);
+            return NULL;
+        }
+    }
+    return snap;
+}
+
+static bool same_file(const syscall_fd_t *f, const syscall_fd_t *s) {
+    return f->open && s->open && f->flags == s->flags && (f->host < 0) == (s->host < 0) &&
+           f->path && s->path && strcmp(f->path, s->path) == 0;
+}
+
+int syscall_restore(syscall_proxy_t *proxy, const syscall_snapshot_t *snap) {
+    int status = RISCV_SUCCESS;
+    proxy->out_len = 0;
+    proxy->brk = snap->brk;
+    for (int fd = 0; fd < 3; fd++) proxy->fd[fd].offset = snap->fd[fd].offset;
+
+    for (int fd = 3; fd < SYSCALL_MAX_FDS; fd++) {
+        syscall_fd_t *f = &proxy->fd[fd];
+        const syscall_fd_t *s = &snap->fd[fd];
+        if (same_file(f, s)) {
+            f->offset = s->offset;
+            continue;
+        }
+        if (f->open) close_fd(f);
+        if (!s->open) continue;
+
+        int host = -1;
+        if (s->host >= 0) {
+            host = open(s->path, s->flags & ~(O_CREAT | O_TRUNC | O_EXCL));
+            if (host < 0) {
+                printf("ERROR: Cannot reopen %s for guest fd %d\n", s->path, fd);
+                status = RISCV_ERROR_MEMORY;
+                continue;
+            }
+        }
+        *f = *s;
+        f->host = host;
+        f->path = strdup(s->path);
+    }
+    return status;
+}
+
+static int host_flags(xlen_t flags) {
+    int f = (flags & GUEST_O_RDWR) ? O_RDWR : (flags & GUEST_O_WRONLY) ? O_WRONLY : O_RDONLY;
+    if (flags & GUEST_O_APPEND) f |= O_APPEND;
+    if (flags & GUEST_O_CREAT) f |= O_CREAT;
+    if (flags & GUEST_O_TRUNC) f |= O_TRUNC;
+    if (flags & GUEST_O_EXCL) f |= O_EXCL;
+#ifdef O_BINARY
+    f |= O_BINARY;
+#endif
+    return f;
+}
+
+static int64_t sys_open(cpu_state_t *cpu, syscall_proxy_t *proxy, xlen_t path_addr,
+                        xlen_t flags, xlen_t mode) {
+    char path[SYSCALL_MAX_PATH];
+    size_t len = 0;
+    do {
+        if (len == sizeof(path)) return -ENAMETOOLONG;
+        if (mem_read(cpu, path_addr + (xlen_t)len, &path[len], 1) != RISCV_SUCCESS) return -EFAULT;
+    } while (path[len++] != '\0');
+
+    int slot = 3;
+    while (slot < SYSCALL_MAX_FDS && proxy->fd[slot].open) slot++;
+    if (slot == SYSCALL_MAX_FDS) return -EMFILE;
+
+    int host = -1;
+    int64_t result;
+    if (replaying(cpu)) {
+        result = logged_result(cpu, 0);
+    } else {
+        int opened = host_flags(flags);
+        if (proxy->quiet) opened &= ~(O_CREAT | O_TRUNC | O_EXCL);
+        host = open(path, opened, (mode_t)mode);
+        result = logged_result(cpu, host < 0 ? -errno : slot);
+    }
+    if (result < 0) return result;
+
+    syscall_fd_t *f = &proxy->fd[slot];
+    f->path = strdup(path);
+    if (!f->path) {
+        if (host >= 0) close(host);
+        return -ENOMEM;
+    }
+    f->host = host;
+    f->open = true;
+    f->flags = host_flags(flags);
+    f->writable = (flags & (GUEST_O_WRONLY | GUEST_O_RDWR)) != 0;
+    f->seekable = !(flags & GUEST_O_APPEND) && (host < 0 || lseek(host, 0, SEEK_CUR) >= 0);
+    f->offset = 0;
+    if (cpu->debug_enabled) printf("Syscall open(\"%s\") -> fd %d\n", path, slot);
+    return slot;
+}
+
+static int64_t sys_close(syscall_proxy_t *proxy, xlen_t fd) {
+    syscall_fd_t *f = guest_fd(proxy, fd);
+    if (!f) return -EBADF;
+    if (fd < 3) return 0;
+    close_fd(f);
+    return 0;
+}
+
+static int64_t sys_read(cpu_state_t *cpu, syscall_proxy_t *proxy, xlen_t fd, xlen_t buf, xlen_t len) {
+    syscall_fd_t *f = guest_fd(proxy, fd);
+    if (!f) return -EBADF;
+
+    size_t done = 0;
+    while (done < len) {
+        size_t n = guest_span(cpu, buf + (xlen_t)done, len - done);
+        uint8_t *dst = guest_ptr(cpu, buf + (xlen_t)done, n, true);
+        if (!dst) {
+            if (done == 0) return -EFAULT;
+            break;
+        }
+
+        int64_t got;
+        if (replaying(cpu)) {
+            got = logged_result(cpu, 0);
+            if (got > (int64_t)n) got = (int64_t)n;
+        } else {
+            ssize_t r = f->seekable ? pread(f->host, dst, n, (off_t)f->offset) : read(f->host, dst, n);
+            got = logged_result(cpu, r < 0 ? -errno : r);
+        }
+        if (got > 0 && cpu->replay) rr_bytes(cpu->replay, RR_EVENT_INPUT, dst, (size_t)got);
+        if (got < 0) {
+            if (done == 0) return got;
+            break;
+        }
+        f->offset += (uint64_t)got;
+        done += (size_t)got;
+        // Short read: end of file, or a pipe or terminal with no more data yet
+        if ((size_t)got < n) break;
+    }
+
+    predecode_invalidate(cpu, buf, done);
+    proxy->bytes_read += done;
+    return (int64_t)done;
+}
+
+static int64_t sys_write(cpu_state_t *cpu, syscall_proxy_t *proxy, xlen_t fd, xlen_t buf, xlen_t len) {
+    syscall_fd_t *f = guest_fd(proxy, fd);
+    if (!f || !f->writable) return -EBADF;
+
+    // A failed flush belongs to earlier writes, not this one
+    if (proxy->out_len > 0 && (proxy->out_fd != (int)fd || len > proxy->out_capacity - proxy->out_len)) {
+        syscall_flush(proxy);
+    }
+
+    if (len <= proxy->out_capacity) {
+        if (mem_read(cpu, buf, proxy->out + proxy->out_len, len) != RISCV_SUCCESS) return -EFAULT;
+        proxy->out_len += len;
+        proxy->out_fd = (int)fd;
+    } else {
+        // Larger than the buffer: straight from guest memory
+        size_t done = 0;
+        while (done < len) {
+            size_t n = guest_span(cpu, buf + (xlen_t)done, len - done);
+            const uint8_t *src = guest_ptr(cpu, buf + (xlen_t)done, n, false);
+            if (!src) return -EFAULT;
+            if (!host_write(proxy, f, src, n, f->offset + done)) return errno ? -errno : -EIO;
+            done += n;
+        }
+    }
+
+    f->offset += len;
+    proxy->bytes_written += len;
+    return (int64_t)len;
+}
+
+static int64_t sys_lseek(cpu_state_t *cpu, syscall_proxy_t *proxy, xlen_t fd, xlen_t offset, xlen_t whence) {
+    syscall_fd_t *f = guest_fd(proxy, fd);
+    if (!f) return -EBADF;
+    if (!f->seekable) return -ESPIPE;
+
+    int64_t base;
+    switch (whence) {
+    case SEEK_SET:
+        base = 0;
+        break;
+    case SEEK_CUR:
+        base = (int64_t)f->offset;
+        break;
+    case SEEK_END:
+        if (replaying(cpu)) {
+            base = logged_result(cpu, 0);
+        } else {
+            off_t size = lseek(f->host, 0, SEEK_END);
+            base = logged_result(cpu, size < 0 ? -errno : (int64_t)size);
+        }
+        if (base < 0) return base;
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    int64_t pos = base + (int64_t)(sxlen_t)offset;
+    if (pos < 0) return -EINVAL;
+    f->offset = (uint64_t)pos;
+    return pos;
+}
+
+static int64_t sys_brk(syscall_proxy_t *proxy, xlen_t addr) {
+    if (addr >= proxy->brk_base && addr <= proxy->brk_limit) proxy->brk = addr;
+    return (int64_t)proxy->brk;
+}
+
+int syscall_handle(cpu_state_t *cpu) {
+    syscall_proxy_t *proxy = cpu->syscalls;
+    const xlen_t *a = &cpu->regs[10];
+    xlen_t number = cpu->regs[17];
+    int64_t result;
+
+    proxy->calls++;
+    // Anything but another write may observe the output (read back a file,
+    // exit), so buffered bytes go out first. Bytes the host refuses are
+    // counted in bytes_lost; the guest keeps running.
+    if (number != SYS_WRITE) syscall_flush(proxy);
+
+    switch (number) {
+    case SYS_EXIT:
+    case SYS_EXIT_GROUP:
+        cpu->halted = true;
+        cpu->exit_code = (int)a[0];
+        return RISCV_SUCCESS;
+    case SYS_READ:
+        result = sys_read(cpu, proxy, a[0], a[1], a[2]);
+        break;
+    case SYS_WRITE:
+        result = sys_write(cpu, proxy, a[0], a[1], a[2]);
+        break;
+    case SYS_OPEN:
+        result = sys_open(cpu, proxy, a[0], a[1], a[2]);
+        break;
+    case SYS_OPENAT:
+        // Only paths relative to the working directory (or absolute)
+        result = (sxlen_t)a[0] == GUEST_AT_FDCWD ? sys_open(cpu, proxy, a[1], a[2], a[3]) : -EBADF;
+        break;
+    case SYS_CLOSE:
+        result = sys_close(proxy, a[0]);
+        break;
+    case SYS_LSEEK:
+        result = sys_lseek(cpu, proxy, a[0], a[1], a[2]);
+        break;
+    case SYS_BRK:
+        result = sys_brk(proxy, a[0]);
+        break;
+    default:
+        if (cpu->debug_enabled) printf("Syscall %" PRIuXLEN " not supported\n", number);
+        result = -ENOSYS;
+        break;
+    }
+
+    cpu->regs[10] = (xlen_t)result;
+    return RISCV_SUCCESS;
+}
@@ -0,0 +1,118 @@
+/**
+ * Proxy System Calls
+ * newlib/libgloss-style system calls made with ecall and carried out on
+ * the host, so compiled guest programs can print and read data files
+ */
+
+#ifndef RISCV_SYSCALL_H
+#define RISCV_SYSCALL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Syscall numbers (a7), as used by the RISC-V libgloss port. Arguments
+// are in a0..a3; the result, or -errno, is returned in a0.
+#define SYS_OPENAT      56
+#define SYS_CLOSE       57
+#define SYS_LSEEK       62
+#define SYS_READ        63
+#define SYS_WRITE       64
+#define SYS_EXIT        93
+#define SYS_EXIT_GROUP  94
+#define SYS_BRK         214
+#define SYS_OPEN        1024    // legacy open(path, flags, mode)
+
+// Guest open flags (newlib values), translated to the host's
+#define GUEST_O_RDONLY  0x0000
+#define GUEST_O_WRONLY  0x0001
+#define GUEST_O_RDWR    0x0002
+#define GUEST_O_APPEND  0x0008
+#define GUEST_O_CREAT   0x0200
+#define GUEST_O_TRUNC   0x0400
+#define GUEST_O_EXCL    0x0800
+#define GUEST_AT_FDCWD  (-100)
+
+#define SYSCALL_MAX_FDS      32
+#define SYSCALL_MAX_PATH     1024
+#define SYSCALL_WRITE_BUFFER (64 * 1024)    // default host write buffer
+
+typedef struct {
+    int host;                   // host fd, -1 for files opened during replay
+    bool open;
+    bool seekable;              // reads use pread at offset, else read
+    bool writable;              // opened for writing; writes fail with EBADF otherwise
+    uint64_t offset;
+    char *path;                 // as opened (fds 3+), to reopen on restore
+    int flags;                  // host open flags
+} syscall_fd_t;
+
+// Guest-visible proxy state kept in checkpoints and the reset base: the
+// heap break and each guest fd's file and offset. Paths are owned by the
+// snapshot; host is -1 for replayed files and 0 otherwise.
+typedef struct syscall_snapshot {
+    xlen_t brk;
+    syscall_fd_t fd[SYSCALL_MAX_FDS];
+} syscall_snapshot_t;
+
+// Guest fds 0..2 are the host's stdin/stdout/stderr and are never closed.
+// Guest writes collect in one buffer and reach the host when it fills,
+// when output switches to another fd, or before any other syscall. The
+// guest has already been told those writes succeeded, so a host write that
+// fails later only adds to bytes_lost.
+typedef struct syscall_proxy {
+    syscall_fd_t fd[SYSCALL_MAX_FDS];
+    xlen_t brk_base;            // heap grows from here to brk_limit
+    xlen_t brk;
+    xlen_t brk_limit;
+    uint8_t *out;
+    size_t out_len;
+    size_t out_capacity;        // 0 writes straight through
+    int out_fd;                 // guest fd the buffered bytes belong to
+    bool quiet;                 // re-executing: output is dropped and opens
+                                // neither create nor truncate
+
+    // Statistics
+    uint64_t calls;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t host_writes;       // write(2) calls made for the guest
+    uint64_t bytes_lost;        // buffered output the host did not take
+} syscall_proxy_t;
+
+// Route ecall through the proxy instead of halting. The heap (brk) spans
+// [brk_base, brk_limit), which must lie in flat RAM.
+int syscall_attach(cpu_state_t *cpu, xlen_t brk_base, xlen_t brk_limit);
+
+// Flush buffered output, close guest-opened files and free the proxy
+void syscall_free(syscall_proxy_t *proxy);
+
+// Push buffered guest output to the host
+int syscall_flush(syscall_proxy_t *proxy);
+
+// Back to the state after syscall_attach: guest-opened files are closed,
+// buffered output is dropped and the break returns to brk_base
+void syscall_reset(syscall_proxy_t *proxy);
+
+// Save the proxy state (buffered output is flushed first), or bring it
+// back: files opened since are closed, files closed since are reopened
+// without creating or truncating them, offsets and the break are restored
+// and buffered output is dropped
+syscall_snapshot_t* syscall_save(syscall_proxy_t *proxy);
+int syscall_restore(syscall_proxy_t *proxy, const syscall_snapshot_t *snap);
+void syscall_snapshot_free(syscall_snapshot_t *snap);
+
+// Carry out the syscall in a7 (called by the interpreter on ecall)
+int syscall_handle(cpu_state_t *cpu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_SYSCALL_H */
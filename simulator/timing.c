@@ -0,0 +1,440 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "riscv_matrix_ext.h"
+#include "riscv_encode.h"
+#include "interpreter.h"
+#include "timing.h"
+#include "sparse24.h"
+#include "conv2d.h"
+#include "csr.h"
+
+// Detailed Timing Model
+// Each instruction issues in order, one per cycle, once its source registers
+// are ready on the scoreboard. Results become ready after the op's latency;
+// loads and MATMUL operands go through a set-associative LRU data cache and
+// pay miss_penalty per missing line. Taken branches and jumps add a refetch
+// bubble. None of this runs in riscv_run: sim_run switches between the two
+// loops at region-of-interest markers so setup code is only simulated
+// functionally.
+
+// Line number that never matches a real address (addr >> line shift)
+#define DCACHE_INVALID_TAG (~(xlen_t)0)
+
+void timing_default_config(timing_config_t *config) {
+    config->alu_latency = 1;
+    config->mul_latency = 3;
+    config->div_latency = 20;
+    config->load_latency = 2;
+    config->matmul_latency = 3;
+    config->matvec_latency = 2;
+    config->conv2d_latency = 5;
+    config->dma_setup = 30;
+    config->dma_bytes_per_cycle = 8;
+    config->branch_penalty = 2;
+    config->miss_penalty = 40;
+    config->dcache_sets = 128;
+    config->dcache_ways = 4;
+    config->line_bytes = 64;
+}
+
+static bool is_power_of_two(uint32_t x) {
+    return x != 0 && (x & (x - 1)) == 0;
+}
+
+int timing_attach(cpu_state_t *cpu, const timing_config_t *config) {
+    timing_config_t defaults;
+    if (!config) {
+        timing_default_config(&defaults);
+        config = &defaults;
+    }
+
+    if (!is_power_of_two(config->dcache_sets) || !is_power_of_two(config->line_bytes) ||
+        config->dcache_ways == 0) {
+        printf("ERROR: Data cache sets and line size must be powers of two\n");
+        return RISCV_ERROR_ALIGNMENT;
+    }
+    if (config->dma_bytes_per_cycle == 0) {
+        printf("ERROR: DMA bandwidth must be non-zero\n");
+        return RISCV_ERROR_ALIGNMENT;
+    }
+
+    timing_model_t *model = calloc(1, sizeof(timing_model_t));
+    if (!model) return RISCV_ERROR_MEMORY;
+
+    size_t lines = (size_t)config->dcache_sets * config->dcache_ways;
+    model->config = *config;
+    model->tags = malloc(lines * sizeof(xlen_t));
+    model->lru = malloc(lines * sizeof(uint64_t));
+    if (!model->tags || !model->lru) {
+        timing_free(model);
+        return RISCV_ERROR_MEMORY;
+    }
+
+    timing_reset(model);
+    timing_free(cpu->timing);
+    cpu->timing = model;
+    return RISCV_SUCCESS;
+}
+
+void timing_free(timing_model_t *model) {
+    if (!model) return;
+    free(model->tags);
+    free(model->lru);
+    free(model);
+}
+
+void timing_reset(timing_model_t *model) {
+    size_t lines = (size_t)model->config.dcache_sets * model->config.dcache_ways;
+    for (size_t i = 0; i < lines; i++) {
+        model->tags[i] = DCACHE_INVALID_TAG;
+        model->lru[i] = 0;
+    }
+    model->lru_clock = 0;
+    model->cycles = 0;
+    model->insns = 0;
+    model->stall_cycles = 0;
+    model->matmul_done = 0;
+    model->dma_done = 0;
+    model->dma_bytes = 0;
+    model->dma_wait_cycles = 0;
+    model->dcache_hits = 0;
+    model->dcache_misses = 0;
+    memset(model->reg_ready, 0, sizeof(model->reg_ready));
+}
+
+// Touch one cache line; returns true on a hit
+static bool dcache_line(timing_model_t *t, xlen_t line) {
+    uint32_t ways = t->config.dcache_ways;
+    size_t base = (size_t)(line & (t->config.dcache_sets - 1)) * ways;
+    size_t victim = base;
+
+    t->lru_clock++;
+    for (size_t i = base; i < base + ways; i++) {
+        if (t->tags[i] == line) {
+            t->lru[i] = t->lru_clock;
+            t->dcache_hits++;
+            return true;
+        }
+        if (t->lru[i] < t->lru[victim]) victim = i;
+    }
+
+    t->tags[victim] = line;
+    t->lru[victim] = t->lru_clock;
+    t->dcache_misses++;
+    return false;
+}
+
+// Touch every line in [addr, addr + size); returns the number of misses
+static uint32_t dcache_access(timing_model_t *t, xlen_t addr, size_t size) {
+    xlen_t first = addr / t->config.line_bytes;
+    xlen_t last = (addr + (xlen_t)size - 1) / t->config.line_bytes;
+    uint32_t misses = 0;
+
+    for (xlen_t line = first; line <= last; line++) {
+        misses += !dcache_line(t, line);
+    }
+    return misses;
+}
+
+// Streaming store: updates lines already cached, but a miss neither
+// allocates nor stalls (write-combined straight to memory)
+static void dcache_stream_store(timing_model_t *t, xlen_t addr, size_t size) {
+    uint32_t ways = t->config.dcache_ways;
+    xlen_t first = addr / t->config.line_bytes;
+    xlen_t last = (addr + (xlen_t)size - 1) / t->config.line_bytes;
+
+    for (xlen_t line = first; line <= last; line++) {
+        size_t base = (size_t)(line & (t->config.dcache_sets - 1)) * ways;
+        for (size_t i = base; i < base + ways; i++) {
+            if (t->tags[i] == line) {
+                t->lru[i] = ++t->lru_clock;
+                t->dcache_hits++;
+                break;
+            }
+        }
+    }
+}
+
+// A MATMUL operand tile: one 16-byte access when packed, otherwise two
+// 8-byte rows pitch apart
+static uint32_t dcache_tile(timing_model_t *t, xlen_t addr, xlen_t pitch) {
+    if (pitch == 0) return dcache_access(t, addr, MATRIX_BYTES);
+    return dcache_access(t, addr, VECTOR_BYTES) + dcache_access(t, addr + pitch, VECTOR_BYTES);
+}
+
+// DMA stash: the engine writes the destination into the cache, filling
+// lines without a demand access so later operand reads hit
+static void dcache_stash(timing_model_t *t, xlen_t addr, size_t size) {
+    uint64_t hits = t->dcache_hits, misses = t->dcache_misses;
+    if (size > 0) dcache_access(t, addr, size);
+    t->dcache_hits = hits;
+    t->dcache_misses = misses;
+}
+
+// Queue a DMA transfer on the single channel: it starts when both the
+// launch and the previous transfer are done, and its destination lines are
+// installed when it is queued
+static void dma_queue(timing_model_t *t, uint64_t issue, xlen_t dst, xlen_t len) {
+    const timing_config_t *cfg = &t->config;
+    uint64_t start = t->dma_done > issue ? t->dma_done : issue;
+    t->dma_done = start + cfg->dma_setup + (len + cfg->dma_bytes_per_cycle - 1) / cfg->dma_bytes_per_cycle;
+    t->dma_bytes += len;
+    dcache_stash(t, dst, len);
+}
+
+static size_t access_size(uint8_t op) {
+    switch (op) {
+    case OP_LB: case OP_LBU: case OP_SB: return 1;
+    case OP_LH: case OP_LHU: case OP_SH: return 2;
+    case OP_LD: case OP_SD: return 8;
+    default: return 4;
+    }
+}
+
+// Operand register usage per op, for the scoreboard
+static bool reads_rs1(uint8_t op) {
+    switch (op) {
+    case OP_LUI: case OP_AUIPC: case OP_JAL:
+    case OP_FENCE: case OP_FENCE_I: case OP_ECALL: case OP_EBREAK: case OP_MARKER:
+        return false;
+    default:
+        return true;
+    }
+}
+
+static bool reads_rs2(uint8_t op) {
+    return (op >= OP_BEQ && op <= OP_BGEU) || (op >= OP_SB && op <= OP_SD) ||
+           (op >= OP_ADD && op <= OP_REMU) || (op >= OP_ADDW && op <= OP_REMUW) ||
+           op == OP_CUSTOM;
+}
+
+static bool writes_rd(uint8_t op) {
+    return !((op >= OP_BEQ && op <= OP_BGEU) || (op >= OP_SB && op <= OP_SD) ||
+             op >= OP_FENCE);
+}
+
+// Cycles charged for a miss of lines cache lines issued at cycle
+static uint64_t miss_cycles(timing_model_t *t, uint64_t cycle, uint32_t lines) {
+    if (lines == 0) return 0;
+    uint64_t cycles = (uint64_t)lines * t->config.miss_penalty;
+    if (t->miss_hook) cycles += t->miss_hook(t->miss_ctx, cycle, lines);
+    return cycles;
+}
+
+static int run_timed(cpu_state_t *cpu, uint64_t max_insns, uint64_t cycle_limit) {
+    timing_model_t *t = cpu->timing;
+    if (!t) {
+        printf("ERROR: Timed run without a timing model\n");
+        return RISCV_ERROR_INSTRUCTION;
+    }
+
+    const timing_config_t *cfg = &t->config;
+    uint64_t end = (max_insns > UINT64_MAX - cpu->instret) ? UINT64_MAX : cpu->instret + max_insns;
+    int status = RISCV_SUCCESS;
+
+    while (cpu->instret < end && !cpu->halted && cpu->pc != cpu->stop_pc &&
+           t->cycles < cycle_limit) {
+        const decoded_insn_t *d = predecode_fetch(cpu, cpu->pc);
+        if (!d) {
+            status = RISCV_ERROR_MEMORY;
+            break;
+        }
+
+        // Operand values are needed for addresses before execution
+        // overwrites them
+        xlen_t base = cpu->regs[d->rs1];
+        xlen_t matmul_a = cpu->regs[d->rs1];
+        xlen_t matmul_b = cpu->regs[d->rs2];
+        xlen_t matmul_c = cpu->regs[d->rd];
+
+        status = riscv_execute_decoded(cpu, d);
+        if (status != RISCV_SUCCESS) break;
+        cpu->instret++;
+
+        uint64_t issue = t->cycles;
+        if (reads_rs1(d->op) && t->reg_ready[d->rs1] > issue) issue = t->reg_ready[d->rs1];
+        if (reads_rs2(d->op) && t->reg_ready[d->rs2] > issue) issue = t->reg_ready[d->rs2];
+        if (d->op == OP_CUSTOM && t->reg_ready[d->rd] > issue) issue = t->reg_ready[d->rd];
+        // Loads may read a MATMUL result, so they wait for it to be written
+        if (d->op >= OP_LB && d->op <= OP_LD && t->matmul_done > issue) issue = t->matmul_done;
+        if (d->op == OP_CUSTOM && (d->raw >> 25) == FUNC7_DMA_FENCE && t->dma_done > issue) {
+            t->dma_wait_cycles += t->dma_done - issue;
+            issue = t->dma_done;
+        }
+        t->stall_cycles += issue - t->cycles;
+        cpu->hpm.stall_cycles += issue - t->cycles;
+
+        uint64_t latency = cfg->alu_latency;
+        uint64_t busy = 1;
+        switch (d->op) {
+        case OP_LB: case OP_LH: case OP_LW: case OP_LBU: case OP_LHU: case OP_LWU: case OP_LD:
+            latency = cfg->load_latency +
+                      miss_cycles(t, issue, dcache_access(t, base + (xlen_t)d->imm,
+                                                          access_size(d->op)));
+            break;
+        case OP_SB: case OP_SH: case OP_SW: case OP_SD:
+            // Write-allocate behind a store buffer: misses fill the cache
+            // but do not stall issue
+            miss_cycles(t, issue, dcache_access(t, base + (xlen_t)d->imm, access_size(d->op)));
+            break;
+        case OP_MUL: case OP_MULH: case OP_MULHSU: case OP_MULHU: case OP_MULW:
+            latency = cfg->mul_latency;
+            break;
+        case OP_DIV: case OP_DIVU: case OP_REM: case OP_REMU:
+        case OP_DIVW: case OP_DIVUW: case OP_REMW: case OP_REMUW:
+            latency = cfg->div_latency;
+            break;
+        case OP_CSRRW: case OP_CSRRS: case OP_CSRRC:
+        case OP_CSRRWI: case OP_CSRRSI: case OP_CSRRCI:
+            // csrrs/csrrc with rs1 = x0 only read
+            if ((uint32_t)d->imm == CSR_DMALEN &&
+                (d->op == OP_CSRRW || d->op == OP_CSRRWI || d->rs1 != 0)) {
+                dma_queue(t, issue, cpu->mcfg.dma_dst, cpu->mcfg.dma_len);
+            }
+            break;
+        case OP_CUSTOM: {
+            if ((d->raw >> 25) == FUNC7_DMA_FENCE) break;
+            // Operand fetch blocks the pipeline; the multiply itself is
+            // pipelined and overlaps with the next instruction
+            if ((d->raw >> 25) == FUNC7_MATVEC) {
+                uint32_t misses = dcache_access(t, matmul_a, MATRIX_BYTES) +
+                                  dcache_access(t, matmul_b, VECTOR_BYTES);
+                dcache_stream_store(t, matmul_c, VECTOR_BYTES);
+                busy += miss_cycles(t, issue, misses);
+                t->matmul_done = issue + busy + cfg->matvec_latency;
+                break;
+            }
+            if ((d->raw >> 25) == FUNC7_CONV2D) {
+                // One access per window row at the configured pitch
+                size_t side = CONV_WINDOW(cpu->mcfg.conv_stride);
+                size_t row_bytes = side * sizeof(int32_t);
+                xlen_t pitch = cpu->mcfg.conv_pitch ? cpu->mcfg.conv_pitch : (xlen_t)row_bytes;
+                uint32_t misses = dcache_access(t, matmul_b, CONV_KERNEL_BYTES) +
+                                  dcache_access(t, matmul_c, MATRIX_BYTES);
+                for (size_t row = 0; row < side; row++) {
+                    misses += dcache_access(t, matmul_a + (xlen_t)row * pitch, row_bytes);
+                }
+                busy += miss_cycles(t, issue, misses);
+                t->matmul_done = issue + busy + cfg->conv2d_latency;
+                break;
+            }
+            uint32_t misses;
+            if ((d->raw >> 25) == FUNC7_MATMUL_SP) {
+                misses = dcache_access(t, matmul_a, SPARSE24_TILE_BYTES) +
+                         dcache_access(t, matmul_b, SPARSE24_B_BYTES);
+            } else {
+                misses = dcache_tile(t, matmul_a, cpu->mcfg.tile_pitch_a) +
+                         dcache_tile(t, matmul_b, cpu->mcfg.tile_pitch_b);
+            }
+            misses += dcache_access(t, matmul_c, MATRIX_BYTES);
+            busy += miss_cycles(t, issue, misses);
+            t->matmul_done = issue + busy + cfg->matmul_latency;
+            break;
+        }
+        default:
+            break;
+        }
+
+        // Matrix operand fills block the pipeline beyond the issue cycle
+        if (d->op == OP_CUSTOM) cpu->hpm.stall_cycles += busy - 1;
+        if (cpu->pc != d->pc + d->len) busy += cfg->branch_penalty;
+        if (writes_rd(d->op) && d->rd != 0) t->reg_ready[d->rd] = issue + latency;
+        t->cycles = issue + busy;
+        t->insns++;
+
+        if (t->trace) {
+            fprintf(t->trace, "%12llu  0x%08" PRIxXLEN "  %08x\n",
+                    (unsigned long long)issue, d->pc, d->raw);
+        }
+
+        if (cpu->stop_requested) break;
+    }
+
+    return status;
+}
+
+int riscv_run_timed(cpu_state_t *cpu, uint64_t max_insns) {
+    return run_timed(cpu, max_insns, UINT64_MAX);
+}
+
+int riscv_run_timed_until(cpu_state_t *cpu, uint64_t cycle_limit) {
+    return run_timed(cpu, UINT64_MAX, cycle_limit);
+}
+
+void sim_default_config(sim_config_t *config) {
+    config->mode = SIM_MODE_FAST_FORWARD;
+    config->roi_begin_pc = RISCV_NO_STOP_PC;
+    config->roi_end_pc = RISCV_NO_STOP_PC;
+    config->resume_functional = true;
+}
+
+int sim_run(cpu_state_t *cpu, const sim_config_t *config, uint64_t max_insns,
+            sim_stats_t *stats) {
+    if (!cpu->timing) {
+        printf("ERROR: sim_run needs a timing model (timing_attach)\n");
+        return RISCV_ERROR_INSTRUCTION;
+    }
+    if (config->roi_begin_pc != RISCV_NO_STOP_PC && config->roi_begin_pc == config->roi_end_pc) {
+        printf("ERROR: ROI begin and end pc must differ\n");
+        return RISCV_ERROR_INSTRUCTION;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+
+    xlen_t saved_stop_pc = cpu->stop_pc;
+    bool saved_stop_on_marker = cpu->stop_on_marker;
+    bool saved_debug = cpu->debug_enabled;
+    uint64_t start_cycles = cpu->timing->cycles;
+
+    // switching: still honoring ROI boundaries; once false the rest of the
+    // run stays in its current mode
+    bool switching = (config->mode == SIM_MODE_FAST_FORWARD);
+    bool detailed = !switching;
+    uint64_t executed = 0;
+    int status = RISCV_SUCCESS;
+
+    if (detailed) stats->roi_count = 1;
+
+    while (!cpu->halted && executed < max_insns) {
+        uint64_t before = cpu->instret;
+        cpu->stop_on_marker = switching;
+        cpu->stop_requested = false;
+        cpu->last_marker = 0;
+
+        if (detailed) {
+            cpu->stop_pc = switching ? config->roi_end_pc : RISCV_NO_STOP_PC;
+            cpu->debug_enabled = saved_debug;
+            status = riscv_run_timed(cpu, max_insns - executed);
+            stats->detailed_insns += cpu->instret - before;
+        } else {
+            // Pure functional: no timing, no cache model, no tracing
+            cpu->stop_pc = config->roi_begin_pc;
+            cpu->debug_enabled = false;
+            status = riscv_run(cpu, max_insns - executed);
+            stats->functional_insns += cpu->instret - before;
+        }
+        executed += cpu->instret - before;
+        if (status != RISCV_SUCCESS || cpu->halted || !switching) break;
+
+        bool at_pc = (cpu->pc == cpu->stop_pc);
+        int marker = cpu->stop_requested ? cpu->last_marker : 0;
+
+        if (!detailed && (at_pc || marker == RV_MARKER_ROI_BEGIN)) {
+            detailed = true;
+            stats->roi_count++;
+        } else if (detailed && (at_pc || marker == RV_MARKER_ROI_END)) {
+            if (config->resume_functional) detailed = false;
+            else switching = false;
+        }
+    }
+
+    stats->detailed_cycles = cpu->timing->cycles - start_cycles;
+    cpu->stop_pc = saved_stop_pc;
+    cpu->stop_on_marker = saved_stop_on_marker;
+    cpu->stop_requested = false;
+    cpu->debug_enabled = saved_debug;
+    return status;
+}
@@ -0,0 +1,114 @@
+/**
+ * Detailed Timing Model
+ * In-order single-issue pipeline with per-op latencies, a register
+ * scoreboard and a set-associative data cache, plus the run-mode driver
+ * that fast-forwards functionally between region-of-interest markers
+ */
+
+#ifndef RISCV_TIMING_H
+#define RISCV_TIMING_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv_matrix_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t alu_latency;
+    uint32_t mul_latency;
+    uint32_t div_latency;
+    uint32_t load_latency;      // load-to-use on a cache hit
+    uint32_t matmul_latency;    // 3-cycle pipelined MATMUL, excluding memory
+    uint32_t matvec_latency;    // MATVEC: half the multiplies of MATMUL
+    uint32_t conv2d_latency;    // CONV2D: nine weights over the 2x2 tile
+    uint32_t dma_setup;         // cycles from launch to first byte of a DMA transfer
+    uint32_t dma_bytes_per_cycle;
+    uint32_t branch_penalty;    // refetch bubble for taken branches and jumps
+    uint32_t miss_penalty;      // added per data-cache line miss
+    uint32_t dcache_sets;       // power of two
+    uint32_t dcache_ways;
+    uint32_t line_bytes;        // power of two
+} timing_config_t;
+
+// Default in-order core: 32 KiB 4-way L1D with 64-byte lines
+void timing_default_config(timing_config_t *config);
+
+struct timing_model {
+    timing_config_t config;
+    uint64_t cycles;
+    uint64_t insns;
+    uint64_t stall_cycles;      // issue delayed waiting on a source register
+    uint64_t dcache_hits;
+    uint64_t dcache_misses;
+    uint64_t reg_ready[NUM_REGISTERS];  // cycle each register's value is available
+    uint64_t matmul_done;               // cycle the last MATMUL result reaches memory
+    uint64_t dma_done;                  // cycle the last queued DMA transfer completes
+    uint64_t dma_bytes;
+    uint64_t dma_wait_cycles;           // dma.fence stalls
+
+    // Data cache: tags[set * ways + way], LRU stamp per line
+    xlen_t *tags;
+    uint64_t *lru;
+    uint64_t lru_clock;
+
+    FILE *trace;                // per-instruction trace, NULL to disable
+
+    // Optional shared-resource model: called for each access that misses,
+    // returns extra cycles (e.g. queueing on a bus shared between harts)
+    uint64_t (*miss_hook)(void *ctx, uint64_t cycle, uint32_t lines);
+    void *miss_ctx;
+};
+
+typedef struct timing_model timing_model_t;
+
+// Attach a timing model to cpu (NULL config for defaults)
+int timing_attach(cpu_state_t *cpu, const timing_config_t *config);
+void timing_free(timing_model_t *model);
+
+// Clear statistics and cache contents, keeping the configuration
+void timing_reset(timing_model_t *model);
+
+// Detailed loop: like riscv_run, but every instruction is charged to
+// cpu->timing. Honors the same run-control stops.
+int riscv_run_timed(cpu_state_t *cpu, uint64_t max_insns);
+
+// Timed run until the model reaches cycle_limit (or halt/stop)
+int riscv_run_timed_until(cpu_state_t *cpu, uint64_t cycle_limit);
+
+// Run modes
+typedef enum {
+    SIM_MODE_DETAILED,          // time every instruction
+    SIM_MODE_FAST_FORWARD       // functional until the ROI begins
+} sim_mode_t;
+
+typedef struct {
+    sim_mode_t mode;
+    xlen_t roi_begin_pc;        // RISCV_NO_STOP_PC: use markers only
+    xlen_t roi_end_pc;
+    bool resume_functional;     // drop back to functional after the ROI ends
+} sim_config_t;
+
+typedef struct {
+    uint64_t functional_insns;
+    uint64_t detailed_insns;
+    uint64_t detailed_cycles;
+    int roi_count;              // regions entered
+} sim_stats_t;
+
+void sim_default_config(sim_config_t *config);
+
+// Run cpu to completion (or max_insns) switching between the functional
+// loop and the timed loop at ROI markers/pcs. Requires cpu->timing.
+int sim_run(cpu_state_t *cpu, const sim_config_t *config, uint64_t max_insns,
+            sim_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RISCV_TIMING_H */
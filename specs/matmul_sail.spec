@@ -18,17 +18,27 @@ struct matmul_instruction {
 // Instruction semantics
 function execute_matmul(rd: regidx, rs1: regidx, rs2: regidx) -> unit = {
     // Read 2x2 matrices from memory pointed by rs1 and rs2
-    let matrix_a = read_matrix_2x2(X(rs1));
-    let matrix_b = read_matrix_2x2(X(rs2));
+    let matrix_a = read_tile_a(X(rs1));
+    let matrix_b = read_tile_b(X(rs2));
     
     // Perform matrix multiplication
     let result = matrix_multiply_2x2(matrix_a, matrix_b);
     
     // Store result matrix at memory location pointed by rd
-    write_matrix_2x2(X(rd), result);
+    write_matrix_2x2(X(rd), epilogue_2x2(result));
 }
 
 // Matrix operations helper functions
+
+// epilogue and the tile reads are defined with their CSRs below
+val epilogue : bits(32) -> bits(32)
+val read_tile_a : xlenbits -> matrix_2x2
+val read_tile_b : xlenbits -> matrix_2x2
+
+function epilogue_2x2(m: matrix_2x2) -> matrix_2x2 = {
+    Matrix2x2(epilogue(m.m00), epilogue(m.m01), epilogue(m.m10), epilogue(m.m11))
+}
+
 function read_matrix_2x2(addr: xlenbits) -> matrix_2x2 = {
     let m00 = mem_read(addr + 0,  4, false, false, false);
     let m01 = mem_read(addr + 4,  4, false, false, false);
@@ -64,3 +74,214 @@ mapping clause assembly = MATMUL(rd, rs1, rs2)
 
 mapping clause execute = MATMUL(rd, rs1, rs2) 
   <-> execute_matmul(rd, rs1, rs2)
+
+// Transpose-on-load variants
+// func7 bit 1 (ta) reads A transposed, bit 2 (tb) reads B transposed:
+//   matmul.ta rd, rs1, rs2   C = A^T * B    func7 = 0b0000011
+//   matmul.tb rd, rs1, rs2   C = A * B^T    func7 = 0b0000101
+//   matmul.tt rd, rs1, rs2   C = A^T * B^T  func7 = 0b0000111
+// Memory accesses are identical to MATMUL, including the tile pitch; only
+// the element order differs.
+
+function transpose_2x2(m: matrix_2x2) -> matrix_2x2 = {
+    Matrix2x2(m.m00, m.m10, m.m01, m.m11)
+}
+
+function execute_matmul_t(rd: regidx, rs1: regidx, rs2: regidx, ta: bits(1), tb: bits(1)) -> unit = {
+    let matrix_a = read_tile_a(X(rs1));
+    let matrix_b = read_tile_b(X(rs2));
+    let op_a = if ta == 0b1 then transpose_2x2(matrix_a) else matrix_a;
+    let op_b = if tb == 0b1 then transpose_2x2(matrix_b) else matrix_b;
+    write_matrix_2x2(X(rd), epilogue_2x2(matrix_multiply_2x2(op_a, op_b)));
+}
+
+mapping clause encdec = MATMUL_T(rd, rs1, rs2, ta, tb) if ta @ tb != 0b00
+  <-> 0b0000 @ tb @ ta @ 0b1 @ rs2 @ rs1 @ 0b111 @ rd @ 0b0110011 if ta @ tb != 0b00
+
+mapping matmul_t_mnemonic : (bits(1), bits(1)) <-> string = {
+    (0b1, 0b0) <-> "matmul.ta",
+    (0b0, 0b1) <-> "matmul.tb",
+    (0b1, 0b1) <-> "matmul.tt"
+}
+
+mapping clause assembly = MATMUL_T(rd, rs1, rs2, ta, tb)
+  <-> matmul_t_mnemonic(ta, tb) ^ spc() ^ reg_name(rd) ^ sep() ^ reg_name(rs1) ^ sep() ^ reg_name(rs2)
+
+mapping clause execute = MATMUL_T(rd, rs1, rs2, ta, tb)
+  <-> execute_matmul_t(rd, rs1, rs2, ta, tb)
+
+// Matrix-vector product
+//   matvec rd, rs1, rs2   y = A * x    func7 = 0b0001000
+// x and y are 2-element vectors (8 bytes). The destination is only
+// written, never read, so a GEMV kernel can stream results out.
+
+function read_vector_2(addr: xlenbits) -> vector_2 = {
+    let v0 = mem_read(addr + 0, 4, false, false, false);
+    let v1 = mem_read(addr + 4, 4, false, false, false);
+    Vector2(v0, v1)
+}
+
+function execute_matvec(rd: regidx, rs1: regidx, rs2: regidx) -> unit = {
+    let a = read_matrix_2x2(X(rs1));
+    let x = read_vector_2(X(rs2));
+    let y0 = a.m00 * x.v0 + a.m01 * x.v1;
+    let y1 = a.m10 * x.v0 + a.m11 * x.v1;
+    mem_write(X(rd) + 0, 4, epilogue(y0), false, false, false);
+    mem_write(X(rd) + 4, 4, epilogue(y1), false, false, false);
+}
+
+union vector_2 = Vector2 : (bits(32), bits(32))
+
+mapping clause encdec = MATVEC(rd, rs1, rs2)
+  <-> 0b0001000 @ rs2 @ rs1 @ 0b111 @ rd @ 0b0110011
+
+mapping clause assembly = MATVEC(rd, rs1, rs2)
+  <-> "matvec" ^ spc() ^ reg_name(rd) ^ sep() ^ reg_name(rs1) ^ sep() ^ reg_name(rs2)
+
+mapping clause execute = MATVEC(rd, rs1, rs2)
+  <-> execute_matvec(rd, rs1, rs2)
+
+// 2:4 structured-sparse matrix multiply
+//   matmul.sp rd, rs1, rs2   C = A * B    func7 = 0b0010000
+// A is a 2x4 tile with at most two non-zeros per row, compressed to
+// 20 bytes: values v[r][k] at rs1 + 8*r + 4*k and a metadata word at
+// rs1 + 16 whose bits 4*r+2*k+1..4*r+2*k give the column of v[r][k].
+// B is 4x2 row-major (32 bytes), C is 2x2. Only 8 products are formed.
+
+function sparse_col(meta: bits(32), r: int, k: int) -> bits(32) =
+  zero_extend((meta >> (4 * r + 2 * k)) & 0x00000003)
+
+function execute_matmul_sp(rd: regidx, rs1: regidx, rs2: regidx) -> unit = {
+    let meta = mem_read(X(rs1) + 16, 4, false, false, false);
+    foreach (r from 0 to 1) {
+        foreach (j from 0 to 1) {
+            var acc : bits(32) = zeros();
+            foreach (k from 0 to 1) {
+                let v = mem_read(X(rs1) + 8 * r + 4 * k, 4, false, false, false);
+                let col = sparse_col(meta, r, k);
+                let b = mem_read(X(rs2) + 8 * col + 4 * j, 4, false, false, false);
+                acc = acc + v * b;
+            };
+            mem_write(X(rd) + 8 * r + 4 * j, 4, epilogue(acc), false, false, false);
+        }
+    }
+}
+
+mapping clause encdec = MATMUL_SP(rd, rs1, rs2)
+  <-> 0b0010000 @ rs2 @ rs1 @ 0b111 @ rd @ 0b0110011
+
+mapping clause assembly = MATMUL_SP(rd, rs1, rs2)
+  <-> "matmul.sp" ^ spc() ^ reg_name(rd) ^ sep() ^ reg_name(rs1) ^ sep() ^ reg_name(rs2)
+
+mapping clause execute = MATMUL_SP(rd, rs1, rs2)
+  <-> execute_matmul_sp(rd, rs1, rs2)
+
+// Direct 3x3 convolution tile
+//   conv2d rd, rs1, rs2   func7 = 0b0100000
+// Writes the 2x2 output tile O[r][c] = sum(i, j) In[r*s + i][c*s + j] * K[i][j]
+// to rd. In is read at rs1 with row pitch convpitch (CSR 0x800, 0 means a
+// packed window of (s + 3) words per row); s is convstride (CSR 0x801,
+// 1 or 2). K is 3x3 row-major at rs2.
+
+register convpitch : xlenbits
+register convstride : xlenbits
+
+function execute_conv2d(rd: regidx, rs1: regidx, rs2: regidx) -> unit = {
+    let s = unsigned(convstride);
+    let pitch = if convpitch == zeros() then to_bits(sizeof(xlen), 4 * (s + 3)) else convpitch;
+    foreach (r from 0 to 1) {
+        foreach (c from 0 to 1) {
+            var acc : bits(32) = zeros();
+            foreach (i from 0 to 2) {
+                foreach (j from 0 to 2) {
+                    let x = mem_read(X(rs1) + (r * s + i) * pitch + 4 * (c * s + j), 4, false, false, false);
+                    let k = mem_read(X(rs2) + 12 * i + 4 * j, 4, false, false, false);
+                    acc = acc + x * k;
+                }
+            };
+            mem_write(X(rd) + 8 * r + 4 * c, 4, epilogue(acc), false, false, false);
+        }
+    }
+}
+
+mapping clause encdec = CONV2D(rd, rs1, rs2)
+  <-> 0b0100000 @ rs2 @ rs1 @ 0b111 @ rd @ 0b0110011
+
+mapping clause assembly = CONV2D(rd, rs1, rs2)
+  <-> "conv2d" ^ spc() ^ reg_name(rd) ^ sep() ^ reg_name(rs1) ^ sep() ^ reg_name(rs2)
+
+mapping clause execute = CONV2D(rd, rs1, rs2)
+  <-> execute_conv2d(rd, rs1, rs2)
+
+// Requantization epilogue
+// When qmode (CSR 0x802) is non-zero, every element a matrix instruction
+// writes (matmul and its variants, matvec, matmul.sp, conv2d) first passes
+// through requantize. qscale (0x803) and qzero (0x805) are signed 32-bit,
+// qshift (0x804) is 0..62. qmode 1 clamps to int8, 2 to uint8.
+
+register qmode : xlenbits
+register qscale : xlenbits
+register qshift : xlenbits
+register qzero : xlenbits
+
+function requantize(acc: bits(32)) -> bits(32) = {
+    let sh = unsigned(qshift);
+    let rnd : int = if sh == 0 then 0 else 2 ^ (sh - 1);
+    let x = shr_int(signed(acc) * signed(qscale[31..0]) + rnd, sh) + signed(qzero[31..0]);
+    let lo : int = if qmode == to_bits(sizeof(xlen), 2) then 0 else -128;
+    let hi : int = if qmode == to_bits(sizeof(xlen), 2) then 255 else 127;
+    to_bits(32, if x < lo then lo else if x > hi then hi else x)
+}
+
+function epilogue(acc: bits(32)) -> bits(32) =
+  if qmode == zeros() then acc else requantize(acc)
+
+// DMA engine
+// dmasrc (0x806) and dmadst (0x807) name the next transfer; writing its
+// length to dmalen (0x808) launches it. Transfers on the single channel
+// complete in order, with memmove semantics.
+//   dma.fence   func7 = 0b1000000, rd = rs1 = rs2 = 0
+// waits until every launched transfer has completed. Software must fence
+// before reading a destination or overwriting a source.
+
+register dmasrc : xlenbits
+register dmadst : xlenbits
+register dmalen : xlenbits
+
+val dma_launch : (xlenbits, xlenbits, xlenbits) -> unit
+val dma_wait_all : unit -> unit
+
+function write_dmalen(len: xlenbits) -> unit = {
+    dmalen = len;
+    dma_launch(dmasrc, dmadst, len)
+}
+
+mapping clause encdec = DMA_FENCE()
+  <-> 0b1000000 @ 0b00000 @ 0b00000 @ 0b111 @ 0b00000 @ 0b0110011
+
+mapping clause assembly = DMA_FENCE()
+  <-> "dma.fence"
+
+mapping clause execute = DMA_FENCE()
+  <-> dma_wait_all()
+
+// Tile row pitch
+// tilepitcha (0x809) and tilepitchb (0x80a) give the byte distance between
+// the two rows of the A and B tiles that matmul and its transposed variants
+// read; 0 keeps the packed 16-byte tile. A tile of a larger row-major
+// matrix is read in place by setting the pitch to the matrix row stride.
+
+register tilepitcha : xlenbits
+register tilepitchb : xlenbits
+
+function read_matrix_2x2_pitched(addr: xlenbits, pitch: xlenbits) -> matrix_2x2 = {
+    let p = if pitch == zeros() then to_bits(sizeof(xlen), 8) else pitch;
+    let m00 = mem_read(addr + 0,     4, false, false, false);
+    let m01 = mem_read(addr + 4,     4, false, false, false);
+    let m10 = mem_read(addr + p,     4, false, false, false);
+    let m11 = mem_read(addr + p + 4, 4, false, false, false);
+    Matrix2x2(m00, m01, m10, m11)
+}
+
+function read_tile_a(addr: xlenbits) -> matrix_2x2 = read_matrix_2x2_pitched(addr, tilepitcha)
+function read_tile_b(addr: xlenbits) -> matrix_2x2 = read_matrix_2x2_pitched(addr, tilepitchb)
@@ -0,0 +1,236 @@
+/**
+ * Test suite for the C++ API (simulator/riscv_matrix.hpp)
+ */
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "../simulator/riscv_matrix.hpp"
+#include "../simulator/riscv_encode.h"
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define ASSERT_EQ(expected, actual, msg) do { \
+    tests_run++; \
+    if ((expected) == (actual)) { \
+        tests_passed++; \
+        printf("✓ PASS: %s\n", msg); \
+    } else { \
+        printf("✗ FAIL: %s (expected %d, got %d)\n", msg, (int)(expected), (int)(actual)); \
+    } \
+} while(0)
+
+// Count C++ heap allocations so the steady-state paths can be checked
+static unsigned long allocations = 0;
+
+void* operator new(std::size_t size) {
+    allocations++;
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+using riscv::Cpu;
+using riscv::Matrix;
+using riscv::MatmulOp;
+using riscv::Span;
+using riscv::Tile;
+
+#define ADDR_CODE 0x1000
+#define ADDR_A    0x2000
+#define ADDR_B    0x2010
+#define ADDR_C    0x2020
+
+void test_matrix_types() {
+    printf("\n=== Testing Matrix Types ===\n");
+
+    Tile a = {{{1, 2}, {3, 4}}};
+    Tile b = {{{5, 6}, {7, 8}}};
+    Tile c = a * b;
+    matrix_2x2_t expected = matrix_multiply_2x2(riscv::to_c(a), riscv::to_c(b));
+    ASSERT_EQ(1, (int)(c == riscv::from_c(expected)), "Tile product matches matrix_multiply_2x2");
+    ASSERT_EQ(1, (int)(a * Tile::identity() == a), "Identity is neutral");
+    ASSERT_EQ(1, (int)(c != a), "Inequality");
+
+    // Products wrap like the MATMUL lanes
+    Tile big = {{{0x7FFFFFFF, 0}, {0, 1}}};
+    Tile two = {{{2, 0}, {0, 2}}};
+    expected = matrix_multiply_2x2(riscv::to_c(big), riscv::to_c(two));
+    ASSERT_EQ(expected.m[0][0], riscv::eval(big * two)(0, 0), "Overflowing product wraps like the core");
+
+    // Non-square shapes are checked at compile time
+    Matrix<int, 2, 3> wide = {{{1, 2, 3}, {4, 5, 6}}};
+    Matrix<int, 3, 1> column = {{{1}, {1}, {1}}};
+    Matrix<int, 2, 1> sums = wide * column;
+    ASSERT_EQ(6, sums(0, 0), "2x3 * 3x1 row 0");
+    ASSERT_EQ(15, sums(1, 0), "2x3 * 3x1 row 1");
+    static_assert(decltype(sums)::rows == 2 && decltype(sums)::cols == 1, "product shape");
+
+    constexpr Matrix<int, 2> k = Matrix<int, 2>::identity() * Matrix<int, 2>{{{3, 0}, {0, 3}}};
+    static_assert(k(0, 0) == 3 && k(0, 1) == 0, "constexpr product");
+    ASSERT_EQ(3, k(1, 1), "Constexpr product");
+}
+
+void test_cpu_handle() {
+    printf("\n=== Testing CPU Handles ===\n");
+    static_assert(!std::is_copy_constructible_v<Cpu> && std::is_nothrow_move_constructible_v<Cpu>,
+                  "Cpu is move-only");
+
+    Cpu cpu = Cpu::create();
+    ASSERT_EQ(1, (int)(bool)cpu, "Cpu::create returns a live handle");
+    cpu_state_t *raw = cpu.get();
+    Cpu moved = std::move(cpu);
+    ASSERT_EQ(0, (int)(bool)cpu, "Moved-from handle is empty");
+    ASSERT_EQ(1, (int)(moved.get() == raw), "Move transfers the CPU");
+    Cpu other = Cpu::create();
+    other = std::move(moved);
+    ASSERT_EQ(1, (int)(other.get() == raw), "Move assignment frees the old CPU and takes the new one");
+
+    static rv_program_t program;
+    program.len = 0;
+    rv_emit32(&program, rv_matmul(12, 10, 11));
+    rv_emit32(&program, rv_addi(10, 0, 7));
+    rv_emit32(&program, rv_ecall());
+    Tile a = {{{1, 2}, {3, 4}}};
+    Tile b = {{{5, 6}, {7, 8}}};
+    ASSERT_EQ(RISCV_SUCCESS, other.load(ADDR_CODE, program.bytes, program.len), "Load program");
+    ASSERT_EQ(RISCV_SUCCESS, other.write(ADDR_A, a), "Write A");
+    ASSERT_EQ(RISCV_SUCCESS, other.write(ADDR_B, b), "Write B");
+    other.set_reg(10, ADDR_A);
+    other.set_reg(11, ADDR_B);
+    other.set_reg(12, ADDR_C);
+    other.set_reg(0, 99);
+    ASSERT_EQ(0, (int)other.reg(0), "x0 stays zero");
+    other.set_pc(ADDR_CODE);
+    ASSERT_EQ(RISCV_SUCCESS, other.run(100), "Run program");
+    ASSERT_EQ(1, (int)other.halted(), "Halted on ecall");
+    ASSERT_EQ(7, other.exit_code(), "Exit code");
+    Tile c;
+    ASSERT_EQ(RISCV_SUCCESS, other.read(ADDR_C, c), "Read C");
+    ASSERT_EQ(1, (int)(c == a * b), "Guest MATMUL matches the host product");
+
+    Cpu released = Cpu::create();
+    cpu_state_t *owned = released.release();
+    ASSERT_EQ(0, (int)(bool)released, "release empties the handle");
+    free_cpu(owned);
+}
+
+void test_batches() {
+    printf("\n=== Testing Span Batches ===\n");
+
+    std::vector<Tile> a(64), b(64), c(64);
+    for (int i = 0; i < 64; i++) {
+        a[i] = {{{i, 1}, {2, i}}};
+        b[i] = {{{1, -i}, {i, 3}}};
+    }
+    Tile small[4];
+    ASSERT_EQ(RISCV_ERROR_BOUNDS, riscv::multiply(a, b, small), "Short output span is rejected");
+
+    Cpu cpu = Cpu::create();
+    std::array<MatmulOp, 64> ops;
+    const xlen_t tile = MATRIX_BYTES;
+    for (xlen_t i = 0; i < 64; i++) {
+        xlen_t base = 0x4000 + i * 3 * tile;
+        ops[i] = { base, base + tile, base + 2 * tile };
+        cpu.write(ops[i].a, a[i]);
+        cpu.write(ops[i].b, b[i]);
+    }
+    cpu.set_reg(5, 55);
+
+    unsigned long before = allocations;
+    int status = riscv::multiply(a, b, c);
+    status |= cpu.matmul(ops);
+    Tile check[8];
+    status |= cpu.read(ops[63].c, Span<Tile>(check, 1));
+    for (int round = 0; round < 100; round++) {
+        riscv::multiply(Span<const Tile>(a).subspan(0, 8), Span<const Tile>(b).subspan(0, 8), check);
+        cpu.matmul(Span<const MatmulOp>(ops).subspan(0, 8));
+    }
+    ASSERT_EQ(0, (int)(allocations - before), "Batch calls make no heap allocations");
+    ASSERT_EQ(RISCV_SUCCESS, status, "Batch calls succeed");
+
+    bool same = true;
+    for (int i = 0; i < 64; i++) same &= c[i] == riscv::from_c(matrix_multiply_2x2(riscv::to_c(a[i]), riscv::to_c(b[i])));
+    ASSERT_EQ(1, (int)same, "Host batch matches matrix_multiply_2x2");
+    Tile guest;
+    cpu.read(ops[63].c, guest);
+    ASSERT_EQ(1, (int)(guest == c[63]), "Guest batch matches the host batch");
+    ASSERT_EQ(64 + 100 * 8, (int)cpu.matrix_ops(), "Host-issued MATMULs are counted");
+    ASSERT_EQ(55, (int)cpu.reg(5), "Scratch registers are restored");
+}
+
+void test_expression_templates() {
+    printf("\n=== Testing Product Expressions ===\n");
+
+    // A chain of tiles is fused: same result as nested matrix_multiply_2x2
+    Tile t[4] = { {{{1, 2}, {3, 4}}}, {{{0, -1}, {5, 2}}}, {{{0x7FFFFFFF, 3}, {1, 1}}}, {{{2, 0}, {7, -3}}} };
+    matrix_2x2_t nested = matrix_multiply_2x2(matrix_multiply_2x2(matrix_multiply_2x2(
+        riscv::to_c(t[0]), riscv::to_c(t[1])), riscv::to_c(t[2])), riscv::to_c(t[3]));
+    Tile fused = t[0] * t[1] * t[2] * t[3];
+    ASSERT_EQ(1, (int)(fused == riscv::from_c(nested)), "Fused tile chain matches nested matrix_multiply_2x2");
+    Tile grouped = t[0] * (t[1] * t[2]) * t[3];
+    ASSERT_EQ(1, (int)(grouped == fused), "Grouping does not change a tile chain");
+
+    // Products are lazy: operands changed before evaluation are seen
+    auto lazy = t[0] * t[1];
+    t[1] = Tile::identity();
+    ASSERT_EQ(1, (int)(Tile(lazy) == t[0]), "Product is evaluated on conversion");
+
+    // 16x1 * 1x16 * 16x1: left to right costs 512 multiplies, right first 32
+    Matrix<int, 16, 1> x{};
+    Matrix<int, 1, 16> y{};
+    Matrix<int, 16, 1> z{};
+    for (int i = 0; i < 16; i++) {
+        x(i, 0) = i + 1;
+        y(0, i) = i % 3 - 1;
+        z(i, 0) = 2 * i - 5;
+    }
+    static_assert(decltype(x * y * z)::cost() == 32, "chain order picks the cheaper association");
+    static_assert(decltype(y * z * y)::cost() == 32, "chain order picks the cheaper association");
+    Matrix<int, 16, 1> xyz = x * y * z;
+    ASSERT_EQ(1, (int)(xyz == multiply(multiply(x, y), z)), "Reordered chain matches left to right");
+
+    // Mixed shapes: 3x5 * 5x2 * 2x4 * 4x1
+    Matrix<int, 3, 5> a{};
+    Matrix<int, 5, 2> b{};
+    Matrix<int, 2, 4> c{};
+    Matrix<int, 4, 1> d{};
+    for (int i = 0; i < 20; i++) {
+        a(i % 3, i % 5) = i;
+        b(i % 5, i % 2) = 3 - i;
+        c(i % 2, i % 4) = i * i;
+        d(i % 4, 0) = -i;
+    }
+    Matrix<int, 3, 1> abcd = a * b * c * d;
+    ASSERT_EQ(1, (int)(abcd == multiply(multiply(multiply(a, b), c), d)), "Four-operand chain");
+    // a(b(cd)) = 8 + 10 + 15 multiplies; left to right would be 66
+    ASSERT_EQ(33, (int)decltype(a * b * c * d)::cost(), "Four-operand chain takes the cheapest order");
+
+    constexpr Matrix<int, 2> s = {{{1, 1}, {0, 1}}};
+    constexpr Matrix<int, 2> s3 = s * s * s;
+    static_assert(s3(0, 1) == 3, "constexpr chain");
+    ASSERT_EQ(3, s3(0, 1), "Constexpr chain");
+}
+
+int main() {
+    printf("RISC-V Matrix Extension C++ API Tests\n");
+    printf("=====================================\n");
+
+    test_matrix_types();
+    test_cpu_handle();
+    test_batches();
+    test_expression_templates();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+    printf("Tests failed: %d\n", tests_run - tests_passed);
+    return tests_passed == tests_run ? 0 : 1;
+}
@@ -2,14 +2,34 @@
 #include <stdint.h>
 #include <assert.h>
 #include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "../simulator/riscv_matrix_ext.h"
+#include "../simulator/sparse_memory.h"
+#include "../simulator/riscv_encode.h"
+#include "../simulator/interpreter.h"
+#include "../simulator/lockstep.h"
+#include "../simulator/timing.h"
+#include "../simulator/checkpoint.h"
+#include "../simulator/sampling.h"
+#include "../simulator/multihart.h"
+#include "../simulator/replay.h"
+#include "../simulator/csr.h"
+#include "../simulator/sparse24.h"
+#include "../simulator/conv2d.h"
+#include "../simulator/dma.h"
+#include "../simulator/layout.h"
+#include "../simulator/syscall.h"
+#include "../simulator/file_map.h"
+#include "../simulator/server.h"
+#include "../simulator/shm_ring.h"
 
 // Test framework for RISC-V Matrix Extension
 // Validates the MATMUL instruction implementation
 
-typedef struct {
-    int32_t m[2][2];
-} matrix_2x2_t;
-
 // Test result tracking
 static int tests_run = 0;
 static int tests_passed = 0;
@@ -47,26 +67,11 @@ static int tests_passed = 0;
     } \
 } while(0)
 
-// Matrix operations for testing
-matrix_2x2_t matrix_multiply_2x2(matrix_2x2_t a, matrix_2x2_t b) {
-    matrix_2x2_t result;
-    
-    result.m[0][0] = a.m[0][0] * b.m[0][0] + a.m[0][1] * b.m[1][0];
-    result.m[0][1] = a.m[0][0] * b.m[0][1] + a.m[0][1] * b.m[1][1];
-    result.m[1][0] = a.m[1][0] * b.m[0][0] + a.m[1][1] * b.m[1][0];
-    result.m[1][1] = a.m[1][0] * b.m[0][1] + a.m[1][1] * b.m[1][1];
-    
-    return result;
-}
-
 // Test instruction encoding/decoding
 void test_instruction_encoding() {
     printf("\n=== Testing Instruction Encoding ===\n");
     
-    // MATMUL instruction format constants
-    const uint32_t OPCODE_CUSTOM_1 = 0x2B;
-    const uint32_t FUNC3_MATMUL = 0x7;
-    const uint32_t FUNC7_MATMUL = 0x1;
+    // MATMUL instruction format constants come from riscv_matrix_ext.h
     
     // Test encoding: matmul x1, x2, x3
     uint32_t expected_encoding = (FUNC7_MATMUL << 25) | (3 << 20) | (2 << 15) | 
@@ -145,6 +150,1729 @@ void test_edge_cases() {
     ASSERT_MATRIX_EQ(single_expected, single_result, "Single element multiplication");
 }
 
+// Test the XLEN-specialized core end to end through execute_instruction
+void test_xlen_core() {
+    printf("\n=== Testing RV%d Execution Core ===\n", XLEN);
+    
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    ASSERT_EQ(1, cpu != NULL, "CPU initialization");
+    if (!cpu) return;
+    
+    ASSERT_EQ(XLEN, (int)(sizeof(cpu->regs[0]) * 8), "Register width matches XLEN");
+    
+    matrix_2x2_t a = {{{1, 2}, {3, 4}}};
+    matrix_2x2_t b = {{{5, 6}, {7, 8}}};
+    matrix_2x2_t expected = {{{19, 22}, {43, 50}}};
+    uint32_t matmul_x1_x2_x3 = (FUNC7_MATMUL << 25) | (3 << 20) | (2 << 15) |
+                               (FUNC3_MATMUL << 12) | (1 << 7) | OPCODE_CUSTOM_1;
+    
+    // Operands in the flat RAM, including the last word of memory
+    write_matrix_2x2(cpu, 0x100, a);
+    write_matrix_2x2(cpu, 0x200, b);
+    cpu->regs[1] = DEFAULT_MEMORY_SIZE - MATRIX_BYTES;
+    cpu->regs[2] = 0x100;
+    cpu->regs[3] = 0x200;
+    ASSERT_EQ(0, execute_instruction(cpu, matmul_x1_x2_x3), "MATMUL executes in flat RAM");
+    matrix_2x2_t result = read_matrix_2x2(cpu, DEFAULT_MEMORY_SIZE - MATRIX_BYTES);
+    ASSERT_MATRIX_EQ(expected, result, "MATMUL result at top of RAM");
+    
+#if XLEN == 64
+    // Operands spread across a 64-bit address space only touch the pages used
+    xlen_t addr_a = 0x0000100000000000ull;
+    xlen_t addr_b = 0x7fffffff00000000ull;
+    xlen_t addr_c = 0xfffffffffffff000ull;
+    write_matrix_2x2(cpu, addr_a, a);
+    write_matrix_2x2(cpu, addr_b, b);
+    cpu->regs[1] = addr_c;
+    cpu->regs[2] = addr_a;
+    cpu->regs[3] = addr_b;
+    ASSERT_EQ(0, execute_instruction(cpu, matmul_x1_x2_x3), "MATMUL executes with 64-bit addresses");
+    result = read_matrix_2x2(cpu, addr_c);
+    ASSERT_MATRIX_EQ(expected, result, "MATMUL result in sparse high memory");
+    ASSERT_EQ(3, (int)sparse_memory_page_count(cpu->sparse), "Only touched sparse pages are allocated");
+    
+    matrix_2x2_t zero = {{{0, 0}, {0, 0}}};
+    result = read_matrix_2x2(cpu, 0x0000200000000000ull);
+    ASSERT_MATRIX_EQ(zero, result, "Unwritten sparse memory reads as zero");
+    ASSERT_EQ(3, (int)sparse_memory_page_count(cpu->sparse), "Reads do not allocate sparse pages");
+#else
+    ASSERT_EQ(1, cpu->sparse == NULL, "RV32 core uses flat memory only");
+#endif
+    
+    free_cpu(cpu);
+}
+
+// Test the base integer interpreter and the M extension
+void test_interpreter_m_extension() {
+    printf("\n=== Testing Interpreter and M Extension ===\n");
+    
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    if (!cpu) return;
+    
+    // Sum of squares 1..10 with a mul/add/bne loop
+    rv_program_t prog = { .len = 0 };
+    rv_emit32(&prog, rv_addi(5, 0, 10));
+    rv_emit32(&prog, rv_addi(6, 0, 0));
+    rv_emit32(&prog, rv_mul(7, 5, 5));       // loop:
+    rv_emit32(&prog, rv_add(6, 6, 7));
+    rv_emit32(&prog, rv_addi(5, 5, -1));
+    rv_emit32(&prog, rv_bne(5, 0, -12));
+    rv_emit32(&prog, rv_addi(10, 6, 0));
+    rv_emit32(&prog, rv_ecall());
+    
+    load_image(cpu, 0x200, prog.bytes, prog.len);
+    cpu->pc = 0x200;
+    ASSERT_EQ(RISCV_SUCCESS, riscv_run(cpu, 1000), "Loop program runs to completion");
+    ASSERT_EQ(1, cpu->halted, "ecall halts the interpreter");
+    ASSERT_EQ(385, cpu->exit_code, "Sum of squares computed with mul");
+    ASSERT_EQ(44, (int)cpu->instret, "Retired instruction count");
+    ASSERT_EQ(8, (int)cpu->predecode->misses, "Each instruction is decoded once");
+    
+    // Division corner cases defined by the M extension
+    cpu->regs[5] = (xlen_t)SXLEN_MIN;
+    cpu->regs[6] = (xlen_t)-1;
+    cpu->regs[7] = 0;
+    cpu->regs[8] = 7;
+    prog.len = 0;
+    rv_emit32(&prog, rv_div(10, 8, 7));      // 7 / 0 = -1
+    rv_emit32(&prog, rv_rem(11, 8, 7));      // 7 % 0 = 7
+    rv_emit32(&prog, rv_div(12, 5, 6));      // MIN / -1 = MIN
+    rv_emit32(&prog, rv_divu(13, 8, 7));     // 7 /u 0 = all ones
+    rv_emit32(&prog, rv_mulh(14, 6, 8));     // high(-1 * 7) = -1
+    rv_emit32(&prog, rv_mulhu(15, 6, 8));    // high(max * 7) = 6
+    rv_emit32(&prog, rv_mulhu(16, 6, 6));    // high(max * max) = max - 1
+    rv_emit32(&prog, rv_mulhsu(17, 6, 6));   // high(-1 * max) = -1
+    rv_emit32(&prog, rv_ebreak());
+    load_image(cpu, 0x200, prog.bytes, prog.len);
+    cpu->pc = 0x200;
+    cpu->halted = false;
+    riscv_run(cpu, 100);
+    ASSERT_EQ(-1, (int)(sxlen_t)cpu->regs[10], "DIV by zero returns -1");
+    ASSERT_EQ(7, (int)cpu->regs[11], "REM by zero returns the dividend");
+    ASSERT_EQ(1, cpu->regs[12] == (xlen_t)SXLEN_MIN, "DIV overflow returns the dividend");
+    ASSERT_EQ(1, cpu->regs[13] == ~(xlen_t)0, "DIVU by zero returns all ones");
+    ASSERT_EQ(-1, (int)(sxlen_t)cpu->regs[14], "MULH sign-extends the high half");
+    ASSERT_EQ(6, (int)cpu->regs[15], "MULHU returns the unsigned high half");
+    ASSERT_EQ(1, cpu->regs[16] == ~(xlen_t)1, "MULHU of all ones by all ones");
+    ASSERT_EQ(-1, (int)(sxlen_t)cpu->regs[17], "MULHSU of -1 by all ones");
+    
+    free_cpu(cpu);
+}
+
+// Test RVC expansion and execution of compressed code
+void test_compressed_extension() {
+    printf("\n=== Testing Compressed (C) Extension ===\n");
+    
+    ASSERT_EQ(rv_addi(5, 5, -3), riscv_expand_compressed(rv_c_addi(5, -3)), "c.addi expands to addi");
+    ASSERT_EQ(rv_addi(9, 0, 17), riscv_expand_compressed(rv_c_li(9, 17)), "c.li expands to addi");
+    ASSERT_EQ(rv_add(10, 0, 11), riscv_expand_compressed(rv_c_mv(10, 11)), "c.mv expands to add");
+    ASSERT_EQ(rv_add(10, 10, 11), riscv_expand_compressed(rv_c_add(10, 11)), "c.add expands to add");
+    ASSERT_EQ(rv_sub(8, 8, 9), riscv_expand_compressed(rv_c_sub(8, 9)), "c.sub expands to sub");
+    ASSERT_EQ(rv_slli(12, 12, 4), riscv_expand_compressed(rv_c_slli(12, 4)), "c.slli expands to slli");
+    ASSERT_EQ(rv_lw(9, 8, 68), riscv_expand_compressed(rv_c_lw(9, 8, 68)), "c.lw expands to lw");
+    ASSERT_EQ(rv_sw(9, 8, 12), riscv_expand_compressed(rv_c_sw(9, 8, 12)), "c.sw expands to sw");
+    ASSERT_EQ(rv_bne(8, 0, -8), riscv_expand_compressed(rv_c_bnez(8, -8)), "c.bnez expands to bne");
+    ASSERT_EQ(rv_jal(0, -1024), riscv_expand_compressed(rv_c_j(-1024)), "c.j expands to jal x0");
+    ASSERT_EQ(0, riscv_expand_compressed(0x0000), "All-zero halfword is illegal");
+    ASSERT_EQ(rv_addi(9, 0, 17), riscv_decode_instruction(rv_c_li(9, 17)).raw,
+              "riscv_decode_instruction expands 16-bit forms");
+    
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    if (!cpu) return;
+    
+    // The sum-of-squares loop again, mixing 16- and 32-bit instructions,
+    // followed by a MATMUL through compressed address setup
+    matrix_2x2_t a = {{{1, 2}, {3, 4}}};
+    matrix_2x2_t b = {{{5, 6}, {7, 8}}};
+    matrix_2x2_t expected = {{{19, 22}, {43, 50}}};
+    write_matrix_2x2(cpu, 0x400, a);
+    write_matrix_2x2(cpu, 0x410, b);
+    
+    rv_program_t prog = { .len = 0 };
+    rv_emit16(&prog, rv_c_li(8, 10));
+    rv_emit16(&prog, rv_c_li(9, 0));
+    rv_emit32(&prog, rv_mul(7, 8, 8));       // loop:
+    rv_emit16(&prog, rv_c_add(9, 7));
+    rv_emit16(&prog, rv_c_addi(8, -1));
+    rv_emit16(&prog, rv_c_bnez(8, -8));
+    rv_emit16(&prog, rv_c_li(12, 1));
+    rv_emit16(&prog, rv_c_slli(12, 10));     // 0x400
+    rv_emit16(&prog, rv_c_mv(13, 12));
+    rv_emit16(&prog, rv_c_addi(13, 16));     // 0x410
+    rv_emit16(&prog, rv_c_mv(14, 13));
+    rv_emit16(&prog, rv_c_addi(14, 16));     // 0x420
+    rv_emit32(&prog, rv_matmul(14, 12, 13));
+    rv_emit16(&prog, rv_c_mv(10, 9));
+    rv_emit32(&prog, rv_ecall());
+    
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    ASSERT_EQ(RISCV_SUCCESS, riscv_run(cpu, 1000), "Compressed program runs to completion");
+    ASSERT_EQ(385, cpu->exit_code, "Compressed loop computes the same result");
+    matrix_2x2_t result = read_matrix_2x2(cpu, 0x420);
+    ASSERT_MATRIX_EQ(expected, result, "MATMUL after compressed address setup");
+    ASSERT_EQ(36, (int)prog.len, "Mixed-width program size in bytes");
+    
+    free_cpu(cpu);
+}
+
+// Test lockstep execution against independent scalar runs
+void test_lockstep_harts() {
+    printf("\n=== Testing Lockstep SoA Harts ===\n");
+    
+    // Each lane sums i*i for i = n..1 (n = x10, differs per lane), then
+    // multiplies the matrix at 0x400 by itself into 0x420
+    rv_program_t prog = { .len = 0 };
+    rv_emit32(&prog, rv_addi(6, 0, 0));
+    rv_emit32(&prog, rv_mul(7, 10, 10));     // loop:
+    rv_emit32(&prog, rv_add(6, 6, 7));
+    rv_emit32(&prog, rv_addi(10, 10, -1));
+    rv_emit32(&prog, rv_bne(10, 0, -12));
+    rv_emit32(&prog, rv_addi(12, 0, 0x400));
+    rv_emit32(&prog, rv_addi(14, 0, 0x420));
+    rv_emit32(&prog, rv_matmul(14, 12, 12));
+    rv_emit32(&prog, rv_addi(10, 6, 0));
+    rv_emit32(&prog, rv_ecall());
+    
+    lockstep_group_t *group = lockstep_create(16, DEFAULT_MEMORY_SIZE);
+    ASSERT_EQ(1, group != NULL, "16-lane group creation");
+    if (!group) return;
+    ASSERT_EQ(1, lockstep_create(4, DEFAULT_MEMORY_SIZE) == NULL, "Unsupported lane count rejected");
+    
+    lockstep_load_image(group, 0x100, prog.bytes, prog.len);
+    lockstep_set_pc(group, 0x100);
+    for (int l = 0; l < group->lanes; l++) {
+        matrix_2x2_t m = {{{l, 1}, {0, l}}};
+        write_matrix_2x2(group->cpu[l], 0x400, m);
+        group->regs[10][l] = (xlen_t)(1 + l % 5);
+    }
+    
+    ASSERT_EQ(RISCV_SUCCESS, lockstep_run(group, 100000), "Lockstep run completes");
+    
+    int exit_ok = 1, matrix_ok = 1, instret_ok = 1;
+    for (int l = 0; l < group->lanes; l++) {
+        cpu_state_t *ref = init_cpu(DEFAULT_MEMORY_SIZE);
+        matrix_2x2_t m = {{{l, 1}, {0, l}}};
+        write_matrix_2x2(ref, 0x400, m);
+        load_image(ref, 0x100, prog.bytes, prog.len);
+        ref->pc = 0x100;
+        ref->regs[10] = (xlen_t)(1 + l % 5);
+        riscv_run(ref, 100000);
+        
+        matrix_2x2_t expected = read_matrix_2x2(ref, 0x420);
+        matrix_2x2_t actual = read_matrix_2x2(group->cpu[l], 0x420);
+        if (!group->cpu[l]->halted || group->cpu[l]->exit_code != ref->exit_code) exit_ok = 0;
+        if (memcmp(&expected, &actual, sizeof(expected)) != 0) matrix_ok = 0;
+        if (group->cpu[l]->instret != ref->instret) instret_ok = 0;
+        free_cpu(ref);
+    }
+    ASSERT_EQ(1, exit_ok, "Every lane matches its scalar exit code");
+    ASSERT_EQ(1, matrix_ok, "Every lane matches its scalar MATMUL result");
+    ASSERT_EQ(1, instret_ok, "Per-lane retired instruction counts match");
+    ASSERT_EQ(1, group->converged_steps > 0 && group->divergent_steps > 0,
+              "Lanes diverge on trip count and reconverge");
+    
+    // Rerun the same group with other trip counts: every lane must run to
+    // its own ecall again, through the scalar MATMUL as well
+    lockstep_set_pc(group, 0x100);
+    for (int l = 0; l < group->lanes; l++) group->regs[10][l] = (xlen_t)(2 + l % 3);
+    ASSERT_EQ(RISCV_SUCCESS, lockstep_run(group, 100000), "Second lockstep run completes");
+    int rerun_ok = 1;
+    for (int l = 0; l < group->lanes; l++) {
+        int n = 2 + l % 3;
+        if (!group->cpu[l]->halted || group->cpu[l]->exit_code != n * (n + 1) * (2 * n + 1) / 6) rerun_ok = 0;
+    }
+    ASSERT_EQ(1, rerun_ok, "Every lane reaches its exit code on a rerun");
+    
+    lockstep_free(group);
+}
+
+void test_fast_forward() {
+    printf("\n=== Testing Functional Fast-Forward ===\n");
+    
+    // 50-iteration setup loop, then a MATMUL region between ROI markers
+    rv_program_t prog = { .len = 0 };
+    rv_emit32(&prog, rv_addi(5, 0, 50));
+    rv_emit32(&prog, rv_addi(6, 6, 3));      // loop:
+    rv_emit32(&prog, rv_addi(5, 5, -1));
+    rv_emit32(&prog, rv_bne(5, 0, -8));
+    rv_emit32(&prog, rv_marker(RV_MARKER_ROI_BEGIN));
+    xlen_t roi_pc = 0x100 + (xlen_t)prog.len;
+    rv_emit32(&prog, rv_addi(12, 0, 0x400));
+    rv_emit32(&prog, rv_addi(14, 0, 0x420));
+    rv_emit32(&prog, rv_matmul(14, 12, 12));
+    rv_emit32(&prog, rv_lw(10, 14, 0));
+    xlen_t end_pc = 0x100 + (xlen_t)prog.len;
+    rv_emit32(&prog, rv_marker(RV_MARKER_ROI_END));
+    rv_emit32(&prog, rv_add(10, 10, 6));
+    rv_emit32(&prog, rv_ecall());
+    
+    matrix_2x2_t m = {{{1, 2}, {3, 4}}};
+    sim_config_t config;
+    sim_stats_t stats;
+    sim_default_config(&config);
+    
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    write_matrix_2x2(cpu, 0x400, m);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    ASSERT_EQ(RISCV_SUCCESS, timing_attach(cpu, NULL), "Timing model attaches");
+    ASSERT_EQ(RISCV_SUCCESS, sim_run(cpu, &config, 100000, &stats), "Fast-forward run completes");
+    ASSERT_EQ(7 + 150, cpu->exit_code, "Result unchanged by mode switches");
+    ASSERT_EQ(1, stats.roi_count, "One region of interest entered");
+    ASSERT_EQ(5, (int)stats.detailed_insns, "Only the marked region is timed");
+    ASSERT_EQ(154, (int)stats.functional_insns, "Setup and tail run functionally");
+    ASSERT_EQ(1, stats.detailed_cycles >= 5 + cpu->timing->config.miss_penalty,
+              "Region pays for the cold MATMUL operand miss");
+    free_cpu(cpu);
+    
+    // Same region selected by pc, markers ignored
+    cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    write_matrix_2x2(cpu, 0x400, m);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    timing_attach(cpu, NULL);
+    config.roi_begin_pc = roi_pc;
+    config.roi_end_pc = end_pc;
+    sim_run(cpu, &config, 100000, &stats);
+    ASSERT_EQ(4, (int)stats.detailed_insns, "PC-delimited region is timed");
+    free_cpu(cpu);
+    
+    // Detailed mode times everything
+    cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    write_matrix_2x2(cpu, 0x400, m);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    timing_attach(cpu, NULL);
+    config.mode = SIM_MODE_DETAILED;
+    sim_run(cpu, &config, 100000, &stats);
+    ASSERT_EQ(159, (int)stats.detailed_insns, "Detailed mode times every instruction");
+    ASSERT_EQ(0, (int)stats.functional_insns, "Detailed mode never fast-forwards");
+    free_cpu(cpu);
+}
+
+// Alternating phases: an ALU loop and a cache-missing MATMUL sweep
+static void build_phased_program(rv_program_t *prog) {
+    prog->len = 0;
+    rv_emit32(prog, rv_addi(20, 0, 4));
+    size_t round = prog->len;
+    rv_emit_li(prog, 5, 20000);
+    rv_emit32(prog, rv_addi(6, 6, 1));       // ALU phase
+    rv_emit32(prog, rv_add(7, 7, 6));
+    rv_emit32(prog, rv_addi(5, 5, -1));
+    rv_emit32(prog, rv_bne(5, 0, -12));
+    rv_emit_li(prog, 5, 3000);
+    rv_emit32(prog, rv_lui(12, 0x8000));
+    rv_emit32(prog, rv_addi(14, 12, 16));    // MATMUL phase
+    rv_emit32(prog, rv_matmul(14, 12, 12));
+    rv_emit32(prog, rv_lw(10, 14, 0));
+    rv_emit32(prog, rv_add(15, 15, 10));
+    rv_emit32(prog, rv_addi(12, 12, 64));
+    rv_emit32(prog, rv_addi(5, 5, -1));
+    rv_emit32(prog, rv_bne(5, 0, -24));
+    rv_emit32(prog, rv_addi(20, 20, -1));
+    rv_emit32(prog, rv_bne(20, 0, (int32_t)round - (int32_t)prog->len));
+    rv_emit32(prog, rv_add(10, 7, 15));
+    rv_emit32(prog, rv_ecall());
+}
+
+void test_simpoint_sampling() {
+    printf("\n=== Testing SimPoint Sampling ===\n");
+    
+    rv_program_t prog;
+    build_phased_program(&prog);
+    
+    // Checkpoint round trip: run half-way, snapshot, finish, restore, finish again
+    cpu_state_t *cpu = init_cpu(256 * 1024);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    riscv_run(cpu, 150000);
+    riscv_checkpoint_t *ckpt = checkpoint_save(cpu);
+    ASSERT_EQ(1, ckpt != NULL, "Checkpoint saved");
+    riscv_run(cpu, UINT64_MAX);
+    int exit_code = cpu->exit_code;
+    uint64_t instret = cpu->instret;
+    ASSERT_EQ(RISCV_SUCCESS, checkpoint_restore(cpu, ckpt), "Checkpoint restored");
+    ASSERT_EQ(150000, (int)cpu->instret, "Restored instret");
+    ASSERT_EQ(0, cpu->halted, "Restored run state");
+    riscv_run(cpu, UINT64_MAX);
+    ASSERT_EQ(exit_code, cpu->exit_code, "Replay from checkpoint matches");
+    ASSERT_EQ((int)instret, (int)cpu->instret, "Replay retires the same instructions");
+    checkpoint_free(ckpt);
+    free_cpu(cpu);
+    
+    // Reference: time the whole run
+    cpu = init_cpu(256 * 1024);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    timing_attach(cpu, NULL);
+    riscv_run_timed(cpu, UINT64_MAX);
+    double full_cycles = (double)cpu->timing->cycles;
+    free_cpu(cpu);
+    
+    cpu = init_cpu(256 * 1024);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    timing_attach(cpu, NULL);
+    simpoint_config_t config;
+    simpoint_result_t result;
+    simpoint_default_config(&config);
+    config.interval_insns = 10000;
+    config.clusters = 4;
+    config.warmup_insns = 1000;
+    ASSERT_EQ(RISCV_SUCCESS, simpoint_run(cpu, &config, UINT64_MAX, &result), "SimPoint run completes");
+    ASSERT_EQ(exit_code, cpu->exit_code, "CPU left in final functional state");
+    ASSERT_EQ(1, result.count >= 2, "Both phases get a simulation point");
+    ASSERT_EQ(1, result.detailed_insns * 4 < result.total_insns, "Most instructions skip detailed timing");
+    
+    double error = (result.estimated_cycles - full_cycles) / full_cycles;
+    printf("  estimated %.0f cycles, full run %.0f (%+.2f%%)\n",
+           result.estimated_cycles, full_cycles, 100.0 * error);
+    ASSERT_EQ(1, error > -0.05 && error < 0.05, "Estimate within 5% of full detailed run");
+    free_cpu(cpu);
+    
+    // A stop pc inside the ALU loop and marker stops do not cut the
+    // sampled runs short, and both are left as they were
+    xlen_t alu_pc = 0;
+    for (size_t off = 0; off + 4 <= prog.len; off += 4) {
+        uint32_t word;
+        memcpy(&word, prog.bytes + off, 4);
+        if (word == rv_addi(6, 6, 1)) alu_pc = (xlen_t)(0x100 + off);
+    }
+    cpu = init_cpu(256 * 1024);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    timing_attach(cpu, NULL);
+    cpu->stop_pc = alu_pc;
+    cpu->stop_on_marker = true;
+    simpoint_result_t stopped;
+    ASSERT_EQ(RISCV_SUCCESS, simpoint_run(cpu, &config, UINT64_MAX, &stopped), "SimPoint run with a stop pc completes");
+    ASSERT_EQ(1, stopped.estimated_cycles == result.estimated_cycles, "Stop pc does not change the estimate");
+    ASSERT_EQ((int)result.detailed_insns, (int)stopped.detailed_insns, "Stop pc does not shorten the timed intervals");
+    ASSERT_EQ(1, cpu->stop_pc == alu_pc && cpu->stop_on_marker, "Stop pc and marker stops restored");
+    free_cpu(cpu);
+}
+
+// Each hart sweeps MATMULs over its own 64 KiB region (a0 = hart index)
+static uint64_t run_harts(int harts, multihart_mode_t mode, uint64_t quantum, uint64_t *cycles,
+                          rr_log_t *log) {
+    rv_program_t prog = { .len = 0 };
+    rv_emit32(&prog, rv_slli(12, 10, 16));
+    rv_emit32(&prog, rv_lui(13, 0x10000));
+    rv_emit32(&prog, rv_add(12, 12, 13));
+    rv_emit32(&prog, rv_addi(5, 0, 500));
+    rv_emit32(&prog, rv_addi(14, 12, 16));   // loop:
+    rv_emit32(&prog, rv_matmul(14, 12, 12));
+    rv_emit32(&prog, rv_lw(11, 14, 0));
+    rv_emit32(&prog, rv_add(15, 15, 11));
+    rv_emit32(&prog, rv_addi(12, 12, 64));
+    rv_emit32(&prog, rv_addi(5, 5, -1));
+    rv_emit32(&prog, rv_bne(5, 0, -24));
+    rv_emit32(&prog, rv_ecall());
+    
+    multihart_t *system = multihart_create(harts, 512 * 1024, NULL);
+    if (!system) return 0;
+    multihart_load_image(system, 0x100, prog.bytes, prog.len);
+    for (int h = 0; h < harts; h++) system->cpu[h]->pc = 0x100;
+    multihart_attach_log(system, log);
+    
+    uint64_t halted = 0;
+    if (multihart_run(system, mode, quantum, UINT64_MAX) == RISCV_SUCCESS) {
+        for (int h = 0; h < harts; h++) {
+            cycles[h] = system->cpu[h]->timing->cycles;
+            halted += system->cpu[h]->halted;
+        }
+    }
+    multihart_free(system);
+    return halted;
+}
+
+// Harts add a0 + 1 to one shared counter 2000 times without locking; each
+// exits with the sum of the counter values it stored
+static uint64_t run_shared_counter(int harts, multihart_mode_t mode, uint64_t quantum, int *exit_codes,
+                                   int32_t *counter, rr_log_t *log) {
+    rv_program_t prog = { .len = 0 };
+    rv_emit32(&prog, rv_lui(13, 0x10000));
+    rv_emit32(&prog, rv_addi(16, 10, 1));
+    rv_emit32(&prog, rv_addi(5, 0, 2000));
+    rv_emit32(&prog, rv_lw(11, 13, 0));      // loop:
+    rv_emit32(&prog, rv_add(11, 11, 16));
+    rv_emit32(&prog, rv_sw(11, 13, 0));
+    rv_emit32(&prog, rv_add(15, 15, 11));
+    rv_emit32(&prog, rv_addi(5, 5, -1));
+    rv_emit32(&prog, rv_bne(5, 0, -20));
+    rv_emit32(&prog, rv_addi(10, 15, 0));
+    rv_emit32(&prog, rv_ecall());
+    
+    multihart_t *system = multihart_create(harts, 512 * 1024, NULL);
+    if (!system) return 0;
+    multihart_load_image(system, 0x100, prog.bytes, prog.len);
+    for (int h = 0; h < harts; h++) system->cpu[h]->pc = 0x100;
+    multihart_attach_log(system, log);
+    
+    uint64_t halted = 0;
+    if (multihart_run(system, mode, quantum, UINT64_MAX) == RISCV_SUCCESS) {
+        for (int h = 0; h < harts; h++) {
+            exit_codes[h] = system->cpu[h]->exit_code;
+            halted += system->cpu[h]->halted;
+        }
+        memcpy(counter, system->memory + 0x10000, sizeof(*counter));
+    }
+    multihart_free(system);
+    return halted;
+}
+
+void test_multihart_timing() {
+    printf("\n=== Testing Multi-Hart Timing ===\n");
+    
+    uint64_t alone[1], serial[4], det[4], det_again[4], shared[4];
+    ASSERT_EQ(1, (int)run_harts(1, MULTIHART_SERIAL, 0, alone, NULL), "Single hart completes");
+    ASSERT_EQ(4, (int)run_harts(4, MULTIHART_SERIAL, 0, serial, NULL), "Serial mode runs all harts");
+    ASSERT_EQ(1, serial[3] > alone[0], "Shared bus contention slows harts down");
+    
+    ASSERT_EQ(4, (int)run_harts(4, MULTIHART_DETERMINISTIC, 200, det, NULL), "Deterministic parallel run");
+    run_harts(4, MULTIHART_DETERMINISTIC, 200, det_again, NULL);
+    ASSERT_EQ(0, memcmp(det, det_again, sizeof(det)), "Deterministic mode is repeatable");
+    ASSERT_EQ(4, (int)run_harts(4, MULTIHART_PARALLEL, 200, shared, NULL), "Shared-bus parallel run");
+    
+    double worst = 0.0;
+    for (int h = 0; h < 4; h++) {
+        double error = ((double)det[h] - (double)serial[h]) / (double)serial[h];
+        if (error < 0) error = -error;
+        if (error > worst) worst = error;
+    }
+    printf("  serial hart 0: %llu cycles, deterministic: %llu (worst error %.2f%%)\n",
+           (unsigned long long)serial[0], (unsigned long long)det[0], 100.0 * worst);
+    ASSERT_EQ(1, worst < 0.10, "Quantum-synchronized timing within 10% of serial");
+}
+
+void test_record_replay() {
+    printf("\n=== Testing Record/Replay ===\n");
+    
+    // a0 = (cycle delta) ^ (time delta) + instret read at a known point
+    rv_program_t prog = { .len = 0 };
+    rv_emit32(&prog, rv_csrrs(5, CSR_CYCLE, 0));
+    rv_emit32(&prog, rv_csrrs(6, CSR_TIME, 0));
+    rv_emit32(&prog, rv_csrrs(7, CSR_INSTRET, 0));
+    rv_emit32(&prog, rv_csrrs(8, CSR_CYCLE, 0));
+    rv_emit32(&prog, rv_csrrs(9, CSR_TIME, 0));
+    rv_emit32(&prog, rv_sub(10, 8, 5));
+    rv_emit32(&prog, rv_sub(11, 9, 6));
+    rv_emit32(&prog, rv_enc_r(RV_OP_OP, 10, 4, 10, 11, 0));  // xor a0, a0, a1
+    rv_emit32(&prog, rv_ecall());
+    
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    rr_log_t *log = rr_create(1);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    cpu->replay = &log->stream[0];
+    riscv_run(cpu, 1000);
+    int recorded = cpu->exit_code;
+    ASSERT_EQ(2, (int)cpu->regs[7], "rdinstret counts retired instructions");
+    ASSERT_EQ(4, (int)log->stream[0].events, "Host-time counter reads are logged");
+    ASSERT_EQ(RISCV_ERROR_INSTRUCTION, csr_write(cpu, CSR_CYCLE, 0), "Counters are read-only");
+    free_cpu(cpu);
+    
+    log->mode = log->stream[0].mode = RR_REPLAY;
+    cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    cpu->replay = &log->stream[0];
+    riscv_run(cpu, 1000);
+    ASSERT_EQ(recorded, cpu->exit_code, "Replay reproduces host-time reads");
+    ASSERT_EQ(0, (int)rr_diverged(log), "Replay consumed the log without divergence");
+    free_cpu(cpu);
+    rr_free(log);
+    
+    // Scheduling-dependent parallel run, then replayed
+    uint64_t recorded_cycles[4], replayed_cycles[4];
+    log = rr_create(4);
+    run_harts(4, MULTIHART_PARALLEL, 500, recorded_cycles, log);
+    for (int h = 0; h < 4; h++) log->stream[h].mode = RR_REPLAY;
+    log->mode = RR_REPLAY;
+    ASSERT_EQ(4, (int)run_harts(4, MULTIHART_PARALLEL, 500, replayed_cycles, log), "Parallel replay completes");
+    ASSERT_EQ(0, memcmp(recorded_cycles, replayed_cycles, sizeof(recorded_cycles)),
+              "Parallel replay is cycle-exact");
+    ASSERT_EQ(0, (int)rr_diverged(log), "Parallel replay did not diverge");
+    rr_free(log);
+    
+    // Harts that race on shared RAM: replay must see the same interleaving
+    int recorded_exits[4], replayed_exits[4];
+    int32_t recorded_counter = 0, replayed_counter = 0;
+    log = rr_create(4);
+    ASSERT_EQ(4, (int)run_shared_counter(4, MULTIHART_PARALLEL, 100, recorded_exits, &recorded_counter, log),
+              "Shared-memory parallel run completes");
+    for (int h = 0; h < 4; h++) log->stream[h].mode = RR_REPLAY;
+    log->mode = RR_REPLAY;
+    run_shared_counter(4, MULTIHART_PARALLEL, 100, replayed_exits, &replayed_counter, log);
+    ASSERT_EQ(recorded_counter, replayed_counter, "Replay reproduces shared RAM");
+    ASSERT_EQ(0, memcmp(recorded_exits, replayed_exits, sizeof(recorded_exits)),
+              "Replay reproduces the values each hart read from shared RAM");
+    ASSERT_EQ(0, (int)rr_diverged(log), "Shared-memory replay did not diverge");
+    rr_free(log);
+    
+    // Corrupt stream lengths fail to load instead of allocating or spinning
+    static const char path[] = "build/replay_test.log";
+    static const uint64_t lens[] = { (1ull << 63) + 1, UINT64_MAX, 5, 4 };
+    for (int i = 0; i < 4; i++) {
+        uint8_t file[20] = { 'R', 'V', 'R', 'R', 1, 0, 0, 0, 1, 0, 0, 0 };
+        for (int b = 0; b < 8; b++) file[12 + b] = (uint8_t)(lens[i] >> (8 * b));
+        FILE *f = fopen(path, "wb");
+        if (!f) continue;
+        fwrite(file, 1, sizeof(file), f);
+        fwrite("abcd", 1, 4, f);
+        fclose(f);
+        log = rr_load(path);
+        if (lens[i] == 4) {
+            ASSERT_EQ(4, log ? (int)log->stream[0].len : -1, "Stream that fits the file loads");
+        } else {
+            ASSERT_EQ(1, log == NULL, "Stream longer than the file is rejected");
+        }
+        rr_free(log);
+    }
+    remove(path);
+}
+
+// Test fast reset to a base image by restoring only dirty pages
+void test_fast_reset() {
+    printf("\n=== Testing Fast Reset ===\n");
+    
+    // Program A: MATMUL at 0x400 into 0x8000, exit with C[0][0]
+    rv_program_t prog_a = { .len = 0 };
+    rv_emit32(&prog_a, rv_addi(12, 0, 0x400));
+    rv_emit_li(&prog_a, 14, 0x8000);
+    rv_emit32(&prog_a, rv_matmul(14, 12, 12));
+    rv_emit32(&prog_a, rv_lw(10, 14, 0));
+    rv_emit32(&prog_a, rv_ecall());
+    
+    // Program B overwrites the code and exits with 99
+    rv_program_t prog_b = { .len = 0 };
+    rv_emit32(&prog_b, rv_addi(10, 0, 99));
+    rv_emit32(&prog_b, rv_ecall());
+    
+    matrix_2x2_t m = {{{1, 2}, {3, 4}}};
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    write_matrix_2x2(cpu, 0x400, m);
+    load_image(cpu, 0x100, prog_a.bytes, prog_a.len);
+    cpu->pc = 0x100;
+    ASSERT_EQ(RISCV_SUCCESS, riscv_cpu_set_base(cpu), "Reset image saved");
+    ASSERT_EQ(0, (int)cpu->dirty[0], "Saving the image clears dirty pages");
+    
+    riscv_run(cpu, 1000);
+    ASSERT_EQ(7, cpu->exit_code, "First case runs");
+    ASSERT_EQ(1, (int)((cpu->dirty[0] >> (0x8000 >> RESET_PAGE_BITS)) & 1), "Store marks its page dirty");
+    ASSERT_EQ(0, (int)(cpu->dirty[0] & 1), "Clean code page stays clean");
+    
+    ASSERT_EQ(RISCV_SUCCESS, riscv_cpu_reset(cpu), "Reset succeeds");
+    ASSERT_EQ(0, read_word(cpu, 0x8000), "Dirty page restored from image");
+    ASSERT_EQ(0x100, (int)cpu->pc, "PC restored");
+    ASSERT_EQ(0, (int)cpu->instret, "instret restored");
+    ASSERT_EQ(0, (int)cpu->halted, "Halt cleared");
+    
+    // Cached decodes of program B must not survive the reset
+    load_image(cpu, 0x100, prog_b.bytes, prog_b.len);
+    riscv_run(cpu, 1000);
+    ASSERT_EQ(99, cpu->exit_code, "Overwritten code runs");
+    riscv_cpu_reset(cpu);
+    riscv_run(cpu, 1000);
+    ASSERT_EQ(7, cpu->exit_code, "Original code runs again after reset");
+    free_cpu(cpu);
+    
+    // Without an image, reset returns to the power-on state
+    cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    write_word(cpu, 0x2000, 5);
+    cpu->regs[5] = 1;
+    riscv_cpu_reset(cpu);
+    ASSERT_EQ(0, read_word(cpu, 0x2000), "Memory zeroed without an image");
+    ASSERT_EQ(0, (int)cpu->regs[5], "Registers zeroed without an image");
+    free_cpu(cpu);
+    
+    // Sparse pages above RAM are restored too
+    cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    if (cpu->sparse) {
+        xlen_t high = (xlen_t)DEFAULT_MEMORY_SIZE + 0x3000;
+        write_word(cpu, high, 11);
+        riscv_cpu_set_base(cpu);
+        write_word(cpu, high, 12);
+        write_word(cpu, high + 0x1000, 13);
+        riscv_cpu_reset(cpu);
+        ASSERT_EQ(11, read_word(cpu, high), "Sparse page restored from image");
+        ASSERT_EQ(0, read_word(cpu, high + 0x1000), "New sparse page cleared");
+    }
+    free_cpu(cpu);
+}
+
+void test_huge_page_memory() {
+    printf("\n=== Testing Huge-Page Guest Memory ===\n");
+    
+    size_t size = 4 * HOST_HUGE_PAGE_SIZE;
+    cpu_state_t *cpu = init_cpu_huge(size);
+    ASSERT_EQ(1, cpu != NULL, "Huge-page CPU created (or fell back)");
+    printf("  backing: %s\n", host_pages_name(cpu->memory_pages));
+    ASSERT_EQ(1, cpu->memory_pages != HOST_PAGES_THP ||
+                 ((uintptr_t)cpu->memory & (HOST_HUGE_PAGE_SIZE - 1)) == 0,
+              "THP backing is 2 MiB aligned");
+    ASSERT_EQ(0, read_word(cpu, (xlen_t)(size - 4)), "Huge-page RAM starts zeroed");
+    
+    matrix_2x2_t m = {{{1, 2}, {3, 4}}};
+    xlen_t a = (xlen_t)(3 * HOST_HUGE_PAGE_SIZE);
+    write_matrix_2x2(cpu, a, m);
+    cpu->regs[12] = a;
+    cpu->regs[14] = a + 0x1000;
+    ASSERT_EQ(0, execute_instruction(cpu, riscv_encode_matmul(14, 12, 12)), "MATMUL executes on huge pages");
+    ASSERT_EQ(7, read_word(cpu, a + 0x1000), "Result correct on huge pages");
+    free_cpu(cpu);
+}
+
+void test_numa_placement() {
+    printf("\n=== Testing NUMA Placement ===\n");
+    
+    host_numa_topology_t topo;
+    host_numa_topology(&topo);
+    printf("  host: %d node(s), %d CPU(s) on node 0\n", topo.nodes, topo.cpu_count[0]);
+    ASSERT_EQ(1, topo.nodes >= 1 && topo.cpu_count[0] >= 1, "Topology has a node with CPUs");
+    
+    static const multihart_numa_policy_t policies[] = {
+        MULTIHART_NUMA_NONE, MULTIHART_NUMA_FIRST_TOUCH, MULTIHART_NUMA_BIND, MULTIHART_NUMA_INTERLEAVE
+    };
+    static const char *names[] = { "none", "first-touch", "bind", "interleave" };
+    
+    rv_program_t prog = { .len = 0 };
+    rv_emit32(&prog, rv_slli(12, 10, 16));
+    rv_emit32(&prog, rv_lui(13, 0x10000));
+    rv_emit32(&prog, rv_add(12, 12, 13));
+    rv_emit32(&prog, rv_addi(14, 12, 16));
+    rv_emit32(&prog, rv_matmul(14, 12, 12));
+    rv_emit32(&prog, rv_lw(10, 14, 0));
+    rv_emit32(&prog, rv_ecall());
+    
+    for (int p = 0; p < 4; p++) {
+        multihart_t *system = multihart_create(4, 512 * 1024, NULL);
+        multihart_numa_t numa = { .policy = policies[p], .region_base = 0x10000, .region_size = 0x10000 };
+        char msg[64];
+        snprintf(msg, sizeof(msg), "NUMA policy %s applies", names[p]);
+        ASSERT_EQ(RISCV_SUCCESS, multihart_set_numa(system, &numa), msg);
+        
+        int node = host_numa_node_of(system->memory + 0x10000 + 3 * 0x10000 + 4096);
+        if (policies[p] == MULTIHART_NUMA_BIND && node >= 0) {
+            ASSERT_EQ(system->hart_node[3], node, "Bound region sits on its hart's node");
+        }
+        
+        for (int h = 0; h < 4; h++) {
+            matrix_2x2_t m = {{{h + 1, 0}, {0, 1}}};
+            write_matrix_2x2(system->cpu[0], (xlen_t)(0x10000 + h * 0x10000), m);
+        }
+        multihart_load_image(system, 0x100, prog.bytes, prog.len);
+        for (int h = 0; h < 4; h++) system->cpu[h]->pc = 0x100;
+        multihart_run(system, MULTIHART_PARALLEL, 100, UINT64_MAX);
+        snprintf(msg, sizeof(msg), "Harts compute correctly under %s", names[p]);
+        ASSERT_EQ(16, system->cpu[3]->exit_code, msg);
+        multihart_free(system);
+    }
+    
+    multihart_t *system = multihart_create(4, 512 * 1024, NULL);
+    multihart_numa_t too_big = { .policy = MULTIHART_NUMA_BIND, .region_base = 0x10000, .region_size = 0x40000 };
+    ASSERT_EQ(RISCV_ERROR_BOUNDS, multihart_set_numa(system, &too_big), "Oversized regions rejected");
+    multihart_free(system);
+}
+
+static matrix_2x2_t transpose_ref(matrix_2x2_t m) {
+    matrix_2x2_t t = {{{m.m[0][0], m.m[1][0]}, {m.m[0][1], m.m[1][1]}}};
+    return t;
+}
+
+void test_matmul_transpose() {
+    printf("\n=== Testing Transpose-on-Load MATMUL ===\n");
+    
+    matrix_2x2_t a = {{{1, 2}, {3, 4}}};
+    matrix_2x2_t b = {{{5, 6}, {7, 8}}};
+    static const char *names[] = { "matmul", "matmul.ta", "matmul.tb", "matmul.tt" };
+    
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    write_matrix_2x2(cpu, 0x100, a);
+    write_matrix_2x2(cpu, 0x200, b);
+    cpu->regs[2] = 0x100;
+    cpu->regs[3] = 0x200;
+    cpu->regs[1] = 0x300;
+    
+    for (int t = 0; t < 4; t++) {
+        matrix_2x2_t op_a = (t & MATMUL_TRANSPOSE_A) ? transpose_ref(a) : a;
+        matrix_2x2_t op_b = (t & MATMUL_TRANSPOSE_B) ? transpose_ref(b) : b;
+        matrix_2x2_t expected = matrix_multiply_2x2(op_a, op_b);
+        
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%s executes", names[t]);
+        ASSERT_EQ(0, execute_instruction(cpu, rv_matmul_t(1, 2, 3, t)), msg);
+        matrix_2x2_t result = read_matrix_2x2(cpu, 0x300);
+        snprintf(msg, sizeof(msg), "%s matches transposed reference", names[t]);
+        ASSERT_EQ(1, memcmp(&expected, &result, sizeof(result)) == 0, msg);
+    }
+    ASSERT_EQ(rv_matmul(1, 2, 3), rv_matmul_t(1, 2, 3, 0), "No modifiers encodes plain MATMUL");
+    
+    // Products wrap like the scalar reference
+    matrix_2x2_t big = {{{INT32_MAX, -7}, {INT32_MIN, 3}}};
+    matrix_2x2_t expected = matrix_multiply_2x2(big, transpose_ref(big));
+    matrix_2x2_t result = matrix_multiply_2x2_transposed(big, big, MATMUL_TRANSPOSE_B);
+    ASSERT_EQ(1, memcmp(&expected, &result, sizeof(result)) == 0, "Overflowing products wrap");
+    
+    // Unused func7 bits stay illegal
+    uint32_t bad = rv_matmul(1, 2, 3) | (0x8u << 25);
+    ASSERT_EQ(-1, execute_instruction(cpu, bad), "Unknown MATMUL modifier rejected");
+    free_cpu(cpu);
+}
+
+void test_matvec() {
+    printf("\n=== Testing MATVEC ===\n");
+    
+    matrix_2x2_t a = {{{1, 2}, {3, 4}}};
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    write_matrix_2x2(cpu, 0x100, a);
+    write_word(cpu, 0x200, 5);
+    write_word(cpu, 0x204, 6);
+    write_word(cpu, 0x308, 0x55);
+    cpu->regs[1] = 0x300;
+    cpu->regs[2] = 0x100;
+    cpu->regs[3] = 0x200;
+    
+    ASSERT_EQ(0, execute_instruction(cpu, rv_matvec(1, 2, 3)), "MATVEC executes");
+    ASSERT_EQ(17, read_word(cpu, 0x300), "y[0] = 1*5 + 2*6");
+    ASSERT_EQ(39, read_word(cpu, 0x304), "y[1] = 3*5 + 4*6");
+    ASSERT_EQ(0x55, read_word(cpu, 0x308), "MATVEC writes only the 2-element vector");
+    
+    // Result may overwrite its own vector operand
+    cpu->regs[1] = 0x200;
+    execute_instruction(cpu, rv_matvec(1, 2, 3));
+    ASSERT_EQ(17, read_word(cpu, 0x200), "In-place MATVEC reads x before writing y");
+    
+    cpu->regs[2] = (xlen_t)DEFAULT_MEMORY_SIZE - 8;
+    if (!cpu->sparse) {
+        ASSERT_EQ(RISCV_ERROR_BOUNDS, execute_instruction(cpu, rv_matvec(1, 2, 3)),
+                  "Out-of-bounds tile rejected");
+    }
+    free_cpu(cpu);
+    
+    // The result streams out without allocating a cache line
+    rv_program_t prog = { .len = 0 };
+    rv_emit32(&prog, rv_addi(12, 0, 0x400));
+    rv_emit32(&prog, rv_addi(13, 0, 0x480));
+    rv_emit_li(&prog, 14, 0x800);
+    rv_emit32(&prog, rv_matvec(14, 12, 13));
+    rv_emit32(&prog, rv_ecall());
+    cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    timing_attach(cpu, NULL);
+    riscv_run_timed(cpu, 100);
+    ASSERT_EQ(2, (int)cpu->timing->dcache_misses, "MATVEC misses on A and x only");
+    free_cpu(cpu);
+}
+
+void test_sparse24() {
+    printf("\n=== Testing 2:4 Sparse MATMUL ===\n");
+    
+    int32_t dense[2][4] = {{0, 3, 0, -2}, {5, 0, 0, 0}};
+    int32_t back[2][4];
+    sparse24_tile_t tile;
+    ASSERT_EQ(0, sparse24_pack(dense, &tile), "2:4 tile packs");
+    sparse24_unpack(&tile, back);
+    ASSERT_EQ(0, memcmp(dense, back, sizeof(dense)), "Pack/unpack roundtrip");
+    ASSERT_EQ(3, tile.values[0][0], "Row 0 keeps its first non-zero");
+    ASSERT_EQ(0xD, (int)(tile.meta & 0xF), "Row 0 indices are 1 and 3");
+    
+    int32_t last[2][4] = {{0, 0, 0, 7}, {0, 0, 0, 0}};
+    ASSERT_EQ(0, sparse24_pack(last, &tile), "Single non-zero packs");
+    ASSERT_EQ(7, tile.values[0][1], "Non-zero in the last column pads before it");
+    sparse24_unpack(&tile, back);
+    ASSERT_EQ(0, memcmp(last, back, sizeof(last)), "Padded tile roundtrips");
+    
+    int32_t dense3[2][4] = {{1, 2, 3, 0}, {0, 0, 0, 0}};
+    ASSERT_EQ(RISCV_ERROR_INSTRUCTION, sparse24_pack(dense3, &tile),
+              "Three non-zeros in a row rejected");
+    
+    // The instruction matches the dense product split into two 2x2 halves
+    int32_t b[4][2] = {{1, 2}, {3, 4}, {5, 6}, {7, 8}};
+    matrix_2x2_t a_lo = {{{dense[0][0], dense[0][1]}, {dense[1][0], dense[1][1]}}};
+    matrix_2x2_t a_hi = {{{dense[0][2], dense[0][3]}, {dense[1][2], dense[1][3]}}};
+    matrix_2x2_t b_lo = {{{b[0][0], b[0][1]}, {b[1][0], b[1][1]}}};
+    matrix_2x2_t b_hi = {{{b[2][0], b[2][1]}, {b[3][0], b[3][1]}}};
+    matrix_2x2_t lo = matrix_multiply_2x2(a_lo, b_lo);
+    matrix_2x2_t hi = matrix_multiply_2x2(a_hi, b_hi);
+    matrix_2x2_t expected;
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) expected.m[i][j] = lo.m[i][j] + hi.m[i][j];
+    }
+    
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    sparse24_pack(dense, &tile);
+    load_image(cpu, 0x100, &tile, SPARSE24_TILE_BYTES);
+    load_image(cpu, 0x200, b, sizeof(b));
+    cpu->regs[1] = 0x300;
+    cpu->regs[2] = 0x100;
+    cpu->regs[3] = 0x200;
+    ASSERT_EQ(0, execute_instruction(cpu, rv_matmul_sp(1, 2, 3)), "MATMUL.SP executes");
+    ASSERT_MATRIX_EQ(expected, read_matrix_2x2(cpu, 0x300), "MATMUL.SP matches dense product");
+    
+    cpu->regs[2] = (xlen_t)DEFAULT_MEMORY_SIZE - 8;
+    if (!cpu->sparse) {
+        ASSERT_EQ(RISCV_ERROR_BOUNDS, execute_instruction(cpu, rv_matmul_sp(1, 2, 3)),
+                  "Out-of-bounds compressed tile rejected");
+    }
+    free_cpu(cpu);
+}
+
+static int32_t conv_ref(const int32_t *in, int pitch, const int32_t k[3][3], int y, int x) {
+    int32_t sum = 0;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) sum += in[(y + i) * pitch + x + j] * k[i][j];
+    }
+    return sum;
+}
+
+void test_conv2d() {
+    printf("\n=== Testing CONV2D ===\n");
+    
+    int32_t image[6][6], kernel[3][3] = {{1, 0, -1}, {2, 0, -2}, {1, 0, -1}};
+    for (int y = 0; y < 6; y++) {
+        for (int x = 0; x < 6; x++) image[y][x] = (y * 7 + x * 3) % 11 - 5 + (x == 3 ? 9 : 0);
+    }
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    load_image(cpu, 0x400, image, sizeof(image));
+    load_image(cpu, 0x200, kernel, sizeof(kernel));
+    
+    // Stride 1 over an image with a 24-byte row pitch, configured by a guest
+    rv_program_t prog = { .len = 0 };
+    rv_emit32(&prog, rv_addi(5, 0, sizeof(image[0])));
+    rv_emit32(&prog, rv_csrrw(0, CSR_CONVPITCH, 5));
+    rv_emit32(&prog, rv_addi(12, 0, 0x400 + 4));
+    rv_emit32(&prog, rv_addi(13, 0, 0x200));
+    rv_emit32(&prog, rv_addi(14, 0, 0x300));
+    rv_emit32(&prog, rv_conv2d(14, 12, 13));
+    rv_emit32(&prog, rv_ecall());
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    riscv_run(cpu, 100);
+    ASSERT_EQ(24, (int)cpu->mcfg.conv_pitch, "convpitch CSR written by csrrw");
+    matrix_2x2_t out = read_matrix_2x2(cpu, 0x300);
+    int ok = 1;
+    for (int r = 0; r < 2; r++) {
+        for (int c = 0; c < 2; c++) ok &= out.m[r][c] == conv_ref(&image[0][0], 6, kernel, r, 1 + c);
+    }
+    ASSERT_EQ(1, ok, "Stride-1 tile matches reference convolution");
+    
+    // Stride 2 reads a 5x5 window
+    ASSERT_EQ(0, csr_write(cpu, CSR_CONVSTRIDE, 2), "convstride accepts 2");
+    cpu->regs[12] = 0x400;
+    execute_instruction(cpu, rv_conv2d(14, 12, 13));
+    out = read_matrix_2x2(cpu, 0x300);
+    ok = 1;
+    for (int r = 0; r < 2; r++) {
+        for (int c = 0; c < 2; c++) ok &= out.m[r][c] == conv_ref(&image[0][0], 6, kernel, 2 * r, 2 * c);
+    }
+    ASSERT_EQ(1, ok, "Stride-2 tile matches reference convolution");
+    
+    ASSERT_EQ(RISCV_ERROR_INSTRUCTION, csr_write(cpu, CSR_CONVSTRIDE, 3), "Stride 3 rejected");
+    ASSERT_EQ(RISCV_ERROR_INSTRUCTION, csr_write(cpu, CSR_CONVPITCH, 6), "Unaligned pitch rejected");
+    
+    // Pitch 0 reads a packed window
+    int32_t packed[4][4];
+    for (int i = 0; i < 4; i++) memcpy(packed[i], &image[i][0], sizeof(packed[i]));
+    load_image(cpu, 0x800, packed, sizeof(packed));
+    csr_write(cpu, CSR_CONVPITCH, 0);
+    csr_write(cpu, CSR_CONVSTRIDE, 1);
+    cpu->regs[12] = 0x800;
+    execute_instruction(cpu, rv_conv2d(14, 12, 13));
+    ASSERT_EQ(conv_ref(&image[0][0], 6, kernel, 1, 1), read_word(cpu, 0x30C), "Packed window convolution");
+    
+    cpu->regs[12] = (xlen_t)DEFAULT_MEMORY_SIZE - 32;
+    if (!cpu->sparse) {
+        ASSERT_EQ(RISCV_ERROR_BOUNDS, execute_instruction(cpu, rv_conv2d(14, 12, 13)),
+                  "Out-of-bounds window rejected");
+    }
+    
+    csr_write(cpu, CSR_CONVSTRIDE, 2);
+    riscv_cpu_reset(cpu);
+    ASSERT_EQ(1, (int)cpu->mcfg.conv_stride, "Reset restores power-on CSR values");
+    free_cpu(cpu);
+}
+
+static int32_t requant_ref(int32_t acc, int32_t scale, int shift, int32_t zero, int32_t lo, int32_t hi) {
+    int64_t x = ((int64_t)acc * scale + (shift ? (int64_t)1 << (shift - 1) : 0)) >> shift;
+    x += zero;
+    return (int32_t)(x < lo ? lo : x > hi ? hi : x);
+}
+
+void test_quantize_epilogue() {
+    printf("\n=== Testing Requantization Epilogue ===\n");
+    
+    matrix_2x2_t a = {{{100, -7}, {30, 2}}};
+    matrix_2x2_t b = {{{40, 3}, {-9, 25}}};
+    matrix_2x2_t acc = matrix_multiply_2x2(a, b);
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    write_matrix_2x2(cpu, 0x200, a);
+    write_matrix_2x2(cpu, 0x210, b);
+    
+    // Guest configures scale 3, shift 4, zero point -5 for int8 output
+    rv_program_t prog = { .len = 0 };
+    rv_emit32(&prog, rv_addi(5, 0, 3));
+    rv_emit32(&prog, rv_csrrw(0, CSR_QSCALE, 5));
+    rv_emit32(&prog, rv_csrrwi(0, CSR_QSHIFT, 4));
+    rv_emit32(&prog, rv_addi(5, 0, -5));
+    rv_emit32(&prog, rv_csrrw(0, CSR_QZERO, 5));
+    rv_emit32(&prog, rv_csrrwi(0, CSR_QMODE, QUANT_MODE_INT8));
+    rv_emit32(&prog, rv_addi(12, 0, 0x200));
+    rv_emit32(&prog, rv_addi(13, 0, 0x210));
+    rv_emit32(&prog, rv_addi(14, 0, 0x300));
+    rv_emit32(&prog, rv_matmul(14, 12, 13));
+    rv_emit32(&prog, rv_ecall());
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    riscv_run(cpu, 100);
+    
+    matrix_2x2_t out = read_matrix_2x2(cpu, 0x300);
+    int ok = 1;
+    for (int e = 0; e < MATRIX_SIZE; e++) {
+        ok &= out.m[e / 2][e % 2] == requant_ref(acc.m[e / 2][e % 2], 3, 4, -5, -128, 127);
+    }
+    ASSERT_EQ(1, ok, "Fused int8 epilogue matches scalar reference");
+    ASSERT_EQ(127, out.m[0][0], "Large accumulator saturates at 127");
+    ASSERT_EQ(requant_ref(acc.m[1][1], 3, 4, -5, -128, 127), out.m[1][1], "Rounded value in range");
+    
+    // uint8 clamps negatives to 0; the epilogue also applies to MATVEC
+    csr_write(cpu, CSR_QMODE, QUANT_MODE_UINT8);
+    csr_write(cpu, CSR_QSCALE, -1);
+    csr_write(cpu, CSR_QSHIFT, 0);
+    csr_write(cpu, CSR_QZERO, 200);
+    execute_instruction(cpu, rv_matmul(14, 12, 13));
+    ASSERT_EQ(0, read_word(cpu, 0x300), "uint8 mode clamps at 0");
+    ASSERT_EQ(200 - acc.m[0][1], read_word(cpu, 0x304), "uint8 mode keeps in-range values");
+    write_word(cpu, 0x220, 1);
+    write_word(cpu, 0x224, 0);
+    cpu->regs[13] = 0x220;
+    execute_instruction(cpu, rv_matvec(14, 12, 13));
+    ASSERT_EQ(200 - a.m[0][0], read_word(cpu, 0x300), "MATVEC result requantized");
+    ASSERT_EQ(170, read_word(cpu, 0x304), "MATVEC second element requantized");
+    
+    ASSERT_EQ(RISCV_ERROR_INSTRUCTION, csr_write(cpu, CSR_QMODE, 3), "Unknown qmode rejected");
+    ASSERT_EQ(RISCV_ERROR_INSTRUCTION, csr_write(cpu, CSR_QSHIFT, 63), "Shift above 62 rejected");
+    
+    // Largest shift with the extreme product: 2^62 + 2^61 still fits in int64
+    matrix_config_t extreme = { .quant_mode = QUANT_MODE_INT8, .quant_scale = INT32_MIN,
+                                .quant_shift = QUANT_MAX_SHIFT, .quant_zero = 0 };
+    matrix_2x2_t edge = {{{INT32_MIN, INT32_MAX}, {0, -1}}};
+    matrix_2x2_t q = matrix_requantize(edge, &extreme);
+    ASSERT_EQ(1, q.m[0][0], "INT32_MIN * INT32_MIN at the largest shift rounds to 1");
+    ASSERT_EQ(-1, q.m[0][1], "INT32_MAX * INT32_MIN at the largest shift rounds to -1");
+    ASSERT_EQ(0, q.m[1][1], "Small product at the largest shift rounds to 0");
+    
+    // Off by default and after reset: raw int32 results
+    riscv_cpu_reset(cpu);
+    write_matrix_2x2(cpu, 0x200, a);
+    write_matrix_2x2(cpu, 0x210, b);
+    cpu->regs[12] = 0x200;
+    cpu->regs[13] = 0x210;
+    cpu->regs[14] = 0x300;
+    execute_instruction(cpu, rv_matmul(14, 12, 13));
+    ASSERT_MATRIX_EQ(acc, read_matrix_2x2(cpu, 0x300), "Epilogue off after reset");
+    free_cpu(cpu);
+}
+
+void test_dma() {
+    printf("\n=== Testing DMA Engine ===\n");
+    
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    for (int i = 0; i < 32; i++) write_word(cpu, 0x2000 + (xlen_t)i * 4, i * 3 + 1);
+    
+    // Launch a 128-byte copy, fence, then read the destination
+    rv_program_t prog = { .len = 0 };
+    rv_emit_li(&prog, 5, 0x2000);
+    rv_emit32(&prog, rv_csrrw(0, CSR_DMASRC, 5));
+    rv_emit_li(&prog, 5, 0x3000);
+    rv_emit32(&prog, rv_csrrw(0, CSR_DMADST, 5));
+    rv_emit32(&prog, rv_addi(6, 0, 128));
+    rv_emit32(&prog, rv_csrrw(0, CSR_DMALEN, 6));
+    rv_emit32(&prog, rv_dma_fence());
+    rv_emit32(&prog, rv_lw(7, 5, 124));
+    rv_emit32(&prog, rv_ecall());
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    timing_attach(cpu, NULL);
+    riscv_run_timed(cpu, 100);
+    ASSERT_EQ(1, cpu->halted, "DMA program completes");
+    ASSERT_EQ(94, (int)cpu->regs[7], "Destination holds copied data after fence");
+    ASSERT_EQ(128, (int)cpu->timing->dma_bytes, "Timing model counts DMA bytes");
+    ASSERT_EQ(1, cpu->timing->dma_wait_cycles >= 16, "dma.fence waits for the transfer");
+    ASSERT_EQ(0, (int)cpu->timing->dcache_misses, "Destination lines stashed in the cache");
+    
+    // Overlapping copies behave like memmove
+    ASSERT_EQ(0, dma_start(cpu, 0x2000, 0x2008, 16), "Overlapping forward copy");
+    ASSERT_EQ(1, read_word(cpu, 0x2008), "Forward overlap copies from the original source");
+    ASSERT_EQ(7, read_word(cpu, 0x2010), "Forward overlap preserves order");
+    
+    if (!cpu->sparse) {
+        ASSERT_EQ(RISCV_ERROR_BOUNDS, dma_start(cpu, 0x2000, DEFAULT_MEMORY_SIZE - 8, 64),
+                  "Out-of-bounds DMA rejected");
+    }
+    ASSERT_EQ(RISCV_ERROR_INSTRUCTION, csr_write(cpu, CSR_DMALEN, DMA_MAX_BYTES + 1),
+              "Oversized DMA rejected");
+    free_cpu(cpu);
+}
+
+void test_matrix_layouts() {
+    printf("\n=== Testing Matrix Layouts ===\n");
+    
+    int32_t dense[8 * 8], back[8 * 8];
+    for (int i = 0; i < 64; i++) dense[i] = i * 5 - 17;
+    matrix_layout_t layouts[] = {
+        { LAYOUT_ROW_MAJOR, 8, 8, 48 }, { LAYOUT_BLOCKED, 8, 8, 0 }, { LAYOUT_ZORDER, 8, 8, 0 }
+    };
+    static const char *names[] = { "Row-major", "Blocked", "Z-order" };
+    uint32_t tr[16], tc[16];
+    for (int i = 0; i < 16; i++) {
+        tr[i] = (uint32_t)(i * 7) % 4;
+        tc[i] = (uint32_t)(i * 3 + i / 4) % 4;
+    }
+    
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    for (int l = 0; l < 3; l++) {
+        char msg[80];
+        memset(back, 0, sizeof(back));
+        ASSERT_EQ(0, layout_store(cpu, 0x1000, &layouts[l], dense), "Layout store");
+        layout_load(cpu, 0x1000, &layouts[l], back);
+        snprintf(msg, sizeof(msg), "%s roundtrip", names[l]);
+        ASSERT_EQ(0, memcmp(dense, back, sizeof(dense)), msg);
+        
+        matrix_2x2_t tiles[16];
+        layout_gather(cpu, 0x1000, &layouts[l], tr, tc, 16, tiles, l == 2);
+        int ok = 1;
+        for (int i = 0; i < 16; i++) {
+            for (int e = 0; e < MATRIX_SIZE; e++) {
+                ok &= tiles[i].m[e / 2][e % 2] == dense[(2 * tr[i] + e / 2) * 8 + 2 * tc[i] + e % 2];
+            }
+        }
+        snprintf(msg, sizeof(msg), "%s gather matches dense tiles", names[l]);
+        ASSERT_EQ(1, ok, msg);
+    }
+    ASSERT_EQ(16, (int)layout_tile_offset(&layouts[2], 0, 1), "Z-order tile (0,1) follows (0,0)");
+    ASSERT_EQ(32, (int)layout_tile_offset(&layouts[2], 1, 0), "Z-order tile (1,0) is third");
+    ASSERT_EQ(48, (int)layout_tile_pitch(&layouts[0]), "Row-major tile pitch is the stride");
+    
+    matrix_layout_t bad = { LAYOUT_ZORDER, 8, 4, 0 };
+    ASSERT_EQ(RISCV_ERROR_ALIGNMENT, layout_validate(&bad), "Non-square Z-order rejected");
+    bad = (matrix_layout_t){ LAYOUT_ROW_MAJOR, 8, 8, 16 };
+    ASSERT_EQ(RISCV_ERROR_ALIGNMENT, layout_validate(&bad), "Short row stride rejected");
+    
+    // MATMUL reads tile (1, 2) straight out of the row-major matrix
+    xlen_t addr_a = 0x1000 + layout_tile_offset(&layouts[0], 1, 2);
+    matrix_2x2_t a = {{{dense[2 * 8 + 4], dense[2 * 8 + 5]}, {dense[3 * 8 + 4], dense[3 * 8 + 5]}}};
+    matrix_2x2_t b = {{{1, 2}, {3, 4}}};
+    layout_store(cpu, 0x1000, &layouts[0], dense);
+    write_matrix_2x2(cpu, 0x2000, b);
+    ASSERT_EQ(0, csr_write(cpu, CSR_TILEPITCHA, 48), "tilepitcha accepts the row stride");
+    cpu->regs[1] = 0x2100;
+    cpu->regs[2] = addr_a;
+    cpu->regs[3] = 0x2000;
+    execute_instruction(cpu, rv_matmul(1, 2, 3));
+    ASSERT_MATRIX_EQ(matrix_multiply_2x2(a, b), read_matrix_2x2(cpu, 0x2100), "Strided A tile");
+    execute_instruction(cpu, rv_matmul_t(1, 2, 3, MATMUL_TRANSPOSE_A));
+    ASSERT_MATRIX_EQ(matrix_multiply_2x2_transposed(a, b, MATMUL_TRANSPOSE_A),
+                     read_matrix_2x2(cpu, 0x2100), "Strided A tile with transpose");
+    ASSERT_EQ(RISCV_ERROR_INSTRUCTION, csr_write(cpu, CSR_TILEPITCHB, 6), "Unaligned tile pitch rejected");
+    free_cpu(cpu);
+}
+
+void test_hpm_counters() {
+    printf("\n=== Testing Performance Counters ===\n");
+    
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    write_matrix_2x2(cpu, 0x2000, (matrix_2x2_t){{{1, 2}, {3, 4}}});
+    write_matrix_2x2(cpu, 0x2010, (matrix_2x2_t){{{5, 6}, {7, 8}}});
+    
+    // Zero minstret and the op counter, then self-measure two MATMULs and
+    // a MATVEC
+    rv_program_t prog = { .len = 0 };
+    rv_emit_li(&prog, 10, 0x2000);
+    rv_emit_li(&prog, 11, 0x2010);
+    rv_emit_li(&prog, 12, 0x2100);
+    rv_emit32(&prog, rv_csrrw(0, CSR_MINSTRET, 0));
+    rv_emit32(&prog, rv_csrrw(0, CSR_MHPMCOUNTER3, 0));
+    rv_emit32(&prog, rv_matmul(12, 10, 11));
+    rv_emit32(&prog, rv_matmul(12, 10, 11));
+    rv_emit32(&prog, rv_matvec(12, 10, 11));
+    rv_emit32(&prog, rv_csrrs(20, CSR_HPMCOUNTER3, 0));
+    rv_emit32(&prog, rv_csrrs(21, CSR_MHPMCOUNTER3 + 1, 0));
+    rv_emit32(&prog, rv_csrrs(22, CSR_HPMCOUNTER3 + 2, 0));
+    rv_emit32(&prog, rv_csrrs(23, CSR_MINSTRET, 0));
+    rv_emit32(&prog, rv_csrrs(24, CSR_INSTRET, 0));
+    rv_emit32(&prog, rv_csrrs(25, CSR_MHPMEVENT3 + 1, 0));
+    rv_emit32(&prog, rv_ecall());
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    riscv_run(cpu, 1000);
+    ASSERT_EQ(1, cpu->halted, "Counter program completes");
+    ASSERT_EQ(3, (int)cpu->regs[20], "hpmcounter3 counts matrix instructions");
+    ASSERT_EQ(2 * 32 + 24, (int)cpu->regs[21], "mhpmcounter4 counts matrix bytes loaded");
+    ASSERT_EQ(2 * 16 + 8, (int)cpu->regs[22], "hpmcounter5 counts matrix bytes stored");
+    ASSERT_EQ(8, (int)cpu->regs[23], "minstret counts from the written value");
+    ASSERT_EQ(9, (int)cpu->regs[24], "instret reads the same counter");
+    ASSERT_EQ(HPM_EVENT_MATRIX_LOADS, (int)cpu->regs[25], "mhpmevent4 reports its event");
+    
+    xlen_t value = 0;
+    ASSERT_EQ(0, csr_write(cpu, CSR_MHPMCOUNTER3, 100), "mhpmcounter3 is writable");
+    execute_instruction(cpu, rv_matmul(12, 10, 11));
+    csr_read(cpu, CSR_HPMCOUNTER3, &value);
+    ASSERT_EQ(101, (int)value, "Written counter keeps counting");
+#if XLEN == 32
+    csr_write(cpu, CSR_MHPMCOUNTER3H, 2);
+    csr_read(cpu, CSR_HPMCOUNTER3H, &value);
+    ASSERT_EQ(2, (int)value, "mhpmcounter3h sets the upper half");
+    csr_read(cpu, CSR_HPMCOUNTER3, &value);
+    ASSERT_EQ(101, (int)value, "Upper-half write keeps the lower half");
+#endif
+    ASSERT_EQ(RISCV_ERROR_INSTRUCTION, csr_write(cpu, CSR_HPMCOUNTER3, 0), "hpmcounter3 is read-only");
+    ASSERT_EQ(RISCV_ERROR_INSTRUCTION, csr_write(cpu, CSR_MCYCLE + 1, 0), "There is no mtime CSR");
+    
+    // Counters and events 7..31 exist but are hard-wired to zero
+    value = 1;
+    ASSERT_EQ(0, csr_read(cpu, CSR_HPMCOUNTER3 + 4, &value), "hpmcounter7 is readable");
+    ASSERT_EQ(0, (int)value, "hpmcounter7 reads zero");
+    ASSERT_EQ(0, csr_write(cpu, CSR_MHPMCOUNTER3 + 28, 55), "mhpmcounter31 write is ignored");
+    value = 1;
+    csr_read(cpu, CSR_MHPMCOUNTER3 + 28, &value);
+    ASSERT_EQ(0, (int)value, "mhpmcounter31 stays zero");
+    value = 1;
+    ASSERT_EQ(0, csr_read(cpu, CSR_MHPMEVENT31, &value), "mhpmevent31 is readable");
+    ASSERT_EQ(0, (int)value, "mhpmevent31 reads zero");
+    ASSERT_EQ(RISCV_ERROR_INSTRUCTION, csr_write(cpu, CSR_HPMCOUNTER3 + 4, 0), "hpmcounter7 is read-only");
+#if XLEN == 32
+    value = 1;
+    ASSERT_EQ(0, csr_read(cpu, CSR_HPMCOUNTER3H + 28, &value), "hpmcounter31h is readable");
+    ASSERT_EQ(0, (int)value, "hpmcounter31h reads zero");
+#else
+    ASSERT_EQ(RISCV_ERROR_INSTRUCTION, csr_read(cpu, CSR_HPMCOUNTER3H + 28, &value), "No upper halves on RV64");
+#endif
+    
+    riscv_cpu_reset(cpu);
+    csr_read(cpu, CSR_MHPMCOUNTER3, &value);
+    ASSERT_EQ(0, (int)value, "Reset clears the counters");
+    free_cpu(cpu);
+    
+    // Stall cycles come from the timing model: add waits on a missing load
+    cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    prog.len = 0;
+    rv_emit_li(&prog, 10, 0x3000);
+    rv_emit32(&prog, rv_lw(5, 10, 0));
+    rv_emit32(&prog, rv_add(6, 5, 5));
+    rv_emit32(&prog, rv_csrrs(7, CSR_HPMCOUNTER3 + 3, 0));
+    rv_emit32(&prog, rv_ecall());
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    cpu->pc = 0x100;
+    timing_attach(cpu, NULL);
+    riscv_run_timed(cpu, 100);
+    ASSERT_EQ(1, cpu->regs[7] > 0, "hpmcounter6 sees the load-use stall");
+    ASSERT_EQ(1, cpu->regs[7] == cpu->timing->stall_cycles, "Stall counter tracks the timing model");
+    free_cpu(cpu);
+}
+
+// a1/a2 = args, a7 = number, then ecall; the caller sets a0
+static void emit_syscall(rv_program_t *prog, int number, int32_t a1, int32_t a2) {
+    rv_emit_li(prog, 11, a1);
+    rv_emit_li(prog, 12, a2);
+    rv_emit_li(prog, 17, number);
+    rv_emit32(prog, rv_ecall());
+}
+
+void test_syscalls() {
+    printf("\n=== Testing Proxy Syscalls ===\n");
+    
+    static const char path[] = "build/syscall_test.dat";
+    uint8_t data[3000];
+    for (int i = 0; i < (int)sizeof(data); i++) data[i] = (uint8_t)(i * 7 + i / 256);
+    FILE *f = fopen(path, "wb");
+    if (f) {
+        fwrite(data, 1, sizeof(data), f);
+        fclose(f);
+    }
+    
+    // open, read it all, lseek to the end, grow the heap, close, read
+    // again, exit(7); fd in s0, results in s1..s6
+    rv_program_t prog = { .len = 0 };
+    rv_emit_li(&prog, 10, 0x4000);
+    emit_syscall(&prog, SYS_OPEN, GUEST_O_RDONLY, 0);
+    rv_emit32(&prog, rv_addi(8, 10, 0));
+    emit_syscall(&prog, SYS_READ, 0x8000, 4096);
+    rv_emit32(&prog, rv_addi(9, 10, 0));
+    rv_emit32(&prog, rv_addi(10, 8, 0));
+    emit_syscall(&prog, SYS_LSEEK, 0, SEEK_END);
+    rv_emit32(&prog, rv_addi(18, 10, 0));
+    rv_emit32(&prog, rv_addi(10, 0, 0));
+    emit_syscall(&prog, SYS_BRK, 0, 0);
+    rv_emit32(&prog, rv_addi(19, 10, 0));
+    rv_emit32(&prog, rv_addi(10, 19, 1024));
+    rv_emit32(&prog, rv_ecall());
+    rv_emit32(&prog, rv_addi(20, 10, 0));
+    rv_emit32(&prog, rv_addi(10, 8, 0));
+    emit_syscall(&prog, SYS_CLOSE, 0, 0);
+    rv_emit32(&prog, rv_addi(21, 10, 0));
+    rv_emit32(&prog, rv_addi(10, 8, 0));
+    emit_syscall(&prog, SYS_READ, 0x8000, 16);
+    rv_emit32(&prog, rv_addi(22, 10, 0));
+    rv_emit32(&prog, rv_addi(10, 0, 7));
+    emit_syscall(&prog, SYS_EXIT, 0, 0);
+    
+    // Record with the file present, then replay after deleting it
+    rr_log_t *log = rr_create(1);
+    for (int pass = 0; pass < 2; pass++) {
+        cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+        load_image(cpu, 0x100, prog.bytes, prog.len);
+        load_image(cpu, 0x4000, path, sizeof(path));
+        cpu->pc = 0x100;
+        cpu->replay = &log->stream[0];
+        syscall_attach(cpu, 0xC000, 0xF000);
+        riscv_run(cpu, 1000);
+        if (pass == 0) {
+            ASSERT_EQ(1, cpu->halted, "exit halts the guest");
+            ASSERT_EQ(7, cpu->exit_code, "exit passes the status");
+            ASSERT_EQ(3, (int)cpu->regs[8], "open returns the first free fd");
+            ASSERT_EQ(3000, (int)cpu->regs[9], "read returns the bytes available");
+            ASSERT_EQ(3000, (int)cpu->regs[18], "lseek to the end returns the file size");
+            ASSERT_EQ(0xC000, (int)cpu->regs[19], "brk(0) returns the heap base");
+            ASSERT_EQ(0xC000 + 1024, (int)cpu->regs[20], "brk grows the heap");
+            ASSERT_EQ(0, (int)cpu->regs[21], "close succeeds");
+            ASSERT_EQ(-EBADF, (int)cpu->regs[22], "read after close fails with EBADF");
+            remove(path);
+            log->mode = log->stream[0].mode = RR_REPLAY;
+        } else {
+            ASSERT_EQ(3000, (int)cpu->regs[9], "Replayed read without the host file");
+            ASSERT_EQ(0, (int)rr_diverged(log), "Replay did not diverge");
+        }
+        ASSERT_EQ(0, memcmp(data, cpu->memory + 0x8000, sizeof(data)), "File lands in guest memory");
+        free_cpu(cpu);
+    }
+    rr_free(log);
+
+    // Proxy state follows checkpoints and reset: open, read 100 bytes
+    // (checkpoint), read 100 more, close, grow the heap, exit
+    f = fopen(path, "wb");
+    if (f) {
+        fwrite(data, 1, sizeof(data), f);
+        fclose(f);
+    }
+    prog.len = 0;
+    rv_emit_li(&prog, 10, 0x4000);
+    emit_syscall(&prog, SYS_OPEN, GUEST_O_RDONLY, 0);
+    rv_emit32(&prog, rv_addi(8, 10, 0));
+    emit_syscall(&prog, SYS_READ, 0x8000, 100);
+    size_t mark = prog.len / 4;
+    rv_emit32(&prog, rv_addi(10, 8, 0));
+    emit_syscall(&prog, SYS_READ, 0x9000, 100);
+    rv_emit32(&prog, rv_addi(10, 8, 0));
+    emit_syscall(&prog, SYS_CLOSE, 0, 0);
+    rv_emit_li(&prog, 10, 0xC200);
+    emit_syscall(&prog, SYS_BRK, 0, 0);
+    rv_emit32(&prog, rv_addi(10, 0, 0));
+    emit_syscall(&prog, SYS_EXIT, 0, 0);
+
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    load_image(cpu, 0x4000, path, sizeof(path));
+    cpu->pc = 0x100;
+    syscall_attach(cpu, 0xC000, 0xF000);
+    riscv_cpu_set_base(cpu);
+    int fds = 0;
+    for (int run = 0; run < 40; run++) {
+        riscv_cpu_reset(cpu);
+        riscv_run(cpu, mark);
+        fds += cpu->regs[8] == 3;
+    }
+    ASSERT_EQ(40, fds, "Reset closes files left open, so every run gets fd 3");
+    riscv_run(cpu, 1000);
+    riscv_cpu_reset(cpu);
+    ASSERT_EQ(0xC000, (int)cpu->syscalls->brk, "Reset moves the break back to the heap base");
+
+    riscv_run(cpu, mark);
+    riscv_checkpoint_t *ckpt = checkpoint_save(cpu);
+    riscv_run(cpu, 1000);
+    ASSERT_EQ(1, cpu->halted, "Run past the checkpoint completes");
+    ASSERT_EQ(0, memcmp(data + 100, cpu->memory + 0x9000, 100), "Second read continues the file");
+    ASSERT_EQ(0xC200, (int)cpu->syscalls->brk, "Guest grew the heap");
+    memset(cpu->memory + 0x9000, 0, 100);
+    ASSERT_EQ(0, checkpoint_restore(cpu, ckpt), "Restore reopens the file the guest closed");
+    ASSERT_EQ(0xC000, (int)cpu->syscalls->brk, "Restore brings back the break");
+    riscv_run(cpu, 1000);
+    ASSERT_EQ(0, memcmp(data + 100, cpu->memory + 0x9000, 100), "Re-executed read sees the same bytes");
+    checkpoint_free(ckpt);
+    free_cpu(cpu);
+
+    // Writes to a read-only fd fail at once; a buffered write the host
+    // refuses later is lost output, not a simulator error
+    static const char full[] = "/dev/full";
+    prog.len = 0;
+    rv_emit_li(&prog, 10, 0x4000);
+    emit_syscall(&prog, SYS_OPEN, GUEST_O_RDONLY, 0);
+    emit_syscall(&prog, SYS_WRITE, 0x5000, 3);
+    rv_emit32(&prog, rv_addi(8, 10, 0));
+    rv_emit_li(&prog, 10, 0x4100);
+    emit_syscall(&prog, SYS_OPEN, GUEST_O_WRONLY, 0);
+    emit_syscall(&prog, SYS_WRITE, 0x5000, 10);
+    rv_emit32(&prog, rv_addi(9, 10, 0));
+    rv_emit32(&prog, rv_addi(10, 0, 5));
+    emit_syscall(&prog, SYS_EXIT, 0, 0);
+    cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    load_image(cpu, 0x4000, path, sizeof(path));
+    load_image(cpu, 0x4100, full, sizeof(full));
+    cpu->pc = 0x100;
+    syscall_attach(cpu, 0xC000, 0xF000);
+    ASSERT_EQ(RISCV_SUCCESS, riscv_run(cpu, 1000), "Failed deferred flush does not stop the run");
+    ASSERT_EQ(-EBADF, (int)cpu->regs[8], "Write to a read-only fd fails with EBADF");
+    ASSERT_EQ(5, cpu->exit_code, "exit still runs after the failed flush");
+    f = fopen(full, "wb");
+    if (f) {
+        fclose(f);
+        ASSERT_EQ(10, (int)cpu->regs[9], "Buffered write reports success");
+        ASSERT_EQ(10, (int)cpu->syscalls->bytes_lost, "Refused output counts as lost");
+    }
+    free_cpu(cpu);
+
+    // 100 small writes to a file reach the host in one write
+    prog.len = 0;
+    rv_emit_li(&prog, 10, 0x4000);
+    emit_syscall(&prog, SYS_OPEN, GUEST_O_WRONLY | GUEST_O_CREAT | GUEST_O_TRUNC, 0644);
+    rv_emit32(&prog, rv_addi(8, 10, 0));
+    rv_emit_li(&prog, 5, 100);
+    size_t loop = prog.len;
+    rv_emit32(&prog, rv_addi(10, 8, 0));
+    emit_syscall(&prog, SYS_WRITE, 0x5000, 3);
+    rv_emit32(&prog, rv_addi(5, 5, -1));
+    rv_emit32(&prog, rv_bne(5, 0, (int32_t)loop - (int32_t)prog.len));
+    rv_emit32(&prog, rv_addi(10, 8, 0));
+    emit_syscall(&prog, SYS_CLOSE, 0, 0);
+    rv_emit32(&prog, rv_addi(10, 0, 0));
+    emit_syscall(&prog, SYS_EXIT, 0, 0);
+    
+    cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    load_image(cpu, 0x100, prog.bytes, prog.len);
+    load_image(cpu, 0x4000, path, sizeof(path));
+    load_image(cpu, 0x5000, "ab\n", 3);
+    cpu->pc = 0x100;
+    syscall_attach(cpu, 0xC000, 0xF000);
+    riscv_run(cpu, 10000);
+    ASSERT_EQ(300, (int)cpu->syscalls->bytes_written, "Guest wrote 100 lines");
+    ASSERT_EQ(1, (int)cpu->syscalls->host_writes, "Buffered writes reach the host once");
+    free_cpu(cpu);
+    f = fopen(path, "rb");
+    long size = -1;
+    if (f) {
+        fseek(f, 0, SEEK_END);
+        size = ftell(f);
+        fclose(f);
+    }
+    ASSERT_EQ(300, (int)size, "Host file holds the guest output");
+    remove(path);
+}
+
+void test_file_map() {
+    printf("\n=== Testing Memory-Mapped Files ===\n");
+    
+    static const char path[] = "build/file_map_test.dat";
+    int32_t words[2048];
+    for (int i = 0; i < 2048; i++) words[i] = i * 3;
+    FILE *f = fopen(path, "wb");
+    if (f) {
+        fwrite(words, sizeof(int32_t), 2048, f);
+        fclose(f);
+    }
+    
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    ASSERT_EQ(0, file_map(cpu, 0x100000, path, 0, 0, FILE_MAP_COPY_ON_WRITE), "Map whole file copy-on-write");
+    ASSERT_EQ(0, file_map(cpu, 0x200000, path, 40, 400, FILE_MAP_READ_ONLY | FILE_MAP_SEQUENTIAL),
+              "Map a range at an unaligned file offset");
+    ASSERT_EQ(30, read_word(cpu, 0x100000 + 40), "Guest reads the mapped file");
+    ASSERT_EQ(30, read_word(cpu, 0x200000), "Offset mapping starts at the file offset");
+    
+    // MATMUL streams its operands straight from the mapping
+    matrix_2x2_t a = {{{words[0], words[1]}, {words[2], words[3]}}};
+    matrix_2x2_t b = {{{words[4], words[5]}, {words[6], words[7]}}};
+    cpu->regs[1] = 0x1000;
+    cpu->regs[2] = 0x100000;
+    cpu->regs[3] = 0x100010;
+    execute_instruction(cpu, rv_matmul(1, 2, 3));
+    ASSERT_MATRIX_EQ(matrix_multiply_2x2(a, b), read_matrix_2x2(cpu, 0x1000), "MATMUL on mapped tiles");
+    
+    int32_t value = 777;
+    ASSERT_EQ(RISCV_ERROR_BOUNDS, mem_write(cpu, 0x200000, &value, sizeof(value)), "Read-only mapping rejects stores");
+    ASSERT_EQ(0, mem_write(cpu, 0x100000, &value, sizeof(value)), "Copy-on-write mapping accepts stores");
+    ASSERT_EQ(777, read_word(cpu, 0x100000), "Guest sees its private copy");
+    int32_t on_disk = -1;
+    f = fopen(path, "rb");
+    if (f) {
+        if (fread(&on_disk, sizeof(on_disk), 1, f) != 1) on_disk = -1;
+        fclose(f);
+    }
+    ASSERT_EQ(0, on_disk, "File is unchanged by guest stores");
+    riscv_cpu_reset(cpu);
+    ASSERT_EQ(0, read_word(cpu, 0x100000), "Reset drops copy-on-write pages");
+    riscv_checkpoint_t *clean = checkpoint_save(cpu);
+    ASSERT_EQ(0, clean ? (int)clean->mapped_page_count : -1, "Reset clears the mapping's written pages");
+    checkpoint_free(clean);
+
+    // Copy-on-write pages written before set_base or a checkpoint are part of it
+    value = 111;
+    mem_write(cpu, 0x101008, &value, sizeof(value));
+    ASSERT_EQ(0, riscv_cpu_set_base(cpu), "Set base with a modified mapping page");
+    value = 222;
+    mem_write(cpu, 0x101008, &value, sizeof(value));
+    mem_write(cpu, 0x100000, &value, sizeof(value));
+    ASSERT_EQ(0, riscv_cpu_reset(cpu), "Reset with a modified mapping page in the base");
+    ASSERT_EQ(111, read_word(cpu, 0x101008), "Reset restores the base's copy-on-write page");
+    ASSERT_EQ(0, read_word(cpu, 0x100000), "Reset drops pages the base did not modify");
+    value = 444;
+    mem_write(cpu, 0x100004, &value, sizeof(value));
+    riscv_checkpoint_t *ckpt = checkpoint_save(cpu);
+    ASSERT_EQ(2, ckpt ? (int)ckpt->mapped_page_count : -1, "Checkpoint saves only the modified mapping pages");
+    value = 555;
+    mem_write(cpu, 0x100004, &value, sizeof(value));
+    mem_write(cpu, 0x101008, &value, sizeof(value));
+    ASSERT_EQ(0, checkpoint_restore(cpu, ckpt), "Restore a checkpoint with mapping pages");
+    ASSERT_EQ(444, read_word(cpu, 0x100004), "Restore brings back the checkpoint's page");
+    ASSERT_EQ(111, read_word(cpu, 0x101008), "Restore brings back every modified page");
+    ASSERT_EQ(12, read_word(cpu, 0x100010), "Restored page keeps the file's other words");
+    cpu_state_t *unmapped = init_cpu(DEFAULT_MEMORY_SIZE);
+    ASSERT_EQ(RISCV_ERROR_MEMORY, checkpoint_restore(unmapped, ckpt), "Restore without the mapping is rejected");
+    free_cpu(unmapped);
+    checkpoint_free(ckpt);
+
+    ASSERT_EQ(RISCV_ERROR_BOUNDS, file_map(cpu, 0x101000, path, 0, 0, FILE_MAP_READ_ONLY), "Overlapping mapping rejected");
+    ASSERT_EQ(RISCV_ERROR_BOUNDS, file_map(cpu, 0x8000, path, 0, 0, FILE_MAP_READ_ONLY), "Mapping over RAM rejected");
+    ASSERT_EQ(RISCV_ERROR_ALIGNMENT, file_map(cpu, 0x300100, path, 0, 0, FILE_MAP_READ_ONLY), "Unaligned base rejected");
+    ASSERT_EQ(RISCV_ERROR_BOUNDS, file_map(cpu, 0x300000, path, 0, 9000, FILE_MAP_READ_ONLY), "Range past end of file rejected");
+    ASSERT_EQ(0, file_unmap(cpu, 0x200000), "Unmap");
+    if (!cpu->sparse) {
+        ASSERT_EQ(RISCV_ERROR_BOUNDS, mem_read(cpu, 0x200000, &value, sizeof(value)), "Unmapped range faults");
+    }
+    free_cpu(cpu);
+    remove(path);
+}
+
+// Guest job for the server tests: C tiles at a2 = A * B for a1 A/B tile
+// pairs at a0, then exit with code
+static void emit_tile_job(rv_program_t *prog, int code) {
+    prog->len = 0;
+    rv_emit32(prog, rv_addi(5, 11, 0));
+    size_t loop = prog->len;
+    rv_emit32(prog, rv_addi(6, 10, 16));
+    rv_emit32(prog, rv_matmul(12, 10, 6));
+    rv_emit32(prog, rv_addi(10, 10, 32));
+    rv_emit32(prog, rv_addi(12, 12, 16));
+    rv_emit32(prog, rv_addi(5, 5, -1));
+    rv_emit32(prog, rv_bne(5, 0, (int32_t)loop - (int32_t)prog->len));
+    rv_emit32(prog, rv_addi(10, 0, code));
+    rv_emit32(prog, rv_ecall());
+}
+
+static void* serve_thread(void *arg) {
+    server_serve(arg);
+    return NULL;
+}
+
+void test_server() {
+    printf("\n=== Testing Simulator Daemon ===\n");
+    
+    static const char path[] = "build/test_server.sock";
+    rv_program_t prog = { .len = 0 }, other = { .len = 0 };
+    emit_tile_job(&prog, 7);
+    emit_tile_job(&other, 9);
+    
+    matrix_2x2_t tiles[3][4];
+    for (int j = 0; j < 3; j++) {
+        for (int t = 0; t < 4; t++) {
+            for (int e = 0; e < MATRIX_SIZE; e++) tiles[j][t].m[e / 2][e % 2] = j * 16 + t * 4 + e - 20;
+        }
+    }
+    server_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.magic = SERVER_JOB_MAGIC;
+    job.image_base = job.entry = 0x1000;
+    job.image_len = (uint32_t)prog.len;
+    job.max_instructions = 1000;
+    job.input_base = job.args[0] = 0x2000;
+    job.args[1] = 2;
+    job.output_base = job.args[2] = 0x3000;
+    job.input_len = sizeof(tiles[0]);
+    job.output_len = 2 * MATRIX_BYTES;
+    
+    server_config_t config = { DEFAULT_MEMORY_SIZE, 2, 8 };
+    sim_server_t *server = server_create(&config);
+    ASSERT_EQ(1, server != NULL, "Create a pool of two CPUs");
+    
+    // Three jobs with the same image in one batch: one image load, then warm
+    server_request_t reqs[3];
+    matrix_2x2_t out[3][2];
+    for (int j = 0; j < 3; j++) {
+        reqs[j].job = job;
+        reqs[j].image = prog.bytes;
+        reqs[j].input = tiles[j];
+        reqs[j].output = out[j];
+    }
+    ASSERT_EQ(0, server_run(server, reqs, 3), "Run a batch in process");
+    bool correct = true;
+    for (int j = 0; j < 3; j++) {
+        correct &= reqs[j].result.status == 0 && reqs[j].result.halted && reqs[j].result.exit_code == 7;
+        correct &= reqs[j].result.output_len == 2 * MATRIX_BYTES && reqs[j].result.batch == 3;
+        correct &= reqs[j].result.matrix_ops == 2 && reqs[j].result.instret == 15;
+        for (int t = 0; t < 2; t++) {
+            matrix_2x2_t expected = matrix_multiply_2x2(tiles[j][2 * t], tiles[j][2 * t + 1]);
+            correct &= memcmp(&expected, &out[j][t], sizeof(expected)) == 0;
+        }
+    }
+    ASSERT_EQ(1, (int)correct, "Each job sees only its own inputs and results");
+    ASSERT_EQ(1, reqs[0].result.predecode_misses > 0, "First job decodes the image");
+    ASSERT_EQ(0, (int)reqs[1].result.predecode_misses, "Repeated image keeps its predecoded code");
+    
+    // Switching images reloads; an exhausted budget stops unhalted
+    reqs[0].image = other.bytes;
+    reqs[1].job.max_instructions = 3;
+    ASSERT_EQ(0, server_run(server, reqs, 2), "Run a batch with a new image");
+    ASSERT_EQ(9, reqs[0].result.exit_code, "New image runs");
+    ASSERT_EQ(0, (int)reqs[1].result.halted, "Budget exhausted");
+    ASSERT_EQ(3, (int)reqs[1].result.instret, "Budget is honored");
+    if (XLEN == 32) {
+        reqs[0].job.output_base = (uint64_t)1 << 40;
+        ASSERT_EQ(RISCV_ERROR_BOUNDS, server_run(server, reqs, 1) | reqs[0].result.status,
+                  "Address beyond XLEN rejected");
+    }
+    
+    // Pipelined jobs over the socket
+    ASSERT_EQ(0, server_listen(server, path), "Listen on a Unix socket");
+    pthread_t thread;
+    pthread_create(&thread, NULL, serve_thread, server);
+    int fd = server_connect(path);
+    ASSERT_EQ(1, fd >= 0, "Client connects");
+    for (int j = 0; j < 3; j++) server_send_job(fd, &job, prog.bytes, tiles[j]);
+    correct = true;
+    for (int j = 0; j < 3; j++) {
+        server_result_t result;
+        matrix_2x2_t got[2];
+        correct &= server_recv_result(fd, &result, got, sizeof(got)) == 0;
+        correct &= result.status == 0 && result.halted && result.exit_code == 7;
+        matrix_2x2_t expected = matrix_multiply_2x2(tiles[j][2], tiles[j][3]);
+        correct &= memcmp(&expected, &got[1], sizeof(expected)) == 0;
+    }
+    ASSERT_EQ(1, (int)correct, "Socket results arrive in order");
+    close(fd);
+    server_stop(server);
+    pthread_join(thread, NULL);
+    
+    server_stats_t stats;
+    server_get_stats(server, &stats);
+    ASSERT_EQ(1, (int)stats.connections, "One connection served");
+    ASSERT_EQ(1, stats.jobs >= 8 && stats.batches < stats.jobs, "Jobs are batched");
+    server_destroy(server);
+}
+
+typedef struct {
+    shm_ring_t *ring;
+    xlen_t a, b, c;
+    int count;
+} ring_producer_t;
+
+static void* ring_producer(void *arg) {
+    ring_producer_t *p = arg;
+    for (int i = 0; i < p->count; i++) {
+        while (!shm_ring_push(p->ring, p->a + (xlen_t)(i % 8) * 32, p->b + (xlen_t)(i % 8) * 32,
+                              p->c + (xlen_t)i * MATRIX_BYTES, (uint32_t)i)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_shm_ring() {
+    printf("\n=== Testing Shared-Memory Ring ===\n");
+    
+    shm_ring_t *ring = shm_ring_create(64 * 1024, 8, 0x100000);
+    ASSERT_EQ(1, ring != NULL, "Create a memfd-backed ring");
+    cpu_state_t *cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    ASSERT_EQ(0, shm_ring_map(cpu, ring), "Map the region into the guest");
+    
+    // Host builds 8 operand pairs in place, then the guest consumes 20
+    // descriptors over them, stopping at the empty marker for refills
+    xlen_t pairs, results;
+    matrix_2x2_t *tiles = shm_ring_alloc(ring, 16 * sizeof(matrix_2x2_t), &pairs);
+    matrix_2x2_t *c = shm_ring_alloc(ring, 1000 * sizeof(matrix_2x2_t), &results);
+    for (int t = 0; t < 16; t++) {
+        for (int e = 0; e < MATRIX_SIZE; e++) tiles[t].m[e / 2][e % 2] = t * 5 - e * 3;
+    }
+    ASSERT_EQ(1, shm_ring_guest_addr(ring, &tiles[2]) == pairs + 32, "Host and guest addresses correspond");
+    ASSERT_EQ(tiles[3].m[1][1], read_word(cpu, pairs + 3 * MATRIX_BYTES + 12), "Guest sees host tiles in place");
+    
+    rv_program_t prog = { .len = 0 };
+    shm_ring_emit_consumer(&prog, ring, 20);
+    load_image(cpu, 0x1000, prog.bytes, prog.len);
+    cpu->pc = 0x1000;
+    cpu->stop_on_marker = true;
+    int pushed = 0, stops = 0;
+    bool full_rejected = false;
+    while (!cpu->halted && stops < 100) {
+        while (pushed < 20 && shm_ring_push(ring, pairs + (xlen_t)(pushed % 8) * 32,
+                                            pairs + (xlen_t)(pushed % 8) * 32 + MATRIX_BYTES,
+                                            results + (xlen_t)pushed * MATRIX_BYTES, (uint32_t)pushed)) {
+            pushed++;
+        }
+        full_rejected |= pushed < 20;
+        riscv_run(cpu, 100000);
+        stops++;
+    }
+    ASSERT_EQ(1, (int)cpu->halted, "Guest consumes every descriptor");
+    ASSERT_EQ(1, (int)full_rejected, "Push fails while the ring is full");
+    ASSERT_EQ(20, (int)shm_ring_consumed(ring), "Tail reports consumption");
+    ASSERT_EQ(SHM_RING_MARKER_EMPTY, cpu->last_marker, "Guest waited on the empty marker");
+    bool correct = true;
+    for (int i = 0; i < 20; i++) {
+        matrix_2x2_t expected = matrix_multiply_2x2(tiles[2 * (i % 8)], tiles[2 * (i % 8) + 1]);
+        correct &= memcmp(&expected, &c[i], sizeof(expected)) == 0;
+    }
+    ASSERT_EQ(1, (int)correct, "Results land in the host view without copies");
+    
+    // Shared pages are not rolled back by reset
+    riscv_cpu_reset(cpu);
+    ASSERT_EQ(matrix_multiply_2x2(tiles[0], tiles[1]).m[0][0], c[0].m[0][0], "Reset keeps shared data");
+    
+    // Concurrent producer thread; the guest spins while the ring is empty
+    free_cpu(cpu);
+    cpu = init_cpu(DEFAULT_MEMORY_SIZE);
+    shm_ring_map(cpu, ring);
+    memset(c, 0, 1000 * sizeof(matrix_2x2_t));
+    prog.len = 0;
+    shm_ring_emit_consumer(&prog, ring, 1000);
+    load_image(cpu, 0x1000, prog.bytes, prog.len);
+    cpu->pc = 0x1000;
+    ring_producer_t producer = { ring, pairs, pairs + MATRIX_BYTES, results, 1000 };
+    pthread_t thread;
+    pthread_create(&thread, NULL, ring_producer, &producer);
+    while (!cpu->halted) riscv_run(cpu, 1000000);
+    pthread_join(thread, NULL);
+    correct = true;
+    for (int i = 0; i < 1000; i++) {
+        matrix_2x2_t expected = matrix_multiply_2x2(tiles[2 * (i % 8)], tiles[2 * (i % 8) + 1]);
+        correct &= memcmp(&expected, &c[i], sizeof(expected)) == 0;
+    }
+    ASSERT_EQ(1, (int)correct, "Guest keeps up with a concurrent producer");
+    ASSERT_EQ(1020, (int)shm_ring_consumed(ring), "All concurrent descriptors consumed");
+    
+    free_cpu(cpu);
+    shm_ring_free(ring);
+    
+    // A data area whose size is not a multiple of the 16-byte allocation
+    // granule: the rounded-up cursor passes the end and must not wrap
+    ring = shm_ring_create(0x140 + 20, 4, 0x100000);
+    xlen_t guest;
+    ASSERT_EQ(1, shm_ring_alloc(ring, 1, &guest) != NULL, "Allocate in the first granule");
+    ASSERT_EQ(1, shm_ring_alloc(ring, 1, &guest) != NULL, "Allocate in the partial last granule");
+    ASSERT_EQ(1, shm_ring_alloc(ring, 1, &guest) == NULL, "Allocation past the end of the region fails");
+    shm_ring_free(ring);
+}
+
 // Test performance characteristics
 void test_performance() {
     printf("\n=== Testing Performance Characteristics ===\n");
@@ -217,6 +1945,29 @@ int main() {
     test_instruction_encoding();
     test_matrix_multiplication();
     test_edge_cases();
+    test_xlen_core();
+    test_interpreter_m_extension();
+    test_compressed_extension();
+    test_lockstep_harts();
+    test_fast_forward();
+    test_simpoint_sampling();
+    test_multihart_timing();
+    test_record_replay();
+    test_fast_reset();
+    test_huge_page_memory();
+    test_numa_placement();
+    test_matmul_transpose();
+    test_matvec();
+    test_sparse24();
+    test_conv2d();
+    test_quantize_epilogue();
+    test_dma();
+    test_matrix_layouts();
+    test_hpm_counters();
+    test_syscalls();
+    test_file_map();
+    test_server();
+    test_shm_ring();
     test_performance();
     test_sail_compliance();
     test_cgen_integration();
@@ -0,0 +1,198 @@
+"""Tests for the CPython bindings (make python-test)
+
+Run with build/python on PYTHONPATH; both the RV32 (matmul_sim) and RV64
+(matmul_sim64) modules are exercised.
+"""
+
+import struct
+import sys
+import threading
+
+import matmul_sim
+import matmul_sim64
+
+tests_run = 0
+tests_passed = 0
+
+
+def check(expected, actual, msg):
+    global tests_run, tests_passed
+    tests_run += 1
+    if expected == actual:
+        tests_passed += 1
+        print("✓ PASS: %s" % msg)
+    else:
+        print("✗ FAIL: %s (expected %r, got %r)" % (msg, expected, actual))
+
+
+# Instruction encoders (see simulator/riscv_encode.h)
+def addi(rd, rs1, imm):
+    return ((imm & 0xFFF) << 20) | (rs1 << 15) | (rd << 7) | 0x13
+
+
+def bne(rs1, rs2, offset):
+    imm = offset & 0x1FFF
+    return (((imm >> 12) & 1) << 31) | (((imm >> 5) & 0x3F) << 25) | (rs2 << 20) | \
+        (rs1 << 15) | (1 << 12) | (((imm >> 1) & 0xF) << 8) | (((imm >> 11) & 1) << 7) | 0x63
+
+
+def matmul(rd, rs1, rs2):
+    return (0x1 << 25) | (rs2 << 20) | (rs1 << 15) | (0x7 << 12) | (rd << 7) | 0x2B
+
+
+ECALL = 0x73
+CODE, ADDR_A, ADDR_B, ADDR_C = 0x1000, 0x2000, 0x2010, 0x2020
+
+
+def program(*insns):
+    return struct.pack("<%dI" % len(insns), *insns)
+
+
+def multiply(a, b):
+    return [[sum(a[i][k] * b[k][j] for k in range(2)) for j in range(2)] for i in range(2)]
+
+
+def test_matmul_program(sim):
+    print("\n=== %s: MATMUL program ===" % sim.__name__)
+    cpu = sim.Cpu(65536)
+    check(65536, cpu.memory_size, "memory size")
+    check(len(memoryview(cpu)), cpu.memory_size, "RAM exported as one buffer")
+
+    a, b = [[1, 2], [3, 4]], [[5, 6], [7, 8]]
+    cpu.load(ADDR_A, struct.pack("<4i", 1, 2, 3, 4))
+    cpu.load(ADDR_B, struct.pack("<4i", 5, 6, 7, 8))
+    cpu.load(CODE, program(matmul(12, 10, 11), addi(10, 0, 7), ECALL))
+
+    # Operand addresses go straight into the register file through its view
+    regs = memoryview(cpu.regs)
+    regs[10], regs[11], regs[12] = ADDR_A, ADDR_B, ADDR_C
+    cpu.pc = CODE
+    retired = cpu.run(100)
+    check(True, cpu.halted, "guest halted on ecall")
+    check(7, cpu.exit_code, "exit code from a0")
+    check(3, retired, "run() returns instructions retired")
+    check(1, cpu.matrix_ops, "one matrix instruction")
+    check(multiply(a, b), cpu.array(ADDR_C, 2, 2).tolist(), "C = A * B")
+    check(struct.pack("<4i", 19, 22, 43, 50), cpu.read(ADDR_C, 16), "read() copies C")
+    check(7, regs[10], "regs view sees the guest's writes")
+    check(sim.XLEN == 64 and "Q" or "I", regs.format, "register format follows XLEN")
+
+
+def test_zero_copy_views(sim):
+    print("\n=== %s: zero-copy views ===" % sim.__name__)
+    cpu = sim.Cpu()
+    view = cpu.array(ADDR_A, 2, 2)
+    mv = memoryview(view)
+    check((2, 2), mv.shape, "2-D view shape")
+    check((8, 4), mv.strides, "packed row stride")
+    mv[1, 0] = -3
+    check(struct.pack("<i", -3), cpu.read(ADDR_A + 8, 4), "view writes land in guest RAM")
+    cpu.load(ADDR_A, struct.pack("<i", 11))
+    check(11, mv[0, 0], "guest writes visible through the view")
+
+    # Pitched view: rows 32 bytes apart, as a tile inside a wider matrix
+    tile = memoryview(cpu.array(0x3000, 2, 2, pitch=32))
+    tile[1, 1] = 9
+    check(struct.pack("<i", 9), cpu.read(0x3000 + 32 + 4, 4), "pitched view addresses rows by pitch")
+    check(False, tile.c_contiguous, "pitched view is not contiguous")
+
+    raw = memoryview(cpu)
+    raw[0x4000:0x4004] = b"\x01\x02\x03\x04"
+    check(0x04030201, memoryview(cpu.array(0x4000, 1, format="I"))[0], "byte and word views alias")
+    check(16, sim.MATRIX_BYTES, "MATRIX_BYTES constant")
+
+
+def test_reset_restores_views(sim):
+    print("\n=== %s: reset with live views ===" % sim.__name__)
+    cpu = sim.Cpu()
+    cpu.load(ADDR_A, struct.pack("<4i", 1, 2, 3, 4))
+    cpu.load(CODE, program(matmul(12, 10, 11), ECALL))
+    cpu.set_base()
+
+    view = memoryview(cpu.array(ADDR_A, 2, 2))
+    view[0, 0] = 100
+    cpu.reset()
+    check(1, view[0, 0], "reset restores a page written through a live view")
+    view[0, 1] = 200
+    cpu.reset()
+    check(2, view[0, 1], "reset keeps tracking views that are still alive")
+    del view
+    memoryview(cpu)[ADDR_A] = 0x55
+    cpu.reset()
+    check(1, struct.unpack("<i", cpu.read(ADDR_A, 4))[0], "reset restores writes through the RAM buffer")
+
+
+def loop_program(iterations):
+    # x5 = iterations; loop: MATMUL; x5--; bnez x5, loop; ecall
+    return program(addi(5, 0, iterations), matmul(12, 10, 11), addi(5, 5, -1), bne(5, 0, -8), ECALL)
+
+
+def make_runner(sim, iterations):
+    cpu = sim.Cpu()
+    cpu.load(ADDR_A, struct.pack("<4i", 1, 0, 0, 1))
+    cpu.load(CODE, loop_program(iterations))
+    regs = memoryview(cpu.regs)
+    regs[10], regs[11], regs[12] = ADDR_A, ADDR_A, ADDR_C
+    cpu.pc = CODE
+    return cpu
+
+
+def test_parallel_runs(sim):
+    print("\n=== %s: parallel runs ===" % sim.__name__)
+    cpus = [make_runner(sim, 1000) for _ in range(4)]
+    check([0, 0, 0, 0], sim.run_all(cpus), "run_all statuses")
+    check([True] * 4, [c.halted for c in cpus], "run_all runs every CPU to ecall")
+    check([1000] * 4, [c.matrix_ops for c in cpus], "every CPU ran its whole loop")
+
+    cpus = [make_runner(sim, 1000) for _ in range(4)]
+    threads = [threading.Thread(target=c.run) for c in cpus]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    check([1000] * 4, [c.matrix_ops for c in cpus], "Python threads drive CPUs concurrently")
+
+    try:
+        sim.run_all([cpus[0], cpus[0]])
+        check("ValueError", None, "run_all rejects a repeated Cpu")
+    except ValueError:
+        check(True, True, "run_all rejects a repeated Cpu")
+
+
+def test_errors(sim):
+    print("\n=== %s: errors ===" % sim.__name__)
+    cpu = sim.Cpu()
+    for name, call, error in (
+        ("illegal instruction raises SimulatorError", lambda: cpu.execute(0xFFFFFFFF), sim.SimulatorError),
+        ("view outside RAM raises IndexError", lambda: cpu.array(cpu.memory_size - 4, 4), IndexError),
+        ("bad view format raises ValueError", lambda: cpu.array(0, 2, format="f"), ValueError),
+    ):
+        try:
+            call()
+            check(error.__name__, None, name)
+        except error:
+            check(True, True, name)
+
+
+def main():
+    for sim in (matmul_sim, matmul_sim64):
+        check(sim.__name__ == "matmul_sim64" and 64 or 32, sim.XLEN, "%s XLEN" % sim.__name__)
+        test_matmul_program(sim)
+        test_zero_copy_views(sim)
+        test_reset_restores_views(sim)
+        test_parallel_runs(sim)
+        test_errors(sim)
+
+    print("\n=== Test Summary ===")
+    print("Tests run: %d" % tests_run)
+    print("Tests passed: %d" % tests_passed)
+    print("Tests failed: %d" % (tests_run - tests_passed))
+    if tests_passed != tests_run:
+        print("\n❌ Some Python binding tests failed.")
+        return 1
+    print("\n🎉 All Python binding tests passed.")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())